@@ -35,10 +35,27 @@
 
 // appleseed.renderer headers.
 #include "renderer/api/frame.h"
+#include "renderer/api/log.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/timer.h"
+#include "foundation/utility/stopwatch.h"
+
+// boost headers.
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+#include "boost/thread/thread_time.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
+#include <memory>
 
+using namespace boost;
 using namespace foundation;
 using namespace renderer;
 using namespace std;
@@ -52,32 +69,165 @@ namespace cli {
 
 namespace
 {
-    class ContinuousSavingTileCallback
-      : public ProgressTileCallback
+    //
+    // Writes the frame to disk from a background thread.
+    //
+    // Write requests that arrive while a write is pending are merged into it.
+    // Writes are spaced out in time so that the writer thread spends at most
+    // a fraction of the wall clock time writing, however many tiles complete.
+    //
+
+    class FrameWriter
+      : public NonCopyable
     {
       public:
-        ContinuousSavingTileCallback(const string& output_filename, Logger& logger)
-          : ProgressTileCallback(logger)
-          , m_output_filename(output_filename)
+        FrameWriter(const string& output_filename, Logger& logger)
+          : m_output_filename(output_filename)
+          , m_logger(logger)
+          , m_frame(0)
+          , m_write_pending(false)
+          , m_stop(false)
+          , m_next_write_time(get_system_time())
         {
         }
 
+        // Request the frame to be written. Returns immediately.
+        void request_write(const Frame* frame)
+        {
+            mutex::scoped_lock lock(m_mutex);
+
+            m_frame = frame;
+            m_write_pending = true;
+
+            m_event.notify_one();
+        }
+
+        // Ask the writer thread to perform the pending write, if any, and to terminate.
+        void stop()
+        {
+            mutex::scoped_lock lock(m_mutex);
+
+            m_stop = true;
+
+            m_event.notify_one();
+        }
+
+        // Main line of the writer thread.
+        void operator()()
+        {
+            mutex::scoped_lock lock(m_mutex);
+
+            while (true)
+            {
+                // Wait for a write request.
+                while (!m_write_pending && !m_stop)
+                    m_event.wait(lock);
+
+                if (!m_write_pending)
+                    break;
+
+                // Honor the minimum delay between writes, unless we're asked to terminate.
+                while (!m_stop && get_system_time() < m_next_write_time)
+                    m_event.timed_wait(lock, m_next_write_time);
+
+                const Frame* frame = m_frame;
+                m_write_pending = false;
+
+                // Write the frame without holding the lock so that rendering threads never wait.
+                lock.unlock();
+                const double write_time = write_frame(*frame);
+                lock.lock();
+
+                const double write_delay = max(MinWriteDelay, WriteDelayFactor * write_time);
+                m_next_write_time =
+                    get_system_time() +
+                    posix_time::milliseconds(static_cast<long>(write_delay * 1000.0));
+            }
+        }
+
       private:
-        const string m_output_filename;
+        // Minimum delay in seconds between two writes.
+        static const double     MinWriteDelay;
+
+        // Minimum delay between two writes, as a multiple of the duration of the last write.
+        static const double     WriteDelayFactor;
+
+        const string            m_output_filename;
+        Logger&                 m_logger;
+
+        mutex                   m_mutex;
+        condition_variable      m_event;
+        const Frame*            m_frame;
+        bool                    m_write_pending;
+        bool                    m_stop;
+        system_time             m_next_write_time;
 
-        virtual void do_post_render_tile(
-            const Frame*    frame,
-            const size_t    tile_x,
-            const size_t    tile_y) OVERRIDE
+        // Write the main and AOV images to disk and return the time it took, in seconds.
+        double write_frame(const Frame& frame) const
         {
-            ProgressTileCallback::do_post_render_tile(frame, tile_x, tile_y);
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
 
-            frame->write_main_image(m_output_filename.c_str());
-            frame->write_aov_images(m_output_filename.c_str());
+            frame.write_main_image(m_output_filename.c_str());
+            frame.write_aov_images(m_output_filename.c_str());
+
+            stopwatch.measure();
+
+            const double seconds = stopwatch.get_seconds();
+
+            LOG_DEBUG(m_logger, "wrote frame to %s in %f seconds.", m_output_filename.c_str(), seconds);
+
+            return seconds;
         }
     };
+
+    const double FrameWriter::MinWriteDelay = 1.0;
+    const double FrameWriter::WriteDelayFactor = 4.0;
 }
 
+class ContinuousSavingTileCallback
+  : public ProgressTileCallback
+{
+  public:
+    ContinuousSavingTileCallback(const string& output_filename, Logger& logger)
+      : ProgressTileCallback(logger)
+      , m_frame_writer(output_filename, logger)
+    {
+        ThreadFunctionWrapper<FrameWriter> wrapper(&m_frame_writer);
+        m_writer_thread.reset(new thread(wrapper));
+    }
+
+    ~ContinuousSavingTileCallback()
+    {
+        flush();
+    }
+
+    // Perform the pending write without delay and terminate the writer thread.
+    void flush()
+    {
+        if (m_writer_thread.get())
+        {
+            m_frame_writer.stop();
+            m_writer_thread->join();
+            m_writer_thread.reset();
+        }
+    }
+
+  private:
+    FrameWriter             m_frame_writer;
+    auto_ptr<thread>        m_writer_thread;
+
+    virtual void do_post_render_tile(
+        const Frame*    frame,
+        const size_t    tile_x,
+        const size_t    tile_y) OVERRIDE
+    {
+        ProgressTileCallback::do_post_render_tile(frame, tile_x, tile_y);
+
+        m_frame_writer.request_write(frame);
+    }
+};
+
 
 //
 // ContinuousSavingTileCallbackFactory class implementation.
@@ -90,6 +240,10 @@ ContinuousSavingTileCallbackFactory::ContinuousSavingTileCallbackFactory(
 {
 }
 
+ContinuousSavingTileCallbackFactory::~ContinuousSavingTileCallbackFactory()
+{
+}
+
 void ContinuousSavingTileCallbackFactory::release()
 {
     delete this;
@@ -100,5 +254,10 @@ ITileCallback* ContinuousSavingTileCallbackFactory::create()
     return m_callback.get();
 }
 
+void ContinuousSavingTileCallbackFactory::flush()
+{
+    m_callback->flush();
+}
+
 }   // namespace cli
 }   // namespace appleseed
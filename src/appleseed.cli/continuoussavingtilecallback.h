@@ -46,6 +46,8 @@ namespace foundation    { class Logger; }
 namespace appleseed {
 namespace cli {
 
+class ContinuousSavingTileCallback;
+
 class ContinuousSavingTileCallbackFactory
   : public renderer::ITileCallbackFactory
 {
@@ -54,12 +56,18 @@ class ContinuousSavingTileCallbackFactory
         const std::string&  output_filename,
         foundation::Logger& logger);
 
+    ~ContinuousSavingTileCallbackFactory();
+
     virtual void release() OVERRIDE;
 
     virtual renderer::ITileCallback* create() OVERRIDE;
 
+    // Write the last rendered tiles and wait until the frame is on disk.
+    // Call this method once rendering is complete.
+    void flush();
+
   private:
-    std::auto_ptr<renderer::ITileCallback> m_callback;
+    std::auto_ptr<ContinuousSavingTileCallback> m_callback;
 };
 
 }       // namespace cli
@@ -644,6 +644,7 @@ namespace
 
         // Create the tile callback factory.
         auto_ptr<ITileCallbackFactory> tile_callback_factory;
+        ContinuousSavingTileCallbackFactory* continuous_saving_tile_callback_factory = 0;
         if (g_cl.m_mplay_display.is_set())
         {
             tile_callback_factory.reset(
@@ -662,10 +663,11 @@ namespace
         }
         else if (g_cl.m_output.is_set() && g_cl.m_continuous_saving.is_set())
         {
-            tile_callback_factory.reset(
+            continuous_saving_tile_callback_factory =
                 new ContinuousSavingTileCallbackFactory(
                     g_cl.m_output.values()[0].c_str(),
-                    g_logger));
+                    g_logger);
+            tile_callback_factory.reset(continuous_saving_tile_callback_factory);
         }
         else
         {
@@ -700,6 +702,10 @@ namespace
             stopwatch.measure();
         }
 
+        // Make sure the continuously saved frame is complete on disk.
+        if (continuous_saving_tile_callback_factory)
+            continuous_saving_tile_callback_factory->flush();
+
         // Print rendering time.
         const double seconds = stopwatch.get_seconds();
         LOG_INFO(
@@ -723,8 +729,8 @@ namespace
                 &archive_path);
         }
 
-        // Write the frame to disk.
-        if (g_cl.m_output.is_set() && !g_cl.m_continuous_saving.is_set())
+        // Write the frame to disk, unless it was already written by continuous saving.
+        if (g_cl.m_output.is_set() && !continuous_saving_tile_callback_factory)
         {
             LOG_INFO(g_logger, "writing frame to disk...");
             project->get_frame()->write_main_image(g_cl.m_output.values()[0].c_str());
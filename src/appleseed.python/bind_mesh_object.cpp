@@ -98,6 +98,57 @@ namespace detail
         return py_objects;
     }
 
+    // Retrieve the contents of a Python object supporting the buffer protocol as an array of items.
+    template <typename T>
+    const T* get_buffer_items(const bpy::object& buffer, size_t& count)
+    {
+        const void* data = 0;
+        Py_ssize_t len;
+
+        const int success = PyObject_AsReadBuffer(buffer.ptr(), &data, &len);
+
+        if (success != 0)
+            bpy::throw_error_already_set();
+
+        if (static_cast<size_t>(len) % sizeof(T) != 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "Buffer size is not a multiple of the item size");
+            bpy::throw_error_already_set();
+        }
+
+        count = static_cast<size_t>(len) / sizeof(T);
+
+        return static_cast<const T*>(data);
+    }
+
+    size_t push_vertices(MeshObject* object, const bpy::object& buffer)
+    {
+        size_t count;
+        const GVector3* vertices = get_buffer_items<GVector3>(buffer, count);
+        return object->push_vertices(vertices, count);
+    }
+
+    size_t push_vertex_normals(MeshObject* object, const bpy::object& buffer)
+    {
+        size_t count;
+        const GVector3* normals = get_buffer_items<GVector3>(buffer, count);
+        return object->push_vertex_normals(normals, count);
+    }
+
+    size_t push_tex_coords(MeshObject* object, const bpy::object& buffer)
+    {
+        size_t count;
+        const GVector2* tex_coords = get_buffer_items<GVector2>(buffer, count);
+        return object->push_tex_coords(tex_coords, count);
+    }
+
+    size_t push_triangles(MeshObject* object, const bpy::object& buffer)
+    {
+        size_t count;
+        const Triangle* triangles = get_buffer_items<Triangle>(buffer, count);
+        return object->push_triangles(triangles, count);
+    }
+
     bool write_mesh_object(
         const MeshObject*   object,
         const std::string&  object_name,
@@ -128,25 +179,32 @@ void bind_mesh_object()
         .def_readwrite("a2", &Triangle::m_a2)
         .def_readwrite("pa", &Triangle::m_pa);
 
+    size_t (MeshObject::*push_tex_coords)(const GVector2&) = &MeshObject::push_tex_coords;
+
     bpy::class_<MeshObject, auto_release_ptr<MeshObject>, bpy::bases<Object>, boost::noncopyable>("MeshObject", bpy::no_init)
         .def("__init__", bpy::make_constructor(detail::create_mesh_obj))
 
         .def("reserve_vertices", &MeshObject::reserve_vertices)
         .def("push_vertex", &MeshObject::push_vertex)
+        .def("push_vertices", detail::push_vertices)
         .def("get_vertex_count", &MeshObject::get_vertex_count)
         .def("get_vertex", &MeshObject::get_vertex, bpy::return_value_policy<bpy::reference_existing_object>())
 
         .def("reserve_vertex_normals", &MeshObject::reserve_vertex_normals)
         .def("push_vertex_normal", &MeshObject::push_vertex_normal)
+        .def("push_vertex_normals", detail::push_vertex_normals)
         .def("get_vertex_normal_count", &MeshObject::get_vertex_normal_count)
         .def("get_vertex_normal", &MeshObject::get_vertex_normal, bpy::return_value_policy<bpy::reference_existing_object>())
 
-        .def("push_tex_coords", &MeshObject::push_tex_coords)
+        // Overloads are tried in reverse order of registration: the buffer overload must come first.
+        .def("push_tex_coords", detail::push_tex_coords)
+        .def("push_tex_coords", push_tex_coords)
         .def("get_tex_coords_count", &MeshObject::get_tex_coords_count)
         .def("get_tex_coords", &MeshObject::get_tex_coords)
 
         .def("reserve_triangles", &MeshObject::reserve_triangles)
         .def("push_triangle", &MeshObject::push_triangle)
+        .def("push_triangles", detail::push_triangles)
         .def("get_triangle_count", &MeshObject::get_triangle_count)
         .def("get_triangle", &MeshObject::get_triangle, bpy::return_value_policy<bpy::reference_existing_object>())
 
@@ -292,16 +292,19 @@ namespace
                 return Color3f(values[0], values[1], values[2]);
             else if (low_wavelength < high_wavelength)
             {
-                float output_spectrum[Spectrum::Samples];
+                Spectrum spectrum;
                 spectral_values_to_spectrum(
                     low_wavelength,
                     high_wavelength,
                     values.size(),
                     &values[0],
-                    output_spectrum);
+                    &spectrum[0]);
 
-                Color3f ciexyz;
-                spectrum_to_ciexyz_standard(&output_spectrum[0], &ciexyz[0]);
+                const LightingConditions lighting_conditions(
+                    IlluminantCIED65,
+                    XYZCMFCIE196410Deg);
+
+                const Color3f ciexyz = spectrum_to_ciexyz<float>(lighting_conditions, spectrum);
 
                 return linear_rgb_to_srgb(ciexyz_to_linear_rgb(ciexyz));
             }
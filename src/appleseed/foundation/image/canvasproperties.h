@@ -84,6 +84,14 @@ class DLLSYMBOL CanvasProperties
     // Compute the width and height in pixels of a given tile.
     size_t get_tile_width(const size_t tile_x) const;
     size_t get_tile_height(const size_t tile_y) const;
+
+    // Return the number of levels of the MIP pyramid of the canvas, down to a 1x1 level.
+    size_t get_mip_level_count() const;
+
+    // Return the properties of a given level of the MIP pyramid of the canvas. Each level
+    // is half the resolution of the previous one; tiles keep their size unless they would
+    // exceed the size of the level.
+    CanvasProperties get_mip_level_properties(const size_t level) const;
 };
 
 
@@ -142,6 +150,33 @@ inline size_t CanvasProperties::get_tile_height(const size_t tile_y) const
             m_tile_height);
 }
 
+// Return the number of levels of the MIP pyramid of the canvas.
+inline size_t CanvasProperties::get_mip_level_count() const
+{
+    size_t level_count = 1;
+
+    for (size_t size = std::max(m_canvas_width, m_canvas_height); size > 1; size /= 2)
+        ++level_count;
+
+    return level_count;
+}
+
+// Return the properties of a given level of the MIP pyramid of the canvas.
+inline CanvasProperties CanvasProperties::get_mip_level_properties(const size_t level) const
+{
+    const size_t canvas_width = std::max<size_t>(m_canvas_width >> level, 1);
+    const size_t canvas_height = std::max<size_t>(m_canvas_height >> level, 1);
+
+    return
+        CanvasProperties(
+            canvas_width,
+            canvas_height,
+            std::min(m_tile_width, canvas_width),
+            std::min(m_tile_height, canvas_height),
+            m_channel_count,
+            m_pixel_format);
+}
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_IMAGE_CANVASPROPERTIES_H
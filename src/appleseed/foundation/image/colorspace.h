@@ -325,6 +325,13 @@ Color<T, 3> spectrum_to_ciexyz(
     const LightingConditions&   lighting,
     const Spectrum&             spectrum);
 
+// Convert a 3-band spectrum to a color in the CIE XYZ color space. The samples of a 3-band
+// spectrum are linear RGB values, hence the lighting conditions are not used.
+template <typename T>
+Color<T, 3> spectrum_to_ciexyz(
+    const LightingConditions&   lighting,
+    const RegularSpectrum<T, 3>& spectrum);
+
 // Converts a spectrum to a color in the CIE XYZ color space using the CIE D65 illuminant
 // and the CIE 1964 10-deg color matching functions.
 DLLSYMBOL void spectrum_to_ciexyz_standard(
@@ -354,6 +361,22 @@ void daylight_ciexy_to_spectrum(
     const T                     y,
     Spectrum&                   spectrum);
 
+template <typename T>
+void daylight_ciexy_to_spectrum(
+    const T                     x,
+    const T                     y,
+    RegularSpectrum<T, 3>&      spectrum);
+
+
+//
+// Compute the luminance of a spectrum. For 31-band spectra, this is the sum of the
+// spectrum weighted by the CIE 1931 2-deg Y color matching function. For 3-band
+// spectra, this is the relative luminance of the linear RGB triplet.
+//
+
+float spectrum_luminance(const Spectrum31f& spectrum);
+float spectrum_luminance(const Spectrum3f& spectrum);
+
 
 //
 // Linear RGB to spectrum transformation.
@@ -380,6 +403,16 @@ void linear_rgb_illuminance_to_spectrum(
     const Color<T, 3>&          linear_rgb,
     Spectrum&                   spectrum);
 
+// Variants of the above functions for 3-band spectra, which simply hold linear RGB values.
+template <typename T>
+void linear_rgb_reflectance_to_spectrum(
+    const Color<T, 3>&          linear_rgb,
+    RegularSpectrum<T, 3>&      spectrum);
+template <typename T>
+void linear_rgb_illuminance_to_spectrum(
+    const Color<T, 3>&          linear_rgb,
+    RegularSpectrum<T, 3>&      spectrum);
+
 
 //
 // Spectrum <-> Spectrum transformation.
@@ -787,6 +820,14 @@ inline Color3f spectrum_to_ciexyz<float, Spectrum31f>(
 
 #endif  // APPLESEED_USE_SSE
 
+template <typename T>
+Color<T, 3> spectrum_to_ciexyz(
+    const LightingConditions&   lighting,
+    const RegularSpectrum<T, 3>& spectrum)
+{
+    return linear_rgb_to_ciexyz(Color<T, 3>(spectrum[0], spectrum[1], spectrum[2]));
+}
+
 template <typename T, typename Spectrum>
 void ciexyz_reflectance_to_spectrum(
     const Color<T, 3>&          xyz,
@@ -833,6 +874,32 @@ inline void daylight_ciexy_to_spectrum<float, Spectrum31f>(
     spectrum += s2;
 }
 
+template <typename T>
+void daylight_ciexy_to_spectrum(
+    const T                     x,
+    const T                     y,
+    RegularSpectrum<T, 3>&      spectrum)
+{
+    const Color<T, 3> xyz(x / y, T(1.0), (T(1.0) - x - y) / y);
+
+    linear_rgb_illuminance_to_spectrum(ciexyz_to_linear_rgb(xyz), spectrum);
+}
+
+
+//
+// Spectrum luminance implementation.
+//
+
+inline float spectrum_luminance(const Spectrum31f& spectrum)
+{
+    return sum_value(spectrum * XYZCMFCIE19312Deg[1]);
+}
+
+inline float spectrum_luminance(const Spectrum3f& spectrum)
+{
+    return luminance(Color3f(spectrum[0], spectrum[1], spectrum[2]));
+}
+
 
 //
 // Linear RGB to spectrum transformation implementation.
@@ -966,6 +1033,26 @@ void linear_rgb_illuminance_to_spectrum(
     spectrum = clamp_low(spectrum, 0.0f);
 }
 
+template <typename T>
+void linear_rgb_reflectance_to_spectrum(
+    const Color<T, 3>&          linear_rgb,
+    RegularSpectrum<T, 3>&      spectrum)
+{
+    spectrum[0] = std::max(linear_rgb[0], T(0.0));
+    spectrum[1] = std::max(linear_rgb[1], T(0.0));
+    spectrum[2] = std::max(linear_rgb[2], T(0.0));
+}
+
+template <typename T>
+void linear_rgb_illuminance_to_spectrum(
+    const Color<T, 3>&          linear_rgb,
+    RegularSpectrum<T, 3>&      spectrum)
+{
+    spectrum[0] = std::max(linear_rgb[0], T(0.0));
+    spectrum[1] = std::max(linear_rgb[1], T(0.0));
+    spectrum[2] = std::max(linear_rgb[2], T(0.0));
+}
+
 
 //
 // Spectrum <-> Spectrum transformation implementation.
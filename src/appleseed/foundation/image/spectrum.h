@@ -153,6 +153,8 @@ template <typename T, size_t N> bool has_nan(const RegularSpectrum<T, N>& s);
 // Full specializations for spectra of type float and double.
 //
 
+typedef RegularSpectrum<float,  3> Spectrum3f;
+typedef RegularSpectrum<double, 3> Spectrum3d;
 typedef RegularSpectrum<float,  31> Spectrum31f;
 typedef RegularSpectrum<double, 31> Spectrum31d;
 
@@ -218,6 +220,12 @@ FORCE_INLINE void RegularSpectrum<float, 31>::set(const float val)
     _mm_store_ps(&m_samples[28], mval);
 }
 
+template <>
+FORCE_INLINE void RegularSpectrum<float, 3>::set(const float val)
+{
+    _mm_store_ps(&m_samples[0], _mm_set1_ps(val));
+}
+
 #endif  // APPLESEED_USE_SSE
 
 template <typename T, size_t N>
@@ -439,6 +447,14 @@ FORCE_INLINE RegularSpectrum<float, 31>& operator+=(RegularSpectrum<float, 31>&
     return lhs;
 }
 
+template <>
+FORCE_INLINE RegularSpectrum<float, 3>& operator+=(RegularSpectrum<float, 3>& lhs, const RegularSpectrum<float, 3>& rhs)
+{
+    _mm_store_ps(&lhs[0], _mm_add_ps(_mm_load_ps(&lhs[0]), _mm_load_ps(&rhs[0])));
+
+    return lhs;
+}
+
 #endif  // APPLESEED_USE_SSE
 
 template <typename T, size_t N>
@@ -478,6 +494,14 @@ FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>&
     return lhs;
 }
 
+template <>
+FORCE_INLINE RegularSpectrum<float, 3>& operator*=(RegularSpectrum<float, 3>& lhs, const float rhs)
+{
+    _mm_store_ps(&lhs[0], _mm_mul_ps(_mm_load_ps(&lhs[0]), _mm_set1_ps(rhs)));
+
+    return lhs;
+}
+
 #endif  // APPLESEED_USE_SSE
 
 template <typename T, size_t N>
@@ -506,6 +530,14 @@ FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>&
     return lhs;
 }
 
+template <>
+FORCE_INLINE RegularSpectrum<float, 3>& operator*=(RegularSpectrum<float, 3>& lhs, const RegularSpectrum<float, 3>& rhs)
+{
+    _mm_store_ps(&lhs[0], _mm_mul_ps(_mm_load_ps(&lhs[0]), _mm_load_ps(&rhs[0])));
+
+    return lhs;
+}
+
 #endif  // APPLESEED_USE_SSE
 
 template <typename T, size_t N>
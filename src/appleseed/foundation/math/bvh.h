@@ -33,10 +33,16 @@
 // Interface headers.
 #include "foundation/math/bvh/bvh_bboxsortpredicate.h"
 #include "foundation/math/bvh/bvh_builder.h"
+#include "foundation/math/bvh/bvh_collapser.h"
+#include "foundation/math/bvh/bvh_compactnode.h"
 #include "foundation/math/bvh/bvh_intersector.h"
 #include "foundation/math/bvh/bvh_medianpartitioner.h"
 #include "foundation/math/bvh/bvh_node.h"
 #include "foundation/math/bvh/bvh_partitionerbase.h"
+#include "foundation/math/bvh/bvh_qintersector.h"
+#include "foundation/math/bvh/bvh_qnode.h"
+#include "foundation/math/bvh/bvh_qtree.h"
+#include "foundation/math/bvh/bvh_refitter.h"
 #include "foundation/math/bvh/bvh_sahpartitioner.h"
 #include "foundation/math/bvh/bvh_sbvhpartitioner.h"
 #include "foundation/math/bvh/bvh_spatialbuilder.h"
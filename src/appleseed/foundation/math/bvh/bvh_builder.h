@@ -32,11 +32,18 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log/logger.h"
 #include "foundation/utility/stopwatch.h"
 
+// boost headers.
+#include "boost/thread/mutex.hpp"
+
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <vector>
 
 namespace foundation {
 namespace bvh {
@@ -65,6 +72,9 @@ namespace bvh {
 //              const AABBType&     bbox);
 //      };
 //
+// When the tree is built with more than one thread, partition() and compute_bbox()
+// will be called concurrently on disjoint ranges of items.
+//
 
 template <typename Tree, typename Partitioner>
 class Builder
@@ -80,20 +90,116 @@ class Builder
         Tree&           tree,
         Partitioner&    partitioner,
         const size_t    size,
-        const size_t    items_per_leaf_hint);
+        const size_t    items_per_leaf_hint,
+        const size_t    thread_count = 1);
 
     // Return the construction time.
     double get_build_time() const;
 
+    // Return the time spent merging subtrees built in parallel into the tree.
+    double get_merge_time() const;
+
+    // Return the number of subtrees built in parallel.
+    size_t get_subtree_count() const;
+
   private:
     typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::NodeVectorType NodeVectorType;
     typedef typename NodeType::AABBType AABBType;
 
-    double m_build_time;
+    // Sets of items smaller than this are never built in parallel.
+    static const size_t MinParallelItemCount = 1024;
+
+    struct Subtree
+    {
+        size_t          m_node_index;
+        NodeVectorType  m_nodes;
+
+        Subtree(
+            const size_t                                node_index,
+            const typename NodeVectorType::allocator_type& allocator)
+          : m_node_index(node_index)
+          , m_nodes(allocator)
+        {
+        }
+    };
+
+    struct SubtreeOrderPredicate
+    {
+        bool operator()(const Subtree* lhs, const Subtree* rhs) const
+        {
+            return lhs->m_node_index < rhs->m_node_index;
+        }
+    };
+
+    class SubdivideJob
+      : public IJob
+    {
+      public:
+        SubdivideJob(
+            Builder&            builder,
+            Tree&               tree,
+            Partitioner&        partitioner,
+            const size_t        node_index,
+            const size_t        begin,
+            const size_t        end,
+            const AABBType&     bbox)
+          : m_builder(builder)
+          , m_tree(tree)
+          , m_partitioner(partitioner)
+          , m_node_index(node_index)
+          , m_begin(begin)
+          , m_end(end)
+          , m_bbox(bbox)
+        {
+        }
+
+        virtual void execute(const size_t thread_index)
+        {
+            m_builder.subdivide_parallel(
+                m_tree,
+                m_partitioner,
+                m_node_index,
+                m_begin,
+                m_end,
+                m_bbox);
+        }
+
+      private:
+        Builder&                m_builder;
+        Tree&                   m_tree;
+        Partitioner&            m_partitioner;
+        const size_t            m_node_index;
+        const size_t            m_begin;
+        const size_t            m_end;
+        const AABBType          m_bbox;
+    };
+
+    double                  m_build_time;
+    double                  m_merge_time;
+    size_t                  m_subtree_count;
+
+    // State of a parallel build.
+    JobQueue*               m_job_queue;
+    size_t                  m_parallel_threshold;
+    boost::mutex            m_mutex;
+    std::vector<Subtree*>   m_subtrees;
+
+    // Recursively subdivide the tree, scheduling a new job for each large enough subtree.
+    void subdivide_parallel(
+        Tree&           tree,
+        Partitioner&    partitioner,
+        const size_t    node_index,
+        const size_t    begin,
+        const size_t    end,
+        const AABBType& bbox);
+
+    // Splice the subtrees built in parallel into the tree.
+    void merge_subtrees(Tree& tree);
 
     // Recursively subdivide the tree.
     void subdivide_recurse(
-        Tree&           tree,
+        NodeVectorType& nodes,
         Partitioner&    partitioner,
         const size_t    node_index,
         const size_t    begin,
@@ -109,6 +215,10 @@ class Builder
 template <typename Tree, typename Partitioner>
 Builder<Tree, Partitioner>::Builder()
   : m_build_time(0.0)
+  , m_merge_time(0.0)
+  , m_subtree_count(0)
+  , m_job_queue(0)
+  , m_parallel_threshold(0)
 {
 }
 
@@ -118,7 +228,8 @@ void Builder<Tree, Partitioner>::build(
     Tree&               tree,
     Partitioner&        partitioner,
     const size_t        size,
-    const size_t        items_per_leaf_hint)
+    const size_t        items_per_leaf_hint,
+    const size_t        thread_count)
 {
     // Start stopwatch.
     Stopwatch<Timer> stopwatch;
@@ -138,16 +249,57 @@ void Builder<Tree, Partitioner>::build(
     // Compute the bounding box of the tree.
     const AABBType root_bbox(partitioner.compute_bbox(0, size));
 
-    // todo: preallocate node memory?
+    m_merge_time = 0.0;
+    m_subtree_count = 0;
 
-    // Recursively subdivide the tree.
-    subdivide_recurse(
-        tree,
-        partitioner,
-        0,              // node index
-        0,              // begin
-        size,           // end
-        root_bbox);
+    // Split the items into a few times more subtrees than there are threads to balance the load.
+    m_parallel_threshold =
+        thread_count > 1 && size / (4 * thread_count) > MinParallelItemCount
+            ? size / (4 * thread_count)
+            : MinParallelItemCount;
+
+    if (thread_count > 1 && size > m_parallel_threshold)
+    {
+        // Recursively subdivide the tree in parallel.
+        JobQueue job_queue;
+        m_job_queue = &job_queue;
+        job_queue.schedule(
+            new SubdivideJob(
+                *this,
+                tree,
+                partitioner,
+                0,              // node index
+                0,              // begin
+                size,           // end
+                root_bbox));
+        Logger logger;
+        JobManager job_manager(
+            logger,
+            job_queue,
+            thread_count,
+            JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+        job_queue.wait_until_completion();
+        m_job_queue = 0;
+
+        // Assemble the final tree.
+        Stopwatch<Timer> merge_stopwatch;
+        merge_stopwatch.start();
+        merge_subtrees(tree);
+        merge_stopwatch.measure();
+        m_merge_time = merge_stopwatch.get_seconds();
+    }
+    else
+    {
+        // Recursively subdivide the tree.
+        subdivide_recurse(
+            tree.m_nodes,
+            partitioner,
+            0,              // node index
+            0,              // begin
+            size,           // end
+            root_bbox);
+    }
 
     // Measure and save construction time.
     stopwatch.measure();
@@ -161,7 +313,19 @@ inline double Builder<Tree, Partitioner>::get_build_time() const
 }
 
 template <typename Tree, typename Partitioner>
-void Builder<Tree, Partitioner>::subdivide_recurse(
+inline double Builder<Tree, Partitioner>::get_merge_time() const
+{
+    return m_merge_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline size_t Builder<Tree, Partitioner>::get_subtree_count() const
+{
+    return m_subtree_count;
+}
+
+template <typename Tree, typename Partitioner>
+void Builder<Tree, Partitioner>::subdivide_parallel(
     Tree&               tree,
     Partitioner&        partitioner,
     const size_t        node_index,
@@ -169,7 +333,131 @@ void Builder<Tree, Partitioner>::subdivide_recurse(
     const size_t        end,
     const AABBType&     bbox)
 {
-    assert(node_index < tree.m_nodes.size());
+    if (end - begin <= m_parallel_threshold)
+    {
+        // Build this subtree on its own, it will be merged into the tree later.
+        Subtree* subtree = new Subtree(node_index, tree.m_nodes.get_allocator());
+        subtree->m_nodes.push_back(NodeType());
+        subdivide_recurse(
+            subtree->m_nodes,
+            partitioner,
+            0,
+            begin,
+            end,
+            bbox);
+
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_subtrees.push_back(subtree);
+        return;
+    }
+
+    // Try to partition the set of items.
+    const size_t pivot = partitioner.partition(begin, end, typename Partitioner::AABBType(bbox));
+    assert(pivot > begin);
+    assert(pivot <= end);
+
+    if (pivot == end)
+    {
+        // Turn the current node into a leaf node.
+        boost::mutex::scoped_lock lock(m_mutex);
+        NodeType& node = tree.m_nodes[node_index];
+        node.make_leaf();
+        node.set_item_index(begin);
+        node.set_item_count(end - begin);
+        return;
+    }
+
+    // Compute the bounding box of the child nodes.
+    const AABBType left_bbox(partitioner.compute_bbox(begin, pivot));
+    const AABBType right_bbox(partitioner.compute_bbox(pivot, end));
+
+    size_t left_node_index;
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        // Compute the indices of the child nodes.
+        left_node_index = tree.m_nodes.size();
+
+        // Turn the current node into an interior node.
+        NodeType& node = tree.m_nodes[node_index];
+        node.make_interior();
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+        node.set_child_node_index(left_node_index);
+
+        // Create the child nodes.
+        tree.m_nodes.push_back(NodeType());
+        tree.m_nodes.push_back(NodeType());
+    }
+
+    // Hand the right subtree over to another thread.
+    m_job_queue->schedule(
+        new SubdivideJob(
+            *this,
+            tree,
+            partitioner,
+            left_node_index + 1,
+            pivot,
+            end,
+            right_bbox));
+
+    // Keep going with the left subtree.
+    subdivide_parallel(
+        tree,
+        partitioner,
+        left_node_index,
+        begin,
+        pivot,
+        left_bbox);
+}
+
+template <typename Tree, typename Partitioner>
+void Builder<Tree, Partitioner>::merge_subtrees(Tree& tree)
+{
+    // Merge subtrees in a deterministic order.
+    std::sort(m_subtrees.begin(), m_subtrees.end(), SubtreeOrderPredicate());
+
+    for (size_t i = 0; i < m_subtrees.size(); ++i)
+    {
+        const Subtree* subtree = m_subtrees[i];
+        const NodeVectorType& nodes = subtree->m_nodes;
+
+        // Node n > 0 of the subtree becomes node n + offset of the tree.
+        const size_t offset = tree.m_nodes.size() - 1;
+
+        // The root of the subtree replaces the node it was built for.
+        NodeType& root = tree.m_nodes[subtree->m_node_index];
+        root = nodes[0];
+        if (root.is_interior())
+            root.set_child_node_index(root.get_child_node_index() + offset);
+
+        for (size_t j = 1; j < nodes.size(); ++j)
+        {
+            tree.m_nodes.push_back(nodes[j]);
+
+            NodeType& node = tree.m_nodes.back();
+            if (node.is_interior())
+                node.set_child_node_index(node.get_child_node_index() + offset);
+        }
+
+        delete subtree;
+    }
+
+    m_subtree_count = m_subtrees.size();
+    m_subtrees.clear();
+}
+
+template <typename Tree, typename Partitioner>
+void Builder<Tree, Partitioner>::subdivide_recurse(
+    NodeVectorType&     nodes,
+    Partitioner&        partitioner,
+    const size_t        node_index,
+    const size_t        begin,
+    const size_t        end,
+    const AABBType&     bbox)
+{
+    assert(node_index < nodes.size());
 
     // Try to partition the set of items.
     size_t pivot = end;
@@ -183,7 +471,7 @@ void Builder<Tree, Partitioner>::subdivide_recurse(
     if (pivot == end)
     {
         // Turn the current node into a leaf node.
-        NodeType& node = tree.m_nodes[node_index];
+        NodeType& node = nodes[node_index];
         node.make_leaf();
         node.set_item_index(begin);
         node.set_item_count(end - begin);
@@ -195,23 +483,23 @@ void Builder<Tree, Partitioner>::subdivide_recurse(
         const AABBType right_bbox(partitioner.compute_bbox(pivot, end));
 
         // Compute the indices of the child nodes.
-        const size_t left_node_index = tree.m_nodes.size();
+        const size_t left_node_index = nodes.size();
         const size_t right_node_index = left_node_index + 1;
 
         // Turn the current node into an interior node.
-        NodeType& node = tree.m_nodes[node_index];
+        NodeType& node = nodes[node_index];
         node.make_interior();
         node.set_left_bbox(left_bbox);
         node.set_right_bbox(right_bbox);
         node.set_child_node_index(left_node_index);
 
         // Create the child nodes.
-        tree.m_nodes.push_back(NodeType());
-        tree.m_nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
 
         // Recurse into the left subtree.
         subdivide_recurse(
-            tree,
+            nodes,
             partitioner,
             left_node_index,
             begin,
@@ -220,7 +508,7 @@ void Builder<Tree, Partitioner>::subdivide_recurse(
 
         // Recurse into the right subtree.
         subdivide_recurse(
-            tree,
+            nodes,
             partitioner,
             right_node_index,
             pivot,
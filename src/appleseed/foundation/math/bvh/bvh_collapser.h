@@ -0,0 +1,269 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_COLLAPSER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_COLLAPSER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Collapse a binary BVH into a 4-wide BVH.
+//
+// Each interior node of the 4-wide tree is obtained by repeatedly replacing
+// the largest (in terms of surface area) interior child of a binary node by
+// its own two children, until four children are gathered or only leaves are
+// left. Leaf nodes are copied verbatim, including their user data.
+//
+// Motion bounding boxes are not supported: only the static bounding boxes
+// stored in the nodes of the binary tree are used.
+//
+
+template <typename Tree, typename QTree>
+class Collapser
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    Collapser();
+
+    // Collapse a binary tree into a 4-wide tree.
+    template <typename Timer>
+    void collapse(
+        const Tree&     tree,
+        QTree&          qtree);
+
+    // Return the collapse time.
+    double get_collapse_time() const;
+
+    // Return the depth (in number of interior nodes) of the last 4-wide tree.
+    size_t get_depth() const;
+
+  private:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename QTree::QNodeType QNodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    double m_collapse_time;
+    size_t m_depth;
+
+    // Return the priority of a node for being opened during the collapse.
+    static ValueType get_priority(const AABBType& bbox);
+
+    // Recursively collapse the tree, return the index of the new interior node.
+    size_t collapse_recurse(
+        const Tree&     tree,
+        QTree&          qtree,
+        const NodeType& node,
+        const size_t    depth);
+};
+
+
+//
+// Collapser class implementation.
+//
+
+template <typename Tree, typename QTree>
+Collapser<Tree, QTree>::Collapser()
+  : m_collapse_time(0.0)
+  , m_depth(0)
+{
+}
+
+template <typename Tree, typename QTree>
+template <typename Timer>
+void Collapser<Tree, QTree>::collapse(
+    const Tree&         tree,
+    QTree&              qtree)
+{
+    assert(!tree.m_nodes.empty());
+
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the 4-wide tree.
+    qtree.clear();
+    m_depth = 1;
+
+    // A binary tree with n leaves has n - 1 interior nodes, each 4-wide
+    // interior node replaces at least one and at most three of them.
+    const size_t node_count = tree.m_nodes.size();
+    const size_t leaf_count = (node_count + 1) / 2;
+    qtree.m_qnodes.reserve(leaf_count / 3 + 1);
+    qtree.m_leaves.reserve(leaf_count);
+
+    const NodeType& root = tree.m_nodes[0];
+
+    if (root.is_leaf())
+    {
+        // The binary tree consists of a single leaf: create a root
+        // with a single, unbounded child pointing to this leaf.
+        QNodeType qnode;
+        qnode.clear();
+        qnode.push_child(
+            AABBType(
+                typename AABBType::VectorType(-std::numeric_limits<ValueType>::max()),
+                typename AABBType::VectorType(+std::numeric_limits<ValueType>::max())),
+            0,
+            true);
+        qtree.m_qnodes.push_back(qnode);
+        qtree.m_leaves.push_back(root);
+    }
+    else collapse_recurse(tree, qtree, root, 1);
+
+    // Measure and save collapse time.
+    stopwatch.measure();
+    m_collapse_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, typename QTree>
+inline double Collapser<Tree, QTree>::get_collapse_time() const
+{
+    return m_collapse_time;
+}
+
+template <typename Tree, typename QTree>
+inline size_t Collapser<Tree, QTree>::get_depth() const
+{
+    return m_depth;
+}
+
+template <typename Tree, typename QTree>
+inline typename Collapser<Tree, QTree>::ValueType
+Collapser<Tree, QTree>::get_priority(const AABBType& bbox)
+{
+    // Half surface area in 3D, generalized to any dimension.
+    const typename AABBType::VectorType extent = bbox.extent();
+
+    ValueType priority(0.0);
+
+    for (size_t i = 0; i < AABBType::Dimension; ++i)
+    {
+        for (size_t j = i + 1; j < AABBType::Dimension; ++j)
+            priority += extent[i] * extent[j];
+    }
+
+    return priority;
+}
+
+template <typename Tree, typename QTree>
+size_t Collapser<Tree, QTree>::collapse_recurse(
+    const Tree&         tree,
+    QTree&              qtree,
+    const NodeType&     node,
+    const size_t        depth)
+{
+    assert(node.is_interior());
+
+    if (m_depth < depth)
+        m_depth = depth;
+
+    // Start with the two children of the binary node.
+    size_t child_indices[QNodeType::MaxChildCount];
+    AABBType child_bboxes[QNodeType::MaxChildCount];
+    child_indices[0] = node.get_child_node_index();
+    child_indices[1] = node.get_child_node_index() + 1;
+    child_bboxes[0] = node.get_left_bbox();
+    child_bboxes[1] = node.get_right_bbox();
+    size_t child_count = 2;
+
+    // Open the largest interior children until the node is full.
+    while (child_count < QNodeType::MaxChildCount)
+    {
+        size_t best_child = ~0;
+        ValueType best_priority(-1.0);
+
+        for (size_t i = 0; i < child_count; ++i)
+        {
+            if (tree.m_nodes[child_indices[i]].is_interior())
+            {
+                const ValueType priority = get_priority(child_bboxes[i]);
+
+                if (best_priority < priority)
+                {
+                    best_priority = priority;
+                    best_child = i;
+                }
+            }
+        }
+
+        if (best_child == size_t(~0))
+            break;
+
+        const NodeType& child = tree.m_nodes[child_indices[best_child]];
+
+        child_indices[child_count] = child.get_child_node_index() + 1;
+        child_bboxes[child_count] = child.get_right_bbox();
+        child_indices[best_child] = child.get_child_node_index();
+        child_bboxes[best_child] = child.get_left_bbox();
+        ++child_count;
+    }
+
+    // Create the interior node.
+    const size_t qnode_index = qtree.m_qnodes.size();
+    qtree.m_qnodes.push_back(QNodeType());
+    qtree.m_qnodes[qnode_index].clear();
+
+    // Create the child nodes. Don't keep references to the interior
+    // node since the array of interior nodes grows during recursion.
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        const NodeType& child = tree.m_nodes[child_indices[i]];
+
+        if (child.is_leaf())
+        {
+            const size_t leaf_index = qtree.m_leaves.size();
+            qtree.m_leaves.push_back(child);
+            qtree.m_qnodes[qnode_index].push_child(child_bboxes[i], leaf_index, true);
+        }
+        else
+        {
+            const size_t child_qnode_index = collapse_recurse(tree, qtree, child, depth + 1);
+            qtree.m_qnodes[qnode_index].push_child(child_bboxes[i], child_qnode_index, false);
+        }
+    }
+
+    return qnode_index;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_COLLAPSER_H
@@ -0,0 +1,347 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_COMPACTNODE_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_COMPACTNODE_H
+
+// appleseed.foundation headers.
+#include "foundation/math/fp.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// boost headers.
+#include "boost/static_assert.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Compact node (leaf node or interior node) of a BVH.
+//
+// Same interface as foundation::bvh::Node but bounding boxes are stored in single
+// precision, rounded outward so that they always enclose the original bounding
+// boxes. For 3D bounding boxes, a node fits in 64 bytes instead of 128 bytes.
+//
+// The motion bounding boxes of the right child node must immediately follow
+// those of the left child node, i.e. the index of the first right bounding box
+// must be set after the index and count of the left bounding boxes, and must be
+// equal to the index of the left bounding boxes, plus the number of left bounding
+// boxes if there are more than one.
+//
+
+template <typename AABB>
+class APPLESEED_ALIGN(64) CompactNode
+{
+  public:
+    typedef AABB AABBType;
+
+    // Set/get the node type.
+    void make_interior();
+    void make_leaf();
+    bool is_interior() const;
+    bool is_leaf() const;
+
+    // Set/get the bounding boxes of the child nodes (interior nodes only, static case).
+    void set_left_bbox(const AABBType& bbox);
+    void set_right_bbox(const AABBType& bbox);
+    AABBType get_left_bbox() const;
+    AABBType get_right_bbox() const;
+
+    // Set/get the bounding boxes of the child nodes (interior nodes only, motion case).
+    void set_left_bbox_index(const size_t index);
+    void set_left_bbox_count(const size_t count);
+    void set_right_bbox_index(const size_t index);
+    void set_right_bbox_count(const size_t count);
+    size_t get_left_bbox_index() const;
+    size_t get_left_bbox_count() const;
+    size_t get_right_bbox_index() const;
+    size_t get_right_bbox_count() const;
+
+    // Access user data (leaf nodes only).
+    static const size_t MaxUserDataSize;
+    template <typename U> void set_user_data(const U& data);
+    template <typename U> const U& get_user_data() const;
+    template <typename U> U& get_user_data();
+
+    // Set/get the index of the first child node (interior nodes only).
+    void set_child_node_index(const size_t index);
+    size_t get_child_node_index() const;
+
+    // Set/get the index of the first item (leaf nodes only).
+    void set_item_index(const size_t index);
+    size_t get_item_index() const;
+
+    // Set/get the item count (leaf nodes only).
+    void set_item_count(const size_t count);
+    size_t get_item_count() const;
+
+  private:
+    template <typename Tree, typename Visitor, typename Ray, size_t StackSize, size_t N>
+    friend class Intersector;
+
+    typedef typename AABBType::ValueType ValueType;
+    static const size_t Dimension = AABBType::Dimension;
+
+    uint32                  m_item_count;
+    uint32                  m_index;
+    uint32                  m_bbox_index;
+    uint16                  m_left_bbox_count;
+    uint16                  m_right_bbox_count;
+
+    SSE_ALIGN float         m_bbox_data[4 * Dimension];
+
+    // Round a value to single precision, toward -infinity or +infinity.
+    static float round_down(const ValueType x);
+    static float round_up(const ValueType x);
+};
+
+
+//
+// CompactNode class implementation.
+//
+
+template <typename AABB>
+inline float CompactNode<AABB>::round_down(const ValueType x)
+{
+    const float y = static_cast<float>(x);
+    return static_cast<ValueType>(y) > x ? shift(y, -1) : y;
+}
+
+template <typename AABB>
+inline float CompactNode<AABB>::round_up(const ValueType x)
+{
+    const float y = static_cast<float>(x);
+    return static_cast<ValueType>(y) < x ? shift(y, +1) : y;
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::make_interior()
+{
+    m_item_count = ~0;
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::make_leaf()
+{
+    if (m_item_count == ~0)
+        m_item_count = 0;
+}
+
+template <typename AABB>
+inline bool CompactNode<AABB>::is_interior() const
+{
+    return m_item_count == ~0;
+}
+
+template <typename AABB>
+inline bool CompactNode<AABB>::is_leaf() const
+{
+    return m_item_count != ~0;
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_left_bbox(const AABBType& bbox)
+{
+    for (size_t i = 0; i < Dimension; ++i)
+    {
+        m_bbox_data[i * 4 + 0] = round_down(bbox.min[i]);
+        m_bbox_data[i * 4 + 2] = round_up(bbox.max[i]);
+    }
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_right_bbox(const AABBType& bbox)
+{
+    for (size_t i = 0; i < Dimension; ++i)
+    {
+        m_bbox_data[i * 4 + 1] = round_down(bbox.min[i]);
+        m_bbox_data[i * 4 + 3] = round_up(bbox.max[i]);
+    }
+}
+
+template <typename AABB>
+inline AABB CompactNode<AABB>::get_left_bbox() const
+{
+    AABBType bbox;
+
+    for (size_t i = 0; i < Dimension; ++i)
+    {
+        bbox.min[i] = static_cast<ValueType>(m_bbox_data[i * 4 + 0]);
+        bbox.max[i] = static_cast<ValueType>(m_bbox_data[i * 4 + 2]);
+    }
+
+    return bbox;
+}
+
+template <typename AABB>
+inline AABB CompactNode<AABB>::get_right_bbox() const
+{
+    AABBType bbox;
+
+    for (size_t i = 0; i < Dimension; ++i)
+    {
+        bbox.min[i] = static_cast<ValueType>(m_bbox_data[i * 4 + 1]);
+        bbox.max[i] = static_cast<ValueType>(m_bbox_data[i * 4 + 3]);
+    }
+
+    return bbox;
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_left_bbox_index(const size_t index)
+{
+    assert(index <= 0xFFFFFFFFUL);
+    m_bbox_index = static_cast<uint32>(index);
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_left_bbox_count(const size_t count)
+{
+    assert(count <= 0xFFFFUL);
+    m_left_bbox_count = static_cast<uint16>(count);
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_right_bbox_index(const size_t index)
+{
+    // The index of the right bounding boxes is implied by the left bounding boxes.
+    assert(index == get_right_bbox_index());
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_right_bbox_count(const size_t count)
+{
+    assert(count <= 0xFFFFUL);
+    m_right_bbox_count = static_cast<uint16>(count);
+}
+
+template <typename AABB>
+inline size_t CompactNode<AABB>::get_left_bbox_index() const
+{
+    return static_cast<size_t>(m_bbox_index);
+}
+
+template <typename AABB>
+inline size_t CompactNode<AABB>::get_left_bbox_count() const
+{
+    return static_cast<size_t>(m_left_bbox_count);
+}
+
+template <typename AABB>
+inline size_t CompactNode<AABB>::get_right_bbox_index() const
+{
+    return
+        m_left_bbox_count > 1
+            ? static_cast<size_t>(m_bbox_index) + m_left_bbox_count
+            : static_cast<size_t>(m_bbox_index);
+}
+
+template <typename AABB>
+inline size_t CompactNode<AABB>::get_right_bbox_count() const
+{
+    return static_cast<size_t>(m_right_bbox_count);
+}
+
+#define MAX_USER_DATA_SIZE (4 * CompactNode<AABB>::Dimension * sizeof(float))
+
+template <typename AABB>
+const size_t CompactNode<AABB>::MaxUserDataSize = MAX_USER_DATA_SIZE;
+
+template <typename AABB>
+template <typename U>
+inline void CompactNode<AABB>::set_user_data(const U& data)
+{
+    get_user_data<U>() = data;
+}
+
+template <typename AABB>
+template <typename U>
+inline const U& CompactNode<AABB>::get_user_data() const
+{
+    BOOST_STATIC_ASSERT(sizeof(U) <= MAX_USER_DATA_SIZE);
+    return *reinterpret_cast<const U*>(m_bbox_data);
+}
+
+template <typename AABB>
+template <typename U>
+inline U& CompactNode<AABB>::get_user_data()
+{
+    BOOST_STATIC_ASSERT(sizeof(U) <= MAX_USER_DATA_SIZE);
+    return *reinterpret_cast<U*>(m_bbox_data);
+}
+
+#undef MAX_USER_DATA_SIZE
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_child_node_index(const size_t index)
+{
+    assert(index <= 0xFFFFFFFFUL);
+    m_index = static_cast<uint32>(index);
+}
+
+template <typename AABB>
+inline size_t CompactNode<AABB>::get_child_node_index() const
+{
+    return static_cast<size_t>(m_index);
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_item_index(const size_t index)
+{
+    assert(index <= 0xFFFFFFFFUL);
+    m_index = static_cast<uint32>(index);
+}
+
+template <typename AABB>
+inline size_t CompactNode<AABB>::get_item_index() const
+{
+    return static_cast<size_t>(m_index);
+}
+
+template <typename AABB>
+inline void CompactNode<AABB>::set_item_count(const size_t count)
+{
+    assert(count < 0xFFFFFFFFUL);
+    m_item_count = static_cast<uint32>(count);
+}
+
+template <typename AABB>
+inline size_t CompactNode<AABB>::get_item_count() const
+{
+    return static_cast<size_t>(m_item_count);
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_COMPACTNODE_H
@@ -418,6 +418,20 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_motion(
 
 #ifdef APPLESEED_USE_SSE
 
+namespace impl
+{
+    // Load the same bounding box value of the left and right child nodes.
+    FORCE_INLINE __m128d load_bbox_pair(const double* ptr)
+    {
+        return _mm_load_pd(ptr);
+    }
+
+    FORCE_INLINE __m128d load_bbox_pair(const float* ptr)
+    {
+        return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(ptr))));
+    }
+}
+
 template <
     typename Tree,
     typename Visitor,
@@ -510,12 +524,12 @@ void Intersector<Tree, Visitor, Ray, StackSize, 3>::intersect_no_motion(
         {
             FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += 2);
 
-            const __m128d xl1 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(_mm_load_pd(node_ptr->m_bbox_data + 0 + 2 * (1 - ray_info.m_sgn_dir.x)), org_x));
-            const __m128d xl2 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(_mm_load_pd(node_ptr->m_bbox_data + 0 + 2 * (    ray_info.m_sgn_dir.x)), org_x));
-            const __m128d yl1 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(_mm_load_pd(node_ptr->m_bbox_data + 4 + 2 * (1 - ray_info.m_sgn_dir.y)), org_y));
-            const __m128d yl2 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(_mm_load_pd(node_ptr->m_bbox_data + 4 + 2 * (    ray_info.m_sgn_dir.y)), org_y));
-            const __m128d zl1 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(_mm_load_pd(node_ptr->m_bbox_data + 8 + 2 * (1 - ray_info.m_sgn_dir.z)), org_z));
-            const __m128d zl2 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(_mm_load_pd(node_ptr->m_bbox_data + 8 + 2 * (    ray_info.m_sgn_dir.z)), org_z));
+            const __m128d xl1 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(impl::load_bbox_pair(node_ptr->m_bbox_data + 0 + 2 * (1 - ray_info.m_sgn_dir.x)), org_x));
+            const __m128d xl2 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(impl::load_bbox_pair(node_ptr->m_bbox_data + 0 + 2 * (    ray_info.m_sgn_dir.x)), org_x));
+            const __m128d yl1 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(impl::load_bbox_pair(node_ptr->m_bbox_data + 4 + 2 * (1 - ray_info.m_sgn_dir.y)), org_y));
+            const __m128d yl2 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(impl::load_bbox_pair(node_ptr->m_bbox_data + 4 + 2 * (    ray_info.m_sgn_dir.y)), org_y));
+            const __m128d zl1 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(impl::load_bbox_pair(node_ptr->m_bbox_data + 8 + 2 * (1 - ray_info.m_sgn_dir.z)), org_z));
+            const __m128d zl2 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(impl::load_bbox_pair(node_ptr->m_bbox_data + 8 + 2 * (    ray_info.m_sgn_dir.z)), org_z));
 
             const __m128d ray_tmax = _mm_set1_pd(rtmax);
             const __m128d tmin = _mm_max_pd(zl1, _mm_max_pd(yl1, _mm_max_pd(xl1, ray_tmin)));
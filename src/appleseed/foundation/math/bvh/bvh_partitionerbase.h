@@ -47,6 +47,8 @@ namespace bvh {
 //
 // A base class for BVH partitioners.
 //
+// Items in disjoint ranges may be partitioned concurrently.
+//
 
 template <typename AABBVector>
 class PartitionerBase
@@ -176,18 +178,10 @@ void PartitionerBase<AABBVector>::sort_indices(
             assert(left == pivot);
             assert(right == end);
 
-            const size_t size = indices.size();
-
-            if (end - begin > size / 2)
-            {
-                for (size_t i = 0; i < begin; ++i)
-                    m_tmp[i] = indices[i];
-
-                for (size_t i = end; i < size; ++i)
-                    m_tmp[i] = indices[i];
-
+            // Only swap buffers when sorting all items: other item ranges may be
+            // concurrently sorted by other threads.
+            if (begin == 0 && end == indices.size())
                 m_tmp.swap(indices);
-            }
             else
             {
                 for (size_t i = begin; i < end; ++i)
@@ -0,0 +1,414 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_QINTERSECTOR_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_QINTERSECTOR_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/intersection.h"
+#include "foundation/math/ray.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Intersect a ray with the bounding boxes of the children of a QBVH node.
+//
+
+template <
+    typename QNodeType,
+    typename RayType,
+    typename RayInfoType,
+    typename ValueType,
+    size_t N
+>
+class QNodeIntersector
+{
+  public:
+    // Constructor.
+    QNodeIntersector(
+        const RayType&          ray,
+        const RayInfoType&      ray_info);
+
+    // Return a bit mask of the children hit by the ray. The distances
+    // to the children are returned in 'tmin' for the children that were hit.
+    size_t intersect(
+        const QNodeType&        node,
+        const ValueType         ray_tmax,
+        ValueType               tmin[QNodeType::MaxChildCount]) const;
+
+  private:
+    const RayType&              m_ray;
+    const RayInfoType&          m_ray_info;
+};
+
+
+//
+// QBVH intersector.
+//
+// The Visitor class has the same prototype as the one used by
+// foundation::bvh::Intersector and is only given leaf nodes.
+//
+// Up to three children are pushed on the stack at each level of the tree:
+// StackSize must be at least three times the depth of the tree.
+//
+
+template <
+    typename QTree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize = 3 * 64,
+    size_t N = QTree::QNodeType::AABBType::Dimension
+>
+class QIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename QTree::QNodeType QNodeType;
+    typedef typename QTree::NodeType NodeType;
+    typedef typename QNodeType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, N> RayInfoType;
+
+    // Intersect a ray with a given QBVH without motion.
+    void intersect_no_motion(
+        const QTree&            tree,
+        const RayType&          ray,
+        const RayInfoType&      ray_info,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    typedef QNodeIntersector<QNodeType, RayType, RayInfoType, ValueType, N> QNodeIntersectorType;
+
+    struct StackEntry
+    {
+        size_t      m_node;         // node index shifted left by one, lowest bit set for leaves
+        ValueType   m_tmin;         // distance to the node's bounding box
+    };
+};
+
+
+//
+// QNodeIntersector class implementation.
+//
+
+template <
+    typename QNodeType,
+    typename RayType,
+    typename RayInfoType,
+    typename ValueType,
+    size_t N
+>
+inline QNodeIntersector<QNodeType, RayType, RayInfoType, ValueType, N>::QNodeIntersector(
+    const RayType&              ray,
+    const RayInfoType&          ray_info)
+  : m_ray(ray)
+  , m_ray_info(ray_info)
+{
+}
+
+template <
+    typename QNodeType,
+    typename RayType,
+    typename RayInfoType,
+    typename ValueType,
+    size_t N
+>
+inline size_t QNodeIntersector<QNodeType, RayType, RayInfoType, ValueType, N>::intersect(
+    const QNodeType&            node,
+    const ValueType             ray_tmax,
+    ValueType                   tmin[QNodeType::MaxChildCount]) const
+{
+    const size_t child_count = node.get_child_count();
+
+    size_t hits = 0;
+
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        if (foundation::intersect(m_ray, m_ray_info, node.get_child_bbox(i), tmin[i]) && tmin[i] < ray_tmax)
+            hits |= size_t(1) << i;
+    }
+
+    return hits;
+}
+
+#ifdef APPLESEED_USE_SSE
+
+template <
+    typename QNodeType,
+    typename RayType,
+    typename RayInfoType
+>
+class QNodeIntersector<QNodeType, RayType, RayInfoType, double, 3>
+{
+  public:
+    // Constructor.
+    QNodeIntersector(
+        const RayType&          ray,
+        const RayInfoType&      ray_info)
+      : m_org_x(_mm_set1_pd(ray.m_org.x))
+      , m_org_y(_mm_set1_pd(ray.m_org.y))
+      , m_org_z(_mm_set1_pd(ray.m_org.z))
+      , m_rcp_dir_x(_mm_set1_pd(ray_info.m_rcp_dir.x))
+      , m_rcp_dir_y(_mm_set1_pd(ray_info.m_rcp_dir.y))
+      , m_rcp_dir_z(_mm_set1_pd(ray_info.m_rcp_dir.z))
+      , m_ray_tmin(_mm_set1_pd(ray.m_tmin))
+    {
+        // Offsets of the near and far planes in the node's bounding box data.
+        m_near[0] = 0 * Stride + 4 * (1 - ray_info.m_sgn_dir.x);
+        m_near[1] = 1 * Stride + 4 * (1 - ray_info.m_sgn_dir.y);
+        m_near[2] = 2 * Stride + 4 * (1 - ray_info.m_sgn_dir.z);
+        m_far[0] = 0 * Stride + 4 * ray_info.m_sgn_dir.x;
+        m_far[1] = 1 * Stride + 4 * ray_info.m_sgn_dir.y;
+        m_far[2] = 2 * Stride + 4 * ray_info.m_sgn_dir.z;
+    }
+
+    // Return a bit mask of the children hit by the ray. The distances
+    // to the children are returned in 'tmin' for the children that were hit.
+    size_t intersect(
+        const QNodeType&        node,
+        const double            ray_tmax,
+        double                  tmin[4]) const
+    {
+        const __m128d mray_tmax = _mm_set1_pd(ray_tmax);
+
+        // Intersect children 0 and 1, then children 2 and 3.
+        const int hits =
+               intersect_pair(node.m_bbox_data + 0, mray_tmax, tmin + 0)
+            | (intersect_pair(node.m_bbox_data + 2, mray_tmax, tmin + 2) << 2);
+
+        return static_cast<size_t>(hits) & ((size_t(1) << node.get_child_count()) - 1);
+    }
+
+  private:
+    static const size_t Stride = 8;     // number of values per dimension in the node's bounding box data
+
+    const __m128d   m_org_x;
+    const __m128d   m_org_y;
+    const __m128d   m_org_z;
+    const __m128d   m_rcp_dir_x;
+    const __m128d   m_rcp_dir_y;
+    const __m128d   m_rcp_dir_z;
+    const __m128d   m_ray_tmin;
+    size_t          m_near[3];
+    size_t          m_far[3];
+
+    int intersect_pair(
+        const double*           bbox_data,
+        const __m128d           ray_tmax,
+        double                  tmin[2]) const
+    {
+        const __m128d xl1 = _mm_mul_pd(m_rcp_dir_x, _mm_sub_pd(_mm_load_pd(bbox_data + m_near[0]), m_org_x));
+        const __m128d xl2 = _mm_mul_pd(m_rcp_dir_x, _mm_sub_pd(_mm_load_pd(bbox_data + m_far[0]), m_org_x));
+        const __m128d yl1 = _mm_mul_pd(m_rcp_dir_y, _mm_sub_pd(_mm_load_pd(bbox_data + m_near[1]), m_org_y));
+        const __m128d yl2 = _mm_mul_pd(m_rcp_dir_y, _mm_sub_pd(_mm_load_pd(bbox_data + m_far[1]), m_org_y));
+        const __m128d zl1 = _mm_mul_pd(m_rcp_dir_z, _mm_sub_pd(_mm_load_pd(bbox_data + m_near[2]), m_org_z));
+        const __m128d zl2 = _mm_mul_pd(m_rcp_dir_z, _mm_sub_pd(_mm_load_pd(bbox_data + m_far[2]), m_org_z));
+
+        const __m128d mtmin = _mm_max_pd(zl1, _mm_max_pd(yl1, _mm_max_pd(xl1, m_ray_tmin)));
+        const __m128d mtmax = _mm_min_pd(zl2, _mm_min_pd(yl2, _mm_min_pd(xl2, ray_tmax)));
+
+        _mm_storeu_pd(tmin, mtmin);
+
+        return
+            _mm_movemask_pd(
+                _mm_or_pd(
+                    _mm_cmpgt_pd(mtmin, mtmax),
+                    _mm_or_pd(
+                        _mm_cmplt_pd(mtmax, m_ray_tmin),
+                        _mm_cmpge_pd(mtmin, ray_tmax)))) ^ 3;
+    }
+};
+
+#endif  // APPLESEED_USE_SSE
+
+
+//
+// QIntersector class implementation.
+//
+
+template <
+    typename QTree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize,
+    size_t N
+>
+void QIntersector<QTree, Visitor, Ray, StackSize, N>::intersect_no_motion(
+    const QTree&                tree,
+    const RayType&              ray,
+    const RayInfoType&          ray_info,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built.
+    assert(!tree.m_qnodes.empty());
+
+    const QNodeIntersectorType node_intersector(ray, ray_info);
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node (the root node is always an interior node).
+    size_t node = 0;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    ValueType ray_tmax = ray.m_tmax;
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if ((node & 1) == 0)
+        {
+            const QNodeType& qnode = tree.m_qnodes[node >> 1];
+            const size_t child_count = qnode.get_child_count();
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += child_count);
+
+            // Intersect the bounding boxes of all children at once.
+            ValueType tmin[QNodeType::MaxChildCount];
+            const size_t hits = node_intersector.intersect(qnode, ray_tmax, tmin);
+
+            if (hits)
+            {
+                // Sort the children that were hit by increasing distance.
+                size_t order[QNodeType::MaxChildCount];
+                size_t hit_count = 0;
+                for (size_t i = 0; i < child_count; ++i)
+                {
+                    if (hits & (size_t(1) << i))
+                    {
+                        size_t j = hit_count++;
+                        for (; j > 0 && tmin[order[j - 1]] > tmin[i]; --j)
+                            order[j] = order[j - 1];
+                        order[j] = i;
+                    }
+                }
+
+                FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count - hit_count);
+
+                // Push the far children to the stack, continue with the nearest child.
+                for (size_t i = hit_count - 1; i > 0; --i)
+                {
+                    assert(stack_ptr < stack + StackSize);
+                    const size_t child = order[i];
+                    assert(qnode.m_child_index[child] < (size_t(1) << 31));
+                    stack_ptr->m_node = (static_cast<size_t>(qnode.m_child_index[child]) << 1) | ((qnode.m_leaf_mask >> child) & 1);
+                    stack_ptr->m_tmin = tmin[child];
+                    ++stack_ptr;
+                }
+
+                assert(qnode.m_child_index[order[0]] < (size_t(1) << 31));
+                node = (static_cast<size_t>(qnode.m_child_index[order[0]]) << 1) | ((qnode.m_leaf_mask >> order[0]) & 1);
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count);
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ValueType distance;
+#ifndef NDEBUG
+            distance = ValueType(-1.0);
+#endif
+            const bool proceed =
+                visitor.visit(
+                    tree.m_leaves[node >> 1],
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            assert(!proceed || distance >= ValueType(0.0));
+
+            // Terminate traversal if the visitor decided so.
+            if (!proceed)
+                break;
+
+            // Keep track of the distance to the closest intersection.
+            if (ray_tmax > distance)
+                ray_tmax = distance;
+        }
+
+        // Pop the top node from the stack, skipping nodes beyond the closest intersection.
+        while (stack_ptr > stack && (stack_ptr - 1)->m_tmin >= ray_tmax)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+            --stack_ptr;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        node = (--stack_ptr)->m_node;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_QINTERSECTOR_H
@@ -0,0 +1,201 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_QNODE_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_QNODE_H
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Interior node of a 4-wide BVH (QBVH).
+//
+// The bounding boxes of the four children are stored in structure-of-arrays
+// form so that they can be intersected together using SIMD instructions:
+//
+//   min.x[0..3]  max.x[0..3]  min.y[0..3]  max.y[0..3]  ...
+//
+// A child is either another interior node or a leaf node of the binary BVH
+// the 4-wide BVH was collapsed from.
+//
+
+template <typename AABB>
+class APPLESEED_ALIGN(64) QNode
+{
+  public:
+    typedef AABB AABBType;
+
+    // Maximum number of children of a node.
+    static const size_t MaxChildCount = 4;
+
+    // Remove all children.
+    void clear();
+
+    // Return the number of children.
+    size_t get_child_count() const;
+
+    // Append a child to this node.
+    void push_child(
+        const AABBType& bbox,
+        const size_t    node_index,
+        const bool      is_leaf);
+
+    // Set/get the bounding box of a given child.
+    void set_child_bbox(const size_t i, const AABBType& bbox);
+    AABBType get_child_bbox(const size_t i) const;
+
+    // Return the index of a given child in the interior node or leaf node array.
+    size_t get_child_node_index(const size_t i) const;
+
+    // Return true if a given child is a leaf node.
+    bool is_child_leaf(const size_t i) const;
+
+  private:
+    template <typename QTree, typename Visitor, typename Ray, size_t StackSize, size_t N>
+    friend class QIntersector;
+
+    template <typename QNodeType, typename RayType, typename RayInfoType, typename ValueType, size_t N>
+    friend class QNodeIntersector;
+
+    typedef typename AABBType::ValueType ValueType;
+    static const size_t Dimension = AABBType::Dimension;
+
+    uint32                  m_child_count;
+    uint32                  m_leaf_mask;
+    uint32                  m_child_index[MaxChildCount];
+
+    SSE_ALIGN ValueType     m_bbox_data[2 * Dimension * MaxChildCount];
+};
+
+
+//
+// QNode class implementation.
+//
+
+template <typename AABB>
+inline void QNode<AABB>::clear()
+{
+    m_child_count = 0;
+    m_leaf_mask = 0;
+
+    // Unused children get an empty bounding box that no ray can intersect.
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        for (size_t i = 0; i < MaxChildCount; ++i)
+        {
+            m_bbox_data[d * 2 * MaxChildCount + i] = std::numeric_limits<ValueType>::max();
+            m_bbox_data[d * 2 * MaxChildCount + MaxChildCount + i] = -std::numeric_limits<ValueType>::max();
+        }
+    }
+}
+
+template <typename AABB>
+inline size_t QNode<AABB>::get_child_count() const
+{
+    return static_cast<size_t>(m_child_count);
+}
+
+template <typename AABB>
+inline void QNode<AABB>::push_child(
+    const AABBType& bbox,
+    const size_t    node_index,
+    const bool      is_leaf)
+{
+    assert(m_child_count < MaxChildCount);
+    assert(node_index < (size_t(1) << 31));     // node indices are shifted left by one during traversal
+
+    const size_t i = m_child_count++;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        m_bbox_data[d * 2 * MaxChildCount + i] = bbox.min[d];
+        m_bbox_data[d * 2 * MaxChildCount + MaxChildCount + i] = bbox.max[d];
+    }
+
+    m_child_index[i] = static_cast<uint32>(node_index);
+
+    if (is_leaf)
+        m_leaf_mask |= 1UL << i;
+}
+
+template <typename AABB>
+inline void QNode<AABB>::set_child_bbox(const size_t i, const AABBType& bbox)
+{
+    assert(i < m_child_count);
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        m_bbox_data[d * 2 * MaxChildCount + i] = bbox.min[d];
+        m_bbox_data[d * 2 * MaxChildCount + MaxChildCount + i] = bbox.max[d];
+    }
+}
+
+template <typename AABB>
+inline AABB QNode<AABB>::get_child_bbox(const size_t i) const
+{
+    assert(i < m_child_count);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = m_bbox_data[d * 2 * MaxChildCount + i];
+        bbox.max[d] = m_bbox_data[d * 2 * MaxChildCount + MaxChildCount + i];
+    }
+
+    return bbox;
+}
+
+template <typename AABB>
+inline size_t QNode<AABB>::get_child_node_index(const size_t i) const
+{
+    assert(i < m_child_count);
+    return static_cast<size_t>(m_child_index[i]);
+}
+
+template <typename AABB>
+inline bool QNode<AABB>::is_child_leaf(const size_t i) const
+{
+    assert(i < m_child_count);
+    return (m_leaf_mask & (1UL << i)) != 0;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_QNODE_H
@@ -0,0 +1,146 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_QTREE_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_QTREE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// 4-wide Bounding Volume Hierarchy (QBVH).
+//
+// Interior nodes and leaf nodes are stored in two separate arrays. Leaf nodes
+// are regular binary BVH nodes so that the leaf visitors written for binary
+// trees can be used unchanged.
+//
+
+template <typename QNodeVector, typename NodeVector>
+class QTree
+  : public NonCopyable
+{
+  public:
+    typedef QNodeVector QNodeVectorType;
+    typedef NodeVector NodeVectorType;
+    typedef QTree<QNodeVectorType, NodeVectorType> QTreeType;
+    typedef typename QNodeVectorType::value_type QNodeType;
+    typedef typename NodeVectorType::value_type NodeType;
+    typedef typename QNodeVectorType::allocator_type QNodeAllocatorType;
+    typedef typename NodeVectorType::allocator_type NodeAllocatorType;
+
+    // Constructor.
+    explicit QTree(
+        const QNodeAllocatorType&   qnode_allocator = QNodeAllocatorType(),
+        const NodeAllocatorType&    node_allocator = NodeAllocatorType());
+
+    // Clear the tree.
+    void clear();
+
+    // Return true if the tree is empty.
+    bool empty() const;
+
+    // Return the number of interior nodes and leaf nodes.
+    size_t get_interior_node_count() const;
+    size_t get_leaf_node_count() const;
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+  protected:
+    template <typename Tree, typename QTree>
+    friend class Collapser;
+
+    template <typename QTree, typename Visitor, typename Ray, size_t StackSize, size_t N>
+    friend class QIntersector;
+
+    template <typename QTree>
+    friend class QRefitter;
+
+    QNodeVector     m_qnodes;
+    NodeVector      m_leaves;
+};
+
+
+//
+// QTree class implementation.
+//
+
+template <typename QNodeVector, typename NodeVector>
+QTree<QNodeVector, NodeVector>::QTree(
+    const QNodeAllocatorType&   qnode_allocator,
+    const NodeAllocatorType&    node_allocator)
+  : m_qnodes(qnode_allocator)
+  , m_leaves(node_allocator)
+{
+}
+
+template <typename QNodeVector, typename NodeVector>
+void QTree<QNodeVector, NodeVector>::clear()
+{
+    m_qnodes.clear();
+    m_leaves.clear();
+}
+
+template <typename QNodeVector, typename NodeVector>
+inline bool QTree<QNodeVector, NodeVector>::empty() const
+{
+    return m_qnodes.empty();
+}
+
+template <typename QNodeVector, typename NodeVector>
+inline size_t QTree<QNodeVector, NodeVector>::get_interior_node_count() const
+{
+    return m_qnodes.size();
+}
+
+template <typename QNodeVector, typename NodeVector>
+inline size_t QTree<QNodeVector, NodeVector>::get_leaf_node_count() const
+{
+    return m_leaves.size();
+}
+
+template <typename QNodeVector, typename NodeVector>
+size_t QTree<QNodeVector, NodeVector>::get_memory_size() const
+{
+    return
+          sizeof(*this)
+        + m_qnodes.capacity() * sizeof(QNodeType)
+        + m_leaves.capacity() * sizeof(NodeType);
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_QTREE_H
@@ -0,0 +1,454 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_REFITTER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_REFITTER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Refit a binary BVH or a 4-wide BVH to items that have moved.
+//
+// The bounding boxes of all nodes are recomputed bottom-up while the topology
+// of the tree is left unchanged. The leaf function is called once for each
+// leaf node and must return the bounding box of the items of that leaf:
+//
+//   AABBType operator()(NodeType& leaf);
+//
+// It receives a non-const leaf so that it can also update the data stored
+// in the leaf, if any.
+//
+// Refitting is much cheaper than rebuilding but the quality of the tree
+// degrades as items move away from their original position. The cost of
+// the tree according to the Surface Area Heuristic can be used to decide
+// when a refit tree should be rebuilt from scratch.
+//
+// Motion bounding boxes are not supported: only the static bounding boxes
+// stored in the nodes are updated.
+//
+
+template <typename Tree>
+class Refitter
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    // Constructor.
+    Refitter();
+
+    // Refit a tree, return the bounding box of the root node.
+    template <typename Timer, typename LeafFunc>
+    AABBType refit(
+        Tree&               tree,
+        LeafFunc&           leaf_func);
+
+    // Return the refit time.
+    double get_refit_time() const;
+
+    // Compute the SAH cost of a tree, relative to the surface area of its root node.
+    static ValueType compute_cost(
+        const Tree&         tree,
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost);
+
+  private:
+    double m_refit_time;
+
+    template <typename LeafFunc>
+    AABBType refit_recurse(
+        Tree&               tree,
+        const size_t        node_index,
+        LeafFunc&           leaf_func);
+
+    static ValueType compute_cost_recurse(
+        const Tree&         tree,
+        const NodeType&     node,
+        const AABBType&     bbox,
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost);
+};
+
+template <typename QTree>
+class QRefitter
+  : public NonCopyable
+{
+  public:
+    typedef typename QTree::QNodeType QNodeType;
+    typedef typename QTree::NodeType NodeType;
+    typedef typename QNodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    // Constructor.
+    QRefitter();
+
+    // Refit a 4-wide tree, return the bounding box of the root node.
+    template <typename Timer, typename LeafFunc>
+    AABBType refit(
+        QTree&              qtree,
+        LeafFunc&           leaf_func);
+
+    // Return the refit time.
+    double get_refit_time() const;
+
+    // Compute the SAH cost of a 4-wide tree, relative to the surface area of its root node.
+    static ValueType compute_cost(
+        const QTree&        qtree,
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost);
+
+  private:
+    double m_refit_time;
+
+    template <typename LeafFunc>
+    AABBType refit_recurse(
+        QTree&              qtree,
+        const size_t        qnode_index,
+        LeafFunc&           leaf_func);
+
+    static ValueType compute_cost_recurse(
+        const QTree&        qtree,
+        const size_t        qnode_index,
+        const ValueType     interior_node_traversal_cost,
+        const ValueType     item_intersection_cost);
+};
+
+
+//
+// Utility function.
+//
+
+namespace impl
+{
+    // Half surface area in 3D, generalized to any dimension.
+    template <typename AABBType>
+    typename AABBType::ValueType get_half_surface_area(const AABBType& bbox)
+    {
+        typedef typename AABBType::ValueType ValueType;
+
+        if (!bbox.is_valid())
+            return ValueType(0.0);
+
+        const typename AABBType::VectorType extent = bbox.extent();
+
+        ValueType area(0.0);
+
+        for (size_t i = 0; i < AABBType::Dimension; ++i)
+        {
+            for (size_t j = i + 1; j < AABBType::Dimension; ++j)
+                area += extent[i] * extent[j];
+        }
+
+        return area;
+    }
+}
+
+
+//
+// Refitter class implementation.
+//
+
+template <typename Tree>
+Refitter<Tree>::Refitter()
+  : m_refit_time(0.0)
+{
+}
+
+template <typename Tree>
+template <typename Timer, typename LeafFunc>
+typename Refitter<Tree>::AABBType Refitter<Tree>::refit(
+    Tree&                   tree,
+    LeafFunc&               leaf_func)
+{
+    assert(!tree.m_nodes.empty());
+
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Refit the tree.
+    const AABBType root_bbox = refit_recurse(tree, 0, leaf_func);
+
+    // Measure and save refit time.
+    stopwatch.measure();
+    m_refit_time = stopwatch.get_seconds();
+
+    return root_bbox;
+}
+
+template <typename Tree>
+inline double Refitter<Tree>::get_refit_time() const
+{
+    return m_refit_time;
+}
+
+template <typename Tree>
+typename Refitter<Tree>::ValueType Refitter<Tree>::compute_cost(
+    const Tree&             tree,
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost)
+{
+    assert(!tree.m_nodes.empty());
+
+    const NodeType& root = tree.m_nodes.front();
+
+    // A tree made of a single leaf: every item is intersected by every ray.
+    if (root.is_leaf())
+        return static_cast<ValueType>(root.get_item_count()) * item_intersection_cost;
+
+    AABBType root_bbox = root.get_left_bbox();
+    root_bbox.insert(root.get_right_bbox());
+
+    const ValueType root_area = impl::get_half_surface_area(root_bbox);
+
+    if (root_area == ValueType(0.0))
+        return ValueType(0.0);
+
+    return
+        compute_cost_recurse(
+            tree,
+            root,
+            root_bbox,
+            interior_node_traversal_cost,
+            item_intersection_cost) / root_area;
+}
+
+template <typename Tree>
+template <typename LeafFunc>
+typename Refitter<Tree>::AABBType Refitter<Tree>::refit_recurse(
+    Tree&                   tree,
+    const size_t            node_index,
+    LeafFunc&               leaf_func)
+{
+    NodeType& node = tree.m_nodes[node_index];
+
+    if (node.is_leaf())
+        return leaf_func(node);
+
+    const size_t child_index = node.get_child_node_index();
+    const AABBType left_bbox = refit_recurse(tree, child_index + 0, leaf_func);
+    const AABBType right_bbox = refit_recurse(tree, child_index + 1, leaf_func);
+
+    node.set_left_bbox(left_bbox);
+    node.set_right_bbox(right_bbox);
+
+    AABBType bbox = left_bbox;
+    bbox.insert(right_bbox);
+
+    return bbox;
+}
+
+template <typename Tree>
+typename Refitter<Tree>::ValueType Refitter<Tree>::compute_cost_recurse(
+    const Tree&             tree,
+    const NodeType&         node,
+    const AABBType&         bbox,
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost)
+{
+    const ValueType area = impl::get_half_surface_area(bbox);
+
+    if (node.is_leaf())
+        return area * static_cast<ValueType>(node.get_item_count()) * item_intersection_cost;
+
+    const size_t child_index = node.get_child_node_index();
+
+    return
+          area * interior_node_traversal_cost
+        + compute_cost_recurse(
+              tree,
+              tree.m_nodes[child_index + 0],
+              node.get_left_bbox(),
+              interior_node_traversal_cost,
+              item_intersection_cost)
+        + compute_cost_recurse(
+              tree,
+              tree.m_nodes[child_index + 1],
+              node.get_right_bbox(),
+              interior_node_traversal_cost,
+              item_intersection_cost);
+}
+
+
+//
+// QRefitter class implementation.
+//
+
+template <typename QTree>
+QRefitter<QTree>::QRefitter()
+  : m_refit_time(0.0)
+{
+}
+
+template <typename QTree>
+template <typename Timer, typename LeafFunc>
+typename QRefitter<QTree>::AABBType QRefitter<QTree>::refit(
+    QTree&                  qtree,
+    LeafFunc&               leaf_func)
+{
+    assert(!qtree.m_qnodes.empty());
+
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Refit the tree.
+    const AABBType root_bbox = refit_recurse(qtree, 0, leaf_func);
+
+    // Measure and save refit time.
+    stopwatch.measure();
+    m_refit_time = stopwatch.get_seconds();
+
+    return root_bbox;
+}
+
+template <typename QTree>
+inline double QRefitter<QTree>::get_refit_time() const
+{
+    return m_refit_time;
+}
+
+template <typename QTree>
+typename QRefitter<QTree>::ValueType QRefitter<QTree>::compute_cost(
+    const QTree&            qtree,
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost)
+{
+    assert(!qtree.m_qnodes.empty());
+
+    const QNodeType& root = qtree.m_qnodes.front();
+
+    // A tree made of a single leaf: every item is intersected by every ray.
+    if (root.get_child_count() == 1 && root.is_child_leaf(0))
+        return static_cast<ValueType>(qtree.m_leaves.front().get_item_count()) * item_intersection_cost;
+
+    AABBType root_bbox;
+    root_bbox.invalidate();
+
+    for (size_t i = 0; i < root.get_child_count(); ++i)
+        root_bbox.insert(root.get_child_bbox(i));
+
+    const ValueType root_area = impl::get_half_surface_area(root_bbox);
+
+    if (root_area == ValueType(0.0))
+        return ValueType(0.0);
+
+    return
+        compute_cost_recurse(
+            qtree,
+            0,
+            interior_node_traversal_cost,
+            item_intersection_cost) / root_area;
+}
+
+template <typename QTree>
+template <typename LeafFunc>
+typename QRefitter<QTree>::AABBType QRefitter<QTree>::refit_recurse(
+    QTree&                  qtree,
+    const size_t            qnode_index,
+    LeafFunc&               leaf_func)
+{
+    // The array of interior nodes doesn't change size during the refit,
+    // it's safe to keep a reference to the interior node.
+    QNodeType& qnode = qtree.m_qnodes[qnode_index];
+
+    AABBType bbox;
+    bbox.invalidate();
+
+    for (size_t i = 0; i < qnode.get_child_count(); ++i)
+    {
+        const size_t child_index = qnode.get_child_node_index(i);
+
+        const AABBType child_bbox =
+            qnode.is_child_leaf(i)
+                ? leaf_func(qtree.m_leaves[child_index])
+                : refit_recurse(qtree, child_index, leaf_func);
+
+        qnode.set_child_bbox(i, child_bbox);
+        bbox.insert(child_bbox);
+    }
+
+    return bbox;
+}
+
+template <typename QTree>
+typename QRefitter<QTree>::ValueType QRefitter<QTree>::compute_cost_recurse(
+    const QTree&            qtree,
+    const size_t            qnode_index,
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost)
+{
+    const QNodeType& qnode = qtree.m_qnodes[qnode_index];
+
+    AABBType bbox;
+    bbox.invalidate();
+
+    ValueType cost(0.0);
+
+    for (size_t i = 0; i < qnode.get_child_count(); ++i)
+    {
+        const AABBType child_bbox = qnode.get_child_bbox(i);
+        const size_t child_index = qnode.get_child_node_index(i);
+
+        if (qnode.is_child_leaf(i))
+        {
+            const ValueType item_count = static_cast<ValueType>(qtree.m_leaves[child_index].get_item_count());
+            cost += impl::get_half_surface_area(child_bbox) * item_count * item_intersection_cost;
+        }
+        else
+        {
+            cost +=
+                compute_cost_recurse(
+                    qtree,
+                    child_index,
+                    interior_node_traversal_cost,
+                    item_intersection_cost);
+        }
+
+        bbox.insert(child_bbox);
+    }
+
+    return cost + impl::get_half_surface_area(bbox) * interior_node_traversal_cost;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_REFITTER_H
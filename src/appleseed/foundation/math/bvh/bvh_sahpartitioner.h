@@ -129,7 +129,7 @@ size_t SAHPartitioner<AABBVector>::partition(
         for (size_t i = 0; i < count - 1; ++i)
         {
             bbox_accumulator.insert(bboxes[indices[begin + i]]);
-            m_left_areas[i] = half_surface_area(bbox_accumulator);
+            m_left_areas[begin + i] = half_surface_area(bbox_accumulator);
         }
 
         // Right-to-left sweep to accumulate bounding boxes, compute their surface area find the best partition.
@@ -140,7 +140,7 @@ size_t SAHPartitioner<AABBVector>::partition(
             bbox_accumulator.insert(bboxes[indices[begin + i]]);
 
             // Compute the cost of this partition.
-            const ValueType left_cost = m_left_areas[i - 1] * i;
+            const ValueType left_cost = m_left_areas[begin + i - 1] * i;
             const ValueType right_cost = half_surface_area(bbox_accumulator) * (count - i);
             const ValueType split_cost = left_cost + right_cost;
 
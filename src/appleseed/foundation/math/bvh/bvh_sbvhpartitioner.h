@@ -37,6 +37,9 @@
 #include "foundation/math/split.h"
 #include "foundation/platform/types.h"
 
+// boost headers.
+#include "boost/thread/mutex.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
@@ -74,6 +77,9 @@ namespace bvh {
 //              const AABBType&     bbox) const;
 //      };
 //
+// Distinct leaves may be split concurrently, in which case the methods
+// of the item handler will be called concurrently as well.
+//
 
 // When defined, additional costly correctness checks are enabled (only in Debug).
 #undef FOUNDATION_SBVH_DEEPCHECK
@@ -107,6 +113,9 @@ class SBVHPartitioner
         const ValueType             interior_node_traversal_cost = ValueType(1.0),
         const ValueType             item_intersection_cost = ValueType(1.0));
 
+    // Destructor.
+    ~SBVHPartitioner();
+
     // Create the root leaf of the tree. Ownership of the leaf is passed to the caller.
     LeafType* create_root_leaf() const;
 
@@ -143,6 +152,16 @@ class SBVHPartitioner
         size_t      m_exit_counter;     // number of items that end in this bin
     };
 
+    // Temporary storage used while splitting a leaf, one per concurrent split.
+    struct Scratch
+    {
+        std::vector<AABBType>       m_left_bboxes;
+        std::vector<Bin>            m_bins;
+        std::vector<uint8>          m_tags;
+        size_t                      m_spatial_split_count;
+        size_t                      m_object_split_count;
+    };
+
     ItemHandler&                    m_item_handler;
     const AABBVectorType&           m_bboxes;
     const size_t                    m_max_leaf_size;
@@ -152,22 +171,24 @@ class SBVHPartitioner
     const ValueType                 m_item_intersection_cost;
 
     ValueType                       m_root_bbox_rcp_sa;
-    std::vector<AABBType>           m_left_bboxes;
-    std::vector<Bin>                m_bins;
-    std::vector<uint8>              m_tags;
     std::vector<size_t>             m_final_indices;
 
-    size_t                          m_spatial_split_count;
-    size_t                          m_object_split_count;
+    boost::mutex                    m_scratch_mutex;
+    std::vector<Scratch*>           m_scratches;
+    std::vector<Scratch*>           m_free_scratches;
 
     void compute_root_bbox_surface_area();
 
+    Scratch* acquire_scratch();
+    void release_scratch(Scratch* scratch);
+
     ValueType compute_final_split_cost(
         const AABBType&             bbox,
         const double                cost) const;
 
     // Find the best object split for a given set of items.
     void find_object_split(
+        Scratch&                    scratch,
         LeafType&                   leaf,
         const AABBType&             leaf_bbox,
         AABBType&                   left_leaf_bbox,
@@ -178,6 +199,7 @@ class SBVHPartitioner
 
     // Find the best spatial split for a given set of items.
     void find_spatial_split(
+        Scratch&                    scratch,
         const LeafType&             leaf,
         const AABBType&             leaf_bbox,
         AABBType&                   left_leaf_bbox,
@@ -187,6 +209,7 @@ class SBVHPartitioner
 
     // Sort a set of items into two subsets according to a given object split.
     void object_sort(
+        Scratch&                    scratch,
         LeafType&                   leaf,
         const size_t                split_dim,
         const size_t                split_pivot,
@@ -225,15 +248,17 @@ SBVHPartitioner<ItemHandler, AABBVector>::SBVHPartitioner(
   , m_rcp_bin_count(ValueType(1.0) / bin_count)
   , m_interior_node_traversal_cost(interior_node_traversal_cost)
   , m_item_intersection_cost(item_intersection_cost)
-  , m_left_bboxes(bboxes.size() > 1 ? bboxes.size() - 1 : 0)
-  , m_bins(bin_count)
-  , m_tags(bboxes.size())
-  , m_spatial_split_count(0)
-  , m_object_split_count(0)
 {
     compute_root_bbox_surface_area();
 }
 
+template <typename ItemHandler, typename AABBVector>
+SBVHPartitioner<ItemHandler, AABBVector>::~SBVHPartitioner()
+{
+    for (size_t i = 0; i < m_scratches.size(); ++i)
+        delete m_scratches[i];
+}
+
 template <typename ItemHandler, typename AABBVector>
 typename SBVHPartitioner<ItemHandler, AABBVector>::LeafType* SBVHPartitioner<ItemHandler, AABBVector>::create_root_leaf() const
 {
@@ -298,6 +323,8 @@ bool SBVHPartitioner<ItemHandler, AABBVector>::split(
     if (leaf.m_indices[0].size() < 2)
         return false;
 
+    Scratch* scratch = acquire_scratch();
+
     // Find the best object split.
     AABBType object_split_left_bbox;
     AABBType object_split_right_bbox;
@@ -305,6 +332,7 @@ bool SBVHPartitioner<ItemHandler, AABBVector>::split(
     size_t object_split_pivot;
     ValueType object_split_cost = std::numeric_limits<ValueType>::max();
     find_object_split(
+        *scratch,
         leaf,
         leaf_bbox,
         object_split_left_bbox,
@@ -339,6 +367,7 @@ bool SBVHPartitioner<ItemHandler, AABBVector>::split(
     if (do_find_spatial_split)
     {
         find_spatial_split(
+            *scratch,
             leaf,
             leaf_bbox,
             spatial_split_left_bbox,
@@ -351,10 +380,11 @@ bool SBVHPartitioner<ItemHandler, AABBVector>::split(
     const ValueType leaf_cost = leaf.size() * m_item_intersection_cost;
 
     // Select the cheapest option.
+    bool split;
     if (leaf_cost <= object_split_cost && leaf_cost <= spatial_split_cost)
     {
         // Don't split, make a leaf.
-        return false;
+        split = false;
     }
     else if (object_split_cost <= spatial_split_cost)
     {
@@ -362,6 +392,7 @@ bool SBVHPartitioner<ItemHandler, AABBVector>::split(
         left_leaf_bbox = object_split_left_bbox;
         right_leaf_bbox = object_split_right_bbox;
         object_sort(
+            *scratch,
             leaf,
             object_split_dim,
             object_split_pivot,
@@ -369,8 +400,8 @@ bool SBVHPartitioner<ItemHandler, AABBVector>::split(
             right_leaf_bbox,
             left_leaf,
             right_leaf);
-        ++m_object_split_count;
-        return true;
+        ++scratch->m_object_split_count;
+        split = true;
     }
     else
     {
@@ -384,9 +415,13 @@ bool SBVHPartitioner<ItemHandler, AABBVector>::split(
             right_leaf_bbox,
             left_leaf,
             right_leaf);
-        ++m_spatial_split_count;
-        return true;
+        ++scratch->m_spatial_split_count;
+        split = true;
     }
+
+    release_scratch(scratch);
+
+    return split;
 }
 
 template <typename ItemHandler, typename AABBVector>
@@ -406,6 +441,35 @@ void SBVHPartitioner<ItemHandler, AABBVector>::compute_root_bbox_surface_area()
             : ValueType(0.0);
 }
 
+template <typename ItemHandler, typename AABBVector>
+typename SBVHPartitioner<ItemHandler, AABBVector>::Scratch* SBVHPartitioner<ItemHandler, AABBVector>::acquire_scratch()
+{
+    boost::mutex::scoped_lock lock(m_scratch_mutex);
+
+    if (!m_free_scratches.empty())
+    {
+        Scratch* scratch = m_free_scratches.back();
+        m_free_scratches.pop_back();
+        return scratch;
+    }
+
+    Scratch* scratch = new Scratch();
+    scratch->m_bins.resize(m_bin_count);
+    scratch->m_spatial_split_count = 0;
+    scratch->m_object_split_count = 0;
+    m_scratches.push_back(scratch);
+
+    return scratch;
+}
+
+template <typename ItemHandler, typename AABBVector>
+void SBVHPartitioner<ItemHandler, AABBVector>::release_scratch(Scratch* scratch)
+{
+    boost::mutex::scoped_lock lock(m_scratch_mutex);
+
+    m_free_scratches.push_back(scratch);
+}
+
 template <typename ItemHandler, typename AABBVector>
 inline typename AABBVector::value_type::ValueType SBVHPartitioner<ItemHandler, AABBVector>::compute_final_split_cost(
     const AABBType&                 bbox,
@@ -427,6 +491,7 @@ inline typename AABBVector::value_type::ValueType SBVHPartitioner<ItemHandler, A
 
 template <typename ItemHandler, typename AABBVector>
 void SBVHPartitioner<ItemHandler, AABBVector>::find_object_split(
+    Scratch&                        scratch,
     LeafType&                       leaf,
     const AABBType&                 leaf_bbox,
     AABBType&                       left_leaf_bbox,
@@ -435,6 +500,10 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_object_split(
     size_t&                         best_split_pivot,
     ValueType&                      best_split_cost)
 {
+    std::vector<AABBType>& left_bboxes = scratch.m_left_bboxes;
+    if (left_bboxes.size() < leaf.size() - 1)
+        left_bboxes.resize(leaf.size() - 1);
+
     for (size_t d = 0; d < Dimension; ++d)
     {
         const std::vector<size_t>& indices = leaf.m_indices[d];
@@ -451,7 +520,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_object_split(
             const AABBType clipped_item_bbox = AABBType::intersect(item_bbox, leaf_bbox);
             assert(clipped_item_bbox.is_valid());
             bbox_accumulator.insert(clipped_item_bbox);
-            m_left_bboxes[i] = bbox_accumulator;
+            left_bboxes[i] = bbox_accumulator;
         }
 
         // Right-to-left sweep to accumulate bounding boxes, compute their surface area find the best partition.
@@ -466,7 +535,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_object_split(
             bbox_accumulator.insert(clipped_item_bbox);
 
             // Compute the cost of this partition.
-            const ValueType left_cost = half_surface_area(m_left_bboxes[i - 1]) * i;
+            const ValueType left_cost = half_surface_area(left_bboxes[i - 1]) * i;
             const ValueType right_cost = half_surface_area(bbox_accumulator) * (item_count - i);
             const ValueType split_cost = left_cost + right_cost;
 
@@ -476,7 +545,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_object_split(
                 best_split_cost = split_cost;
                 best_split_dim = d;
                 best_split_pivot = i;
-                left_leaf_bbox = m_left_bboxes[i - 1];
+                left_leaf_bbox = left_bboxes[i - 1];
                 right_leaf_bbox = bbox_accumulator;
             }
         }
@@ -487,6 +556,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_object_split(
 
 template <typename ItemHandler, typename AABBVector>
 void SBVHPartitioner<ItemHandler, AABBVector>::find_spatial_split(
+    Scratch&                        scratch,
     const LeafType&                 leaf,
     const AABBType&                 leaf_bbox,
     AABBType&                       left_leaf_bbox,
@@ -494,6 +564,8 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_spatial_split(
     SplitType&                      best_split,
     ValueType&                      best_split_cost)
 {
+    std::vector<Bin>& bins = scratch.m_bins;
+
     for (size_t d = 0; d < Dimension; ++d)
     {
         const std::vector<size_t>& indices = leaf.m_indices[d];
@@ -512,7 +584,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_spatial_split(
         // Clear the bins.
         for (size_t i = 0; i < m_bin_count; ++i)
         {
-            Bin& bin = m_bins[i];
+            Bin& bin = bins[i];
             bin.m_bin_bbox.invalidate();
             bin.m_entry_counter = 0;
             bin.m_exit_counter = 0;
@@ -556,21 +628,21 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_spatial_split(
                 assert(item_clipped_bbox.is_valid());
 
                 // Grow the bounding box associated with this bin.
-                m_bins[b].m_bin_bbox.insert(item_clipped_bbox);
+                bins[b].m_bin_bbox.insert(item_clipped_bbox);
             }
 
             // Update the enter/leave counters.
-            ++m_bins[begin_bin].m_entry_counter;
-            ++m_bins[end_bin].m_exit_counter;
+            ++bins[begin_bin].m_entry_counter;
+            ++bins[end_bin].m_exit_counter;
         }
 
         AABBType bbox_accumulator;
 
         // Left-to-right sweep to compute the left bounding boxes.
-        bbox_accumulator = m_bins[0].m_bin_bbox;
+        bbox_accumulator = bins[0].m_bin_bbox;
         for (size_t i = 1; i < m_bin_count; ++i)
         {
-            Bin& bin = m_bins[i];
+            Bin& bin = bins[i];
             bin.m_left_bbox = bbox_accumulator;
             bbox_accumulator.insert(bin.m_bin_bbox);
         }
@@ -581,7 +653,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_spatial_split(
         bbox_accumulator.invalidate();
         for (size_t i = m_bin_count - 1; i > 0; --i)
         {
-            const Bin& bin = m_bins[i];
+            const Bin& bin = bins[i];
 
             // Compute the right bounding box.
             bbox_accumulator.insert(bin.m_bin_bbox);
@@ -623,6 +695,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_spatial_split(
 
 template <typename ItemHandler, typename AABBVector>
 void SBVHPartitioner<ItemHandler, AABBVector>::object_sort(
+    Scratch&                        scratch,
     LeafType&                       leaf,
     const size_t                    split_dim,
     const size_t                    split_pivot,
@@ -634,13 +707,17 @@ void SBVHPartitioner<ItemHandler, AABBVector>::object_sort(
     const std::vector<size_t>& split_indices = leaf.m_indices[split_dim];
     const size_t size = split_indices.size();
 
+    std::vector<uint8>& tags = scratch.m_tags;
+    if (tags.size() < m_bboxes.size())
+        tags.resize(m_bboxes.size());
+
     enum { Left = 0, Right = 1 };
 
     for (size_t i = 0; i < split_pivot; ++i)
-        m_tags[split_indices[i]] = Left;
+        tags[split_indices[i]] = Left;
 
     for (size_t i = split_pivot; i < size; ++i)
-        m_tags[split_indices[i]] = Right;
+        tags[split_indices[i]] = Right;
 
     for (size_t d = 0; d < Dimension; ++d)
     {
@@ -680,7 +757,7 @@ void SBVHPartitioner<ItemHandler, AABBVector>::object_sort(
             {
                 const size_t item_index = leaf.m_indices[d][i];
 
-                if (m_tags[item_index] == Left)
+                if (tags[item_index] == Left)
                 {
                     assert(left < split_pivot);
                     left_leaf.m_indices[d][left++] = item_index;
@@ -796,13 +873,23 @@ inline const std::vector<size_t>& SBVHPartitioner<ItemHandler, AABBVector>::get_
 template <typename ItemHandler, typename AABBVector>
 inline size_t SBVHPartitioner<ItemHandler, AABBVector>::get_spatial_split_count() const
 {
-    return m_spatial_split_count;
+    size_t count = 0;
+
+    for (size_t i = 0; i < m_scratches.size(); ++i)
+        count += m_scratches[i]->m_spatial_split_count;
+
+    return count;
 }
 
 template <typename ItemHandler, typename AABBVector>
 inline size_t SBVHPartitioner<ItemHandler, AABBVector>::get_object_split_count() const
 {
-    return m_object_split_count;
+    size_t count = 0;
+
+    for (size_t i = 0; i < m_scratches.size(); ++i)
+        count += m_scratches[i]->m_object_split_count;
+
+    return count;
 }
 
 }       // namespace bvh
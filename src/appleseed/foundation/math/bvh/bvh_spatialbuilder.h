@@ -32,9 +32,15 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log/logger.h"
 #include "foundation/utility/stopwatch.h"
 
+// boost headers.
+#include "boost/thread/mutex.hpp"
+
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <vector>
@@ -70,6 +76,9 @@ namespace bvh {
 //          size_t store(const LeafType& leaf);
 //      };
 //
+// When the tree is built with more than one thread, split() will be called
+// concurrently on distinct leaves.
+//
 
 template <typename Tree, typename Partitioner>
 class SpatialBuilder
@@ -89,19 +98,122 @@ class SpatialBuilder
         Tree&               tree,
         Partitioner&        partitioner,
         LeafType*           root_leaf,
-        const AABBType&     root_leaf_bbox);
+        const AABBType&     root_leaf_bbox,
+        const size_t        thread_count = 1);
 
     // Return the construction time.
     double get_build_time() const;
 
+    // Return the time spent merging subtrees built in parallel into the tree.
+    double get_merge_time() const;
+
+    // Return the time spent storing the leaves.
+    double get_store_time() const;
+
+    // Return the number of subtrees built in parallel.
+    size_t get_subtree_count() const;
+
   private:
+    typedef typename Tree::NodeVectorType NodeVectorType;
     typedef std::vector<const LeafType*> LeafVector;
 
-    double m_build_time;
+    // Leaves smaller than this are never built in parallel.
+    static const size_t MinParallelItemCount = 1024;
+
+    struct Subtree
+    {
+        size_t          m_node_index;
+        NodeVectorType  m_nodes;
+        LeafVector      m_leaves;
+
+        Subtree(
+            const size_t                                node_index,
+            const typename NodeVectorType::allocator_type& allocator)
+          : m_node_index(node_index)
+          , m_nodes(allocator)
+        {
+        }
+    };
+
+    struct SubtreeOrderPredicate
+    {
+        bool operator()(const Subtree* lhs, const Subtree* rhs) const
+        {
+            return lhs->m_node_index < rhs->m_node_index;
+        }
+    };
+
+    class SubdivideJob
+      : public IJob
+    {
+      public:
+        SubdivideJob(
+            SpatialBuilder&     builder,
+            Tree&               tree,
+            Partitioner&        partitioner,
+            LeafType*           leaf,
+            const AABBType&     leaf_bbox,
+            const size_t        leaf_node_index,
+            const size_t        depth)
+          : m_builder(builder)
+          , m_tree(tree)
+          , m_partitioner(partitioner)
+          , m_leaf(leaf)
+          , m_leaf_bbox(leaf_bbox)
+          , m_leaf_node_index(leaf_node_index)
+          , m_depth(depth)
+        {
+        }
+
+        virtual void execute(const size_t thread_index)
+        {
+            m_builder.subdivide_parallel(
+                m_tree,
+                m_partitioner,
+                m_leaf,
+                m_leaf_bbox,
+                m_leaf_node_index,
+                m_depth);
+        }
+
+      private:
+        SpatialBuilder&         m_builder;
+        Tree&                   m_tree;
+        Partitioner&            m_partitioner;
+        LeafType*               m_leaf;
+        const AABBType          m_leaf_bbox;
+        const size_t            m_leaf_node_index;
+        const size_t            m_depth;
+    };
+
+    double                  m_build_time;
+    double                  m_merge_time;
+    double                  m_store_time;
+    size_t                  m_subtree_count;
+
+    // State of a parallel build.
+    JobQueue*               m_job_queue;
+    size_t                  m_parallel_threshold;
+    boost::mutex            m_mutex;
+    std::vector<Subtree*>   m_subtrees;
+
+    // Recursively subdivide the tree, scheduling a new job for each large enough subtree.
+    void subdivide_parallel(
+        Tree&               tree,
+        Partitioner&        partitioner,
+        LeafType*           leaf,
+        const AABBType&     leaf_bbox,
+        const size_t        leaf_node_index,
+        const size_t        depth);
+
+    // Splice the subtrees built in parallel into the tree.
+    void merge_subtrees(
+        Tree&               tree,
+        LeafVector&         leaves);
 
     // Recursively subdivide the tree.
     void subdivide_recurse(
-        Tree&               tree,
+        NodeVectorType&     nodes,
         Partitioner&        partitioner,
         LeafVector&         leaves,
         LeafType*           leaf,
@@ -118,6 +230,11 @@ class SpatialBuilder
 template <typename Tree, typename Partitioner>
 SpatialBuilder<Tree, Partitioner>::SpatialBuilder()
   : m_build_time(0.0)
+  , m_merge_time(0.0)
+  , m_store_time(0.0)
+  , m_subtree_count(0)
+  , m_job_queue(0)
+  , m_parallel_threshold(0)
 {
 }
 
@@ -127,7 +244,8 @@ void SpatialBuilder<Tree, Partitioner>::build(
     Tree&                   tree,
     Partitioner&            partitioner,
     LeafType*               root_leaf,
-    const AABBType&         root_leaf_bbox)
+    const AABBType&         root_leaf_bbox,
+    const size_t            thread_count)
 {
     // Start stopwatch.
     Stopwatch<Timer> stopwatch;
@@ -141,18 +259,65 @@ void SpatialBuilder<Tree, Partitioner>::build(
 
     // todo: preallocate node memory?
 
-    // Recursively subdivide the tree.
+    m_merge_time = 0.0;
+    m_subtree_count = 0;
+
+    // Split the items into a few times more subtrees than there are threads to balance the load.
+    const size_t size = root_leaf->size();
+    m_parallel_threshold =
+        thread_count > 1 && size / (4 * thread_count) > MinParallelItemCount
+            ? size / (4 * thread_count)
+            : MinParallelItemCount;
+
     LeafVector leaves;
-    subdivide_recurse(
-        tree,
-        partitioner,
-        leaves,
-        root_leaf,
-        root_leaf_bbox,
-        0,
-        0);
+
+    if (thread_count > 1 && size > m_parallel_threshold)
+    {
+        // Recursively subdivide the tree in parallel.
+        JobQueue job_queue;
+        m_job_queue = &job_queue;
+        job_queue.schedule(
+            new SubdivideJob(
+                *this,
+                tree,
+                partitioner,
+                root_leaf,
+                root_leaf_bbox,
+                0,
+                0));
+        Logger logger;
+        JobManager job_manager(
+            logger,
+            job_queue,
+            thread_count,
+            JobManager::KeepRunningOnEmptyQueue);
+        job_manager.start();
+        job_queue.wait_until_completion();
+        m_job_queue = 0;
+
+        // Assemble the final tree.
+        Stopwatch<Timer> merge_stopwatch;
+        merge_stopwatch.start();
+        merge_subtrees(tree, leaves);
+        merge_stopwatch.measure();
+        m_merge_time = merge_stopwatch.get_seconds();
+    }
+    else
+    {
+        // Recursively subdivide the tree.
+        subdivide_recurse(
+            tree.m_nodes,
+            partitioner,
+            leaves,
+            root_leaf,
+            root_leaf_bbox,
+            0,
+            0);
+    }
 
     // Store the leaves.
+    Stopwatch<Timer> store_stopwatch;
+    store_stopwatch.start();
     const size_t node_count = tree.m_nodes.size();
     for (size_t i = 0; i < node_count; ++i)
     {
@@ -164,6 +329,8 @@ void SpatialBuilder<Tree, Partitioner>::build(
             delete leaf;
         }
     }
+    store_stopwatch.measure();
+    m_store_time = store_stopwatch.get_seconds();
 
     // Measure and save construction time.
     stopwatch.measure();
@@ -177,8 +344,177 @@ inline double SpatialBuilder<Tree, Partitioner>::get_build_time() const
 }
 
 template <typename Tree, typename Partitioner>
-void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
+inline double SpatialBuilder<Tree, Partitioner>::get_merge_time() const
+{
+    return m_merge_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline double SpatialBuilder<Tree, Partitioner>::get_store_time() const
+{
+    return m_store_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline size_t SpatialBuilder<Tree, Partitioner>::get_subtree_count() const
+{
+    return m_subtree_count;
+}
+
+template <typename Tree, typename Partitioner>
+void SpatialBuilder<Tree, Partitioner>::subdivide_parallel(
+    Tree&                   tree,
+    Partitioner&            partitioner,
+    LeafType*               leaf,
+    const AABBType&         leaf_bbox,
+    const size_t            leaf_node_index,
+    const size_t            depth)
+{
+    // Build small enough subtrees on their own, they will be merged into the tree later.
+    Subtree* subtree = 0;
+    if (leaf->size() <= m_parallel_threshold)
+    {
+        subtree = new Subtree(leaf_node_index, tree.m_nodes.get_allocator());
+        subtree->m_nodes.push_back(NodeType());
+        subdivide_recurse(
+            subtree->m_nodes,
+            partitioner,
+            subtree->m_leaves,
+            leaf,
+            leaf_bbox,
+            0,
+            depth);
+    }
+    else
+    {
+        // Try to split the leaf.
+        LeafType* left_leaf = new LeafType();
+        LeafType* right_leaf = new LeafType();
+        AABBType left_leaf_bbox, right_leaf_bbox;
+        const bool split =
+            partitioner.split(
+                *leaf,
+                leaf_bbox,
+                *left_leaf,
+                left_leaf_bbox,
+                *right_leaf,
+                right_leaf_bbox);
+
+        if (split)
+        {
+            // Get rid of the current leaf.
+            delete leaf;
+
+            size_t left_node_index;
+
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+
+                // Compute the indices of the child nodes.
+                left_node_index = tree.m_nodes.size();
+
+                // Turn the current node into an interior node.
+                NodeType& node = tree.m_nodes[leaf_node_index];
+                node.make_interior();
+                node.set_left_bbox(left_leaf_bbox);
+                node.set_right_bbox(right_leaf_bbox);
+                node.set_child_node_index(left_node_index);
+
+                // Create the child nodes.
+                tree.m_nodes.push_back(NodeType());
+                tree.m_nodes.push_back(NodeType());
+            }
+
+            // Hand the right subtree over to another thread.
+            m_job_queue->schedule(
+                new SubdivideJob(
+                    *this,
+                    tree,
+                    partitioner,
+                    right_leaf,
+                    right_leaf_bbox,
+                    left_node_index + 1,
+                    depth + 1));
+
+            // Keep going with the left subtree.
+            subdivide_parallel(
+                tree,
+                partitioner,
+                left_leaf,
+                left_leaf_bbox,
+                left_node_index,
+                depth + 1);
+
+            return;
+        }
+
+        // Get rid of the child nodes.
+        delete left_leaf;
+        delete right_leaf;
+
+        // The current node becomes a single leaf subtree.
+        subtree = new Subtree(leaf_node_index, tree.m_nodes.get_allocator());
+        NodeType node;
+        node.make_leaf();
+        node.set_item_index(0);
+        node.set_item_count(leaf->size());
+        subtree->m_nodes.push_back(node);
+        subtree->m_leaves.push_back(leaf);
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_subtrees.push_back(subtree);
+}
+
+template <typename Tree, typename Partitioner>
+void SpatialBuilder<Tree, Partitioner>::merge_subtrees(
     Tree&                   tree,
+    LeafVector&             leaves)
+{
+    // Merge subtrees in a deterministic order.
+    std::sort(m_subtrees.begin(), m_subtrees.end(), SubtreeOrderPredicate());
+
+    for (size_t i = 0; i < m_subtrees.size(); ++i)
+    {
+        const Subtree* subtree = m_subtrees[i];
+        const NodeVectorType& nodes = subtree->m_nodes;
+
+        // Node n > 0 of the subtree becomes node n + node_offset of the tree.
+        const size_t node_offset = tree.m_nodes.size() - 1;
+        const size_t leaf_offset = leaves.size();
+
+        for (size_t j = 0; j < nodes.size(); ++j)
+        {
+            NodeType* node;
+            if (j == 0)
+            {
+                // The root of the subtree replaces the node it was built for.
+                node = &tree.m_nodes[subtree->m_node_index];
+                *node = nodes[0];
+            }
+            else
+            {
+                tree.m_nodes.push_back(nodes[j]);
+                node = &tree.m_nodes.back();
+            }
+
+            if (node->is_interior())
+                node->set_child_node_index(node->get_child_node_index() + node_offset);
+            else node->set_item_index(node->get_item_index() + leaf_offset);
+        }
+
+        leaves.insert(leaves.end(), subtree->m_leaves.begin(), subtree->m_leaves.end());
+
+        delete subtree;
+    }
+
+    m_subtree_count = m_subtrees.size();
+    m_subtrees.clear();
+}
+
+template <typename Tree, typename Partitioner>
+void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
+    NodeVectorType&         nodes,
     Partitioner&            partitioner,
     LeafVector&             leaves,
     LeafType*               leaf,
@@ -186,7 +522,7 @@ void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
     const size_t            leaf_node_index,
     const size_t            depth)
 {
-    assert(leaf_node_index < tree.m_nodes.size());
+    assert(leaf_node_index < nodes.size());
 
     // Try to split the leaf.
     LeafType* left_leaf = new LeafType();
@@ -207,23 +543,23 @@ void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
         delete leaf;
 
         // Compute the indices of the child nodes.
-        const size_t left_node_index = tree.m_nodes.size();
+        const size_t left_node_index = nodes.size();
         const size_t right_node_index = left_node_index + 1;
 
         // Turn the current node into an interior node.
-        NodeType& node = tree.m_nodes[leaf_node_index];
+        NodeType& node = nodes[leaf_node_index];
         node.make_interior();
         node.set_left_bbox(left_leaf_bbox);
         node.set_right_bbox(right_leaf_bbox);
         node.set_child_node_index(left_node_index);
 
         // Create the child nodes.
-        tree.m_nodes.push_back(NodeType());
-        tree.m_nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
 
         // Recurse into the left subtree.
         subdivide_recurse(
-            tree,
+            nodes,
             partitioner,
             leaves,
             left_leaf,
@@ -233,7 +569,7 @@ void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
 
         // Recurse into the right subtree.
         subdivide_recurse(
-            tree,
+            nodes,
             partitioner,
             leaves,
             right_leaf,
@@ -248,7 +584,7 @@ void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
         delete right_leaf;
 
         // Turn the current node into a leaf node.
-        NodeType& node = tree.m_nodes[leaf_node_index];
+        NodeType& node = nodes[leaf_node_index];
         node.make_leaf();
         node.set_item_index(leaves.size());
         node.set_item_count(leaf->size());
@@ -69,6 +69,12 @@ class Tree
     template <typename Tree, typename Partitioner>
     friend class SpatialBuilder;
 
+    template <typename Tree, typename QTree>
+    friend class Collapser;
+
+    template <typename Tree>
+    friend class Refitter;
+
     template <typename Tree>
     friend class TreeStatistics;
 
@@ -38,6 +38,9 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/split.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
@@ -75,6 +78,13 @@ class Builder
     void build_move_points(
         std::vector<VectorType>&    points);
 
+    // Like build_move_points() but the tree is built in parallel using a given job queue.
+    // The resulting tree is identical, except for the order of the nodes in memory.
+    template <typename Timer>
+    void build_move_points(
+        std::vector<VectorType>&    points,
+        JobQueue&                   job_queue);
+
     // Return the construction time.
     double get_build_time() const;
 
@@ -98,14 +108,57 @@ class Builder
             const size_t            index) const;
     };
 
+    typedef std::vector<NodeType> NodeVector;
+
+    // A range of points attached to a node whose subtree remains to be built.
+    struct PendingNode
+    {
+        size_t                      m_node_index;
+        size_t                      m_begin;
+        size_t                      m_end;
+        SplitType                   m_split;
+        size_t                      m_pivot;
+    };
+
+    typedef std::vector<PendingNode> PendingNodeVector;
+
+    class SplitJob;
+    class SubtreeJob;
+
     TreeType&   m_tree;
     double      m_build_time;
 
+    void initialize_tree(
+        std::vector<VectorType>&    points);
+
+    void finalize_tree();
+
+    void build_parallel(JobQueue& job_queue);
+
     void partition(
+        NodeVector&                 nodes,
         const size_t                parent_node_index,
         const size_t                begin,
         const size_t                end) const;
 
+    // Partition the points of a range of at least two points and return the pivot.
+    size_t split(
+        const size_t                begin,
+        const size_t                end,
+        SplitType&                  split) const;
+
+    static void make_interior_node(
+        NodeType&                   node,
+        const SplitType&            split,
+        const size_t                child_node_index,
+        const size_t                begin,
+        const size_t                end);
+
+    static void make_leaf_node(
+        NodeType&                   node,
+        const size_t                begin,
+        const size_t                end);
+
     BboxType compute_bbox(
         const size_t                begin,
         const size_t                end) const;
@@ -153,6 +206,107 @@ void Builder<T, N>::build_move_points(
     Stopwatch<Timer> stopwatch;
     stopwatch.start();
 
+    initialize_tree(points);
+    partition(m_tree.m_nodes, 0, 0, m_tree.m_points.size());
+    finalize_tree();
+
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename T, size_t N>
+template <typename Timer>
+void Builder<T, N>::build_move_points(
+    std::vector<VectorType>&    points,
+    JobQueue&                   job_queue)
+{
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    initialize_tree(points);
+    build_parallel(job_queue);
+    finalize_tree();
+
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename T, size_t N>
+inline double Builder<T, N>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename T, size_t N>
+inline Builder<T, N>::PartitionPredicate::PartitionPredicate(
+    const PointVector&          points,
+    const SplitType&            split)
+  : m_points(points)
+  , m_split(split)
+{
+}
+
+template <typename T, size_t N>
+inline bool Builder<T, N>::PartitionPredicate::operator()(
+    const size_t                index) const
+{
+    return m_points[index][m_split.m_dimension] < m_split.m_abscissa;
+}
+
+template <typename T, size_t N>
+class Builder<T, N>::SplitJob
+  : public IJob
+{
+  public:
+    SplitJob(
+        const Builder&              builder,
+        PendingNode&                node)
+      : m_builder(builder)
+      , m_node(node)
+    {
+    }
+
+    virtual void execute(const size_t thread_index) OVERRIDE
+    {
+        m_node.m_pivot = m_builder.split(m_node.m_begin, m_node.m_end, m_node.m_split);
+    }
+
+  private:
+    const Builder&                  m_builder;
+    PendingNode&                    m_node;
+};
+
+template <typename T, size_t N>
+class Builder<T, N>::SubtreeJob
+  : public IJob
+{
+  public:
+    SubtreeJob(
+        const Builder&              builder,
+        const PendingNode&          node,
+        NodeVector&                 nodes)
+      : m_builder(builder)
+      , m_node(node)
+      , m_nodes(nodes)
+    {
+    }
+
+    virtual void execute(const size_t thread_index) OVERRIDE
+    {
+        m_nodes.push_back(NodeType());
+        m_builder.partition(m_nodes, 0, m_node.m_begin, m_node.m_end);
+    }
+
+  private:
+    const Builder&                  m_builder;
+    const PendingNode&              m_node;
+    NodeVector&                     m_nodes;
+};
+
+template <typename T, size_t N>
+void Builder<T, N>::initialize_tree(
+    std::vector<VectorType>&    points)
+{
     const size_t count = points.size();
 
     if (count > 0)
@@ -167,8 +321,12 @@ void Builder<T, N>::build_move_points(
 
     m_tree.m_nodes.reserve(count * 2 + 1);
     m_tree.m_nodes.push_back(NodeType());
+}
 
-    partition(0, 0, count);
+template <typename T, size_t N>
+void Builder<T, N>::finalize_tree()
+{
+    const size_t count = m_tree.m_points.size();
 
     if (count > 0)
     {
@@ -180,88 +338,200 @@ void Builder<T, N>::build_move_points(
             &m_tree.m_indices[0],
             count);
     }
-
-    stopwatch.measure();
-    m_build_time = stopwatch.get_seconds();
 }
 
 template <typename T, size_t N>
-inline double Builder<T, N>::get_build_time() const
+void Builder<T, N>::build_parallel(JobQueue& job_queue)
 {
-    return m_build_time;
-}
+    // Nodes with fewer points are built serially.
+    const size_t MinParallelPointCount = 16 * 1024;
 
-template <typename T, size_t N>
-inline Builder<T, N>::PartitionPredicate::PartitionPredicate(
-    const PointVector&          points,
-    const SplitType&            split)
-  : m_points(points)
-  , m_split(split)
-{
-}
+    // Maximum depth of the nodes built level by level, in parallel within each level.
+    const size_t MaxParallelDepth = 8;
 
-template <typename T, size_t N>
-inline bool Builder<T, N>::PartitionPredicate::operator()(
-    const size_t                index) const
-{
-    return m_points[index][m_split.m_dimension] < m_split.m_abscissa;
+    PendingNodeVector pending_nodes(1);
+    pending_nodes[0].m_node_index = 0;
+    pending_nodes[0].m_begin = 0;
+    pending_nodes[0].m_end = m_tree.m_points.size();
+
+    // Build the top levels of the tree: the points of all the nodes of a level are partitioned in parallel.
+    for (size_t depth = 0; depth < MaxParallelDepth && !pending_nodes.empty(); ++depth)
+    {
+        bool large_nodes = false;
+
+        for (size_t i = 0; i < pending_nodes.size(); ++i)
+        {
+            if (pending_nodes[i].m_end - pending_nodes[i].m_begin >= MinParallelPointCount)
+                large_nodes = true;
+        }
+
+        if (!large_nodes)
+            break;
+
+        for (size_t i = 0; i < pending_nodes.size(); ++i)
+        {
+            if (pending_nodes[i].m_end - pending_nodes[i].m_begin > 1)
+                job_queue.schedule(new SplitJob(*this, pending_nodes[i]));
+        }
+
+        job_queue.wait_until_completion();
+
+        PendingNodeVector next_pending_nodes;
+
+        for (size_t i = 0; i < pending_nodes.size(); ++i)
+        {
+            const PendingNode& node = pending_nodes[i];
+
+            if (node.m_end - node.m_begin <= 1)
+            {
+                make_leaf_node(m_tree.m_nodes[node.m_node_index], node.m_begin, node.m_end);
+                continue;
+            }
+
+            const size_t left_node_index = m_tree.m_nodes.size();
+
+            m_tree.m_nodes.push_back(NodeType());
+            m_tree.m_nodes.push_back(NodeType());
+
+            make_interior_node(
+                m_tree.m_nodes[node.m_node_index],
+                node.m_split,
+                left_node_index,
+                node.m_begin,
+                node.m_end);
+
+            PendingNode left_node;
+            left_node.m_node_index = left_node_index;
+            left_node.m_begin = node.m_begin;
+            left_node.m_end = node.m_pivot;
+            next_pending_nodes.push_back(left_node);
+
+            PendingNode right_node;
+            right_node.m_node_index = left_node_index + 1;
+            right_node.m_begin = node.m_pivot;
+            right_node.m_end = node.m_end;
+            next_pending_nodes.push_back(right_node);
+        }
+
+        pending_nodes.swap(next_pending_nodes);
+    }
+
+    // Build the remaining subtrees in parallel, each into its own node array.
+    const size_t subtree_count = pending_nodes.size();
+    std::vector<NodeVector> subtrees(subtree_count);
+
+    for (size_t i = 0; i < subtree_count; ++i)
+        job_queue.schedule(new SubtreeJob(*this, pending_nodes[i], subtrees[i]));
+
+    job_queue.wait_until_completion();
+
+    // Append the subtrees to the tree. The root of a subtree replaces the node
+    // it was built for, the other nodes of the subtree are moved to the end of
+    // the tree and their child node indices are offset accordingly.
+    for (size_t i = 0; i < subtree_count; ++i)
+    {
+        const NodeVector& subtree = subtrees[i];
+        const size_t offset = m_tree.m_nodes.size() - 1;
+
+        for (size_t j = 0; j < subtree.size(); ++j)
+        {
+            NodeType node = subtree[j];
+
+            if (node.is_interior())
+                node.set_child_node_index(node.get_child_node_index() + offset);
+
+            if (j == 0)
+                m_tree.m_nodes[pending_nodes[i].m_node_index] = node;
+            else m_tree.m_nodes.push_back(node);
+        }
+    }
 }
 
 template <typename T, size_t N>
 void Builder<T, N>::partition(
+    NodeVector&                 nodes,
     const size_t                parent_node_index,
     const size_t                begin,
     const size_t                end) const
 {
-    const size_t count = end - begin;
-
-    if (count <= 1)
+    if (end - begin <= 1)
     {
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
-        parent_node.make_leaf();
-        parent_node.set_point_index(begin);
-        parent_node.set_point_count(count);
+        make_leaf_node(nodes[parent_node_index], begin, end);
+        return;
     }
-    else
-    {
-        const BboxType bbox = compute_bbox(begin, end);
-        SplitType split = SplitType::middle(bbox);
 
-        const size_t* bound =
-            std::partition(
-                &m_tree.m_indices[0] + begin,
-                &m_tree.m_indices[0] + end,
-                PartitionPredicate(m_tree.m_points, split));
+    SplitType split;
+    const size_t pivot = Builder::split(begin, end, split);
 
-        size_t pivot = bound - &m_tree.m_indices[0];
-        assert(pivot >= begin);
-        assert(pivot <= end);
+    const size_t left_node_index = nodes.size();
+    const size_t right_node_index = left_node_index + 1;
 
-        // Switch to median split if one of the two leaf is empty.
-        if (pivot == begin || pivot == end)
-        {
-            pivot = (begin + end) / 2;
-            const VectorType& median_point = m_tree.m_points[m_tree.m_indices[pivot]];
-            split.m_abscissa = median_point[split.m_dimension];
-        }
+    nodes.push_back(NodeType());
+    nodes.push_back(NodeType());
 
-        const size_t left_node_index = m_tree.m_nodes.size();
-        const size_t right_node_index = left_node_index + 1;
+    make_interior_node(nodes[parent_node_index], split, left_node_index, begin, end);
 
-        m_tree.m_nodes.push_back(NodeType());
-        m_tree.m_nodes.push_back(NodeType());
+    partition(nodes, left_node_index, begin, pivot);
+    partition(nodes, right_node_index, pivot, end);
+}
+
+template <typename T, size_t N>
+size_t Builder<T, N>::split(
+    const size_t                begin,
+    const size_t                end,
+    SplitType&                  split) const
+{
+    assert(end - begin > 1);
 
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
-        parent_node.make_interior();
-        parent_node.set_split_dim(split.m_dimension);
-        parent_node.set_split_abs(split.m_abscissa);
-        parent_node.set_child_node_index(left_node_index);
-        parent_node.set_point_index(begin);
-        parent_node.set_point_count(count);
+    const BboxType bbox = compute_bbox(begin, end);
+    split = SplitType::middle(bbox);
 
-        partition(left_node_index, begin, pivot);
-        partition(right_node_index, pivot, end);
+    const size_t* bound =
+        std::partition(
+            &m_tree.m_indices[0] + begin,
+            &m_tree.m_indices[0] + end,
+            PartitionPredicate(m_tree.m_points, split));
+
+    size_t pivot = bound - &m_tree.m_indices[0];
+    assert(pivot >= begin);
+    assert(pivot <= end);
+
+    // Switch to median split if one of the two leaf is empty.
+    if (pivot == begin || pivot == end)
+    {
+        pivot = (begin + end) / 2;
+        const VectorType& median_point = m_tree.m_points[m_tree.m_indices[pivot]];
+        split.m_abscissa = median_point[split.m_dimension];
     }
+
+    return pivot;
+}
+
+template <typename T, size_t N>
+inline void Builder<T, N>::make_interior_node(
+    NodeType&                   node,
+    const SplitType&            split,
+    const size_t                child_node_index,
+    const size_t                begin,
+    const size_t                end)
+{
+    node.make_interior();
+    node.set_split_dim(split.m_dimension);
+    node.set_split_abs(split.m_abscissa);
+    node.set_child_node_index(child_node_index);
+    node.set_point_index(begin);
+    node.set_point_count(end - begin);
+}
+
+template <typename T, size_t N>
+inline void Builder<T, N>::make_leaf_node(
+    NodeType&                   node,
+    const size_t                begin,
+    const size_t                end)
+{
+    node.make_leaf();
+    node.set_point_index(begin);
+    node.set_point_count(end - begin);
 }
 
 template <typename T, size_t N>
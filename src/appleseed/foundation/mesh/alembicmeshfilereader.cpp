@@ -116,11 +116,8 @@ namespace
             const Imath::V3f* vertices = mesh_sample.getPositions()->get();
             const size_t vertex_count = mesh_sample.getPositions()->size();
 
-            for (size_t i = 0; i < vertex_count; ++i)
-            {
-                const Vector3d v(vertices[i]);      // todo: transform to world space using matrix stack
-                m_mesh_builder.push_vertex(v);
-            }
+            // todo: transform to world space using matrix stack.
+            m_mesh_builder.push_vertex_array(&vertices[0].x, vertex_count);
         }
 
         void read_vertex_normals(IPolyMeshSchema& mesh_schema)
@@ -135,12 +132,10 @@ namespace
 
             const N3f* normals = normal_sample.getVals()->get();
             const size_t normal_count = normal_sample.getVals()->size();
-                
-            for (size_t i = 0; i < normal_count; ++i)
-            {
-                const Vector3d n(normals[i]);       // todo: transform to world space using matrix stack
-                m_mesh_builder.push_vertex_normal(n);
-            }
+
+            // todo: transform to world space using matrix stack.
+            if (normal_count > 0)
+                m_mesh_builder.push_vertex_normal_array(&normals[0].x, normal_count);
 
             m_has_vertex_normals = normal_count > 0;
         }
@@ -157,12 +152,9 @@ namespace
 
             const V2f* uv = uv_sample.getVals()->get();
             const size_t uv_count = uv_sample.getVals()->size();
-                
-            for (size_t i = 0; i < uv_count; ++i)
-            {
-                const Vector2d v(uv[i]);
-                m_mesh_builder.push_tex_coords(v);
-            }
+
+            if (uv_count > 0)
+                m_mesh_builder.push_tex_coords_array(&uv[0].x, uv_count);
 
             m_has_uv = uv_count > 0;
         }
@@ -175,6 +167,8 @@ namespace
 
             size_t current_vertex_index = 0;
             vector<size_t> indices;
+            vector<IMeshBuilder::IndexedTriangle> triangles;
+            triangles.reserve(face_count);
 
             for (size_t i = 0; i < face_count; ++i)
             {
@@ -184,6 +178,17 @@ namespace
                 if (face_size < 3)
                     continue;
 
+                // Collect triangles so that they can be inserted in bulk.
+                if (face_size == 3)
+                {
+                    triangles.push_back(make_triangle(face_indices + current_vertex_index));
+                    current_vertex_index += face_size;
+                    continue;
+                }
+
+                // Preserve the order of faces.
+                insert_triangles(triangles);
+
                 // Collect feature indices for this face.
                 ensure_minimum_size(indices, face_size);
                 for (size_t j = 0; j < face_size; ++j)
@@ -207,6 +212,47 @@ namespace
 
                 current_vertex_index += face_size;
             }
+
+            insert_triangles(triangles);
+        }
+
+        IMeshBuilder::IndexedTriangle make_triangle(const int32* face_indices) const
+        {
+            IMeshBuilder::IndexedTriangle triangle;
+
+            triangle.m_v0 = static_cast<uint32>(face_indices[0]);
+            triangle.m_v1 = static_cast<uint32>(face_indices[1]);
+            triangle.m_v2 = static_cast<uint32>(face_indices[2]);
+
+            if (m_has_vertex_normals)
+            {
+                triangle.m_n0 = triangle.m_v0;
+                triangle.m_n1 = triangle.m_v1;
+                triangle.m_n2 = triangle.m_v2;
+            }
+            else triangle.m_n0 = triangle.m_n1 = triangle.m_n2 = IMeshBuilder::None;
+
+            if (m_has_uv)
+            {
+                triangle.m_a0 = triangle.m_v0;
+                triangle.m_a1 = triangle.m_v1;
+                triangle.m_a2 = triangle.m_v2;
+            }
+            else triangle.m_a0 = triangle.m_a1 = triangle.m_a2 = IMeshBuilder::None;
+
+            triangle.m_pa = 0;
+
+            return triangle;
+        }
+
+        void insert_triangles(vector<IMeshBuilder::IndexedTriangle>& triangles)
+        {
+            if (triangles.empty())
+                return;
+
+            m_mesh_builder.push_triangle_array(&triangles[0], triangles.size());
+
+            triangles.clear();
         }
     };
 
@@ -39,9 +39,18 @@
 #include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/memory.h"
 
+// LZ4 headers.
+#include "lz4.h"
+
+// boost headers.
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
 // Standard headers.
 #include <cstring>
 #include <memory>
+#include <vector>
 
 using namespace std;
 
@@ -76,6 +85,134 @@ namespace
     {
         checked_read(file, &object, sizeof(T));
     }
+
+    // Alignment in bytes of the arrays of version 4 files.
+    const size_t ArrayAlignment = 16;
+
+    // In-file representation of a triangle in version 4 files.
+    typedef IMeshBuilder::IndexedTriangle TriangleRecord;
+
+    // Bounds-checked cursor over a file mapped in memory.
+    class MappedFileReader
+      : public ReaderAdapter
+    {
+      public:
+        MappedFileReader(const uint8* begin, const size_t size)
+          : m_ptr(begin)
+          , m_end(begin + size)
+        {
+        }
+
+        bool at_end() const
+        {
+            return m_ptr == m_end;
+        }
+
+        virtual size_t read(void* outbuf, const size_t size) OVERRIDE
+        {
+            const size_t bytes_read = min<size_t>(size, m_end - m_ptr);
+            memcpy(outbuf, m_ptr, bytes_read);
+            m_ptr += bytes_read;
+            return bytes_read;
+        }
+
+        const uint8* skip(const size_t size)
+        {
+            if (size > static_cast<size_t>(m_end - m_ptr))
+                throw ExceptionIOError();
+
+            const uint8* ptr = m_ptr;
+            m_ptr += size;
+            return ptr;
+        }
+
+        void skip_padding()
+        {
+            // The mapping starts on a page boundary, hence aligning pointers aligns file offsets.
+            skip(align(m_ptr, ArrayAlignment) - m_ptr);
+        }
+
+      private:
+        const uint8*        m_ptr;
+        const uint8* const  m_end;
+    };
+
+    // Read an array of a version 4 file. Uncompressed arrays are returned in place,
+    // compressed arrays are decompressed into 'storage'.
+    const uint8* read_array(
+        MappedFileReader&   reader,
+        const size_t        item_size,
+        vector<uint8>&      storage,
+        size_t&             item_count)
+    {
+        uint64 count;
+        checked_read(reader, count);
+
+        uint32 stored_item_size;
+        checked_read(reader, stored_item_size);
+
+        uint32 chunk_count;
+        checked_read(reader, chunk_count);
+
+        if (stored_item_size != item_size)
+            throw ExceptionIOError();
+
+        item_count = static_cast<size_t>(count);
+
+        const size_t size = item_count * item_size;
+        const uint8* result = 0;
+        size_t offset = 0;
+
+        for (uint32 i = 0; i < chunk_count; ++i)
+        {
+            uint64 chunk_size;
+            checked_read(reader, chunk_size);
+
+            uint64 stored_chunk_size;
+            checked_read(reader, stored_chunk_size);
+
+            if (chunk_size > size - offset)
+                throw ExceptionIOError();
+
+            const uint8* chunk = reader.skip(static_cast<size_t>(stored_chunk_size));
+            reader.skip_padding();
+
+            if (chunk_count == 1 && stored_chunk_size == chunk_size)
+            {
+                // Single uncompressed chunk: use the data directly from the mapping.
+                result = chunk;
+            }
+            else
+            {
+                if (storage.size() < size)
+                    storage.resize(size);
+
+                if (stored_chunk_size == chunk_size)
+                    memcpy(&storage[offset], chunk, static_cast<size_t>(chunk_size));
+                else
+                {
+                    const int decompressed_size =
+                        LZ4_decompress_safe(
+                            reinterpret_cast<const char*>(chunk),
+                            reinterpret_cast<char*>(&storage[offset]),
+                            static_cast<int>(stored_chunk_size),
+                            static_cast<int>(chunk_size));
+
+                    if (decompressed_size != static_cast<int>(chunk_size))
+                        throw ExceptionIOError();
+                }
+
+                result = &storage[0];
+            }
+
+            offset += static_cast<size_t>(chunk_size);
+        }
+
+        if (offset != size)
+            throw ExceptionIOError();
+
+        return result;
+    }
 }
 
 BinaryMeshFileReader::BinaryMeshFileReader(const string& filename)
@@ -114,6 +251,11 @@ void BinaryMeshFileReader::read(IMeshBuilder& builder)
         reader.reset(new LZ4CompressedReaderAdapter(file));
         break;
 
+      case 4:                       // memory-mappable arrays
+        file.close();
+        read_mapped_meshes(builder);
+        return;
+
       default:                      // unknown format
         throw ExceptionIOError();   // todo: throw better-qualified exception
     }
@@ -275,4 +417,77 @@ void BinaryMeshFileReader::read_face(ReaderAdapter& reader, IMeshBuilder& builde
     builder.end_face();
 }
 
+void BinaryMeshFileReader::read_mapped_meshes(IMeshBuilder& builder)
+{
+    using namespace boost::interprocess;
+
+    try
+    {
+        const file_mapping mapping(m_filename.c_str(), read_only);
+        const mapped_region region(mapping, read_only);
+
+        MappedFileReader reader(
+            static_cast<const uint8*>(region.get_address()),
+            region.get_size());
+
+        // Skip the signature and the version number, they have already been checked.
+        reader.skip(12);
+        reader.skip_padding();
+
+        vector<uint8> vertex_storage;
+        vector<uint8> vertex_normal_storage;
+        vector<uint8> tex_coords_storage;
+        vector<uint8> triangle_storage;
+
+        while (!reader.at_end())
+        {
+            const string mesh_name = read_string(reader);
+
+            builder.begin_mesh(mesh_name.c_str());
+
+            uint16 material_slot_count;
+            checked_read(reader, material_slot_count);
+
+            for (uint16 i = 0; i < material_slot_count; ++i)
+            {
+                const string material_slot = read_string(reader);
+                builder.push_material_slot(material_slot.c_str());
+            }
+
+            reader.skip_padding();
+
+            size_t vertex_count;
+            const uint8* vertices =
+                read_array(reader, 3 * sizeof(float), vertex_storage, vertex_count);
+            builder.push_vertex_array(reinterpret_cast<const float*>(vertices), vertex_count);
+
+            size_t vertex_normal_count;
+            const uint8* vertex_normals =
+                read_array(reader, 3 * sizeof(float), vertex_normal_storage, vertex_normal_count);
+            builder.push_vertex_normal_array(reinterpret_cast<const float*>(vertex_normals), vertex_normal_count);
+
+            size_t tex_coords_count;
+            const uint8* tex_coords =
+                read_array(reader, 2 * sizeof(float), tex_coords_storage, tex_coords_count);
+            builder.push_tex_coords_array(reinterpret_cast<const float*>(tex_coords), tex_coords_count);
+
+            size_t triangle_count;
+            const uint8* triangles =
+                read_array(reader, sizeof(TriangleRecord), triangle_storage, triangle_count);
+            builder.push_triangle_array(reinterpret_cast<const TriangleRecord*>(triangles), triangle_count);
+
+            builder.end_mesh();
+        }
+    }
+    catch (const interprocess_exception&)
+    {
+        throw ExceptionIOError();
+    }
+    catch (const ExceptionEOF&)
+    {
+        // Unexpected EOF.
+        throw ExceptionIOError();
+    }
+}
+
 }   // namespace foundation
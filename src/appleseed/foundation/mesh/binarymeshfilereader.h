@@ -77,6 +77,9 @@ class BinaryMeshFileReader
     void read_material_slots(ReaderAdapter& reader, IMeshBuilder& builder);
     void read_faces(ReaderAdapter& reader, IMeshBuilder& builder);
     void read_face(ReaderAdapter& reader, IMeshBuilder& builder);
+
+    // Read a version 4 file by mapping it in memory.
+    void read_mapped_meshes(IMeshBuilder& builder);
 };
 
 }       // namespace foundation
@@ -32,12 +32,20 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/math/triangulator.h"
 #include "foundation/math/vector.h"
+#include "foundation/mesh/imeshbuilder.h"
 #include "foundation/mesh/imeshwalker.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/memory.h"
+
+// LZ4 headers.
+#include "lz4.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 using namespace std;
 
@@ -64,10 +72,34 @@ namespace
     {
         checked_write(file, &object, sizeof(T));
     }
+
+    template <typename File>
+    void write_string(File& file, const char* s)
+    {
+        const uint16 length = static_cast<uint16>(strlen(s));
+
+        checked_write(file, length);
+        checked_write(file, s, length);
+    }
+
+    // Alignment in bytes of the arrays of version 4 files.
+    const size_t ArrayAlignment = 16;
+
+    // Maximum uncompressed size in bytes of the chunks of compressed arrays.
+    const size_t MaxChunkSize = 1024 * 1024;
+
+    // In-file representation of a triangle in version 4 files.
+    typedef IMeshBuilder::IndexedTriangle TriangleRecord;
+
+    // Special index value used to indicate that a feature is not present.
+    const uint32 None = IMeshBuilder::None;
 }
 
-BinaryMeshFileWriter::BinaryMeshFileWriter(const string& filename)
+BinaryMeshFileWriter::BinaryMeshFileWriter(
+    const string&   filename,
+    const int       options)
   : m_filename(filename)
+  , m_options(options)
   , m_writer(m_file, 256 * 1024)
 {
 }
@@ -86,9 +118,14 @@ void BinaryMeshFileWriter::write(const IMeshWalker& walker)
 
         write_signature();
         write_version();
+
+        if (m_options & MemoryMappable)
+            write_padding();
     }
 
-    write_mesh(walker);
+    if (m_options & MemoryMappable)
+        write_mappable_mesh(walker);
+    else write_mesh(walker);
 }
 
 void BinaryMeshFileWriter::write_signature()
@@ -100,17 +137,24 @@ void BinaryMeshFileWriter::write_signature()
 
 void BinaryMeshFileWriter::write_version()
 {
-    const uint16 Version = 3;
+    const uint16 Version = (m_options & MemoryMappable) ? 4 : 3;
 
     checked_write(m_file, Version);
 }
 
-void BinaryMeshFileWriter::write_string(const char* s)
+void BinaryMeshFileWriter::write_padding()
 {
-    const uint16 length = static_cast<uint16>(strlen(s));
+    static const uint8 Zeros[ArrayAlignment] = { 0 };
+
+    const size_t offset = static_cast<size_t>(m_file.tell());
+    const size_t padding = align(offset, ArrayAlignment) - offset;
+
+    checked_write(m_file, Zeros, padding);
+}
 
-    checked_write(m_writer, length);
-    checked_write(m_writer, s, length);
+void BinaryMeshFileWriter::write_string(const char* s)
+{
+    foundation::write_string(m_writer, s);
 }
 
 void BinaryMeshFileWriter::write_mesh(const IMeshWalker& walker)
@@ -183,4 +227,176 @@ void BinaryMeshFileWriter::write_face(const IMeshWalker& walker, const size_t fa
     checked_write(m_writer, static_cast<uint16>(walker.get_face_material(face_index)));
 }
 
+void BinaryMeshFileWriter::write_mappable_mesh(const IMeshWalker& walker)
+{
+    // Write the name of the mesh.
+    foundation::write_string(m_file, walker.get_name());
+
+    // Write the material slots.
+    const uint16 material_slot_count = static_cast<uint16>(walker.get_material_slot_count());
+    checked_write(m_file, material_slot_count);
+    for (uint16 i = 0; i < material_slot_count; ++i)
+        foundation::write_string(m_file, walker.get_material_slot(i));
+
+    write_padding();
+
+    // Write the vertices.
+    const size_t vertex_count = walker.get_vertex_count();
+    vector<Vector3f> vertices(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i)
+        vertices[i] = Vector3f(walker.get_vertex(i));
+    write_array(vertex_count > 0 ? &vertices[0] : 0, vertex_count, sizeof(Vector3f));
+    clear_release_memory(vertices);
+
+    // Write the vertex normals.
+    const size_t vertex_normal_count = walker.get_vertex_normal_count();
+    vector<Vector3f> vertex_normals(vertex_normal_count);
+    for (size_t i = 0; i < vertex_normal_count; ++i)
+        vertex_normals[i] = Vector3f(walker.get_vertex_normal(i));
+    write_array(vertex_normal_count > 0 ? &vertex_normals[0] : 0, vertex_normal_count, sizeof(Vector3f));
+    clear_release_memory(vertex_normals);
+
+    // Write the texture coordinates.
+    const size_t tex_coords_count = walker.get_tex_coords_count();
+    vector<Vector2f> tex_coords(tex_coords_count);
+    for (size_t i = 0; i < tex_coords_count; ++i)
+        tex_coords[i] = Vector2f(walker.get_tex_coords(i));
+    write_array(tex_coords_count > 0 ? &tex_coords[0] : 0, tex_coords_count, sizeof(Vector2f));
+    clear_release_memory(tex_coords);
+
+    // Triangulate the faces and write the resulting triangles.
+    const size_t face_count = walker.get_face_count();
+    vector<TriangleRecord> triangles;
+    triangles.reserve(face_count);
+
+    Triangulator<double> triangulator(Triangulator<double>::KeepDegenerateTriangles);
+    vector<Vector3d> polygon;
+    vector<size_t> polygon_triangles;
+
+    for (size_t face_index = 0; face_index < face_count; ++face_index)
+    {
+        const size_t face_vertex_count = walker.get_face_vertex_count(face_index);
+
+        clear_keep_memory(polygon_triangles);
+
+        if (face_vertex_count > 3)
+        {
+            clear_keep_memory(polygon);
+
+            for (size_t i = 0; i < face_vertex_count; ++i)
+                polygon.push_back(walker.get_vertex(walker.get_face_vertex(face_index, i)));
+
+            if (!triangulator.triangulate(polygon, polygon_triangles))
+            {
+                // The polygon could not be triangulated: insert zero-area triangles instead.
+                polygon_triangles.assign(3 * (face_vertex_count - 2), 0);
+            }
+        }
+        else
+        {
+            polygon_triangles.push_back(0);
+            polygon_triangles.push_back(1);
+            polygon_triangles.push_back(2);
+        }
+
+        const uint32 material = static_cast<uint32>(walker.get_face_material(face_index));
+
+        for (size_t i = 0; i < polygon_triangles.size(); i += 3)
+        {
+            const size_t c0 = polygon_triangles[i + 0];
+            const size_t c1 = polygon_triangles[i + 1];
+            const size_t c2 = polygon_triangles[i + 2];
+
+            TriangleRecord triangle;
+
+            triangle.m_v0 = static_cast<uint32>(walker.get_face_vertex(face_index, c0));
+            triangle.m_v1 = static_cast<uint32>(walker.get_face_vertex(face_index, c1));
+            triangle.m_v2 = static_cast<uint32>(walker.get_face_vertex(face_index, c2));
+
+            if (vertex_normal_count > 0)
+            {
+                triangle.m_n0 = static_cast<uint32>(walker.get_face_vertex_normal(face_index, c0));
+                triangle.m_n1 = static_cast<uint32>(walker.get_face_vertex_normal(face_index, c1));
+                triangle.m_n2 = static_cast<uint32>(walker.get_face_vertex_normal(face_index, c2));
+            }
+            else triangle.m_n0 = triangle.m_n1 = triangle.m_n2 = None;
+
+            if (tex_coords_count > 0)
+            {
+                triangle.m_a0 = static_cast<uint32>(walker.get_face_tex_coords(face_index, c0));
+                triangle.m_a1 = static_cast<uint32>(walker.get_face_tex_coords(face_index, c1));
+                triangle.m_a2 = static_cast<uint32>(walker.get_face_tex_coords(face_index, c2));
+            }
+            else triangle.m_a0 = triangle.m_a1 = triangle.m_a2 = None;
+
+            triangle.m_pa = material;
+
+            triangles.push_back(triangle);
+        }
+    }
+
+    write_array(triangles.empty() ? 0 : &triangles[0], triangles.size(), sizeof(TriangleRecord));
+}
+
+void BinaryMeshFileWriter::write_array(
+    const void*     items,
+    const size_t    item_count,
+    const size_t    item_size)
+{
+    const uint8* data = static_cast<const uint8*>(items);
+    const size_t size = item_count * item_size;
+
+    // Uncompressed arrays are written as a single chunk so that they can be used in place.
+    const size_t chunk_size =
+        m_options & CompressArrays
+            ? max<size_t>((MaxChunkSize / item_size) * item_size, item_size)
+            : max<size_t>(size, 1);
+    const size_t chunk_count = (size + chunk_size - 1) / chunk_size;
+
+    checked_write(m_file, static_cast<uint64>(item_count));
+    checked_write(m_file, static_cast<uint32>(item_size));
+    checked_write(m_file, static_cast<uint32>(chunk_count));
+
+    for (size_t i = 0; i < chunk_count; ++i)
+    {
+        const size_t begin = i * chunk_size;
+        write_chunk(data + begin, min(chunk_size, size - begin));
+    }
+}
+
+void BinaryMeshFileWriter::write_chunk(
+    const uint8*    data,
+    const size_t    size)
+{
+    const uint8* stored_data = data;
+    size_t stored_size = size;
+
+    if (m_options & CompressArrays)
+    {
+        ensure_minimum_size(
+            m_compressed_buffer,
+            static_cast<size_t>(LZ4_compressBound(static_cast<int>(size))));
+
+        const size_t compressed_size =
+            static_cast<size_t>(
+                LZ4_compress(
+                    reinterpret_cast<const char*>(data),
+                    reinterpret_cast<char*>(&m_compressed_buffer[0]),
+                    static_cast<int>(size)));
+
+        // Only keep the compressed chunk if it is actually smaller.
+        if (compressed_size > 0 && compressed_size < size)
+        {
+            stored_data = &m_compressed_buffer[0];
+            stored_size = compressed_size;
+        }
+    }
+
+    checked_write(m_file, static_cast<uint64>(size));
+    checked_write(m_file, static_cast<uint64>(stored_size));
+    checked_write(m_file, stored_data, stored_size);
+
+    write_padding();
+}
+
 }   // namespace foundation
@@ -33,11 +33,13 @@
 // appleseed.foundation headers.
 #include "foundation/mesh/imeshfilewriter.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/bufferedfile.h"
 
 // Standard headers.
 #include <cstddef>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IMeshWalker; }
@@ -53,19 +55,31 @@ class BinaryMeshFileWriter
   : public IMeshFileWriter
 {
   public:
+    enum Options
+    {
+        Default         = 0,            // write LZ4-compressed version 3 files
+        MemoryMappable  = 1 << 0,       // write version 4 files whose arrays can be memory-mapped
+        CompressArrays  = 1 << 1        // compress the arrays of version 4 files
+    };
+
     // Constructor.
-    explicit BinaryMeshFileWriter(const std::string& filename);
+    BinaryMeshFileWriter(
+        const std::string&  filename,
+        const int           options = Default);
 
     // Write a mesh.
     virtual void write(const IMeshWalker& walker) OVERRIDE;
 
   private:
     const std::string           m_filename;
+    const int                   m_options;
     BufferedFile                m_file;
     LZ4CompressedWriterAdapter  m_writer;
+    std::vector<uint8>          m_compressed_buffer;
 
     void write_signature();
     void write_version();
+    void write_padding();
 
     void write_string(const char* s);
     void write_mesh(const IMeshWalker& walker);
@@ -75,6 +89,15 @@ class BinaryMeshFileWriter
     void write_material_slots(const IMeshWalker& walker);
     void write_faces(const IMeshWalker& walker);
     void write_face(const IMeshWalker& walker, const size_t face_index);
+
+    void write_mappable_mesh(const IMeshWalker& walker);
+    void write_array(
+        const void*         items,
+        const size_t        item_count,
+        const size_t        item_size);
+    void write_chunk(
+        const uint8*        data,
+        const size_t        size);
 };
 
 }       // namespace foundation
@@ -48,7 +48,9 @@ using namespace std;
 namespace foundation
 {
 
-GenericMeshFileWriter::GenericMeshFileWriter(const char* filename)
+GenericMeshFileWriter::GenericMeshFileWriter(
+    const char* filename,
+    const int   binarymesh_options)
 {
     const filesystem::path filepath(filename);
     const string extension = lower_case(filepath.extension().string());
@@ -56,7 +58,7 @@ GenericMeshFileWriter::GenericMeshFileWriter(const char* filename)
     if (extension == ".obj")
         m_writer = new OBJMeshFileWriter(filename);
     else if (extension == ".binarymesh")
-        m_writer = new BinaryMeshFileWriter(filename);
+        m_writer = new BinaryMeshFileWriter(filename, binarymesh_options);
     else throw ExceptionUnsupportedFileFormat(filename);
 }
 
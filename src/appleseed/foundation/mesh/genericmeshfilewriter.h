@@ -31,6 +31,7 @@
 #define APPLESEED_FOUNDATION_MESH_GENERICMESHFILEWRITER_H
 
 // appleseed.foundation headers.
+#include "foundation/mesh/binarymeshfilewriter.h"
 #include "foundation/mesh/imeshfilewriter.h"
 #include "foundation/platform/compiler.h"
 
@@ -52,7 +53,9 @@ class DLLSYMBOL GenericMeshFileWriter
 {
   public:
     // Constructor.
-    explicit GenericMeshFileWriter(const char* filename);
+    explicit GenericMeshFileWriter(
+        const char* filename,
+        const int   binarymesh_options = BinaryMeshFileWriter::Default);
 
     // Destructor.
     virtual ~GenericMeshFileWriter();
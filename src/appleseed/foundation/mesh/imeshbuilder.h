@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
@@ -46,11 +47,27 @@ namespace foundation
 //
 // Mesh builder interface.
 //
+// The push_*_array() methods allow to define large meshes with a handful of calls.
+// Their default implementations forward to the per-element methods; builders should
+// override them when they can store the arrays more efficiently.
+//
 
 class DLLSYMBOL IMeshBuilder
   : public NonCopyable
 {
   public:
+    // Special index value used to indicate that a feature is not present.
+    static const uint32 None = ~0;
+
+    // A triangle given by indices into the features of the mesh.
+    struct IndexedTriangle
+    {
+        uint32  m_v0, m_v1, m_v2;       // vertex indices
+        uint32  m_n0, m_n1, m_n2;       // vertex normal indices, or None
+        uint32  m_a0, m_a1, m_a2;       // texture coordinates indices, or None
+        uint32  m_pa;                   // material index, or None
+    };
+
     // Destructor.
     virtual ~IMeshBuilder() {}
 
@@ -92,8 +109,101 @@ class DLLSYMBOL IMeshBuilder
 
     // End the definition of the mesh.
     virtual void end_mesh() = 0;
+
+    // Append vertices to the mesh, given as triplets of floats.
+    // Return the index of the first vertex within the mesh.
+    virtual size_t push_vertex_array(const float* vertices, const size_t count);
+
+    // Append vertex normals to the mesh, given as triplets of floats.
+    // The normals are NOT necessarily unit-length.
+    // Return the index of the first normal within the mesh.
+    virtual size_t push_vertex_normal_array(const float* vertex_normals, const size_t count);
+
+    // Append texture coordinates to the mesh, given as pairs of floats.
+    // Return the index of the first vector within the mesh.
+    virtual size_t push_tex_coords_array(const float* tex_coords, const size_t count);
+
+    // Append triangles to the mesh.
+    virtual void push_triangle_array(const IndexedTriangle* triangles, const size_t count);
 };
 
+
+//
+// IMeshBuilder class implementation.
+//
+
+inline size_t IMeshBuilder::push_vertex_array(const float* vertices, const size_t count)
+{
+    size_t index = 0;
+
+    for (size_t i = 0; i < count; ++i, vertices += 3)
+    {
+        const size_t j = push_vertex(Vector3d(vertices[0], vertices[1], vertices[2]));
+        if (i == 0)
+            index = j;
+    }
+
+    return index;
+}
+
+inline size_t IMeshBuilder::push_vertex_normal_array(const float* vertex_normals, const size_t count)
+{
+    size_t index = 0;
+
+    for (size_t i = 0; i < count; ++i, vertex_normals += 3)
+    {
+        const size_t j = push_vertex_normal(Vector3d(vertex_normals[0], vertex_normals[1], vertex_normals[2]));
+        if (i == 0)
+            index = j;
+    }
+
+    return index;
+}
+
+inline size_t IMeshBuilder::push_tex_coords_array(const float* tex_coords, const size_t count)
+{
+    size_t index = 0;
+
+    for (size_t i = 0; i < count; ++i, tex_coords += 2)
+    {
+        const size_t j = push_tex_coords(Vector2d(tex_coords[0], tex_coords[1]));
+        if (i == 0)
+            index = j;
+    }
+
+    return index;
+}
+
+inline void IMeshBuilder::push_triangle_array(const IndexedTriangle* triangles, const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const IndexedTriangle& triangle = triangles[i];
+
+        begin_face(3);
+
+        const size_t vertices[3] = { triangle.m_v0, triangle.m_v1, triangle.m_v2 };
+        set_face_vertices(vertices);
+
+        if (triangle.m_n0 != None)
+        {
+            const size_t vertex_normals[3] = { triangle.m_n0, triangle.m_n1, triangle.m_n2 };
+            set_face_vertex_normals(vertex_normals);
+        }
+
+        if (triangle.m_a0 != None)
+        {
+            const size_t tex_coords[3] = { triangle.m_a0, triangle.m_a1, triangle.m_a2 };
+            set_face_vertex_tex_coords(tex_coords);
+        }
+
+        if (triangle.m_pa != None)
+            set_face_material(triangle.m_pa);
+
+        end_face();
+    }
+}
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_MESH_IMESHBUILDER_H
@@ -36,6 +36,7 @@
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshbuilder.h"
 #include "foundation/mesh/objmeshfilelexer.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/memory.h"
 
 // Standard headers.
@@ -86,6 +87,9 @@ struct OBJMeshFileReader::Impl
     vector<size_t>          m_face_tex_coord_indices;
     vector<size_t>          m_face_normal_indices;
 
+    // Triangles of the current mesh waiting to be inserted in bulk.
+    vector<IMeshBuilder::IndexedTriangle> m_pending_triangles;
+
     // Constructor.
     Impl(
         const int           options,
@@ -191,7 +195,10 @@ struct OBJMeshFileReader::Impl
 
         // End the definition of the last object.
         if (m_inside_mesh_def)
+        {
+            insert_pending_triangles_into_mesh();
             m_builder.end_mesh();
+        }
     }
 
     void parse_f_statement()
@@ -349,6 +356,16 @@ struct OBJMeshFileReader::Impl
 
         const size_t n = m_face_vertex_indices.size();
 
+        // Defer the insertion of triangles so that they can be inserted in bulk.
+        if (n == 3)
+        {
+            queue_triangle();
+            return;
+        }
+
+        // Preserve the order of faces.
+        insert_pending_triangles_into_mesh();
+
         // Begin defining a new face.
         m_builder.begin_face(n); 
 
@@ -370,6 +387,45 @@ struct OBJMeshFileReader::Impl
         m_builder.end_face();
     }
 
+    void queue_triangle()
+    {
+        IMeshBuilder::IndexedTriangle triangle;
+
+        triangle.m_v0 = static_cast<uint32>(m_face_vertex_indices[0]);
+        triangle.m_v1 = static_cast<uint32>(m_face_vertex_indices[1]);
+        triangle.m_v2 = static_cast<uint32>(m_face_vertex_indices[2]);
+
+        if (m_face_normal_indices.size() == 3)
+        {
+            triangle.m_n0 = static_cast<uint32>(m_face_normal_indices[0]);
+            triangle.m_n1 = static_cast<uint32>(m_face_normal_indices[1]);
+            triangle.m_n2 = static_cast<uint32>(m_face_normal_indices[2]);
+        }
+        else triangle.m_n0 = triangle.m_n1 = triangle.m_n2 = IMeshBuilder::None;
+
+        if (m_face_tex_coord_indices.size() == 3)
+        {
+            triangle.m_a0 = static_cast<uint32>(m_face_tex_coord_indices[0]);
+            triangle.m_a1 = static_cast<uint32>(m_face_tex_coord_indices[1]);
+            triangle.m_a2 = static_cast<uint32>(m_face_tex_coord_indices[2]);
+        }
+        else triangle.m_a0 = triangle.m_a1 = triangle.m_a2 = IMeshBuilder::None;
+
+        triangle.m_pa = static_cast<uint32>(m_current_material_slot_index);
+
+        m_pending_triangles.push_back(triangle);
+    }
+
+    void insert_pending_triangles_into_mesh()
+    {
+        if (m_pending_triangles.empty())
+            return;
+
+        m_builder.push_triangle_array(&m_pending_triangles[0], m_pending_triangles.size());
+
+        clear_keep_memory(m_pending_triangles);
+    }
+
     void insert_vertices_into_mesh()
     {
         const size_t face_vertex_index_count = m_face_vertex_indices.size();
@@ -430,6 +486,7 @@ struct OBJMeshFileReader::Impl
             // End the current mesh.
             if (m_inside_mesh_def)
             {
+                insert_pending_triangles_into_mesh();
                 m_builder.end_mesh();
                 m_inside_mesh_def = false;
             }
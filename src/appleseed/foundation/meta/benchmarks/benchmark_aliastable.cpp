@@ -0,0 +1,104 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/aliastable.h"
+#include "foundation/math/cdf.h"
+#include "foundation/math/rng.h"
+#include "foundation/utility/benchmark.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+using namespace foundation;
+using namespace std;
+
+BENCHMARK_SUITE(Foundation_Math_AliasTable)
+{
+    template <typename Distribution, size_t N>
+    struct Fixture
+    {
+        static const size_t InputCount = 1024;
+
+        Distribution    m_distribution;
+        double          m_inputs[InputCount];
+        double          m_x;
+
+        Fixture()
+          : m_x(0.0)
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < N; ++i)
+                m_distribution.insert(i, rand_double1(rng));
+
+            assert(m_distribution.valid());
+
+            m_distribution.prepare();
+
+            for (size_t i = 0; i < InputCount; ++i)
+                m_inputs[i] = rand_double2(rng);
+        }
+
+        void sample()
+        {
+            for (size_t i = 0; i < InputCount; ++i)
+                m_x += m_distribution.sample(m_inputs[i]).second;
+        }
+    };
+
+    typedef CDF<size_t, double> CDFType;
+    typedef AliasTable<size_t, double> AliasTableType;
+
+    typedef Fixture<CDFType, 1000> SmallCDFFixture;
+    typedef Fixture<AliasTableType, 1000> SmallAliasTableFixture;
+    typedef Fixture<CDFType, 1000000> LargeCDFFixture;
+    typedef Fixture<AliasTableType, 1000000> LargeAliasTableFixture;
+
+    BENCHMARK_CASE_F(CDF_1000Items, SmallCDFFixture)
+    {
+        sample();
+    }
+
+    BENCHMARK_CASE_F(AliasTable_1000Items, SmallAliasTableFixture)
+    {
+        sample();
+    }
+
+    BENCHMARK_CASE_F(CDF_1000000Items, LargeCDFFixture)
+    {
+        sample();
+    }
+
+    BENCHMARK_CASE_F(AliasTable_1000000Items, LargeAliasTableFixture)
+    {
+        sample();
+    }
+}
@@ -0,0 +1,192 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/bvh.h"
+#include "foundation/math/intersection.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/rng.h"
+#include "foundation/math/sampling.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/utility/alignedvector.h"
+#include "foundation/utility/benchmark.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+BENCHMARK_SUITE(Foundation_Math_BVH)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef AlignedVector<NodeType> NodeVector;
+    typedef AlignedVector<bvh::QNode<AABB3d> > QNodeVector;
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::QTree<QNodeVector, NodeVector> QTree;
+    typedef vector<AABB3d> AABBVector;
+
+    class Visitor
+    {
+      public:
+        Visitor(
+            const AABBVector&           bboxes,
+            const vector<size_t>&       ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+        {
+        }
+
+        bool visit(
+            const NodeType&             node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            distance = ray.m_tmax;
+
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[m_ordering[i]], tmin) && tmin < distance)
+                    distance = tmin;
+            }
+
+            return true;
+        }
+
+      private:
+        const AABBVector&               m_bboxes;
+        const vector<size_t>&           m_ordering;
+    };
+
+    struct Fixture
+    {
+        static const size_t ItemCount = 10000;
+        static const size_t RayCount = 1000;
+
+        AABBVector          m_bboxes;
+        vector<size_t>      m_ordering;
+        Tree                m_tree;
+        QTree               m_qtree;
+        Ray3d               m_rays[RayCount];
+        RayInfo3d           m_ray_infos[RayCount];
+
+        Fixture()
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < ItemCount; ++i)
+            {
+                const Vector3d center(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+                const Vector3d extent(rand_double1(rng, 0.0, 0.01));
+                m_bboxes.push_back(AABB3d(center - extent, center + extent));
+            }
+
+            typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+            Partitioner partitioner(m_bboxes, 4);
+
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, partitioner, ItemCount, 4);
+            m_ordering = partitioner.get_item_ordering();
+
+            bvh::Collapser<Tree, QTree> collapser;
+            collapser.collapse<DefaultWallclockTimer>(m_tree, m_qtree);
+
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                Vector2d s;
+                s[0] = rand_double2(rng);
+                s[1] = rand_double2(rng);
+
+                const Vector3d v = sample_sphere_uniform(s);
+                const Vector3d target(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+
+                m_rays[i] = Ray3d(target + 2.0 * v, -v);
+                m_ray_infos[i] = RayInfo3d(m_rays[i]);
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(IntersectNoMotion_BinaryBVH, Fixture)
+    {
+        Visitor visitor(m_bboxes, m_ordering);
+        bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            intersector.intersect_no_motion(
+                m_tree,
+                m_rays[i],
+                m_ray_infos[i],
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+        }
+    }
+
+    BENCHMARK_CASE_F(IntersectNoMotion_QBVH, Fixture)
+    {
+        Visitor visitor(m_bboxes, m_ordering);
+        bvh::QIntersector<QTree, Visitor, Ray3d> intersector;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            intersector.intersect_no_motion(
+                m_qtree,
+                m_rays[i],
+                m_ray_infos[i],
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+        }
+    }
+}
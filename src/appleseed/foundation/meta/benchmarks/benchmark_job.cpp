@@ -82,4 +82,19 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
     {
         payload();
     }
+
+    BENCHMARK_CASE_F(JobExecutionWith8Threads, Fixture<8>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(JobExecutionWith16Threads, Fixture<16>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(JobExecutionWith32Threads, Fixture<32>)
+    {
+        payload();
+    }
 }
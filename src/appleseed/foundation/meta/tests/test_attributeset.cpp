@@ -81,6 +81,22 @@ TEST_SUITE(Foundation_Utility_AttributeSet)
         EXPECT_EQ(RefUV, uv);
     }
 
+    TEST_CASE_F(TestPushAttributes, FixtureTestAttributeSet)
+    {
+        attributes.push_attribute(uv_id, Vector2f(0.1f, 0.3f));
+
+        const Vector2f RefUVs[2] = { Vector2f(0.2f, 0.4f), Vector2f(0.6f, 0.8f) };
+        const size_t index = attributes.push_attributes(uv_id, RefUVs, 2);
+
+        EXPECT_EQ(1, index);
+        EXPECT_EQ(3, attributes.get_attribute_count(uv_id));
+
+        Vector2f uv;
+        attributes.get_attribute<Vector2f>(uv_id, 2, &uv);
+
+        EXPECT_EQ(RefUVs[1], uv);
+    }
+
     TEST_CASE_F(TestSetAttribute, FixtureTestAttributeSet)
     {
         const Vector2f RefUV(0.2f, 0.4f);
@@ -0,0 +1,338 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/mesh/binarymeshfilereader.h"
+#include "foundation/mesh/binarymeshfilewriter.h"
+#include "foundation/mesh/imeshwalker.h"
+#include "foundation/mesh/meshbuilderbase.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Mesh_BinaryMeshFileWriter)
+{
+    struct Face
+    {
+        size_t m_v0, m_v1, m_v2;
+        size_t m_material;
+    };
+
+    struct Mesh
+    {
+        string              m_name;
+        vector<Vector3d>    m_vertices;
+        vector<Vector2d>    m_tex_coords;
+        vector<string>      m_material_slots;
+        vector<Face>        m_faces;
+    };
+
+    struct MeshBuilder
+      : public MeshBuilderBase
+    {
+        vector<Mesh> m_meshes;
+
+        virtual void begin_mesh(const char* name) OVERRIDE
+        {
+            m_meshes.push_back(Mesh());
+            m_meshes.back().m_name = name;
+        }
+
+        virtual size_t push_vertex(const Vector3d& v) OVERRIDE
+        {
+            m_meshes.back().m_vertices.push_back(v);
+            return m_meshes.back().m_vertices.size() - 1;
+        }
+
+        virtual size_t push_tex_coords(const Vector2d& v) OVERRIDE
+        {
+            m_meshes.back().m_tex_coords.push_back(v);
+            return m_meshes.back().m_tex_coords.size() - 1;
+        }
+
+        virtual size_t push_material_slot(const char* name) OVERRIDE
+        {
+            m_meshes.back().m_material_slots.push_back(name);
+            return m_meshes.back().m_material_slots.size() - 1;
+        }
+
+        virtual void begin_face(const size_t vertex_count) OVERRIDE
+        {
+            assert(vertex_count == 3);
+            m_meshes.back().m_faces.push_back(Face());
+        }
+
+        virtual void set_face_vertices(const size_t vertices[]) OVERRIDE
+        {
+            Face& face = m_meshes.back().m_faces.back();
+            face.m_v0 = vertices[0];
+            face.m_v1 = vertices[1];
+            face.m_v2 = vertices[2];
+        }
+
+        virtual void set_face_material(const size_t material) OVERRIDE
+        {
+            m_meshes.back().m_faces.back().m_material = material;
+        }
+    };
+
+    struct MeshWalker
+      : public IMeshWalker
+    {
+        const Mesh& m_mesh;
+
+        explicit MeshWalker(const Mesh& mesh)
+          : m_mesh(mesh)
+        {
+        }
+
+        virtual const char* get_name() const OVERRIDE
+        {
+            return m_mesh.m_name.c_str();
+        }
+
+        virtual size_t get_vertex_count() const OVERRIDE
+        {
+            return m_mesh.m_vertices.size();
+        }
+
+        virtual Vector3d get_vertex(const size_t i) const OVERRIDE
+        {
+            return m_mesh.m_vertices[i];
+        }
+
+        virtual size_t get_vertex_normal_count() const OVERRIDE
+        {
+            return 0;
+        }
+
+        virtual Vector3d get_vertex_normal(const size_t i) const OVERRIDE
+        {
+            return Vector3d();
+        }
+
+        virtual size_t get_tex_coords_count() const OVERRIDE
+        {
+            return m_mesh.m_tex_coords.size();
+        }
+
+        virtual Vector2d get_tex_coords(const size_t i) const OVERRIDE
+        {
+            return m_mesh.m_tex_coords[i];
+        }
+
+        virtual size_t get_material_slot_count() const OVERRIDE
+        {
+            return m_mesh.m_material_slots.size();
+        }
+
+        virtual const char* get_material_slot(const size_t i) const OVERRIDE
+        {
+            return m_mesh.m_material_slots[i].c_str();
+        }
+
+        virtual size_t get_face_count() const OVERRIDE
+        {
+            return m_mesh.m_faces.size();
+        }
+
+        virtual size_t get_face_vertex_count(const size_t face_index) const OVERRIDE
+        {
+            return 3;
+        }
+
+        virtual size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const OVERRIDE
+        {
+            assert(vertex_index < 3);
+            return (&m_mesh.m_faces[face_index].m_v0)[vertex_index];
+        }
+
+        virtual size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const OVERRIDE
+        {
+            return None;
+        }
+
+        virtual size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const OVERRIDE
+        {
+            return get_face_vertex(face_index, vertex_index);
+        }
+
+        virtual size_t get_face_material(const size_t face_index) const OVERRIDE
+        {
+            return m_mesh.m_faces[face_index].m_material;
+        }
+    };
+
+    Mesh create_mesh(const string& name, const size_t face_count)
+    {
+        Mesh mesh;
+        mesh.m_name = name;
+        mesh.m_material_slots.push_back("front");
+        mesh.m_material_slots.push_back("back");
+
+        for (size_t i = 0; i < face_count; ++i)
+        {
+            const double x = static_cast<double>(i);
+
+            mesh.m_vertices.push_back(Vector3d(x, 0.0, 0.0));
+            mesh.m_vertices.push_back(Vector3d(x + 1.0, 0.0, 0.0));
+            mesh.m_vertices.push_back(Vector3d(x + 1.0, 1.0, 0.0));
+
+            mesh.m_tex_coords.push_back(Vector2d(0.0, 0.0));
+            mesh.m_tex_coords.push_back(Vector2d(1.0, 0.0));
+            mesh.m_tex_coords.push_back(Vector2d(1.0, 1.0));
+
+            Face face;
+            face.m_v0 = 3 * i + 0;
+            face.m_v1 = 3 * i + 1;
+            face.m_v2 = 3 * i + 2;
+            face.m_material = i % 2;
+            mesh.m_faces.push_back(face);
+        }
+
+        return mesh;
+    }
+
+    void write_and_read_back(
+        const string&           filename,
+        const int               options,
+        const vector<Mesh>&     meshes,
+        MeshBuilder&            builder)
+    {
+        {
+            BinaryMeshFileWriter writer(filename, options);
+
+            for (size_t i = 0; i < meshes.size(); ++i)
+            {
+                MeshWalker walker(meshes[i]);
+                writer.write(walker);
+            }
+        }
+
+        BinaryMeshFileReader reader(filename);
+        reader.read(builder);
+    }
+
+    bool operator==(const Face& lhs, const Face& rhs)
+    {
+        return
+            lhs.m_v0 == rhs.m_v0 &&
+            lhs.m_v1 == rhs.m_v1 &&
+            lhs.m_v2 == rhs.m_v2 &&
+            lhs.m_material == rhs.m_material;
+    }
+
+    bool operator==(const Mesh& lhs, const Mesh& rhs)
+    {
+        return
+            lhs.m_name == rhs.m_name &&
+            lhs.m_vertices == rhs.m_vertices &&
+            lhs.m_tex_coords == rhs.m_tex_coords &&
+            lhs.m_material_slots == rhs.m_material_slots &&
+            lhs.m_faces == rhs.m_faces;
+    }
+
+    TEST_CASE(WriteAndReadBackStreamFormat)
+    {
+        vector<Mesh> meshes;
+        meshes.push_back(create_mesh("mesh1", 3));
+        meshes.push_back(create_mesh("mesh2", 5));
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfilewriter_stream.binarymesh",
+            BinaryMeshFileWriter::Default,
+            meshes,
+            builder);
+
+        ASSERT_EQ(2, builder.m_meshes.size());
+        EXPECT_TRUE(meshes[0] == builder.m_meshes[0]);
+        EXPECT_TRUE(meshes[1] == builder.m_meshes[1]);
+    }
+
+    TEST_CASE(WriteAndReadBackMappableFormat)
+    {
+        vector<Mesh> meshes;
+        meshes.push_back(create_mesh("mesh1", 3));
+        meshes.push_back(create_mesh("mesh2", 5));
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfilewriter_mappable.binarymesh",
+            BinaryMeshFileWriter::MemoryMappable,
+            meshes,
+            builder);
+
+        ASSERT_EQ(2, builder.m_meshes.size());
+        EXPECT_TRUE(meshes[0] == builder.m_meshes[0]);
+        EXPECT_TRUE(meshes[1] == builder.m_meshes[1]);
+    }
+
+    TEST_CASE(WriteAndReadBackCompressedMappableFormat)
+    {
+        // Large enough for the arrays to span several compressed chunks.
+        vector<Mesh> meshes;
+        meshes.push_back(create_mesh("mesh", 100000));
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfilewriter_compressedmappable.binarymesh",
+            BinaryMeshFileWriter::MemoryMappable | BinaryMeshFileWriter::CompressArrays,
+            meshes,
+            builder);
+
+        ASSERT_EQ(1, builder.m_meshes.size());
+        EXPECT_TRUE(meshes[0] == builder.m_meshes[0]);
+    }
+
+    TEST_CASE(WriteAndReadBackEmptyMeshInMappableFormat)
+    {
+        vector<Mesh> meshes;
+        meshes.push_back(create_mesh("empty", 0));
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfilewriter_empty.binarymesh",
+            BinaryMeshFileWriter::MemoryMappable,
+            meshes,
+            builder);
+
+        ASSERT_EQ(1, builder.m_meshes.size());
+        EXPECT_TRUE(meshes[0] == builder.m_meshes[0]);
+    }
+}
@@ -31,6 +31,8 @@
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng.h"
+#include "foundation/math/sampling.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/utility/alignedvector.h"
@@ -38,7 +40,9 @@
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
+#include <limits>
 #include <vector>
 
 using namespace foundation;
@@ -75,6 +79,133 @@ TEST_SUITE(Foundation_Math_BVH_Node)
     }
 }
 
+TEST_SUITE(Foundation_Math_BVH_CompactNode)
+{
+    TEST_CASE(TestStorageAndRetrievalOfExactlyRepresentableBoundingBoxes)
+    {
+        static const AABB3d LeftBBox(Vector3d(1.0, 2.0, 3.0), Vector3d(4.0, 5.0, 6.0));
+        static const AABB3d RightBBox(Vector3d(7.0, 8.0, 9.0), Vector3d(10.0, 11.0, 12.0));
+
+        bvh::CompactNode<AABB3d> node;
+
+        node.set_left_bbox(LeftBBox);
+        node.set_right_bbox(RightBBox);
+
+        EXPECT_EQ(LeftBBox, node.get_left_bbox());
+        EXPECT_EQ(RightBBox, node.get_right_bbox());
+    }
+
+    TEST_CASE(SetLeftBBox_RoundsBoundingBoxOutward)
+    {
+        static const AABB3d BBox(Vector3d(0.1, -0.2, 1.0 / 3.0), Vector3d(0.7, 0.2, 2.0 / 3.0));
+
+        bvh::CompactNode<AABB3d> node;
+
+        node.set_left_bbox(BBox);
+
+        const AABB3d result = node.get_left_bbox();
+
+        EXPECT_TRUE(result.contains(BBox.min));
+        EXPECT_TRUE(result.contains(BBox.max));
+    }
+
+    TEST_CASE(GetRightBBoxIndex_ReturnsIndexFollowingLeftMotionBoundingBoxes)
+    {
+        bvh::CompactNode<AABB3d> node;
+
+        node.set_left_bbox_count(3);
+        node.set_right_bbox_count(2);
+        node.set_left_bbox_index(10);
+
+        EXPECT_EQ(10, node.get_left_bbox_index());
+        EXPECT_EQ(13, node.get_right_bbox_index());
+    }
+
+    TEST_CASE(SizeOf3DNodeIsOneCacheLine)
+    {
+        EXPECT_EQ(64, sizeof(bvh::CompactNode<AABB3d>));
+    }
+}
+
+namespace
+{
+    typedef AlignedVector<bvh::Node<AABB3d> > LeafCollectingNodeVector;
+
+    struct LeafCollectingTree
+      : public bvh::Tree<LeafCollectingNodeVector>
+    {
+        // Collect the items of each leaf, in depth-first order.
+        void collect_leaves(
+            const vector<size_t>&       ordering,
+            vector<vector<size_t> >&    leaves,
+            const size_t                node_index = 0) const
+        {
+            const NodeType& node = m_nodes[node_index];
+
+            if (node.is_leaf())
+            {
+                const size_t begin = node.get_item_index();
+                const size_t end = begin + node.get_item_count();
+                leaves.push_back(vector<size_t>(ordering.begin() + begin, ordering.begin() + end));
+                sort(leaves.back().begin(), leaves.back().end());
+            }
+            else
+            {
+                collect_leaves(ordering, leaves, node.get_child_node_index());
+                collect_leaves(ordering, leaves, node.get_child_node_index() + 1);
+            }
+        }
+    };
+
+    void create_random_bboxes(vector<AABB3d>& bboxes, const size_t count)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Vector3d center(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+            const Vector3d extent(rand_double1(rng, 0.0, 0.02));
+            bboxes.push_back(AABB3d(center - extent, center + extent));
+        }
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Builder)
+{
+    typedef vector<AABB3d> AABBVector;
+    typedef LeafCollectingTree Tree;
+
+    TEST_CASE(Build_GivenMultipleThreads_ProducesSameLeavesAsSingleThread)
+    {
+        AABBVector bboxes;
+        create_random_bboxes(bboxes, 20000);
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+        vector<vector<size_t> > serial_leaves;
+        {
+            Partitioner partitioner(bboxes, 4);
+            Tree tree;
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4);
+            tree.collect_leaves(partitioner.get_item_ordering(), serial_leaves);
+            EXPECT_EQ(0, builder.get_subtree_count());
+        }
+
+        vector<vector<size_t> > parallel_leaves;
+        {
+            Partitioner partitioner(bboxes, 4);
+            Tree tree;
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4, 4);
+            tree.collect_leaves(partitioner.get_item_ordering(), parallel_leaves);
+            EXPECT_GT(1, builder.get_subtree_count());
+        }
+
+        EXPECT_TRUE(serial_leaves == parallel_leaves);
+    }
+}
+
 TEST_SUITE(Foundation_Math_BVH_SpatialBuilder)
 {
     struct ItemHandler
@@ -118,6 +249,81 @@ TEST_SUITE(Foundation_Math_BVH_SpatialBuilder)
         Tree tree;
         bvh::SpatialBuilder<Tree, Partitioner> builder;
     }
+
+    struct BoxItemHandler
+    {
+        const vector<AABB3d>&   m_bboxes;
+
+        explicit BoxItemHandler(const vector<AABB3d>& bboxes)
+          : m_bboxes(bboxes)
+        {
+        }
+
+        double get_bbox_grow_eps() const
+        {
+            return 1.0e-9;
+        }
+
+        AABB3d clip(
+            const size_t    item_index,
+            const size_t    dimension,
+            const double    slab_min,
+            const double    slab_max) const
+        {
+            AABB3d bbox = m_bboxes[item_index];
+            bbox.min[dimension] = max(bbox.min[dimension], slab_min);
+            bbox.max[dimension] = min(bbox.max[dimension], slab_max);
+            return bbox;
+        }
+
+        bool intersect(
+            const size_t    item_index,
+            const AABB3d&   bbox) const
+        {
+            return AABB3d::overlap(m_bboxes[item_index], bbox);
+        }
+    };
+
+    TEST_CASE(Build_GivenMultipleThreads_ProducesSameLeavesAsSingleThread)
+    {
+        typedef bvh::SBVHPartitioner<BoxItemHandler, vector<AABB3d> > Partitioner;
+        typedef LeafCollectingTree Tree;
+
+        vector<AABB3d> bboxes;
+        create_random_bboxes(bboxes, 20000);
+
+        BoxItemHandler item_handler(bboxes);
+
+        vector<vector<size_t> > serial_leaves;
+        size_t serial_split_count;
+        {
+            Partitioner partitioner(item_handler, bboxes, 4);
+            Partitioner::LeafType* root_leaf = partitioner.create_root_leaf();
+            const AABB3d root_leaf_bbox = partitioner.compute_leaf_bbox(*root_leaf);
+            Tree tree;
+            bvh::SpatialBuilder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(tree, partitioner, root_leaf, root_leaf_bbox);
+            tree.collect_leaves(partitioner.get_item_ordering(), serial_leaves);
+            serial_split_count = partitioner.get_spatial_split_count() + partitioner.get_object_split_count();
+        }
+
+        vector<vector<size_t> > parallel_leaves;
+        size_t parallel_split_count;
+        {
+            Partitioner partitioner(item_handler, bboxes, 4);
+            Partitioner::LeafType* root_leaf = partitioner.create_root_leaf();
+            const AABB3d root_leaf_bbox = partitioner.compute_leaf_bbox(*root_leaf);
+            Tree tree;
+            bvh::SpatialBuilder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(tree, partitioner, root_leaf, root_leaf_bbox, 4);
+            tree.collect_leaves(partitioner.get_item_ordering(), parallel_leaves);
+            parallel_split_count = partitioner.get_spatial_split_count() + partitioner.get_object_split_count();
+            EXPECT_GT(1, builder.get_subtree_count());
+        }
+
+        EXPECT_EQ(serial_split_count, parallel_split_count);
+        EXPECT_TRUE(serial_leaves == parallel_leaves);
+    }
 }
 
 TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
@@ -149,3 +355,404 @@ TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
         > intersector;
     }
 }
+
+TEST_SUITE(Foundation_Math_BVH_QNode)
+{
+    TEST_CASE(TestStorageAndRetrievalOfChildren)
+    {
+        static const AABB3d FirstBBox(Vector3d(1.0, 2.0, 3.0), Vector3d(4.0, 5.0, 6.0));
+        static const AABB3d SecondBBox(Vector3d(7.0, 8.0, 9.0), Vector3d(10.0, 11.0, 12.0));
+
+        bvh::QNode<AABB3d> node;
+        node.clear();
+
+        node.push_child(FirstBBox, 12, false);
+        node.push_child(SecondBBox, 34, true);
+
+        ASSERT_EQ(2, node.get_child_count());
+        EXPECT_EQ(FirstBBox, node.get_child_bbox(0));
+        EXPECT_EQ(SecondBBox, node.get_child_bbox(1));
+        EXPECT_EQ(12, node.get_child_node_index(0));
+        EXPECT_EQ(34, node.get_child_node_index(1));
+        EXPECT_FALSE(node.is_child_leaf(0));
+        EXPECT_TRUE(node.is_child_leaf(1));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_QIntersector)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef AlignedVector<NodeType> NodeVector;
+    typedef AlignedVector<bvh::QNode<AABB3d> > QNodeVector;
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::QTree<QNodeVector, NodeVector> QTree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct Visitor
+    {
+        vector<size_t>  m_visited_leaves;
+
+        bool visit(
+            const NodeType&             node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            m_visited_leaves.push_back(node.get_item_index());
+            distance = ray.m_tmax;
+            return true;
+        }
+    };
+
+    struct Fixture
+    {
+        AABBVector  m_bboxes;
+        Tree        m_tree;
+        QTree       m_qtree;
+
+        Fixture()
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                const Vector3d center(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+                const Vector3d extent(rand_double1(rng, 0.0, 0.05));
+                m_bboxes.push_back(AABB3d(center - extent, center + extent));
+            }
+
+            typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+            Partitioner partitioner(m_bboxes, 2);
+
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, partitioner, m_bboxes.size(), 2);
+
+            bvh::Collapser<Tree, QTree> collapser;
+            collapser.collapse<DefaultWallclockTimer>(m_tree, m_qtree);
+        }
+    };
+
+    TEST_CASE(Collapse_GivenFourLeaves_ReturnsDepthOfOne)
+    {
+        AABBVector bboxes;
+        for (size_t i = 0; i < 4; ++i)
+            bboxes.push_back(AABB3d(Vector3d(i * 2.0, 0.0, 0.0), Vector3d(i * 2.0 + 1.0, 1.0, 1.0)));
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes, 1);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        QTree qtree;
+        bvh::Collapser<Tree, QTree> collapser;
+        collapser.collapse<DefaultWallclockTimer>(tree, qtree);
+
+        EXPECT_EQ(1, qtree.get_interior_node_count());
+        EXPECT_EQ(4, qtree.get_leaf_node_count());
+        EXPECT_EQ(1, collapser.get_depth());
+    }
+
+    TEST_CASE_F(IntersectNoMotion_VisitsSameLeavesAsBinaryIntersector, Fixture)
+    {
+        MersenneTwister rng;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            Vector2d s;
+            s[0] = rand_double2(rng);
+            s[1] = rand_double2(rng);
+
+            const Vector3d origin(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+            const Ray3d ray(origin, sample_sphere_uniform(s));
+            const RayInfo3d ray_info(ray);
+
+            Visitor binary_visitor;
+            bvh::Intersector<Tree, Visitor, Ray3d> binary_intersector;
+            binary_intersector.intersect_no_motion(
+                m_tree,
+                ray,
+                ray_info,
+                binary_visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+            Visitor qbvh_visitor;
+            bvh::QIntersector<QTree, Visitor, Ray3d> qbvh_intersector;
+            qbvh_intersector.intersect_no_motion(
+                m_qtree,
+                ray,
+                ray_info,
+                qbvh_visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+            sort(binary_visitor.m_visited_leaves.begin(), binary_visitor.m_visited_leaves.end());
+            sort(qbvh_visitor.m_visited_leaves.begin(), qbvh_visitor.m_visited_leaves.end());
+
+            EXPECT_EQ(binary_visitor.m_visited_leaves, qbvh_visitor.m_visited_leaves);
+        }
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Intersector_CompactNode)
+{
+    typedef vector<AABB3d> AABBVector;
+
+    template <typename NodeType>
+    struct Visitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        double                  m_closest_hit;
+
+        Visitor(
+            const AABBVector&           bboxes,
+            const vector<size_t>&       ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_closest_hit(numeric_limits<double>::max())
+        {
+        }
+
+        bool visit(
+            const NodeType&             node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[m_ordering[i]], tmin) && tmin < m_closest_hit)
+                    m_closest_hit = tmin;
+            }
+
+            distance = m_closest_hit;
+            return true;
+        }
+    };
+
+    template <typename NodeType>
+    vector<double> find_closest_hits(
+        const AABBVector&               bboxes,
+        const vector<Ray3d>&            rays)
+    {
+        typedef bvh::Tree<AlignedVector<NodeType> > Tree;
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+        Partitioner partitioner(bboxes, 2);
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.template build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 2);
+
+        bvh::Intersector<Tree, Visitor<NodeType>, Ray3d> intersector;
+        vector<double> hits;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            Visitor<NodeType> visitor(bboxes, partitioner.get_item_ordering());
+            intersector.intersect_no_motion(
+                tree,
+                rays[i],
+                RayInfo3d(rays[i]),
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+            hits.push_back(visitor.m_closest_hit);
+        }
+
+        return hits;
+    }
+
+    TEST_CASE(IntersectNoMotion_FindsSameClosestHitsAsRegularNodes)
+    {
+        MersenneTwister rng;
+
+        AABBVector bboxes;
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d center(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+            const Vector3d extent(rand_double1(rng, 0.0, 0.05));
+            bboxes.push_back(AABB3d(center - extent, center + extent));
+        }
+
+        vector<Ray3d> rays;
+        for (size_t i = 0; i < 100; ++i)
+        {
+            Vector2d s;
+            s[0] = rand_double2(rng);
+            s[1] = rand_double2(rng);
+
+            const Vector3d origin(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+            rays.push_back(Ray3d(origin, sample_sphere_uniform(s)));
+        }
+
+        const vector<double> expected = find_closest_hits<bvh::Node<AABB3d> >(bboxes, rays);
+        const vector<double> result = find_closest_hits<bvh::CompactNode<AABB3d> >(bboxes, rays);
+
+        EXPECT_EQ(expected, result);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Refitter)
+{
+    typedef bvh::Node<AABB3d> NodeType;
+    typedef AlignedVector<NodeType> NodeVector;
+    typedef AlignedVector<bvh::QNode<AABB3d> > QNodeVector;
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::QTree<QNodeVector, NodeVector> QTree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct LeafFunc
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+
+        LeafFunc(
+            const AABBVector&           bboxes,
+            const vector<size_t>&       ordering)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+        {
+        }
+
+        AABB3d operator()(NodeType& leaf) const
+        {
+            const size_t begin = leaf.get_item_index();
+            const size_t end = begin + leaf.get_item_count();
+
+            AABB3d bbox;
+            bbox.invalidate();
+
+            for (size_t i = begin; i < end; ++i)
+                bbox.insert(m_bboxes[m_ordering[i]]);
+
+            return bbox;
+        }
+    };
+
+    struct Fixture
+    {
+        AABBVector      m_bboxes;
+        vector<size_t>  m_ordering;
+        Tree            m_tree;
+        QTree           m_qtree;
+
+        Fixture()
+        {
+            create_random_bboxes(m_bboxes, 1000);
+
+            typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+            Partitioner partitioner(m_bboxes, 2);
+
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, partitioner, m_bboxes.size(), 2);
+            m_ordering = partitioner.get_item_ordering();
+
+            bvh::Collapser<Tree, QTree> collapser;
+            collapser.collapse<DefaultWallclockTimer>(m_tree, m_qtree);
+        }
+
+        AABB3d translate_bboxes(const Vector3d& offset)
+        {
+            AABB3d bbox;
+            bbox.invalidate();
+
+            for (size_t i = 0; i < m_bboxes.size(); ++i)
+            {
+                m_bboxes[i] = AABB3d(m_bboxes[i].min + offset, m_bboxes[i].max + offset);
+                bbox.insert(m_bboxes[i]);
+            }
+
+            return bbox;
+        }
+    };
+
+    TEST_CASE_F(Refit_GivenTranslatedItems_ReturnsBoundingBoxOfAllItems, Fixture)
+    {
+        const AABB3d expected_bbox = translate_bboxes(Vector3d(1.0, 2.0, 3.0));
+
+        LeafFunc leaf_func(m_bboxes, m_ordering);
+        bvh::Refitter<Tree> refitter;
+        const AABB3d root_bbox = refitter.refit<DefaultWallclockTimer>(m_tree, leaf_func);
+
+        EXPECT_EQ(expected_bbox, root_bbox);
+    }
+
+    TEST_CASE_F(Refit_GivenTranslatedItems_PreservesCost, Fixture)
+    {
+        const double initial_cost = bvh::Refitter<Tree>::compute_cost(m_tree, 1.0, 1.0);
+
+        translate_bboxes(Vector3d(1.0, 2.0, 3.0));
+
+        LeafFunc leaf_func(m_bboxes, m_ordering);
+        bvh::Refitter<Tree> refitter;
+        refitter.refit<DefaultWallclockTimer>(m_tree, leaf_func);
+
+        EXPECT_FEQ_EPS(initial_cost, bvh::Refitter<Tree>::compute_cost(m_tree, 1.0, 1.0), 1.0e-6);
+    }
+
+    TEST_CASE_F(Refit_GivenShuffledItems_IncreasesCost, Fixture)
+    {
+        const double initial_cost = bvh::Refitter<Tree>::compute_cost(m_tree, 1.0, 1.0);
+
+        reverse(m_bboxes.begin(), m_bboxes.end());
+
+        LeafFunc leaf_func(m_bboxes, m_ordering);
+        bvh::Refitter<Tree> refitter;
+        refitter.refit<DefaultWallclockTimer>(m_tree, leaf_func);
+
+        EXPECT_GT(2.0 * initial_cost, bvh::Refitter<Tree>::compute_cost(m_tree, 1.0, 1.0));
+    }
+
+    TEST_CASE_F(QRefit_GivenTranslatedItems_ReturnsBoundingBoxOfAllItems, Fixture)
+    {
+        const AABB3d expected_bbox = translate_bboxes(Vector3d(1.0, 2.0, 3.0));
+
+        LeafFunc leaf_func(m_bboxes, m_ordering);
+        bvh::QRefitter<QTree> refitter;
+        const AABB3d root_bbox = refitter.refit<DefaultWallclockTimer>(m_qtree, leaf_func);
+
+        EXPECT_EQ(expected_bbox, root_bbox);
+    }
+
+    TEST_CASE_F(QRefit_GivenTranslatedItems_PreservesCost, Fixture)
+    {
+        const double initial_cost = bvh::QRefitter<QTree>::compute_cost(m_qtree, 1.0, 1.0);
+
+        translate_bboxes(Vector3d(1.0, 2.0, 3.0));
+
+        LeafFunc leaf_func(m_bboxes, m_ordering);
+        bvh::QRefitter<QTree> refitter;
+        refitter.refit<DefaultWallclockTimer>(m_qtree, leaf_func);
+
+        EXPECT_FEQ_EPS(initial_cost, bvh::QRefitter<QTree>::compute_cost(m_qtree, 1.0, 1.0), 1.0e-6);
+    }
+}
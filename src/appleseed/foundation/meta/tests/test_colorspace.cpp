@@ -223,6 +223,41 @@ TEST_SUITE(Foundation_Image_ColorSpace)
             1.0e-6f);
     }
 
+    TEST_CASE(TestRGBSpectrumToCIEXYZConversion)
+    {
+        const float Values[3] = { 0.5f, 0.25f, 1.0f };
+        const Spectrum3f spectrum(Values);
+        const LightingConditions lighting_conditions(IlluminantCIED65, XYZCMFCIE196410Deg);
+        const Color3f ciexyz = spectrum_to_ciexyz<float>(lighting_conditions, spectrum);
+
+        EXPECT_FEQ(linear_rgb_to_ciexyz(Color3f(0.5f, 0.25f, 1.0f)), ciexyz);
+    }
+
+    TEST_CASE(TestCIEXYZReflectanceToRGBSpectrumConversion)
+    {
+        const Color3f linear_rgb(0.5f, 0.25f, 1.0f);
+
+        Spectrum3f spectrum;
+        ciexyz_reflectance_to_spectrum(linear_rgb_to_ciexyz(linear_rgb), spectrum);
+
+        const float ExpectedSpectrumValues[3] = { 0.5f, 0.25f, 1.0f };
+
+        EXPECT_FEQ_EPS(
+            Spectrum3f(ExpectedSpectrumValues),
+            spectrum,
+            1.0e-5f);
+    }
+
+    TEST_CASE(TestDaylightCIExyToRGBSpectrumConversion)
+    {
+        // CIE xy chromaticity of the CIE D65 illuminant.
+        Spectrum3f spectrum;
+        daylight_ciexy_to_spectrum(0.31271f, 0.32902f, spectrum);
+
+        EXPECT_FEQ_EPS(Spectrum3f(1.0f), spectrum, 1.0e-3f);
+        EXPECT_FEQ_EPS(1.0f, spectrum_luminance(spectrum), 1.0e-5f);
+    }
+
     TEST_CASE(TestSpectrumToSpectrumConversion)
     {
         static const float InputWavelength[Spectrum31f::Samples] =
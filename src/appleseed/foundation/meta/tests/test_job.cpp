@@ -28,6 +28,7 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/platform/thread.h"
 #include "foundation/platform/timer.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/job/abortswitch.h"
@@ -38,6 +39,9 @@
 #include "foundation/utility/log.h"
 #include "foundation/utility/test.h"
 
+// boost headers.
+#include "boost/cstdint.hpp"
+
 // Standard headers.
 #include <cstddef>
 #include <exception>
@@ -221,7 +225,7 @@ TEST_SUITE(Foundation_Utility_Job_JobQueue)
     {
         JobQueue job_queue;
 
-        EXPECT_EQ(0, job_queue.acquire_scheduled_job().first.m_job);
+        EXPECT_EQ(0, job_queue.acquire_scheduled_job().m_job);
     }
 
     TEST_CASE(AcquireScheduledJobWorksOnNonEmptyJobQueue)
@@ -234,7 +238,7 @@ TEST_SUITE(Foundation_Utility_Job_JobQueue)
         const JobQueue::RunningJobInfo running_job_info =
             job_queue.acquire_scheduled_job();
 
-        EXPECT_EQ(job, running_job_info.first.m_job);
+        EXPECT_EQ(job, running_job_info.m_job);
 
         EXPECT_FALSE(job_queue.has_scheduled_jobs());
         EXPECT_TRUE(job_queue.has_running_jobs());
@@ -331,6 +335,40 @@ TEST_SUITE(Foundation_Utility_Job_JobManager)
         volatile size_t&    m_execution_count;
     };
 
+    class JobCreatingTwoSubJobs
+      : public IJob
+    {
+      public:
+        JobCreatingTwoSubJobs(
+            JobQueue&                   job_queue,
+            volatile boost::uint32_t&   execution_count,
+            const size_t                depth)
+          : m_job_queue(job_queue)
+          , m_execution_count(execution_count)
+          , m_depth(depth)
+        {
+        }
+
+        virtual void execute(const size_t thread_index)
+        {
+            boost_atomic::atomic_inc32(&m_execution_count);
+
+            if (m_depth > 0)
+            {
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    m_job_queue.schedule(
+                        new JobCreatingTwoSubJobs(m_job_queue, m_execution_count, m_depth - 1));
+                }
+            }
+        }
+
+      private:
+        JobQueue&                   m_job_queue;
+        volatile boost::uint32_t&   m_execution_count;
+        const size_t                m_depth;
+    };
+
     TEST_CASE_F(InitialStateIsCorrect, FixtureJobManager)
     {
         EXPECT_EQ(1, job_manager.get_thread_count());
@@ -371,6 +409,24 @@ TEST_SUITE(Foundation_Utility_Job_JobManager)
 
         EXPECT_EQ(1, execution_count);
     }
+
+    TEST_CASE(JobManagerWithMultipleThreadsExecutesAllSubJobs)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4);
+
+        volatile boost::uint32_t execution_count = 0;
+
+        job_queue.schedule(
+            new JobCreatingTwoSubJobs(job_queue, execution_count, 9));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(1023, execution_count);
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Job_WorkerThread)
@@ -47,6 +47,8 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/timer.h"
 #include "foundation/utility/iostreamop.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log.h"
 #include "foundation/utility/test.h"
 
 // STANN headers.
@@ -141,6 +143,63 @@ TEST_SUITE(Foundation_Math_Knn_Builder)
 
         EXPECT_EQ(8 + 4 + 2 + 1, tree.m_nodes.size());
     }
+
+    TEST_CASE(BuildMovePoints_GivenJobQueue_BuildsSameTreeAsSerialBuild)
+    {
+        const size_t PointCount = 100000;
+        const size_t QueryCount = 100;
+        const size_t AnswerSize = 10;
+
+        MersenneTwister rng;
+
+        vector<Vector3d> points(PointCount);
+        for (size_t i = 0; i < PointCount; ++i)
+            points[i] = Vector3d(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+
+        vector<Vector3d> points_copy(points);
+
+        knn::Tree3d serial_tree;
+        knn::Builder3d serial_builder(serial_tree);
+        serial_builder.build_move_points<DefaultWallclockTimer>(points);
+
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4);
+        job_manager.start();
+
+        knn::Tree3d parallel_tree;
+        knn::Builder3d parallel_builder(parallel_tree);
+        parallel_builder.build_move_points<DefaultWallclockTimer>(points_copy, job_queue);
+
+        ASSERT_EQ(serial_tree.m_nodes.size(), parallel_tree.m_nodes.size());
+        EXPECT_TRUE(serial_tree.m_points == parallel_tree.m_points);
+        EXPECT_TRUE(serial_tree.m_indices == parallel_tree.m_indices);
+
+        knn::Answer<double> serial_answer(AnswerSize);
+        knn::Answer<double> parallel_answer(AnswerSize);
+        knn::Query3d serial_query(serial_tree, serial_answer);
+        knn::Query3d parallel_query(parallel_tree, parallel_answer);
+
+        bool all_equal = true;
+
+        for (size_t i = 0; i < QueryCount; ++i)
+        {
+            const Vector3d point(rand_double1(rng), rand_double1(rng), rand_double1(rng));
+
+            serial_query.run(point);
+            parallel_query.run(point);
+            serial_answer.sort();
+            parallel_answer.sort();
+
+            for (size_t j = 0; j < AnswerSize; ++j)
+            {
+                if (serial_answer.get(j).m_index != parallel_answer.get(j).m_index)
+                    all_equal = false;
+            }
+        }
+
+        EXPECT_TRUE(all_equal);
+    }
 }
 
 TEST_SUITE(Foundation_Math_Knn_Answer)
@@ -164,3 +164,62 @@ TEST_SUITE(Foundation_Image_Spectrum31f)
         EXPECT_FALSE(is_saturated(s));
     }
 }
+
+TEST_SUITE(Foundation_Image_Spectrum3f)
+{
+    using namespace foundation;
+
+    TEST_CASE(Set)
+    {
+        const float ExpectedValues[3] = { 42.0f, 42.0f, 42.0f };
+
+        const Spectrum3f Expected(ExpectedValues);
+        Spectrum3f s;
+
+        s.set(42.0f);
+
+        EXPECT_EQ(Expected, s);
+    }
+
+    TEST_CASE(InPlaceAddition)
+    {
+        const float InputValues[3] = { 1.0f, 2.0f, 3.0f };
+        const float RhsValues[3] = { 3.0f, 2.0f, 1.0f };
+
+        const Spectrum3f Expected(4.0f);
+        const Spectrum3f Rhs(RhsValues);
+        Spectrum3f s(InputValues);
+
+        s += Rhs;
+
+        EXPECT_FEQ(Expected, s);
+    }
+
+    TEST_CASE(InPlaceMultiplicationByScalar)
+    {
+        const float InputValues[3] = { 1.0f, 2.0f, 3.0f };
+        const float ExpectedValues[3] = { 2.0f, 4.0f, 6.0f };
+
+        const Spectrum3f Expected(ExpectedValues);
+        Spectrum3f s(InputValues);
+
+        s *= 2.0f;
+
+        EXPECT_FEQ(Expected, s);
+    }
+
+    TEST_CASE(InPlaceMultiplicationBySpectrum)
+    {
+        const float InputValues[3] = { 1.0f, 2.0f, 3.0f };
+        const float RhsValues[3] = { 3.0f, 2.0f, 1.0f };
+        const float ExpectedValues[3] = { 3.0f, 4.0f, 3.0f };
+
+        const Spectrum3f Expected(ExpectedValues);
+        const Spectrum3f Rhs(RhsValues);
+        Spectrum3f s(InputValues);
+
+        s *= Rhs;
+
+        EXPECT_FEQ(Expected, s);
+    }
+}
@@ -31,14 +31,19 @@
 #include "jobqueue.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/rng/xorshift.h"
 #include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/job/ijob.h"
 #include "foundation/utility/foreach.h"
-#include "foundation/utility/iterators.h"
 
 // boost headers.
+#include "boost/cstdint.hpp"
 #include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/tss.hpp"
 
 // Standard headers.
 #include <cassert>
@@ -48,16 +53,90 @@ using namespace std;
 namespace foundation
 {
 
+namespace
+{
+    // Maximum number of per-worker job lists. Worker threads beyond this limit share job lists.
+    const size_t MaxWorkerListCount = 256;
+
+    // Atomically subtract a value from a 32-bit integer and return its previous value.
+    boost::uint32_t atomic_sub32(volatile boost::uint32_t* mem, const boost::uint32_t val)
+    {
+        while (true)
+        {
+            const boost::uint32_t old_value = boost_atomic::atomic_read32(mem);
+
+            if (boost_atomic::atomic_cas32(mem, old_value - val, old_value) == old_value)
+                return old_value;
+        }
+    }
+}
+
+
 //
 // JobQueue class implementation.
 //
 
 struct JobQueue::Impl
 {
-    mutable boost::mutex            m_mutex;
-    boost::condition_variable_any   m_event;
-    JobList                         m_scheduled_jobs;
-    JobList                         m_running_jobs;
+    struct WorkerList
+      : public NonCopyable
+    {
+        Spinlock                        m_lock;
+        JobList                         m_jobs;
+        Xorshift                        m_rng;      // only used by the owning worker thread
+
+        explicit WorkerList(const uint32 seed)
+          : m_rng(seed)
+        {
+        }
+    };
+
+    // Job lists.
+    WorkerList                          m_shared_list;
+    WorkerList*                         m_worker_lists[MaxWorkerListCount];
+    volatile boost::uint32_t            m_worker_list_count;
+    boost::mutex                        m_attach_mutex;
+    boost::thread_specific_ptr<WorkerList> m_local_list;
+
+    // Job counters.
+    volatile boost::uint32_t            m_scheduled_job_count;
+    volatile boost::uint32_t            m_running_job_count;
+    volatile boost::uint32_t            m_pending_job_count;    // scheduled or running
+
+    // Parking of idle worker threads.
+    boost::mutex                        m_park_mutex;
+    boost::condition_variable_any       m_park_event;
+    volatile boost::uint32_t            m_parked_thread_count;
+    volatile boost::uint32_t            m_searching_thread_count;   // woken up but without a job yet
+
+    // Completion notification.
+    boost::mutex                        m_completion_mutex;
+    boost::condition_variable_any       m_completion_event;
+
+    Impl()
+      : m_shared_list(1)
+      , m_worker_list_count(0)
+      , m_local_list(&keep_list)
+      , m_scheduled_job_count(0)
+      , m_running_job_count(0)
+      , m_pending_job_count(0)
+      , m_parked_thread_count(0)
+      , m_searching_thread_count(0)
+    {
+    }
+
+    ~Impl()
+    {
+        const size_t worker_list_count = m_worker_list_count;
+
+        for (size_t i = 0; i < worker_list_count; ++i)
+            delete m_worker_lists[i];
+    }
+
+    // Job lists are owned by the queue, not by the threads bound to them.
+    static void keep_list(WorkerList* list)
+    {
+    }
 
     static void delete_jobs(JobList& list)
     {
@@ -66,9 +145,122 @@ struct JobQueue::Impl
             if (i->m_owned)
                 delete i->m_job;
         }
- 
+
         list.clear();
     }
+
+    // Delete all the jobs of a job list and return how many there were.
+    static size_t clear_list(WorkerList& list)
+    {
+        Spinlock::ScopedLock lock(list.m_lock);
+
+        const size_t job_count = list.m_jobs.size();
+        delete_jobs(list.m_jobs);
+
+        return job_count;
+    }
+
+    static void push_back(WorkerList& list, const JobInfo& job_info)
+    {
+        Spinlock::ScopedLock lock(list.m_lock);
+
+        list.m_jobs.push_back(job_info);
+    }
+
+    static bool pop_back(WorkerList& list, JobInfo& job_info)
+    {
+        Spinlock::ScopedLock lock(list.m_lock);
+
+        if (list.m_jobs.empty())
+            return false;
+
+        job_info = list.m_jobs.back();
+        list.m_jobs.pop_back();
+
+        return true;
+    }
+
+    static bool pop_front(WorkerList& list, JobInfo& job_info)
+    {
+        Spinlock::ScopedLock lock(list.m_lock);
+
+        if (list.m_jobs.empty())
+            return false;
+
+        job_info = list.m_jobs.front();
+        list.m_jobs.pop_front();
+
+        return true;
+    }
+
+    // Like pop_front() but give up immediately if the job list is in use.
+    static bool steal(WorkerList& list, JobInfo& job_info)
+    {
+        if (!list.m_lock.try_lock())
+            return false;
+
+        const bool found = !list.m_jobs.empty();
+
+        if (found)
+        {
+            job_info = list.m_jobs.front();
+            list.m_jobs.pop_front();
+        }
+
+        list.m_lock.unlock();
+
+        return found;
+    }
+
+    bool find_job(JobInfo& job_info)
+    {
+        WorkerList* local_list = m_local_list.get();
+
+        // Jobs scheduled by this worker thread come first, most recent first.
+        if (local_list && pop_back(*local_list, job_info))
+            return true;
+
+        // Then come jobs scheduled from outside the worker threads.
+        if (pop_front(m_shared_list, job_info))
+            return true;
+
+        // Finally, try to steal the oldest job of another worker thread.
+        const size_t worker_list_count = boost_atomic::atomic_read32(&m_worker_list_count);
+
+        if (worker_list_count == 0)
+            return false;
+
+        const size_t first_victim =
+            local_list ? local_list->m_rng.rand_uint32() % worker_list_count : 0;
+
+        for (size_t i = 0; i < worker_list_count; ++i)
+        {
+            WorkerList* victim = m_worker_lists[(first_victim + i) % worker_list_count];
+
+            if (victim != local_list && steal(*victim, job_info))
+                return true;
+        }
+
+        return false;
+    }
+
+    // Wake up a parked worker thread, unless one is already looking for jobs.
+    void wake_parked_thread()
+    {
+        if (boost_atomic::atomic_read32(&m_parked_thread_count) > 0 &&
+            boost_atomic::atomic_read32(&m_searching_thread_count) == 0)
+        {
+            boost::mutex::scoped_lock lock(m_park_mutex);
+            m_park_event.notify_one();
+        }
+    }
+
+    void notify_completion()
+    {
+        boost::mutex::scoped_lock lock(m_completion_mutex);
+
+        m_completion_event.notify_all();
+    }
 };
 
 JobQueue::JobQueue()
@@ -81,142 +273,194 @@ JobQueue::~JobQueue()
     // We assume that worker threads are not running, so we don't lock.
 
     // At this point, no job must be running.
-    assert(impl->m_running_jobs.empty());
+    assert(impl->m_running_job_count == 0);
 
     // Delete all scheduled jobs that the queue owns.
-    Impl::delete_jobs(impl->m_scheduled_jobs);
+    clear_scheduled_jobs();
 
     delete impl;
 }
 
 void JobQueue::clear_scheduled_jobs()
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    size_t job_count = Impl::clear_list(impl->m_shared_list);
+
+    const size_t worker_list_count = boost_atomic::atomic_read32(&impl->m_worker_list_count);
 
-    impl->delete_jobs(impl->m_scheduled_jobs);
+    for (size_t i = 0; i < worker_list_count; ++i)
+        job_count += Impl::clear_list(*impl->m_worker_lists[i]);
 
-    // Notify worker threads that all scheduled jobs are gone.
-    impl->m_event.notify_all();
+    if (job_count == 0)
+        return;
+
+    atomic_sub32(&impl->m_scheduled_job_count, static_cast<boost::uint32_t>(job_count));
+
+    // Notify waiting threads if there is no more scheduled or running jobs.
+    if (atomic_sub32(&impl->m_pending_job_count, static_cast<boost::uint32_t>(job_count)) == job_count)
+        impl->notify_completion();
 }
 
 bool JobQueue::has_scheduled_jobs() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return !impl->m_scheduled_jobs.empty();
+    return boost_atomic::atomic_read32(&impl->m_scheduled_job_count) > 0;
 }
 
 bool JobQueue::has_running_jobs() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return !impl->m_running_jobs.empty();
+    return boost_atomic::atomic_read32(&impl->m_running_job_count) > 0;
 }
 
 bool JobQueue::has_scheduled_or_running_jobs() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return !impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty();
+    return boost_atomic::atomic_read32(&impl->m_pending_job_count) > 0;
 }
 
 size_t JobQueue::get_scheduled_job_count() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return impl->m_scheduled_jobs.size();
+    return boost_atomic::atomic_read32(&impl->m_scheduled_job_count);
 }
 
 size_t JobQueue::get_running_job_count() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return impl->m_running_jobs.size();
+    return boost_atomic::atomic_read32(&impl->m_running_job_count);
 }
 
 size_t JobQueue::get_total_job_count() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    return impl->m_scheduled_jobs.size() + impl->m_running_jobs.size();
+    return boost_atomic::atomic_read32(&impl->m_pending_job_count);
 }
 
 void JobQueue::schedule(IJob* job, const bool transfer_ownership)
 {
     assert(job);
 
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    // Count the job before it becomes visible to worker threads.
+    boost_atomic::atomic_inc32(&impl->m_pending_job_count);
+    boost_atomic::atomic_inc32(&impl->m_scheduled_job_count);
 
-    impl->m_scheduled_jobs.push_back(JobInfo(job, transfer_ownership));
+    // Worker threads push jobs to their own job list, other threads to the shared one.
+    Impl::WorkerList* local_list = impl->m_local_list.get();
+    Impl::push_back(
+        local_list ? *local_list : impl->m_shared_list,
+        JobInfo(job, transfer_ownership));
 
-    // Notify worker threads that a new scheduled job is available.
-    impl->m_event.notify_all();
+    impl->wake_parked_thread();
 }
 
 void JobQueue::wait_until_completion()
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    boost::mutex::scoped_lock lock(impl->m_completion_mutex);
 
     // Wait until there is no more scheduled or running jobs.
-    while (!impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty())
-        impl->m_event.wait(lock);
+    while (boost_atomic::atomic_read32(&impl->m_pending_job_count) > 0)
+        impl->m_completion_event.wait(lock);
 }
 
-JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
+void JobQueue::attach_worker(const size_t worker_index)
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    const size_t list_index = worker_index % MaxWorkerListCount;
+
+    boost::mutex::scoped_lock lock(impl->m_attach_mutex);
 
-    return acquire_scheduled_job_unlocked();
+    // Create the job lists up to and including the one of this worker thread.
+    const size_t worker_list_count = impl->m_worker_list_count;
+
+    for (size_t i = worker_list_count; i <= list_index; ++i)
+    {
+        impl->m_worker_lists[i] = new Impl::WorkerList(static_cast<uint32>(2 * i + 3));
+        boost_atomic::atomic_write32(&impl->m_worker_list_count, static_cast<boost::uint32_t>(i + 1));
+    }
+
+    impl->m_local_list.reset(impl->m_worker_lists[list_index]);
 }
 
-JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_switch)
+void JobQueue::detach_worker()
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    // Jobs left in the job list of this thread remain available to other threads.
+    impl->m_local_list.reset();
+}
 
-    // Wait for a scheduled job to be available.
-    while (!abort_switch.is_aborted() && impl->m_scheduled_jobs.empty())    // order matters
-        impl->m_event.wait(lock);
+JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
+{
+    JobInfo job_info(0, false);
 
-    return acquire_scheduled_job_unlocked();
+    if (impl->find_job(job_info))
+    {
+        // Move the job from the scheduled to the running state.
+        boost_atomic::atomic_inc32(&impl->m_running_job_count);
+        boost_atomic::atomic_dec32(&impl->m_scheduled_job_count);
+    }
+
+    return job_info;
 }
 
-JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_unlocked()
+JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_switch)
 {
-    // Bail out if there is no scheduled job.
-    if (impl->m_scheduled_jobs.empty())
-        return RunningJobInfo(JobInfo(0, false), impl->m_running_jobs.end());
+    bool searching = false;
 
-    // Move the next scheduled job to the end of the queue of running jobs.
-    const JobInfo job_info = impl->m_scheduled_jobs.front();
-    impl->m_scheduled_jobs.pop_front();
-    impl->m_running_jobs.push_back(job_info);
+    while (true)
+    {
+        const RunningJobInfo running_job_info = acquire_scheduled_job();
+
+        if (running_job_info.m_job || abort_switch.is_aborted())
+        {
+            if (searching)
+            {
+                boost_atomic::atomic_dec32(&impl->m_searching_thread_count);
 
-    // Notify worker threads that a job has moved from the scheduled to the running state.
-    impl->m_event.notify_all();
+                // Let another parked thread take over the search if more jobs are waiting.
+                if (running_job_info.m_job &&
+                    boost_atomic::atomic_read32(&impl->m_scheduled_job_count) > 0)
+                    impl->wake_parked_thread();
+            }
 
-    return RunningJobInfo(job_info, pred(impl->m_running_jobs.end()));
+            return running_job_info;
+        }
+
+        // A job is being scheduled or acquired by another thread, or its job list was busy.
+        if (boost_atomic::atomic_read32(&impl->m_scheduled_job_count) > 0)
+        {
+            yield();
+            continue;
+        }
+
+        // Park this thread until a job is scheduled.
+        boost::mutex::scoped_lock lock(impl->m_park_mutex);
+
+        if (searching)
+            boost_atomic::atomic_dec32(&impl->m_searching_thread_count);
+
+        boost_atomic::atomic_inc32(&impl->m_parked_thread_count);
+
+        while (!abort_switch.is_aborted() &&
+               boost_atomic::atomic_read32(&impl->m_scheduled_job_count) == 0)  // order matters
+            impl->m_park_event.wait(lock);
+
+        boost_atomic::atomic_dec32(&impl->m_parked_thread_count);
+        boost_atomic::atomic_inc32(&impl->m_searching_thread_count);
+
+        searching = true;
+    }
 }
 
 void JobQueue::retire_running_job(const RunningJobInfo& running_job_info)
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
-    // Remove the job from the running list.
-    impl->m_running_jobs.erase(running_job_info.second);
-
     // Delete the job.
-    if (running_job_info.first.m_owned)
-        delete running_job_info.first.m_job;
+    if (running_job_info.m_owned)
+        delete running_job_info.m_job;
+
+    boost_atomic::atomic_dec32(&impl->m_running_job_count);
 
-    // Notify worker threads that a scheduled job was retired.
-    impl->m_event.notify_all();
+    // Notify waiting threads if there is no more scheduled or running jobs.
+    if (boost_atomic::atomic_dec32(&impl->m_pending_job_count) == 1)
+        impl->notify_completion();
 }
 
 void JobQueue::signal_event()
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
+    boost::mutex::scoped_lock lock(impl->m_park_mutex);
 
-    impl->m_event.notify_all();
+    impl->m_park_event.notify_all();
 }
 
 }   // namespace foundation
@@ -32,7 +32,6 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
-#include "foundation/utility/poolallocator.h"
 #include "foundation/utility/test.h"
 
 // appleseed.main headers.
@@ -40,7 +39,7 @@
 
 // Standard headers.
 #include <cstddef>
-#include <list>
+#include <deque>
 
 // Forward declarations.
 namespace foundation    { class AbortSwitch; }
@@ -66,6 +65,14 @@ namespace foundation
 //   - scheduled: the job was inserted into the job queue, but hasn't yet been executed
 //   - running: the job is currently being executed
 //
+// Scheduled jobs are distributed over several double-ended queues: one
+// per worker thread, plus one for jobs scheduled from any other thread.
+// A worker thread pushes the jobs it schedules to its own queue and
+// executes them in last-in first-out order. When its own queue is empty,
+// it takes jobs from the shared queue, then steals jobs from the queues
+// of randomly chosen worker threads, in first-in first-out order. Worker
+// threads that cannot find any job are parked until a job is scheduled.
+//
 
 class DLLSYMBOL JobQueue
   : public NonCopyable
@@ -120,7 +127,7 @@ class DLLSYMBOL JobQueue
     struct JobInfo
     {
         IJob*       m_job;
-        const bool  m_owned;
+        bool        m_owned;
 
         JobInfo(IJob* job, const bool owned)
           : m_job(job)
@@ -129,9 +136,15 @@ class DLLSYMBOL JobQueue
         }
     };
 
-    typedef std::list<JobInfo, PoolAllocator<JobInfo, 64> > JobList;
+    typedef std::deque<JobInfo> JobList;
+
+    typedef JobInfo RunningJobInfo;
 
-    typedef std::pair<JobInfo, JobList::iterator> RunningJobInfo;
+    // Bind the calling thread to the job list of a given worker thread.
+    void attach_worker(const size_t worker_index);
+
+    // Unbind the calling thread from its job list.
+    void detach_worker();
 
     // Acquire a scheduled job and change its state from 'scheduled' to 'running'.
     RunningJobInfo acquire_scheduled_job();
@@ -139,9 +152,6 @@ class DLLSYMBOL JobQueue
     // Wait for a scheduled job to be available.
     RunningJobInfo wait_for_scheduled_job(AbortSwitch& abort_switch);
 
-    // Acquire a scheduled job without any locking.
-    RunningJobInfo acquire_scheduled_job_unlocked();
-
     // Retire a running job. The job is deleted if it is owned by the queue.
     void retire_running_job(const RunningJobInfo& running_job_info);
 
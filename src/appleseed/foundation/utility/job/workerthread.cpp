@@ -100,6 +100,9 @@ void WorkerThread::stop()
 
 void WorkerThread::run()
 {
+    // Jobs scheduled from this thread will go to its own job list.
+    m_job_queue.attach_worker(m_index);
+
     while (!m_abort_switch.is_aborted())
     {
         // Acquire a job.
@@ -107,7 +110,7 @@ void WorkerThread::run()
             m_job_queue.wait_for_scheduled_job(m_abort_switch);
 
         // Handle the case where the job queue is empty.
-        if (running_job_info.first.m_job == 0)
+        if (running_job_info.m_job == 0)
         {
             if (m_flags & JobManager::KeepRunningOnEmptyQueue)
             {
@@ -122,7 +125,7 @@ void WorkerThread::run()
         }
 
         // Execute the job.
-        const bool success = execute_job(*running_job_info.first.m_job);
+        const bool success = execute_job(*running_job_info.m_job);
 
         // Retire the job.
         m_job_queue.retire_running_job(running_job_info);
@@ -134,6 +137,8 @@ void WorkerThread::run()
             break;
         }
     }
+
+    m_job_queue.detach_worker();
 }
 
 bool WorkerThread::execute_job(IJob& job)
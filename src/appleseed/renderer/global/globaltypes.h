@@ -52,7 +52,11 @@ typedef foundation::AABB<GScalar, 3> GAABB3;
 typedef foundation::AABB<GScalar, 1> GAABB1;
 
 // Spectrum representation.
-typedef foundation::RegularSpectrum<float, 31> Spectrum;
+#ifdef USE_RGB_SPECTRUM
+    typedef foundation::RegularSpectrum<float, 3> Spectrum;
+#else
+    typedef foundation::RegularSpectrum<float, 31> Spectrum;
+#endif
 
 // Alpha channel representation.
 typedef foundation::Color<float, 1> Alpha;
@@ -43,8 +43,11 @@
 #include "foundation/math/intersection.h"
 #include "foundation/math/permutation.h"
 #include "foundation/platform/system.h"
+#include "foundation/platform/thread.h"
 #include "foundation/platform/timer.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
 // Standard headers.
@@ -61,11 +64,14 @@ namespace renderer
 // AssemblyTree class implementation.
 //
 
-AssemblyTree::AssemblyTree(const Scene& scene)
+AssemblyTree::AssemblyTree(
+    const Scene&    scene,
+    const size_t    build_thread_count)
   : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
   , m_scene(scene)
+  , m_build_cost(0.0)
 {
-    update();
+    update(build_thread_count);
 }
 
 AssemblyTree::~AssemblyTree()
@@ -84,12 +90,156 @@ AssemblyTree::~AssemblyTree()
     m_triangle_trees.clear();
 }
 
-void AssemblyTree::update()
+void AssemblyTree::update(const size_t build_thread_count)
 {
-    rebuild_assembly_tree();
+    m_build_thread_count = build_thread_count;
+
+    if (!update_assembly_tree())
+        rebuild_assembly_tree();
+
     update_child_trees();
 }
 
+namespace
+{
+    struct ChildTreeBuildContext
+      : public NonCopyable
+    {
+        JobQueue        m_job_queue;
+        boost::mutex    m_mutex;
+        size_t          m_tree_count;
+        double          m_cumulated_build_time;
+
+        ChildTreeBuildContext()
+          : m_tree_count(0)
+          , m_cumulated_build_time(0.0)
+        {
+        }
+
+        void report_build(const double build_time)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            ++m_tree_count;
+            m_cumulated_build_time += build_time;
+        }
+    };
+
+    class TriangleTreeBuildJob
+      : public IJob
+    {
+      public:
+        TriangleTreeBuildJob(
+            ChildTreeBuildContext&  context,
+            Lazy<TriangleTree>*     triangle_tree)
+          : m_context(context)
+          , m_triangle_tree(triangle_tree)
+        {
+        }
+
+        virtual void execute(const size_t thread_index)
+        {
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            // Acquiring access to the tree builds it if necessary.
+            Access<TriangleTree> access(m_triangle_tree);
+
+            m_context.report_build(stopwatch.measure().get_seconds());
+        }
+
+      private:
+        ChildTreeBuildContext&      m_context;
+        Lazy<TriangleTree>*         m_triangle_tree;
+    };
+
+    class RegionTreeBuildJob
+      : public IJob
+    {
+      public:
+        RegionTreeBuildJob(
+            ChildTreeBuildContext&  context,
+            Lazy<RegionTree>*       region_tree)
+          : m_context(context)
+          , m_region_tree(region_tree)
+        {
+        }
+
+        virtual void execute(const size_t thread_index)
+        {
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            // Acquiring access to the tree builds it if necessary.
+            Access<RegionTree> access(m_region_tree);
+
+            m_context.report_build(stopwatch.measure().get_seconds());
+
+            // Build the triangle trees of the leaves of the region tree.
+            const TriangleTreeContainer& triangle_trees = access->get_triangle_trees();
+            for (const_each<TriangleTreeContainer> i = triangle_trees; i; ++i)
+                m_context.m_job_queue.schedule(new TriangleTreeBuildJob(m_context, i->second));
+        }
+
+      private:
+        ChildTreeBuildContext&      m_context;
+        Lazy<RegionTree>*           m_region_tree;
+    };
+}
+
+void AssemblyTree::build_child_trees(const size_t thread_count) const
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    ChildTreeBuildContext context;
+
+    for (const_each<RegionTreeContainer> i = m_region_trees; i; ++i)
+        context.m_job_queue.schedule(new RegionTreeBuildJob(context, i->second));
+
+    for (const_each<TriangleTreeContainer> i = m_triangle_trees; i; ++i)
+        context.m_job_queue.schedule(new TriangleTreeBuildJob(context, i->second));
+
+    RENDERER_LOG_INFO(
+        "building child trees of the assembly tree using %s %s...",
+        pretty_uint(thread_count).c_str(),
+        plural(thread_count, "thread").c_str());
+
+    JobManager job_manager(
+        global_logger(),
+        context.m_job_queue,
+        thread_count,
+        JobManager::KeepRunningOnEmptyQueue);
+    job_manager.start();
+    context.m_job_queue.wait_until_completion();
+
+    const double wall_time = stopwatch.measure().get_seconds();
+    const double saved_time = max(context.m_cumulated_build_time - wall_time, 0.0);
+
+    RENDERER_LOG_INFO(
+        "built %s child %s in %s, saving %s over building them one after another.",
+        pretty_uint(context.m_tree_count).c_str(),
+        plural(context.m_tree_count, "tree").c_str(),
+        pretty_time(wall_time).c_str(),
+        pretty_time(saved_time).c_str());
+}
+
+void AssemblyTree::update_alpha_mapped_object_instances() const
+{
+    for (const_each<RegionTreeContainer> i = m_region_trees; i; ++i)
+    {
+        Update<RegionTree> access(i->second);
+        if (access.get())
+            access->update_alpha_mapped_object_instances();
+    }
+
+    for (const_each<TriangleTreeContainer> i = m_triangle_trees; i; ++i)
+    {
+        Update<TriangleTree> access(i->second);
+        if (access.get())
+            access->update_alpha_mapped_object_instances();
+    }
+}
+
 size_t AssemblyTree::get_memory_size() const
 {
     return
@@ -97,6 +247,8 @@ size_t AssemblyTree::get_memory_size() const
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
         + m_items.capacity() * sizeof(AssemblyInstance*)
+        + m_item_bboxes.capacity() * sizeof(AABB3d)
+        + m_instance_infos.capacity() * sizeof(InstanceInfo)
         + m_assembly_versions.size() * sizeof(pair<UniqueID, VersionID>);
 }
 
@@ -113,6 +265,17 @@ void AssemblyTree::collect_assembly_instances(
         // Retrieve the assembly.
         const Assembly& assembly = assembly_instance.get_assembly();
 
+        // Remember the state of this assembly instance for subsequent updates.
+        const size_t instance_index = m_instance_infos.size();
+        InstanceInfo instance_info;
+        instance_info.m_assembly_instance_uid = assembly_instance.get_uid();
+        instance_info.m_assembly_instance_version_id = assembly_instance.get_version_id();
+        instance_info.m_assembly_uid = assembly.get_uid();
+        instance_info.m_assembly_version_id = assembly.get_version_id();
+        instance_info.m_transform_sequence = assembly_instance.transform_sequence();
+        instance_info.m_item_index = ~0;
+        m_instance_infos.push_back(instance_info);
+
         // Compute the cumulated transform sequence of this assembly instance.
         TransformSequence cumulated_transform_seq =
             assembly_instance.transform_sequence() * parent_transform_seq;
@@ -129,6 +292,7 @@ void AssemblyTree::collect_assembly_instances(
             continue;
 
         // Create and store an item for this assembly instance.
+        m_instance_infos[instance_index].m_item_index = m_items.size();
         m_items.push_back(
             Item(
                 &assembly,
@@ -149,6 +313,8 @@ void AssemblyTree::rebuild_assembly_tree()
     // Clear the current tree.
     clear();
     m_items.clear();
+    m_item_bboxes.clear();
+    m_instance_infos.clear();
 
     Statistics statistics;
 
@@ -192,8 +358,32 @@ void AssemblyTree::rebuild_assembly_tree()
             &ordering[0],
             ordering.size());
 
+        // Keep the bounding boxes of the items, in the same order, to refit the tree later on.
+        m_item_bboxes.resize(ordering.size());
+        vector<size_t> item_indices(ordering.size());
+        for (size_t i = 0; i < ordering.size(); ++i)
+        {
+            m_item_bboxes[i] = assembly_instance_bboxes[ordering[i]];
+            item_indices[ordering[i]] = i;
+        }
+
+        // Point the assembly instances to their items in tree order.
+        for (each<InstanceInfoVector> i = m_instance_infos; i; ++i)
+        {
+            if (i->m_item_index != size_t(~0))
+                i->m_item_index = item_indices[i->m_item_index];
+        }
+
         // Store the items in the tree leaves whenever possible.
         store_items_in_leaves(statistics);
+
+        // Compute the cost of the tree, refitting is allowed until it grows too much.
+        m_build_cost =
+            bvh::Refitter<TreeType>::compute_cost(
+                *this,
+                AssemblyTreeInteriorNodeTraversalCost,
+                AssemblyTreeTriangleIntersectionCost);
+        statistics.insert("sah cost", m_build_cost);
     }
 
     // Print assembly tree statistics.
@@ -225,7 +415,7 @@ void AssemblyTree::store_items_in_leaves(Statistics& statistics)
                 ++fat_leaf_count;
 
                 const size_t item_begin = node.get_item_index();
-                Item* user_data = &node.get_user_data<Item>();
+                Item* user_data = reinterpret_cast<Item*>(&node.get_user_data<uint8>());
 
                 for (size_t j = 0; j < item_count; ++j)
                     user_data[j] = m_items[item_begin + j];
@@ -236,6 +426,188 @@ void AssemblyTree::store_items_in_leaves(Statistics& statistics)
     statistics.insert_percent("fat leaves", fat_leaf_count, leaf_count);
 }
 
+bool AssemblyTree::update_assembly_instances(
+    const AssemblyInstanceContainer&    assembly_instances,
+    const TransformSequence&            parent_transform_seq,
+    const bool                          parent_touched,
+    size_t&                             instance_index,
+    size_t&                             touched_item_count)
+{
+    for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+    {
+        // Retrieve the assembly instance.
+        const AssemblyInstance& assembly_instance = *i;
+
+        // Retrieve the assembly.
+        const Assembly& assembly = assembly_instance.get_assembly();
+
+        // Assembly instances must be visited in the same order as when the tree was built.
+        if (instance_index >= m_instance_infos.size())
+            return false;
+        InstanceInfo& instance_info = m_instance_infos[instance_index++];
+        if (instance_info.m_assembly_instance_uid != assembly_instance.get_uid() ||
+            instance_info.m_assembly_uid != assembly.get_uid())
+            return false;
+
+        // Assemblies that became empty or non-empty change the set of items.
+        const bool has_item = instance_info.m_item_index != size_t(~0);
+        if (assembly.object_instances().empty() == has_item)
+            return false;
+
+        // Determine whether this assembly instance needs to be updated. The transform sequence is
+        // compared by value since it can be modified without bumping the version of the instance.
+        const bool touched =
+            parent_touched ||
+            instance_info.m_assembly_instance_version_id != assembly_instance.get_version_id() ||
+            instance_info.m_assembly_version_id != assembly.get_version_id() ||
+            instance_info.m_transform_sequence != assembly_instance.transform_sequence();
+        instance_info.m_assembly_instance_version_id = assembly_instance.get_version_id();
+        instance_info.m_assembly_version_id = assembly.get_version_id();
+        if (touched)
+            instance_info.m_transform_sequence = assembly_instance.transform_sequence();
+
+        // The cumulated transform sequence is only needed by updated assembly instances and their children.
+        const bool has_children = !assembly.assembly_instances().empty();
+        TransformSequence cumulated_transform_seq;
+        if (touched || has_children)
+        {
+            cumulated_transform_seq = assembly_instance.transform_sequence() * parent_transform_seq;
+            cumulated_transform_seq.prepare();
+        }
+
+        // Recurse into child assembly instances.
+        if (has_children)
+        {
+            if (!update_assembly_instances(
+                    assembly.assembly_instances(),
+                    cumulated_transform_seq,
+                    touched,
+                    instance_index,
+                    touched_item_count))
+                return false;
+        }
+
+        // Update the item of this assembly instance and its bounding box.
+        if (touched && has_item)
+        {
+            m_items[instance_info.m_item_index].m_transform_sequence = cumulated_transform_seq;
+
+            AABB3d assembly_instance_bbox(
+                cumulated_transform_seq.to_parent(
+                    assembly.compute_non_hierarchical_local_bbox()));
+            assembly_instance_bbox.robust_grow(1.0e-15);
+            m_item_bboxes[instance_info.m_item_index] = assembly_instance_bbox;
+
+            ++touched_item_count;
+        }
+    }
+
+    return true;
+}
+
+namespace
+{
+    class ItemLeafRefitter
+    {
+      public:
+        explicit ItemLeafRefitter(const vector<AABB3d>& item_bboxes)
+          : m_item_bboxes(item_bboxes)
+        {
+        }
+
+        AABB3d operator()(const AssemblyTree::NodeType& leaf) const
+        {
+            const size_t item_begin = leaf.get_item_index();
+            const size_t item_count = leaf.get_item_count();
+
+            AABB3d leaf_bbox;
+            leaf_bbox.invalidate();
+
+            for (size_t i = 0; i < item_count; ++i)
+                leaf_bbox.insert(m_item_bboxes[item_begin + i]);
+
+            return leaf_bbox;
+        }
+
+      private:
+        const vector<AABB3d>& m_item_bboxes;
+    };
+}
+
+bool AssemblyTree::update_assembly_tree()
+{
+    // Nothing to update if the tree was never built.
+    if (m_nodes.empty() || m_items.empty())
+        return false;
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Update the items of the assembly instances that have changed.
+    size_t instance_index = 0;
+    size_t touched_item_count = 0;
+    if (!update_assembly_instances(
+            m_scene.assembly_instances(),
+            TransformSequence(),
+            false,
+            instance_index,
+            touched_item_count) ||
+        instance_index != m_instance_infos.size())
+    {
+        RENDERER_LOG_INFO("assembly instances have changed, assembly tree will be rebuilt.");
+        return false;
+    }
+
+    Statistics statistics;
+    statistics.insert(
+        "touched instances",
+        pretty_uint(touched_item_count) + " (" + pretty_percent(touched_item_count, m_items.size()) + ")");
+
+    if (touched_item_count > 0)
+    {
+        RENDERER_LOG_INFO(
+            "refitting assembly tree (%s of %s %s touched)...",
+            pretty_uint(touched_item_count).c_str(),
+            pretty_uint(m_items.size()).c_str(),
+            plural(m_items.size(), "assembly instance").c_str());
+
+        // Refit the tree.
+        ItemLeafRefitter leaf_refitter(m_item_bboxes);
+        bvh::Refitter<TreeType> refitter;
+        refitter.refit<DefaultWallclockTimer>(*this, leaf_refitter);
+        statistics.insert_time("refit time", refitter.get_refit_time());
+
+        // Rebuild the tree if its quality has degraded too much.
+        const double cost =
+            bvh::Refitter<TreeType>::compute_cost(
+                *this,
+                AssemblyTreeInteriorNodeTraversalCost,
+                AssemblyTreeTriangleIntersectionCost);
+        if (cost > m_build_cost * (1.0 + AssemblyTreeRefitMaxCostIncrease))
+        {
+            RENDERER_LOG_INFO(
+                "sah cost of assembly tree increased from %f to %f, assembly tree will be rebuilt.",
+                m_build_cost,
+                cost);
+            return false;
+        }
+        statistics.insert("sah cost", cost);
+
+        // Items stored in the leaves have changed.
+        store_items_in_leaves(statistics);
+    }
+
+    statistics.insert_time("total time", stopwatch.measure().get_seconds());
+
+    // Print assembly tree statistics.
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "assembly tree update statistics",
+            statistics).to_string().c_str());
+
+    return true;
+}
+
 void AssemblyTree::collect_unique_assemblies(AssemblyVector& assemblies) const
 {
     assert(assemblies.empty());
@@ -294,7 +666,10 @@ namespace
         }
     }
 
-    Lazy<TriangleTree>* create_triangle_tree(const Scene& scene, const Assembly& assembly)
+    TriangleTree::Arguments make_triangle_tree_arguments(
+        const Scene&        scene,
+        const Assembly&     assembly,
+        const size_t        build_thread_count)
     {
         // Compute the assembly space bounding box of the assembly.
         const GAABB3 assembly_bbox =
@@ -305,26 +680,53 @@ namespace
         RegionInfoVector regions;
         collect_regions(assembly, regions);
 
+        return
+            TriangleTree::Arguments(
+                scene,
+                assembly.get_uid(),
+                assembly_bbox,
+                assembly,
+                regions,
+                build_thread_count);
+    }
+
+    Lazy<TriangleTree>* create_triangle_tree(
+        const Scene&        scene,
+        const Assembly&     assembly,
+        const size_t        build_thread_count)
+    {
         auto_ptr<ILazyFactory<TriangleTree> > triangle_tree_factory(
             new TriangleTreeFactory(
-                TriangleTree::Arguments(
-                    scene,
-                    assembly.get_uid(),
-                    assembly_bbox,
-                    assembly,
-                    regions)));
+                make_triangle_tree_arguments(scene, assembly, build_thread_count)));
 
         return new Lazy<TriangleTree>(triangle_tree_factory);
     }
 
-    Lazy<RegionTree>* create_region_tree(const Scene& scene, const Assembly& assembly)
+    bool refit_triangle_tree(
+        const Scene&        scene,
+        const Assembly&     assembly,
+        const size_t        build_thread_count,
+        Lazy<TriangleTree>* triangle_tree)
+    {
+        // Trees that haven't been built yet will be built from the new geometry anyway.
+        Update<TriangleTree> access(triangle_tree);
+        return
+            access.get() &&
+            access->refit(make_triangle_tree_arguments(scene, assembly, build_thread_count));
+    }
+
+    Lazy<RegionTree>* create_region_tree(
+        const Scene&        scene,
+        const Assembly&     assembly,
+        const size_t        build_thread_count)
     {
         auto_ptr<ILazyFactory<RegionTree> > region_tree_factory(
             new RegionTreeFactory(
                 RegionTree::Arguments(
                     scene,
                     assembly.get_uid(),
-                    assembly)));
+                    assembly,
+                    build_thread_count)));
 
         return new Lazy<RegionTree>(region_tree_factory);
     }
@@ -336,6 +738,22 @@ void AssemblyTree::update_child_trees()
     AssemblyVector assemblies;
     collect_unique_assemblies(assemblies);
 
+    // Child trees may be built concurrently (by build_child_trees() or by rendering threads),
+    // unless there is a single one: only use multiple threads per tree in that case.
+    // Region trees always have several triangle trees.
+    size_t child_tree_count = 0;
+    bool has_region_trees = false;
+    for (const_each<AssemblyVector> i = assemblies; i; ++i)
+    {
+        if (!(*i)->object_instances().empty())
+        {
+            ++child_tree_count;
+            has_region_trees = has_region_trees || (*i)->is_flushable();
+        }
+    }
+    const size_t child_tree_build_thread_count =
+        child_tree_count == 1 && !has_region_trees ? m_build_thread_count : 1;
+
     // Create or rebuild the child tree of each assembly.
     for (const_each<AssemblyVector> i = assemblies; i; ++i)
     {
@@ -373,8 +791,8 @@ void AssemblyTree::update_child_trees()
             }
             else
             {
-                // The child tree is out-of-date wrt. the assembly's geometry: delete it.
-                // It will get rebuilt from scratch lazily.
+                // The child tree is out-of-date wrt. the assembly's geometry: refit it if only
+                // the triangles have moved, otherwise delete it. It will get rebuilt from scratch lazily.
                 if (assembly.is_flushable())
                 {
                     const RegionTreeContainer::iterator it = m_region_trees.find(assembly_uid);
@@ -384,6 +802,13 @@ void AssemblyTree::update_child_trees()
                 else
                 {
                     const TriangleTreeContainer::iterator it = m_triangle_trees.find(assembly_uid);
+
+                    if (refit_triangle_tree(m_scene, assembly, child_tree_build_thread_count, it->second))
+                    {
+                        m_assembly_versions[assembly_uid] = current_version_id;
+                        continue;
+                    }
+
                     delete it->second;
                     m_triangle_trees.erase(it);
                 }
@@ -398,12 +823,12 @@ void AssemblyTree::update_child_trees()
         if (assembly.is_flushable())
         {
             m_region_trees.insert(
-                make_pair(assembly_uid, create_region_tree(m_scene, assembly)));
+                make_pair(assembly_uid, create_region_tree(m_scene, assembly, child_tree_build_thread_count)));
         }
         else
         {
             m_triangle_trees.insert(
-                make_pair(assembly_uid, create_triangle_tree(m_scene, assembly)));
+                make_pair(assembly_uid, create_triangle_tree(m_scene, assembly, child_tree_build_thread_count)));
         }
 
         // Store the current version ID of the assembly.
@@ -477,8 +902,8 @@ bool AssemblyLeafVisitor::visit(
     const size_t assembly_instance_count = node.get_item_count();
     const AssemblyTree::Item* items =
         assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
-            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
-            : &m_tree.m_items[assembly_instance_index];     // items are stored in the tree
+            ? reinterpret_cast<const AssemblyTree::Item*>(&node.get_user_data<uint8>())   // items are stored in the leaf node
+            : &m_tree.m_items[assembly_instance_index];                                 // items are stored in the tree
 
     for (size_t i = 0; i < assembly_instance_count; ++i)
     {
@@ -548,6 +973,19 @@ bool AssemblyLeafVisitor::visit(
                         visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                         , m_triangle_tree_stats
+#endif
+                        );
+                }
+                else if (triangle_tree->is_collapsed())
+                {
+                    TriangleTreeQIntersector qintersector;
+                    qintersector.intersect_no_motion(
+                        triangle_tree->get_qtree(),
+                        local_shading_point.m_ray,
+                        local_ray_info,
+                        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                        , m_triangle_tree_stats
 #endif
                         );
                 }
@@ -606,7 +1044,7 @@ bool AssemblyLeafProbeVisitor::visit(
     const size_t assembly_instance_count = node.get_item_count();
     const AssemblyTree::Item* items =
         assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
-            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
+            ? reinterpret_cast<const AssemblyTree::Item*>(&node.get_user_data<uint8>())     // items are stored in the leaf node
             : &m_tree.m_items[node.get_item_index()];       // items are stored in the tree
 
     for (size_t i = 0; i < assembly_instance_count; ++i)
@@ -641,7 +1079,9 @@ bool AssemblyLeafProbeVisitor::visit(
 
             // Check the intersection between the ray and the region tree.
             RegionLeafProbeVisitor visitor(
-                m_triangle_tree_cache
+                m_triangle_tree_cache,
+                m_alpha_aware,
+                m_occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_triangle_tree_stats
 #endif
@@ -652,13 +1092,10 @@ bool AssemblyLeafProbeVisitor::visit(
                 local_ray,
                 local_ray_info,
                 visitor);
-        
+
             // Terminate traversal if there was a hit.
-            if (visitor.hit())
-            {
-                m_hit = true;
+            if (collect_probe_results(visitor, item, assembly_instance_transform))
                 return false;
-            }
         }
         else
         {
@@ -672,7 +1109,7 @@ bool AssemblyLeafProbeVisitor::visit(
             {
                 // Check the intersection between the ray and the triangle tree.
                 TriangleTreeProbeIntersector intersector;
-                TriangleLeafProbeVisitor visitor(*triangle_tree);
+                TriangleLeafProbeVisitor visitor(*triangle_tree, m_alpha_aware, m_occluder);
                 if (triangle_tree->get_moving_triangle_count() > 0)
                 {
                     intersector.intersect_motion(
@@ -683,6 +1120,19 @@ bool AssemblyLeafProbeVisitor::visit(
                         visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                         , m_triangle_tree_stats
+#endif
+                        );
+                }
+                else if (triangle_tree->is_collapsed())
+                {
+                    TriangleTreeProbeQIntersector qintersector;
+                    qintersector.intersect_no_motion(
+                        triangle_tree->get_qtree(),
+                        local_ray,
+                        local_ray_info,
+                        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                        , m_triangle_tree_stats
 #endif
                         );
                 }
@@ -700,11 +1150,8 @@ bool AssemblyLeafProbeVisitor::visit(
                 }
 
                 // Terminate traversal if there was a hit.
-                if (visitor.hit())
-                {
-                    m_hit = true;
+                if (collect_probe_results(visitor, item, assembly_instance_transform))
                     return false;
-                }
             }
         }
     }
@@ -714,4 +1161,32 @@ bool AssemblyLeafProbeVisitor::visit(
     return true;
 }
 
+bool AssemblyLeafProbeVisitor::collect_probe_results(
+    const ProbeVisitorBase&             visitor,
+    const AssemblyTree::Item&           item,
+    const Transformd&                   assembly_instance_transform)
+{
+    // Remember whether alpha-mapped triangles were crossed.
+    if (visitor.alpha_hit())
+        m_alpha_hit = true;
+
+    if (!visitor.hit())
+        return false;
+
+    m_hit = true;
+
+    // Report the occluder in world space, unless the assembly instance is moving.
+    if (visitor.has_occluder() && item.m_transform_sequence.size() <= 1)
+    {
+        TriangleType& triangle = m_occluder->m_triangle;
+        triangle.m_v0 = assembly_instance_transform.point_to_parent(triangle.m_v0);
+        triangle.m_e0 = assembly_instance_transform.vector_to_parent(triangle.m_e0);
+        triangle.m_e1 = assembly_instance_transform.vector_to_parent(triangle.m_e1);
+        m_occluder->m_assembly_instance = item.m_assembly_instance;
+        m_has_occluder = true;
+    }
+
+    return true;
+}
+
 }   // namespace renderer
@@ -68,20 +68,36 @@ namespace renderer
 
 class AssemblyTree
   : public foundation::bvh::Tree<
-               foundation::AlignedVector<
-                   foundation::bvh::Node<foundation::AABB3d>
-               >
+               foundation::AlignedVector<BVHNodeType>
            >
 {
   public:
-    // Constructor, builds the tree for a given scene.
-    explicit AssemblyTree(const Scene& scene);
+    // Constructor, builds the tree for a given scene. Child trees are built
+    // using up to 'build_thread_count' threads each.
+    AssemblyTree(
+        const Scene&            scene,
+        const size_t            build_thread_count);
 
     // Destructor.
     ~AssemblyTree();
 
-    // Update the assembly tree and all the child trees.
-    void update();
+    // Update the assembly tree and all the child trees. When the assembly instances
+    // of the scene are unchanged, only the items of the assembly instances whose
+    // transform sequence or version (or the version of their assembly, or those of
+    // a parent assembly instance) has changed are updated, and the tree is refit
+    // instead of being rebuilt.
+    // Child trees created by this update are built using up to 'build_thread_count'
+    // threads if the scene has a single child tree, and one thread otherwise.
+    void update(const size_t build_thread_count);
+
+    // Build all child trees that don't exist yet instead of waiting for them
+    // to be built on first access. Trees are built concurrently, each of them
+    // by a single thread unless it is the only child tree of the scene.
+    void build_child_trees(const size_t thread_count) const;
+
+    // Update the set of alpha-mapped object instances of the child trees that
+    // already exist. Child trees built later are up-to-date on creation.
+    void update_alpha_mapped_object_instances() const;
 
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
@@ -112,7 +128,19 @@ class AssemblyTree
         }
     };
 
+    // State of an assembly instance at the time the tree was last updated.
+    struct InstanceInfo
+    {
+        foundation::UniqueID                    m_assembly_instance_uid;
+        foundation::VersionID                   m_assembly_instance_version_id;
+        foundation::UniqueID                    m_assembly_uid;
+        foundation::VersionID                   m_assembly_version_id;
+        renderer::TransformSequence             m_transform_sequence;   // transform sequence of the instance itself
+        size_t                                  m_item_index;       // ~0 if the assembly is empty
+    };
+
     typedef std::vector<Item> ItemVector;
+    typedef std::vector<InstanceInfo> InstanceInfoVector;
     typedef std::vector<foundation::AABB3d> AABBVector;
     typedef std::vector<const Assembly*> AssemblyVector;
     typedef std::map<foundation::UniqueID, foundation::VersionID> AssemblyVersionMap;
@@ -121,7 +149,11 @@ class AssemblyTree
     RegionTreeContainer     m_region_trees;
     TriangleTreeContainer   m_triangle_trees;
     ItemVector              m_items;
+    AABBVector              m_item_bboxes;
+    InstanceInfoVector      m_instance_infos;
+    double                  m_build_cost;
     AssemblyVersionMap      m_assembly_versions;
+    size_t                  m_build_thread_count;
 
     void collect_assembly_instances(
         const AssemblyInstanceContainer&        assembly_instances,
@@ -130,6 +162,14 @@ class AssemblyTree
     void rebuild_assembly_tree();
     void store_items_in_leaves(foundation::Statistics& statistics);
 
+    bool update_assembly_instances(
+        const AssemblyInstanceContainer&        assembly_instances,
+        const TransformSequence&                parent_transform_seq,
+        const bool                              parent_touched,
+        size_t&                                 instance_index,
+        size_t&                                 touched_item_count);
+    bool update_assembly_tree();
+
     void collect_unique_assemblies(AssemblyVector& assemblies) const;
     void update_child_trees();
 };
@@ -192,7 +232,9 @@ class AssemblyLeafProbeVisitor
         const AssemblyTree&                         tree,
         RegionTreeAccessCache&                      region_tree_cache,
         TriangleTreeAccessCache&                    triangle_tree_cache,
-        const ShadingPoint*                         parent_shading_point
+        const ShadingPoint*                         parent_shading_point,
+        const bool                                  alpha_aware,
+        ProbeOccluder*                              occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , foundation::bvh::TraversalStatistics&     triangle_tree_stats
 #endif
@@ -217,6 +259,13 @@ class AssemblyLeafProbeVisitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
 #endif
+
+    // Collect the outcome of probing the geometry of an assembly instance.
+    // Return true if the ray was stopped.
+    bool collect_probe_results(
+        const ProbeVisitorBase&                     visitor,
+        const AssemblyTree::Item&                   item,
+        const foundation::Transformd&               assembly_instance_transform);
 };
 
 
@@ -271,12 +320,15 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
     const AssemblyTree&                             tree,
     RegionTreeAccessCache&                          region_tree_cache,
     TriangleTreeAccessCache&                        triangle_tree_cache,
-    const ShadingPoint*                             parent_shading_point
+    const ShadingPoint*                             parent_shading_point,
+    const bool                                      alpha_aware,
+    ProbeOccluder*                                  occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , foundation::bvh::TraversalStatistics&         triangle_tree_stats
 #endif
     )
-  : m_tree(tree)
+  : ProbeVisitorBase(alpha_aware, occluder)
+  , m_tree(tree)
   , m_region_tree_cache(region_tree_cache)
   , m_triangle_tree_cache(triangle_tree_cache)
   , m_parent_shading_point(parent_shading_point)
@@ -45,11 +45,17 @@
 #include "renderer/modeling/texture/texture.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/tile.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/lazy.h"
+#include "foundation/utility/memory.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
 
 using namespace foundation;
 using namespace std;
@@ -111,6 +117,198 @@ namespace
             copy_uv_coordinates(*tess, uv);
         }
     }
+
+    void copy_primitive_attributes(Object& object, vector<size_t>& pa)
+    {
+        Access<RegionKit> region_kit(&object.get_region_kit());
+
+        for (const_each<RegionKit> i = *region_kit; i; ++i)
+        {
+            const IRegion* region = *i;
+            Access<StaticTriangleTess> tess(&region->get_static_triangle_tess());
+
+            for (const_each<StaticTriangleTess::PrimitiveArray> j = tess->m_primitives; j; ++j)
+                pa.push_back(j->m_pa);
+        }
+    }
+
+
+    //
+    // A hierarchy of coarse masks built on top of an alpha mask. Each cell of each level
+    // records whether the texels it covers include opaque texels, transparent texels or
+    // both, which allows to classify a rectangle of texels without visiting all of them.
+    //
+
+    class AlphaMaskHierarchy
+      : public NonCopyable
+    {
+      public:
+        enum
+        {
+            HasOpaque       = 1 << 0,
+            HasTransparent  = 1 << 1,
+            HasBoth         = HasOpaque | HasTransparent
+        };
+
+        explicit AlphaMaskHierarchy(const BitMask2& bitmask)
+          : m_bitmask(bitmask)
+        {
+            // Build the finest level directly from the alpha mask.
+            m_levels.push_back(Level());
+            Level& base = m_levels.back();
+            base.m_cell_size = BaseCellSize;
+            base.m_width = (bitmask.get_width() + BaseCellSize - 1) / BaseCellSize;
+            base.m_height = (bitmask.get_height() + BaseCellSize - 1) / BaseCellSize;
+            base.m_cells.resize(base.m_width * base.m_height);
+
+            for (size_t cy = 0; cy < base.m_height; ++cy)
+            {
+                for (size_t cx = 0; cx < base.m_width; ++cx)
+                {
+                    uint8 flags = 0;
+                    scan_texels(
+                        cx * BaseCellSize,
+                        cy * BaseCellSize,
+                        min((cx + 1) * BaseCellSize, bitmask.get_width()) - 1,
+                        min((cy + 1) * BaseCellSize, bitmask.get_height()) - 1,
+                        flags);
+                    base.m_cells[cy * base.m_width + cx] = flags;
+                }
+            }
+
+            // Build coarser levels until a level is made of a single cell.
+            while (m_levels.back().m_width > 1 || m_levels.back().m_height > 1)
+            {
+                const Level& fine = m_levels.back();
+
+                Level coarse;
+                coarse.m_cell_size = fine.m_cell_size * 2;
+                coarse.m_width = (fine.m_width + 1) / 2;
+                coarse.m_height = (fine.m_height + 1) / 2;
+                coarse.m_cells.resize(coarse.m_width * coarse.m_height, 0);
+
+                for (size_t fy = 0; fy < fine.m_height; ++fy)
+                {
+                    for (size_t fx = 0; fx < fine.m_width; ++fx)
+                        coarse.m_cells[(fy / 2) * coarse.m_width + fx / 2] |= fine.m_cells[fy * fine.m_width + fx];
+                }
+
+                m_levels.push_back(coarse);
+            }
+        }
+
+        // Return the content of the [x0, x1] x [y0, y1] rectangle of texels.
+        uint8 get_flags(
+            const size_t    x0,
+            const size_t    y0,
+            const size_t    x1,
+            const size_t    y1) const
+        {
+            assert(x0 <= x1 && x1 < m_bitmask.get_width());
+            assert(y0 <= y1 && y1 < m_bitmask.get_height());
+
+            const size_t top = m_levels.size() - 1;
+            const size_t cell_size = m_levels[top].m_cell_size;
+
+            uint8 flags = 0;
+
+            for (size_t cy = y0 / cell_size; cy <= y1 / cell_size; ++cy)
+            {
+                for (size_t cx = x0 / cell_size; cx <= x1 / cell_size; ++cx)
+                {
+                    visit(top, cx, cy, x0, y0, x1, y1, flags);
+                    if (flags == HasBoth)
+                        return flags;
+                }
+            }
+
+            return flags;
+        }
+
+      private:
+        static const size_t BaseCellSize = 8;
+
+        struct Level
+        {
+            size_t          m_cell_size;    // size in texels of the cells of this level
+            size_t          m_width;        // width of this level, in cells
+            size_t          m_height;       // height of this level, in cells
+            vector<uint8>   m_cells;
+        };
+
+        const BitMask2&     m_bitmask;
+        vector<Level>       m_levels;
+
+        void scan_texels(
+            const size_t    x0,
+            const size_t    y0,
+            const size_t    x1,
+            const size_t    y1,
+            uint8&          flags) const
+        {
+            for (size_t y = y0; y <= y1; ++y)
+            {
+                for (size_t x = x0; x <= x1; ++x)
+                {
+                    flags |= m_bitmask.is_set(x, y) ? HasOpaque : HasTransparent;
+                    if (flags == HasBoth)
+                        return;
+                }
+            }
+        }
+
+        void visit(
+            const size_t    level_index,
+            const size_t    cx,
+            const size_t    cy,
+            const size_t    x0,
+            const size_t    y0,
+            const size_t    x1,
+            const size_t    y1,
+            uint8&          flags) const
+        {
+            const Level& level = m_levels[level_index];
+            const uint8 cell = level.m_cells[cy * level.m_width + cx];
+
+            // Texel bounds of this cell.
+            const size_t cell_x0 = cx * level.m_cell_size;
+            const size_t cell_y0 = cy * level.m_cell_size;
+            const size_t cell_x1 = min(cell_x0 + level.m_cell_size, m_bitmask.get_width()) - 1;
+            const size_t cell_y1 = min(cell_y0 + level.m_cell_size, m_bitmask.get_height()) - 1;
+
+            // Uniform cells and cells entirely inside the rectangle are conclusive.
+            if (cell != HasBoth ||
+                (cell_x0 >= x0 && cell_x1 <= x1 && cell_y0 >= y0 && cell_y1 <= y1))
+            {
+                flags |= cell;
+                return;
+            }
+
+            // Clip the rectangle to this cell.
+            const size_t clip_x0 = max(cell_x0, x0);
+            const size_t clip_y0 = max(cell_y0, y0);
+            const size_t clip_x1 = min(cell_x1, x1);
+            const size_t clip_y1 = min(cell_y1, y1);
+
+            if (level_index == 0)
+            {
+                scan_texels(clip_x0, clip_y0, clip_x1, clip_y1, flags);
+                return;
+            }
+
+            // Recurse into the child cells that overlap the rectangle.
+            const size_t child_cell_size = m_levels[level_index - 1].m_cell_size;
+            for (size_t child_y = clip_y0 / child_cell_size; child_y <= clip_y1 / child_cell_size; ++child_y)
+            {
+                for (size_t child_x = clip_x0 / child_cell_size; child_x <= clip_x1 / child_cell_size; ++child_x)
+                {
+                    visit(level_index - 1, child_x, child_y, x0, y0, x1, y1, flags);
+                    if (flags == HasBoth)
+                        return;
+                }
+            }
+        }
+    };
 }
 
 IntersectionFilter::IntersectionFilter(
@@ -159,16 +357,45 @@ IntersectionFilter::IntersectionFilter(
     if (has_alpha_masks())
     {
         // Make a local copy of the object's UV coordinates.
-        m_uv.reserve(get_triangle_count(object) * 3);
+        const size_t triangle_count = get_triangle_count(object);
+        m_uv.reserve(triangle_count * 3);
         copy_uv_coordinates(object, m_uv);
 
+        // Classify the triangles of the object against the alpha masks.
+        m_coverage.reserve(triangle_count);
+        classify_triangles(object);
+
+        const size_t transparent_count = std::count(m_coverage.begin(), m_coverage.end(), CoverageTransparent);
+        const size_t mixed_count = std::count(m_coverage.begin(), m_coverage.end(), CoverageMixed);
+
+        if (transparent_count == 0 && mixed_count == 0)
+        {
+            // All triangles are fully opaque: the intersection filter is useless.
+            for (size_t i = 0; i < m_alpha_masks.size(); ++i)
+            {
+                delete m_alpha_masks[i];
+                m_alpha_masks[i] = 0;
+            }
+
+            clear_release_memory(m_uv);
+            clear_release_memory(m_coverage);
+            return;
+        }
+
+        // UV coordinates are only needed to filter intersections with partially transparent triangles.
+        if (mixed_count == 0)
+            clear_release_memory(m_uv);
+
         RENDERER_LOG_DEBUG(
-            "created intersection filter for object \"%s\" with " FMT_SIZE_T " material%s (masks: %s, uvs: %s).",
+            "created intersection filter for object \"%s\" with " FMT_SIZE_T " material%s "
+            "(masks: %s, uvs: %s, triangles: %s transparent, %s partially transparent).",
             object.get_name(),
             materials.size(),
             materials.size() > 1 ? "s" : "",
             pretty_size(get_masks_memory_size()).c_str(),
-            pretty_size(m_uv.capacity() * sizeof(Vector2f)).c_str());
+            pretty_size(m_uv.capacity() * sizeof(Vector2f)).c_str(),
+            pretty_percent(transparent_count, triangle_count).c_str(),
+            pretty_percent(mixed_count, triangle_count).c_str());
     }
 }
 
@@ -245,6 +472,70 @@ IntersectionFilter::AlphaMask* IntersectionFilter::create_alpha_mask(
     return alpha_mask;
 }
 
+void IntersectionFilter::classify_triangles(Object& object)
+{
+    // Texels whose distance to the UV bounding box of a triangle is less than this
+    // value are considered covered by the triangle, to account for rounding errors
+    // in the interpolation of UV coordinates.
+    const float UVEpsilon = 1.0e-4f;
+
+    // Build a mask hierarchy for each alpha mask.
+    vector<AlphaMaskHierarchy*> hierarchies(m_alpha_masks.size(), 0);
+    for (size_t i = 0; i < m_alpha_masks.size(); ++i)
+    {
+        if (m_alpha_masks[i])
+            hierarchies[i] = new AlphaMaskHierarchy(m_alpha_masks[i]->get_bitmask());
+    }
+
+    vector<size_t> pa;
+    pa.reserve(m_uv.size() / 3);
+    copy_primitive_attributes(object, pa);
+
+    for (size_t i = 0; i < pa.size(); ++i)
+    {
+        // Triangles without an alpha mask are fully opaque.
+        if (pa[i] >= m_alpha_masks.size() || m_alpha_masks[pa[i]] == 0)
+        {
+            m_coverage.push_back(CoverageOpaque);
+            continue;
+        }
+
+        const AlphaMask& alpha_mask = *m_alpha_masks[pa[i]];
+        const Vector2f& uv0 = m_uv[i * 3 + 0];
+        const Vector2f& uv1 = m_uv[i * 3 + 1];
+        const Vector2f& uv2 = m_uv[i * 3 + 2];
+
+        // Don't try to classify triangles with indefinite UV coordinates.
+        if (uv0 != uv0 || uv1 != uv1 || uv2 != uv2)
+        {
+            m_coverage.push_back(CoverageMixed);
+            continue;
+        }
+
+        const Vector2f uv_min(
+            min(min(uv0[0], uv1[0]), uv2[0]) - UVEpsilon,
+            min(min(uv0[1], uv1[1]), uv2[1]) - UVEpsilon);
+        const Vector2f uv_max(
+            max(max(uv0[0], uv1[0]), uv2[0]) + UVEpsilon,
+            max(max(uv0[1], uv1[1]), uv2[1]) + UVEpsilon);
+
+        const uint8 flags =
+            hierarchies[pa[i]]->get_flags(
+                alpha_mask.get_x(uv_min[0]),
+                alpha_mask.get_y(uv_min[1]),
+                alpha_mask.get_x(uv_max[0]),
+                alpha_mask.get_y(uv_max[1]));
+
+        m_coverage.push_back(
+            flags == AlphaMaskHierarchy::HasOpaque ? CoverageOpaque :
+            flags == AlphaMaskHierarchy::HasTransparent ? CoverageTransparent :
+            CoverageMixed);
+    }
+
+    for (size_t i = 0; i < hierarchies.size(); ++i)
+        delete hierarchies[i];
+}
+
 size_t IntersectionFilter::get_masks_memory_size() const
 {
     size_t size = 0;
@@ -37,6 +37,7 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/bitmask.h"
 
 // Standard headers.
@@ -66,12 +67,24 @@ class IntersectionFilter
 
     bool has_alpha_masks() const;
 
+    // Return true if a triangle is known to be fully transparent, in which case
+    // it does not need to be intersected at all.
+    bool is_transparent(const TriangleKey& triangle_key) const;
+
     bool accept(
         const TriangleKey&      triangle_key,
         const double            u,
         const double            v) const;
 
   private:
+    // Classification of a triangle with respect to the alpha mask of its material.
+    enum Coverage
+    {
+        CoverageOpaque,                 // the triangle only covers opaque texels
+        CoverageTransparent,            // the triangle only covers transparent texels
+        CoverageMixed                   // the triangle covers both opaque and transparent texels
+    };
+
     class AlphaMask
       : public foundation::NonCopyable
     {
@@ -93,15 +106,24 @@ class IntersectionFilter
             m_bitmask.set(x, y, opaque);
         }
 
-        bool is_opaque(const foundation::Vector2f& uv) const
+        size_t get_x(const float u) const
         {
-            const float fx = foundation::clamp(uv[0] * m_bitmask.get_width(), 0.0f, m_max_x);
-            const float fy = foundation::clamp(uv[1] * m_bitmask.get_height(), 0.0f, m_max_y);
+            return foundation::truncate<size_t>(foundation::clamp(u * m_bitmask.get_width(), 0.0f, m_max_x));
+        }
 
-            const size_t ix = foundation::truncate<size_t>(fx);
-            const size_t iy = foundation::truncate<size_t>(fy);
+        size_t get_y(const float v) const
+        {
+            return foundation::truncate<size_t>(foundation::clamp(v * m_bitmask.get_height(), 0.0f, m_max_y));
+        }
+
+        bool is_opaque(const foundation::Vector2f& uv) const
+        {
+            return m_bitmask.is_set(get_x(uv[0]), get_y(uv[1]));
+        }
 
-            return m_bitmask.is_set(ix, iy);
+        const foundation::BitMask2& get_bitmask() const
+        {
+            return m_bitmask;
         }
 
         size_t get_memory_size() const
@@ -117,12 +139,15 @@ class IntersectionFilter
 
     std::vector<AlphaMask*>             m_alpha_masks;
     std::vector<foundation::Vector2f>   m_uv;
+    std::vector<foundation::uint8>      m_coverage;
 
     static AlphaMask* create_alpha_mask(
         const Source*           alpha_map,
         TextureCache&           texture_cache,
         double&                 transparency);
 
+    void classify_triangles(Object& object);
+
     size_t get_masks_memory_size() const;
 };
 
@@ -131,6 +156,13 @@ class IntersectionFilter
 // IntersectionFilter class implementation.
 //
 
+inline bool IntersectionFilter::is_transparent(const TriangleKey& triangle_key) const
+{
+    assert(triangle_key.get_region_index() == 0);
+
+    return m_coverage[triangle_key.get_triangle_index()] == CoverageTransparent;
+}
+
 inline bool IntersectionFilter::accept(
     const TriangleKey&          triangle_key,
     const double                u,
@@ -138,10 +170,15 @@ inline bool IntersectionFilter::accept(
 {
     assert(triangle_key.get_region_index() == 0);
 
-    const AlphaMask* alpha_mask = m_alpha_masks[triangle_key.get_triangle_pa()];
+    const size_t triangle_index = triangle_key.get_triangle_index();
 
-    if (alpha_mask == 0)
-        return true;
+    // Only triangles partially covered by transparent texels need an alpha mask lookup.
+    const foundation::uint8 coverage = m_coverage[triangle_index];
+    if (coverage != CoverageMixed)
+        return coverage == CoverageOpaque;
+
+    const AlphaMask* alpha_mask = m_alpha_masks[triangle_key.get_triangle_pa()];
+    assert(alpha_mask);
 
     // Don't use the alpha mask if the UV coordinates are indefinite.
     // This can happen in rare circumstances, when hitting degenerate
@@ -152,8 +189,6 @@ inline bool IntersectionFilter::accept(
     if (u != u || v != v)
         return true;
 
-    const size_t triangle_index = triangle_key.get_triangle_index();
-
     const float fu = static_cast<float>(u);
     const float fv = static_cast<float>(v);
 
@@ -34,6 +34,8 @@
 #include "renderer/global/globaltypes.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/bvh.h"
 #include "foundation/math/intersection.h"
 
 // Standard headers.
@@ -54,6 +56,22 @@ typedef foundation::TriangleMT<double> TriangleType;
 typedef foundation::TriangleMTSupportPlane<double> TriangleSupportPlaneType;
 
 
+//
+// BVH node types.
+//
+
+// Define this symbol to store the bounding boxes of the nodes of assembly trees and
+// triangle trees in single precision. Nodes are half as large, at the expense of
+// slightly looser bounding boxes and fewer triangles stored directly in leaf nodes.
+#undef RENDERER_USE_COMPACT_BVH_NODES
+
+#ifdef RENDERER_USE_COMPACT_BVH_NODES
+typedef foundation::bvh::CompactNode<foundation::AABB3d> BVHNodeType;
+#else
+typedef foundation::bvh::Node<foundation::AABB3d> BVHNodeType;
+#endif
+
+
 //
 // Assembly tree settings.
 //
@@ -67,6 +85,9 @@ const double AssemblyTreeInteriorNodeTraversalCost = 1.0;
 // Relative cost of intersecting an assembly.
 const double AssemblyTreeTriangleIntersectionCost = 10.0;
 
+// Maximum relative increase of the SAH cost of the refit assembly tree before it gets rebuilt.
+const double AssemblyTreeRefitMaxCostIncrease = 0.5;
+
 
 //
 // Region tree settings.
@@ -102,6 +123,10 @@ const GScalar TriangleTreeDefaultTriangleIntersectionCost(1.0);
 // Number of bins used during SBVH construction.
 const size_t TriangleTreeDefaultBinCount = 256;
 
+// Maximum relative increase of the SAH cost of a refit triangle tree before it gets rebuilt.
+// Refitting is disabled when the "sbvh" algorithm is used since spatial splits duplicate triangles.
+const double TriangleTreeDefaultRefitMaxCostIncrease = 0.5;
+
 // Define this symbol to enable reordering the nodes of triangle trees for better
 // locality of reference. Requires a lot of temporary memory for minimal results.
 #undef RENDERER_TRIANGLE_TREE_REORDER_NODES
@@ -116,6 +141,13 @@ const size_t TriangleTreeAccessCacheWays = 2;
 // Size of the stack (in number of nodes) used during traversal.
 const size_t TriangleTreeStackSize = 64;
 
+// Maximum depth of 4-wide triangle trees, deeper trees keep the binary layout.
+const size_t TriangleTreeMaxQTreeDepth = 64;
+
+// Size of the stack (in number of nodes) used during traversal of 4-wide trees.
+// Up to three children are pushed on the stack at each level.
+const size_t TriangleTreeQStackSize = 3 * TriangleTreeMaxQTreeDepth;
+
 
 //
 // Miscellaneous settings.
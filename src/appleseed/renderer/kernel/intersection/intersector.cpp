@@ -296,9 +296,21 @@ bool Intersector::trace(
 bool Intersector::trace_probe(
     const ShadingRay&               ray,
     const ShadingPoint*             parent_shading_point) const
+{
+    return trace_probe(ray, false, 0, parent_shading_point) != ProbeMiss;
+}
+
+Intersector::ProbeResult Intersector::trace_probe(
+    const ShadingRay&               ray,
+    const bool                      alpha_aware,
+    ProbeOccluder*                  occluder,
+    const ShadingPoint*             parent_shading_point) const
 {
     assert(parent_shading_point == 0 || parent_shading_point->hit());
 
+    if (occluder)
+        occluder->m_assembly_instance = 0;
+
     // Update ray casting statistics.
     ++m_probe_ray_count;
 
@@ -320,7 +332,9 @@ bool Intersector::trace_probe(
         assembly_tree,
         m_region_tree_cache,
         m_triangle_tree_cache,
-        parent_shading_point
+        parent_shading_point,
+        alpha_aware,
+        occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_triangle_tree_traversal_stats
 #endif
@@ -335,7 +349,10 @@ bool Intersector::trace_probe(
 #endif
         );
 
-    return visitor.hit();
+    if (visitor.hit())
+        return ProbeOpaqueHit;
+
+    return visitor.alpha_hit() ? ProbeAlphaHit : ProbeMiss;
 }
 
 void Intersector::manufacture_hit(
@@ -66,6 +66,14 @@ class Intersector
   : public foundation::NonCopyable
 {
   public:
+    // Outcome of an alpha-aware probe ray.
+    enum ProbeResult
+    {
+        ProbeMiss,                      // the ray didn't hit anything
+        ProbeOpaqueHit,                 // the ray hit a surface that isn't alpha-mapped
+        ProbeAlphaHit                   // the ray only hit alpha-mapped surfaces
+    };
+
     // Constructor, binds the intersector to a given trace context.
     Intersector(
         const TraceContext&             trace_context,
@@ -102,6 +110,17 @@ class Intersector
         const ShadingRay&               ray,
         const ShadingPoint*             parent_shading_point = 0) const;
 
+    // Trace a world space probe ray through the scene. In alpha-aware mode, the
+    // ray is filtered by intersection filters and passes through alpha-mapped
+    // surfaces, which are only reported if no other surface stops the ray.
+    // If 'occluder' is not null, it receives the surface that stopped the ray
+    // whenever the result is ProbeOpaqueHit and this surface is static.
+    ProbeResult trace_probe(
+        const ShadingRay&               ray,
+        const bool                      alpha_aware,
+        ProbeOccluder*                  occluder,
+        const ShadingPoint*             parent_shading_point = 0) const;
+
     // Manufacture a hit "by hand".
     void manufacture_hit(
         ShadingPoint&                   shading_point,
@@ -30,28 +30,74 @@
 #ifndef APPLESEED_RENDERER_KERNEL_INTERSECTION_PROBEVISITORBASE_H
 #define APPLESEED_RENDERER_KERNEL_INTERSECTION_PROBEVISITORBASE_H
 
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
+
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class AssemblyInstance; }
+
 namespace renderer
 {
 
+//
+// An opaque triangle that stopped a probe ray.
+//
+// Only static triangles of assembly instances without motion are reported,
+// such that the occluder remains valid for rays cast at any time. The triangle
+// is expressed in world space; m_assembly_instance is null if no occluder
+// could be reported.
+//
+
+struct ProbeOccluder
+{
+    const AssemblyInstance*     m_assembly_instance;
+    size_t                      m_object_instance_index;
+    size_t                      m_region_index;
+    size_t                      m_triangle_index;
+    TriangleType                m_triangle;
+};
+
+
 //
 // Base class for probe visitors.
 //
+// In alpha-aware mode, triangles of alpha-mapped object instances are filtered
+// by their intersection filters and, when hit, don't terminate the traversal:
+// only hits with other triangles are reported by hit(), while alpha_hit()
+// reports whether an alpha-mapped triangle lies on the path of the ray.
+//
 
 class ProbeVisitorBase
   : public foundation::NonCopyable
 {
   public:
-    // Constructor.
-    ProbeVisitorBase();
+    // Constructor. If 'occluder' is not null, it receives the triangle that
+    // stopped the ray (in the space of the visited tree) whenever possible.
+    explicit ProbeVisitorBase(
+        const bool          alpha_aware = false,
+        ProbeOccluder*      occluder = 0);
 
     // Return whether a hit was found.
     bool hit() const;
 
+    // Return whether an alpha-mapped triangle was hit (alpha-aware mode only).
+    bool alpha_hit() const;
+
+    // Return whether the triangle that stopped the ray was reported.
+    bool has_occluder() const;
+
   protected:
-    bool m_hit;
+    const bool              m_alpha_aware;
+    ProbeOccluder*          m_occluder;
+    bool                    m_hit;
+    bool                    m_alpha_hit;
+    bool                    m_has_occluder;
 };
 
 
@@ -59,8 +105,14 @@ class ProbeVisitorBase
 // ProbeVisitorBase class implementation.
 //
 
-inline ProbeVisitorBase::ProbeVisitorBase()
-  : m_hit(false)
+inline ProbeVisitorBase::ProbeVisitorBase(
+    const bool              alpha_aware,
+    ProbeOccluder*          occluder)
+  : m_alpha_aware(alpha_aware)
+  , m_occluder(occluder)
+  , m_hit(false)
+  , m_alpha_hit(false)
+  , m_has_occluder(false)
 {
 }
 
@@ -69,6 +121,16 @@ inline bool ProbeVisitorBase::hit() const
     return m_hit;
 }
 
+inline bool ProbeVisitorBase::alpha_hit() const
+{
+    return m_alpha_hit;
+}
+
+inline bool ProbeVisitorBase::has_occluder() const
+{
+    return m_has_occluder;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_PROBEVISITORBASE_H
@@ -407,10 +407,12 @@ namespace
 RegionTree::Arguments::Arguments(
     const Scene&    scene,
     const UniqueID  assembly_uid,
-    const Assembly& assembly)
+    const Assembly& assembly,
+    const size_t    build_thread_count)
   : m_scene(scene)
   , m_assembly_uid(assembly_uid)
   , m_assembly(assembly)
+  , m_build_thread_count(build_thread_count)
 {
 }
 
@@ -444,7 +446,8 @@ RegionTree::RegionTree(const Arguments& arguments)
                     triangle_tree_uid,
                     interm_leaf->m_extent,
                     interm_leaf->m_assembly,
-                    interm_leaf->m_regions)));
+                    interm_leaf->m_regions,
+                    arguments.m_build_thread_count)));
 
         // Create and store the triangle tree.
         m_triangle_trees.insert(
@@ -476,6 +479,16 @@ void RegionTree::update_non_geometry()
     }
 }
 
+void RegionTree::update_alpha_mapped_object_instances()
+{
+    for (each<TriangleTreeContainer> i = m_triangle_trees; i; ++i)
+    {
+        Update<TriangleTree> access(i->second);
+        if (access.get())
+            access->update_alpha_mapped_object_instances();
+    }
+}
+
 
 //
 // RegionTreeFactory class implementation.
@@ -525,6 +538,19 @@ double RegionLeafVisitor::visit(
                 visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_triangle_tree_stats
+#endif
+                );
+        }
+        else if (triangle_tree->is_collapsed())
+        {
+            TriangleTreeQIntersector qintersector;
+            qintersector.intersect_no_motion(
+                triangle_tree->get_qtree(),
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_triangle_tree_stats
 #endif
                 );
         }
@@ -569,7 +595,7 @@ double RegionLeafProbeVisitor::visit(
     {
         // Check the intersection between the ray and the triangle tree.
         TriangleTreeProbeIntersector intersector;
-        TriangleLeafProbeVisitor visitor(*triangle_tree);
+        TriangleLeafProbeVisitor visitor(*triangle_tree, m_alpha_aware, m_occluder);
         if (triangle_tree->get_moving_triangle_count() > 0)
         {
             intersector.intersect_motion(
@@ -580,6 +606,19 @@ double RegionLeafProbeVisitor::visit(
                 visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_triangle_tree_stats
+#endif
+                );
+        }
+        else if (triangle_tree->is_collapsed())
+        {
+            TriangleTreeProbeQIntersector qintersector;
+            qintersector.intersect_no_motion(
+                triangle_tree->get_qtree(),
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_triangle_tree_stats
 #endif
                 );
         }
@@ -596,10 +635,15 @@ double RegionLeafProbeVisitor::visit(
                 );
         }
 
+        // Remember whether alpha-mapped triangles were crossed.
+        if (visitor.alpha_hit())
+            m_alpha_hit = true;
+
         // Terminate traversal if there was a hit.
         if (visitor.hit())
         {
             m_hit = true;
+            m_has_occluder = visitor.has_occluder();
             return ray.m_tmin;
         }
     }
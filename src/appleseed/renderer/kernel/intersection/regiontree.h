@@ -94,12 +94,14 @@ class RegionTree
         const Scene&                    m_scene;
         const foundation::UniqueID      m_assembly_uid;
         const Assembly&                 m_assembly;
+        const size_t                    m_build_thread_count;
 
         // Constructor.
         Arguments(
             const Scene&                scene,
             const foundation::UniqueID  assembly_uid,
-            const Assembly&             assembly);
+            const Assembly&             assembly,
+            const size_t                build_thread_count);
     };
 
     // Constructor, builds the tree for a given assembly.
@@ -111,6 +113,12 @@ class RegionTree
     // Update the non-geometry aspects of the tree.
     void update_non_geometry();
 
+    // Update the set of alpha-mapped object instances of the triangle trees.
+    void update_alpha_mapped_object_instances();
+
+    // Return the triangle trees of the leaves of the tree.
+    const TriangleTreeContainer& get_triangle_trees() const;
+
   private:
     friend class RegionLeafVisitor;
     friend class RegionLeafProbeVisitor;
@@ -204,7 +212,9 @@ class RegionLeafProbeVisitor
   public:
     // Constructor.
     RegionLeafProbeVisitor(
-        TriangleTreeAccessCache&                triangle_tree_cache
+        TriangleTreeAccessCache&                triangle_tree_cache,
+        const bool                              alpha_aware,
+        ProbeOccluder*                          occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , foundation::bvh::TraversalStatistics& triangle_tree_stats
 #endif
@@ -266,6 +276,16 @@ inline foundation::UniqueID RegionLeaf::get_triangle_tree_uid() const
 }
 
 
+//
+// RegionTree class implementation.
+//
+
+inline const TriangleTreeContainer& RegionTree::get_triangle_trees() const
+{
+    return m_triangle_trees;
+}
+
+
 //
 // RegionLeafVisitor class implementation.
 //
@@ -291,12 +311,15 @@ inline RegionLeafVisitor::RegionLeafVisitor(
 //
 
 inline RegionLeafProbeVisitor::RegionLeafProbeVisitor(
-    TriangleTreeAccessCache&                    triangle_tree_cache
+    TriangleTreeAccessCache&                    triangle_tree_cache,
+    const bool                                  alpha_aware,
+    ProbeOccluder*                              occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , foundation::bvh::TraversalStatistics&     triangle_tree_stats
 #endif
     )
-  : m_triangle_tree_cache(triangle_tree_cache)
+  : ProbeVisitorBase(alpha_aware, occluder)
+  , m_triangle_tree_cache(triangle_tree_cache)
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
   , m_triangle_tree_stats(triangle_tree_stats)
 #endif
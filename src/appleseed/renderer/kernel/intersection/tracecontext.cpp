@@ -53,9 +53,11 @@ namespace renderer
 // TraceContext class implementation.
 //
 
-TraceContext::TraceContext(const Scene& scene)
+TraceContext::TraceContext(
+    const Scene&    scene,
+    const size_t    build_thread_count)
   : m_scene(scene)
-  , m_assembly_tree(new AssemblyTree(scene))
+  , m_assembly_tree(new AssemblyTree(scene, build_thread_count))
 {
     RENDERER_LOG_DEBUG(
         "data structures size:\n"
@@ -80,9 +82,19 @@ TraceContext::~TraceContext()
     delete m_assembly_tree;
 }
 
-void TraceContext::update()
+void TraceContext::update(const size_t build_thread_count)
 {
-    m_assembly_tree->update();
+    m_assembly_tree->update(build_thread_count);
+}
+
+void TraceContext::build_acceleration_structures(const size_t thread_count) const
+{
+    m_assembly_tree->build_child_trees(thread_count);
+}
+
+void TraceContext::update_alpha_mapped_object_instances() const
+{
+    m_assembly_tree->update_alpha_mapped_object_instances();
 }
 
 }   // namespace renderer
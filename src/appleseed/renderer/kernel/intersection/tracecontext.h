@@ -36,6 +36,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class AssemblyTree; }
 namespace renderer  { class Scene; }
@@ -54,8 +57,11 @@ class DLLSYMBOL TraceContext
   : public foundation::NonCopyable
 {
   public:
-    // Constructor, initializes the trace context for a given scene.
-    explicit TraceContext(const Scene& scene);
+    // Constructor, initializes the trace context for a given scene. Acceleration
+    // structures are built using up to 'build_thread_count' threads each.
+    explicit TraceContext(
+        const Scene&    scene,
+        const size_t    build_thread_count = 1);
 
     // Destructor.
     ~TraceContext();
@@ -66,8 +72,18 @@ class DLLSYMBOL TraceContext
     // Get the assembly tree.
     const AssemblyTree& get_assembly_tree() const;
 
-    // Synchronize the trace context with the scene.
-    void update();
+    // Synchronize the trace context with the scene. Acceleration structures
+    // are built using up to 'build_thread_count' threads each.
+    void update(const size_t build_thread_count = 1);
+
+    // Build all acceleration structures upfront, using a given number of threads,
+    // instead of building each of them the first time it is accessed.
+    void build_acceleration_structures(const size_t thread_count) const;
+
+    // Update the object instances known to be opaque to probe rays. Whether OSL
+    // shader groups have transparency is only known once they are set up, so this
+    // must be called after on_frame_begin() while no rendering is in progress.
+    void update_alpha_mapped_object_instances() const;
 
   private:
     const Scene&    m_scene;
@@ -380,24 +380,30 @@ TriangleTree::Arguments::Arguments(
     const UniqueID          triangle_tree_uid,
     const GAABB3&           bbox,
     const Assembly&         assembly,
-    const RegionInfoVector& regions)
+    const RegionInfoVector& regions,
+    const size_t            build_thread_count)
   : m_scene(scene)
   , m_triangle_tree_uid(triangle_tree_uid)
   , m_bbox(bbox)
   , m_assembly(assembly)
   , m_regions(regions)
+  , m_build_thread_count(build_thread_count)
 {
 }
 
 TriangleTree::TriangleTree(const Arguments& arguments)
   : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
   , m_arguments(arguments)
+  , m_qtree(
+        AlignedAllocator<void>(System::get_l1_data_cache_line_size()),
+        AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
 {
     // Retrieve construction parameters.
     const MessageContext message_context(
         string("while building acceleration structure for assembly \"") + m_arguments.m_assembly.get_name() + "\"");
     const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
     const string algorithm = params.get_optional<string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
+    const string layout = params.get_optional<string>("layout", "binary", make_vector("binary", "qbvh"), message_context);
     const double time = params.get_optional<double>("time", 0.5);
     const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
 
@@ -418,8 +424,17 @@ TriangleTree::TriangleTree(const Arguments& arguments)
     assert(m_nodes.size() == m_nodes.capacity());
 #endif
 
+    // Optionally collapse the tree to a 4-wide tree.
+    if (layout == "qbvh")
+        collapse(statistics);
+
+    // Compute the cost of the tree, refitting is allowed until it grows too much.
+    m_build_cost = compute_cost(params);
+    statistics.insert("sah cost", m_build_cost);
+
     // Print triangle tree statistics.
-    statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
+    if (!m_nodes.empty())
+        statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
     statistics.insert_time("total time", stopwatch.measure().get_seconds());
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -429,6 +444,9 @@ TriangleTree::TriangleTree(const Arguments& arguments)
     // Create intersection filters.
     if (m_arguments.m_assembly.get_parameters().get_optional<bool>("enable_intersection_filters", true))
         create_intersection_filters();
+
+    // Find object instances which are not necessarily opaque to probe rays.
+    update_alpha_mapped_object_instances();
 }
 
 TriangleTree::~TriangleTree()
@@ -446,6 +464,306 @@ void TriangleTree::update_non_geometry()
     delete_intersection_filters();
     if (m_arguments.m_assembly.get_parameters().get_optional<bool>("enable_intersection_filters", true))
         create_intersection_filters();
+
+    // Update alpha-mapped object instances.
+    update_alpha_mapped_object_instances();
+}
+
+namespace
+{
+    bool have_same_regions(
+        const RegionInfoVector&         lhs,
+        const RegionInfoVector&         rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (size_t i = 0; i < lhs.size(); ++i)
+        {
+            if (lhs[i].get_object_instance_index() != rhs[i].get_object_instance_index() ||
+                lhs[i].get_region_index() != rhs[i].get_region_index())
+                return false;
+        }
+
+        return true;
+    }
+
+    //
+    // Recompute the triangles stored in the leaves of a triangle tree from
+    // the current geometry of the assembly, and return the leaf bounding boxes.
+    //
+    // Leaves are expected to store the same triangles as a tree built from
+    // scratch would, in the same encoding; if that's not the case (a triangle
+    // has been removed, has become degenerate or has started moving) the
+    // refitter becomes invalid and the tree must be rebuilt.
+    //
+
+    class TriangleLeafRefitter
+      : public NonCopyable
+    {
+      public:
+        TriangleLeafRefitter(
+            const TriangleTree::Arguments&  arguments,
+            vector<TriangleKey>&            triangle_keys,
+            vector<uint8>&                  leaf_data)
+          : m_arguments(arguments)
+          , m_triangle_keys(triangle_keys)
+          , m_leaf_data(leaf_data)
+          , m_valid(true)
+        {
+            const size_t region_count = m_arguments.m_regions.size();
+
+            m_tessellations.reserve(region_count);
+            m_transforms.reserve(region_count);
+
+            for (size_t i = 0; i < region_count; ++i)
+            {
+                // Fetch the region info.
+                const RegionInfo& region_info = m_arguments.m_regions[i];
+
+                // Retrieve the object instance and its transformation.
+                const ObjectInstance* object_instance =
+                    m_arguments.m_assembly.object_instances().get_by_index(
+                        region_info.get_object_instance_index());
+                assert(object_instance);
+
+                // Retrieve the tessellation of the region.
+                Access<RegionKit> region_kit(&object_instance->get_object().get_region_kit());
+                const IRegion* region = (*region_kit)[region_info.get_region_index()];
+                m_tessellations.push_back(Access<StaticTriangleTess>(&region->get_static_triangle_tess()));
+
+                // Motion bounding boxes cannot be refit.
+                if (m_tessellations.back()->get_motion_segment_count() > 0)
+                    m_valid = false;
+
+                m_transforms.push_back(&object_instance->get_transform());
+                m_region_indices[make_pair(region_info.get_object_instance_index(), region_info.get_region_index())] = i;
+            }
+        }
+
+        bool is_valid() const
+        {
+            return m_valid;
+        }
+
+        AABB3d operator()(TriangleTree::NodeType& leaf)
+        {
+            AABB3d leaf_bbox;
+            leaf_bbox.invalidate();
+
+            if (!m_valid)
+                return leaf_bbox;
+
+            // Triangles are stored either in the leaf node or in the tree.
+            uint8* user_data = &leaf.get_user_data<uint8>();
+            const uint32 leaf_data_index = *reinterpret_cast<const uint32*>(user_data);
+            MemoryWriter writer(
+                leaf_data_index == ~0
+                    ? user_data + sizeof(uint32)
+                    : &m_leaf_data[leaf_data_index]);
+
+            const size_t item_begin = leaf.get_item_index();
+            const size_t item_count = leaf.get_item_count();
+
+            for (size_t i = 0; i < item_count; ++i)
+            {
+                TriangleKey& triangle_key = m_triangle_keys[item_begin + i];
+
+                GVector3 v0, v1, v2;
+                if (!fetch_triangle(triangle_key, v0, v1, v2))
+                {
+                    m_valid = false;
+                    return leaf_bbox;
+                }
+
+                writer.write(static_cast<uint32>(0));
+                writer.write(GTriangleType(v0, v1, v2));
+
+                GAABB3 triangle_bbox;
+                triangle_bbox.invalidate();
+                triangle_bbox.insert(v0);
+                triangle_bbox.insert(v1);
+                triangle_bbox.insert(v2);
+                leaf_bbox.insert(AABB3d(triangle_bbox));
+            }
+
+            return leaf_bbox;
+        }
+
+      private:
+        typedef map<pair<size_t, size_t>, size_t> RegionIndexMap;
+
+        const TriangleTree::Arguments&      m_arguments;
+        vector<TriangleKey>&                m_triangle_keys;
+        vector<uint8>&                      m_leaf_data;
+        vector<Access<StaticTriangleTess> > m_tessellations;
+        vector<const Transformd*>           m_transforms;
+        RegionIndexMap                      m_region_indices;
+        bool                                m_valid;
+
+        // Retrieve the assembly space vertices of a triangle and update its key.
+        // Return false if this triangle would not be part of a new tree.
+        bool fetch_triangle(
+            TriangleKey&                    triangle_key,
+            GVector3&                       v0,
+            GVector3&                       v1,
+            GVector3&                       v2) const
+        {
+            const RegionIndexMap::const_iterator it =
+                m_region_indices.find(
+                    make_pair(
+                        triangle_key.get_object_instance_index(),
+                        triangle_key.get_region_index()));
+            assert(it != m_region_indices.end());
+
+            const StaticTriangleTess& tess = m_tessellations[it->second].ref();
+            const size_t triangle_index = triangle_key.get_triangle_index();
+
+            if (triangle_index >= tess.m_primitives.size())
+                return false;
+
+            // Fetch the triangle.
+            const Triangle& triangle = tess.m_primitives[triangle_index];
+
+            // Retrieve the object space vertices of the triangle.
+            const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
+            const GVector3& v1_os = tess.m_vertices[triangle.m_v1];
+            const GVector3& v2_os = tess.m_vertices[triangle.m_v2];
+
+            // Degenerate triangles are not stored in the tree.
+            if (square_area(v0_os, v1_os, v2_os) == GScalar(0.0))
+                return false;
+
+            // Transform triangle vertices to assembly space.
+            const Transformd& transform = *m_transforms[it->second];
+            v0 = transform.point_to_parent(v0_os);
+            v1 = transform.point_to_parent(v1_os);
+            v2 = transform.point_to_parent(v2_os);
+
+            // Degenerate triangles are not stored in the tree.
+            if (square_area(v0, v1, v2) == GScalar(0.0))
+                return false;
+
+            // Triangles that don't intersect the tree are not stored in the tree.
+            if (!intersect(m_arguments.m_bbox, v0, v1, v2))
+                return false;
+
+            // The primitive attribute index may have changed.
+            triangle_key =
+                TriangleKey(
+                    triangle_key.get_object_instance_index(),
+                    triangle_key.get_region_index(),
+                    triangle_index,
+                    triangle.m_pa);
+
+            return true;
+        }
+    };
+}
+
+bool TriangleTree::refit(const Arguments& arguments)
+{
+    assert(arguments.m_triangle_tree_uid == m_arguments.m_triangle_tree_uid);
+
+    // Retrieve refit parameters.
+    const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+    if (!params.get_optional<bool>("refit", true))
+        return false;
+
+    // Spatial splits reference some triangles from several leaves: SBVH trees are always rebuilt.
+    if (params.get_optional<string>("algorithm", "bvh") == "sbvh")
+        return false;
+
+    const double time = params.get_optional<double>("time", 0.5);
+    const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
+    const double max_cost_increase = params.get_optional<double>("refit_max_cost_increase", TriangleTreeDefaultRefitMaxCostIncrease);
+
+    // Motion bounding boxes cannot be refit.
+    if (m_moving_triangle_count > 0)
+        return false;
+
+    // The tree must cover the same regions.
+    if (!have_same_regions(m_arguments.m_regions, arguments.m_regions))
+        return false;
+
+    RENDERER_LOG_INFO(
+        "refitting triangle tree #" FMT_UNIQUE_ID "...",
+        m_arguments.m_triangle_tree_uid);
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // A new tree must contain as many triangles as this one. Together with the checks
+    // performed by the leaf refitter, this guarantees that the set of triangles is the same.
+    vector<TriangleKey> triangle_keys;
+    collect_triangles<GAABB3>(
+        arguments,
+        time,
+        save_memory,
+        &triangle_keys,
+        0,
+        0,
+        0);
+    if (triangle_keys.size() != m_triangle_keys.size())
+    {
+        RENDERER_LOG_INFO(
+            "triangles of triangle tree #" FMT_UNIQUE_ID " have changed, tree will be rebuilt.",
+            m_arguments.m_triangle_tree_uid);
+        return false;
+    }
+    clear_release_memory(triangle_keys);
+
+    // Refit the tree.
+    m_arguments.m_bbox = arguments.m_bbox;
+    m_arguments.m_regions = arguments.m_regions;
+    if (!m_triangle_keys.empty())
+    {
+        TriangleLeafRefitter leaf_refitter(m_arguments, m_triangle_keys, m_leaf_data);
+
+        if (leaf_refitter.is_valid())
+        {
+            if (is_collapsed())
+            {
+                bvh::QRefitter<QTreeType> refitter;
+                refitter.refit<DefaultWallclockTimer>(m_qtree, leaf_refitter);
+            }
+            else
+            {
+                bvh::Refitter<TreeType> refitter;
+                refitter.refit<DefaultWallclockTimer>(*this, leaf_refitter);
+            }
+        }
+
+        if (!leaf_refitter.is_valid())
+        {
+            RENDERER_LOG_INFO(
+                "triangles of triangle tree #" FMT_UNIQUE_ID " have changed, tree will be rebuilt.",
+                m_arguments.m_triangle_tree_uid);
+            return false;
+        }
+
+        // Rebuild the tree if its quality has degraded too much.
+        const double cost = compute_cost(params);
+        if (cost > m_build_cost * (1.0 + max_cost_increase))
+        {
+            RENDERER_LOG_INFO(
+                "sah cost of triangle tree #" FMT_UNIQUE_ID " increased from %f to %f, tree will be rebuilt.",
+                m_arguments.m_triangle_tree_uid,
+                m_build_cost,
+                cost);
+            return false;
+        }
+    }
+
+    RENDERER_LOG_INFO(
+        "refit triangle tree #" FMT_UNIQUE_ID " in %s.",
+        m_arguments.m_triangle_tree_uid,
+        pretty_time(stopwatch.measure().get_seconds()).c_str());
+
+    // Materials may have changed as well.
+    update_non_geometry();
+
+    return true;
 }
 
 size_t TriangleTree::get_memory_size() const
@@ -454,8 +772,11 @@ size_t TriangleTree::get_memory_size() const
           TreeType::get_memory_size()
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
+        + m_qtree.get_memory_size()
+        - sizeof(m_qtree)
         + m_triangle_keys.capacity() * sizeof(TriangleKey)
-        + m_leaf_data.capacity() * sizeof(uint8);
+        + m_leaf_data.capacity() * sizeof(uint8)
+        + m_alpha_mapped_object_instances.capacity() * sizeof(uint8);
 }
 
 namespace
@@ -539,6 +860,7 @@ void TriangleTree::build_bvh(
     const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
     const GScalar interior_node_travesal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
+    const size_t thread_count = params.get_optional<size_t>("build_threads", m_arguments.m_build_thread_count);
 
     // Create the partitioner.
     typedef bvh::SAHPartitioner<vector<GAABB3> > Partitioner;
@@ -551,7 +873,7 @@ void TriangleTree::build_bvh(
     // Build the tree.
     typedef bvh::Builder<TriangleTree, Partitioner> Builder;
     Builder builder;
-    builder.build<DefaultWallclockTimer>(*this, partitioner, triangle_keys.size(), max_leaf_size);
+    builder.build<DefaultWallclockTimer>(*this, partitioner, triangle_keys.size(), max_leaf_size, thread_count);
     statistics.merge(bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
 
     stopwatch.start();
@@ -587,8 +909,11 @@ void TriangleTree::build_bvh(
 
     const double storing_time = stopwatch.measure().get_seconds();
 
+    statistics.insert("build threads", thread_count);
+    statistics.insert("parallel subtrees", builder.get_subtree_count());
     statistics.insert_time("collection time", collection_time);
     statistics.insert_time("partition time", builder.get_build_time());
+    statistics.insert_time("subtree merge time", builder.get_merge_time());
     statistics.insert_time("store time", storing_time);
 }
 
@@ -640,6 +965,7 @@ void TriangleTree::build_sbvh(
     const size_t bin_count = params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinCount);
     const GScalar interior_node_travesal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
+    const size_t thread_count = params.get_optional<size_t>("build_threads", m_arguments.m_build_thread_count);
 
     // Create the partitioner.
     typedef bvh::SBVHPartitioner<TriangleItemHandler, vector<AABB3d> > Partitioner;
@@ -666,7 +992,8 @@ void TriangleTree::build_sbvh(
         *this,
         partitioner,
         root_leaf,
-        root_leaf_bbox);
+        root_leaf_bbox,
+        thread_count);
     statistics.merge(bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
 
     // Add splits statistics.
@@ -700,8 +1027,12 @@ void TriangleTree::build_sbvh(
 
     const double storing_time = stopwatch.measure().get_seconds();
 
+    statistics.insert("build threads", thread_count);
+    statistics.insert("parallel subtrees", builder.get_subtree_count());
     statistics.insert_time("collection time", collection_time);
     statistics.insert_time("partition time", builder.get_build_time());
+    statistics.insert_time("subtree merge time", builder.get_merge_time());
+    statistics.insert_time("leaf store time", builder.get_store_time());
     statistics.insert_time("store time", storing_time);
 }
 
@@ -777,18 +1108,19 @@ vector<GAABB3> TriangleTree::compute_motion_bboxes(
         node.set_left_bbox_count(left_bboxes.size());
         node.set_right_bbox_count(right_bboxes.size());
 
+        // Right bounding boxes immediately follow left bounding boxes (required by compact nodes).
+        node.set_left_bbox_index(m_node_bboxes.size());
+
         if (left_bboxes.size() > 1)
         {
-            node.set_left_bbox_index(m_node_bboxes.size());
-
             for (vector<GAABB3>::const_iterator i = left_bboxes.begin(); i != left_bboxes.end(); ++i)
                 m_node_bboxes.push_back(swizzle(AABB3d(*i)));
         }
 
+        node.set_right_bbox_index(m_node_bboxes.size());
+
         if (right_bboxes.size() > 1)
         {
-            node.set_right_bbox_index(m_node_bboxes.size());
-
             for (vector<GAABB3>::const_iterator i = right_bboxes.begin(); i != right_bboxes.end(); ++i)
                 m_node_bboxes.push_back(swizzle(AABB3d(*i)));
         }
@@ -1124,6 +1456,66 @@ namespace
     }
 }
 
+void TriangleTree::collapse(Statistics& statistics)
+{
+    // Motion bounding boxes are not supported by 4-wide trees.
+    if (m_moving_triangle_count > 0)
+    {
+        RENDERER_LOG_WARNING(
+            "triangle tree #" FMT_UNIQUE_ID " contains moving triangles and will not be collapsed to a 4-wide tree.",
+            m_arguments.m_triangle_tree_uid);
+        return;
+    }
+
+    // Collapse the tree.
+    typedef bvh::Collapser<TreeType, QTreeType> Collapser;
+    Collapser collapser;
+    collapser.collapse<DefaultWallclockTimer>(*this, m_qtree);
+
+    // Keep the binary tree if the 4-wide tree is too deep for the traversal stack.
+    if (collapser.get_depth() > TriangleTreeMaxQTreeDepth)
+    {
+        RENDERER_LOG_WARNING(
+            "triangle tree #" FMT_UNIQUE_ID " is too deep (%s levels) and will not be collapsed to a 4-wide tree.",
+            m_arguments.m_triangle_tree_uid,
+            pretty_uint(collapser.get_depth()).c_str());
+        m_qtree.clear();
+        return;
+    }
+
+    // The binary tree is no longer needed.
+    clear_release_memory(m_nodes);
+    clear_release_memory(m_node_bboxes);
+
+    statistics.insert("qbvh interior nodes", m_qtree.get_interior_node_count());
+    statistics.insert("qbvh leaf nodes", m_qtree.get_leaf_node_count());
+    statistics.insert_time("collapse time", collapser.get_collapse_time());
+}
+
+double TriangleTree::compute_cost(const ParamArray& params) const
+{
+    const GScalar interior_node_travesal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
+    const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
+
+    if (is_collapsed())
+    {
+        return
+            bvh::QRefitter<QTreeType>::compute_cost(
+                m_qtree,
+                interior_node_travesal_cost,
+                triangle_intersection_cost);
+    }
+
+    if (m_nodes.empty())
+        return 0.0;
+
+    return
+        bvh::Refitter<TreeType>::compute_cost(
+            *this,
+            interior_node_travesal_cost,
+            triangle_intersection_cost);
+}
+
 void TriangleTree::create_intersection_filters()
 {
     // Collect object instance indices.
@@ -1175,6 +1567,55 @@ void TriangleTree::delete_intersection_filters()
     m_intersection_filters.clear();
 }
 
+namespace
+{
+    bool uses_alpha_mapping(const MaterialArray& materials)
+    {
+        for (size_t i = 0; i < materials.size(); ++i)
+        {
+            if (materials[i] && materials[i]->uses_alpha_mapping())
+                return true;
+        }
+
+        return false;
+    }
+}
+
+void TriangleTree::update_alpha_mapped_object_instances()
+{
+    m_alpha_mapped_object_instances.clear();
+
+    // Collect object instance indices.
+    IndexSet object_instance_indices;
+    collect_object_instance_indices(
+        m_arguments.m_regions,
+        object_instance_indices);
+    if (object_instance_indices.empty())
+        return;
+
+    const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
+    bool found = false;
+
+    // Flag object instances that use alpha mapping on either side, using the same test as the tracer.
+    const size_t max_object_instance_index =
+        *max_element(object_instance_indices.begin(), object_instance_indices.end());
+    m_alpha_mapped_object_instances.assign(max_object_instance_index + 1, 0);
+    for (const_each<IndexSet> i = object_instance_indices; i; ++i)
+    {
+        const ObjectInstance* object_instance = object_instances.get_by_index(*i);
+        if (uses_alpha_mapping(object_instance->get_front_materials()) ||
+            uses_alpha_mapping(object_instance->get_back_materials()))
+        {
+            m_alpha_mapped_object_instances[*i] = 1;
+            found = true;
+        }
+    }
+
+    // Keep the vector empty when there are no alpha-mapped object instances.
+    if (!found)
+        clear_release_memory(m_alpha_mapped_object_instances);
+}
+
 
 //
 // TriangleTreeFactory class implementation.
@@ -74,20 +74,27 @@ namespace renderer
 
 class TriangleTree
   : public foundation::bvh::Tree<
-               foundation::AlignedVector<
-                   foundation::bvh::Node<foundation::AABB3d>
-               >
+               foundation::AlignedVector<BVHNodeType>
            >
 {
   public:
+    // 4-wide tree obtained by collapsing the binary tree.
+    typedef foundation::bvh::QTree<
+        foundation::AlignedVector<
+            foundation::bvh::QNode<foundation::AABB3d>
+        >,
+        NodeVectorType
+    > QTreeType;
+
     // Construction arguments.
     struct Arguments
     {
         const Scene&                            m_scene;
         const foundation::UniqueID              m_triangle_tree_uid;
-        const GAABB3                            m_bbox;
+        GAABB3                                  m_bbox;
         const Assembly&                         m_assembly;
-        const RegionInfoVector                  m_regions;
+        RegionInfoVector                        m_regions;
+        const size_t                            m_build_thread_count;
 
         // Constructor.
         Arguments(
@@ -95,7 +102,8 @@ class TriangleTree
             const foundation::UniqueID          triangle_tree_uid,
             const GAABB3&                       bbox,
             const Assembly&                     assembly,
-            const RegionInfoVector&             regions);
+            const RegionInfoVector&             regions,
+            const size_t                        build_thread_count);
     };
 
     // Constructor, builds the tree for a given set of regions.
@@ -107,10 +115,27 @@ class TriangleTree
     // Update the non-geometry aspects of the tree.
     void update_non_geometry();
 
+    // Update the set of object instances that are not necessarily opaque to probe rays.
+    // Must be called again once OSL shader groups are set up.
+    void update_alpha_mapped_object_instances();
+
+    // Refit the tree to the current geometry of the assembly without changing
+    // its topology. Return false if the triangles of the tree have changed or
+    // if the quality of the refit tree is too low, in which case the tree is
+    // left in an undefined state and must be rebuilt. Trees built with the
+    // "sbvh" algorithm are never refit and this method returns false for them.
+    bool refit(const Arguments& arguments);
+
     // Return the number of static and moving triangles.
     size_t get_static_triangle_count() const;
     size_t get_moving_triangle_count() const;
 
+    // Return true if the tree was collapsed to a 4-wide tree.
+    bool is_collapsed() const;
+
+    // Return the 4-wide tree, only valid if is_collapsed() returns true.
+    const QTreeType& get_qtree() const;
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -118,15 +143,19 @@ class TriangleTree
     friend class TriangleLeafVisitor;
     friend class TriangleLeafProbeVisitor;
 
-    const Arguments                             m_arguments;
+    Arguments                                   m_arguments;
 
     size_t                                      m_static_triangle_count;
     size_t                                      m_moving_triangle_count;
+    double                                      m_build_cost;
+
+    QTreeType                                   m_qtree;
 
     std::vector<TriangleKey>                    m_triangle_keys;
     std::vector<foundation::uint8>              m_leaf_data;
     std::vector<const IntersectionFilter*>      m_intersection_filters_repository;
     std::vector<const IntersectionFilter*>      m_intersection_filters;
+    std::vector<foundation::uint8>              m_alpha_mapped_object_instances;
 
     void build_bvh(
         const ParamArray&                       params,
@@ -153,6 +182,10 @@ class TriangleTree
         const std::vector<TriangleKey>&         triangle_keys,
         foundation::Statistics&                 statistics);
 
+    void collapse(foundation::Statistics&       statistics);
+
+    double compute_cost(const ParamArray&       params) const;
+
     void create_intersection_filters();
     void delete_intersection_filters();
 };
@@ -233,6 +266,9 @@ class TriangleLeafVisitor
     GTriangleType           m_interpolated_triangle;
     const GTriangleType*    m_hit_triangle;
     size_t                  m_hit_triangle_index;
+
+    // Return the intersection filter of a given triangle, or 0 if it doesn't have one.
+    const IntersectionFilter* get_intersection_filter(const size_t triangle_index) const;
 };
 
 
@@ -247,7 +283,9 @@ class TriangleLeafProbeVisitor
   public:
     // Constructor.
     explicit TriangleLeafProbeVisitor(
-        const TriangleTree&                     tree);
+        const TriangleTree&                     tree,
+        const bool                              alpha_aware = false,
+        ProbeOccluder*                          occluder = 0);
 
     // Visit a leaf.
     bool visit(
@@ -263,6 +301,21 @@ class TriangleLeafProbeVisitor
   private:
     const TriangleTree&     m_tree;
     const bool              m_has_intersection_filters;
+    const bool              m_has_alpha_mapped_object_instances;
+
+    // Return the intersection filter of a given triangle, or 0 if it doesn't have one.
+    const IntersectionFilter* get_intersection_filter(const size_t triangle_index) const;
+
+    // Return true if a given triangle stops the ray.
+    bool intersect(
+        const TriangleType&                     triangle,
+        const ShadingRay&                       ray,
+        const size_t                            triangle_index);
+
+    // Report a given static triangle as the occluder.
+    void set_occluder(
+        const TriangleType&                     triangle,
+        const size_t                            triangle_index);
 };
 
 
@@ -284,6 +337,20 @@ typedef foundation::bvh::Intersector<
     TriangleTreeStackSize
 > TriangleTreeProbeIntersector;
 
+typedef foundation::bvh::QIntersector<
+    TriangleTree::QTreeType,
+    TriangleLeafVisitor,
+    ShadingRay,
+    TriangleTreeQStackSize
+> TriangleTreeQIntersector;
+
+typedef foundation::bvh::QIntersector<
+    TriangleTree::QTreeType,
+    TriangleLeafProbeVisitor,
+    ShadingRay,
+    TriangleTreeQStackSize
+> TriangleTreeProbeQIntersector;
+
 
 //
 // Utility class to convert a triangle to the desired precision if necessary,
@@ -337,6 +404,16 @@ inline size_t TriangleTree::get_moving_triangle_count() const
     return m_moving_triangle_count;
 }
 
+inline bool TriangleTree::is_collapsed() const
+{
+    return !m_qtree.empty();
+}
+
+inline const TriangleTree::QTreeType& TriangleTree::get_qtree() const
+{
+    return m_qtree;
+}
+
 
 //
 // TriangleLeafVisitor class implementation.
@@ -352,6 +429,16 @@ inline TriangleLeafVisitor::TriangleLeafVisitor(
 {
 }
 
+inline const IntersectionFilter* TriangleLeafVisitor::get_intersection_filter(const size_t triangle_index) const
+{
+    if (!m_has_intersection_filters)
+        return 0;
+
+    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+
+    return m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+}
+
 inline bool TriangleLeafVisitor::visit(
     const TriangleTree::NodeType&           node,
     const ShadingRay&                       ray,
@@ -384,24 +471,24 @@ inline bool TriangleLeafVisitor::visit(
 
         if (motion_segment_count == 0)
         {
-            // Load the triangle, converting it to the right format if necessary.
             const GTriangleType* triangle_ptr = reinterpret_cast<const GTriangleType*>(leaf_data);
-            const impl::TriangleReader reader(*triangle_ptr);
             leaf_data += sizeof(GTriangleType);
 
+            // Skip fully transparent triangles.
+            const IntersectionFilter* filter = get_intersection_filter(triangle_index + i);
+            if (filter && filter->is_transparent(m_tree.m_triangle_keys[triangle_index + i]))
+                continue;
+
+            // Load the triangle, converting it to the right format if necessary.
+            const impl::TriangleReader reader(*triangle_ptr);
+
             // Intersect the triangle.
             double t, u, v;
             if (reader.m_triangle.intersect(m_shading_point.m_ray, t, u, v))
             {
                 // Optionally filter intersections.
-                if (m_has_intersection_filters)
-                {
-                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index + i];
-                    const IntersectionFilter* filter =
-                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
-                    if (filter && !filter->accept(triangle_key, u, v))
-                        continue;
-                }
+                if (filter && !filter->accept(m_tree.m_triangle_keys[triangle_index + i], u, v))
+                    continue;
 
                 m_hit_triangle = triangle_ptr;
                 m_hit_triangle_index = triangle_index + i;
@@ -418,6 +505,11 @@ inline bool TriangleLeafVisitor::visit(
             const GVector3* next_vertices = prev_vertices + 3;
             leaf_data += (motion_segment_count + 1) * 3 * sizeof(GVector3);
 
+            // Skip fully transparent triangles.
+            const IntersectionFilter* filter = get_intersection_filter(triangle_index + i);
+            if (filter && filter->is_transparent(m_tree.m_triangle_keys[triangle_index + i]))
+                continue;
+
             // Interpolate triangle vertices.
             const GScalar k = static_cast<GScalar>(ray.m_time * motion_segment_count - prev_index);
             const GVector3 vert0 = foundation::lerp(prev_vertices[0], next_vertices[0], k);
@@ -433,14 +525,8 @@ inline bool TriangleLeafVisitor::visit(
             if (reader.m_triangle.intersect(m_shading_point.m_ray, t, u, v))
             {
                 // Optionally filter intersections.
-                if (m_has_intersection_filters)
-                {
-                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index + i];
-                    const IntersectionFilter* filter =
-                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
-                    if (filter && !filter->accept(triangle_key, u, v))
-                        continue;
-                }
+                if (filter && !filter->accept(m_tree.m_triangle_keys[triangle_index + i], u, v))
+                    continue;
 
                 m_interpolated_triangle = triangle;
                 m_hit_triangle = &m_interpolated_triangle;
@@ -484,12 +570,73 @@ inline void TriangleLeafVisitor::read_hit_triangle_data() const
 //
 
 inline TriangleLeafProbeVisitor::TriangleLeafProbeVisitor(
-    const TriangleTree&                     tree)
-  : m_tree(tree)
+    const TriangleTree&                     tree,
+    const bool                              alpha_aware,
+    ProbeOccluder*                          occluder)
+  : ProbeVisitorBase(alpha_aware, occluder)
+  , m_tree(tree)
   , m_has_intersection_filters(!tree.m_intersection_filters.empty())
+  , m_has_alpha_mapped_object_instances(!tree.m_alpha_mapped_object_instances.empty())
 {
 }
 
+inline const IntersectionFilter* TriangleLeafProbeVisitor::get_intersection_filter(const size_t triangle_index) const
+{
+    if (!m_has_intersection_filters)
+        return 0;
+
+    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+
+    return m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+}
+
+inline bool TriangleLeafProbeVisitor::intersect(
+    const TriangleType&                     triangle,
+    const ShadingRay&                       ray,
+    const size_t                            triangle_index)
+{
+    if (!m_alpha_aware)
+        return triangle.intersect(ray);
+
+    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+
+    // Skip fully transparent triangles.
+    const IntersectionFilter* filter = get_intersection_filter(triangle_index);
+    if (filter && filter->is_transparent(triangle_key))
+        return false;
+
+    // Intersect the triangle.
+    double t, u, v;
+    if (!triangle.intersect(ray, t, u, v))
+        return false;
+
+    // Optionally filter intersections.
+    if (filter && !filter->accept(triangle_key, u, v))
+        return false;
+
+    // A hit with an alpha-mapped triangle may let some light through: record it but keep going.
+    if (m_has_alpha_mapped_object_instances &&
+        m_tree.m_alpha_mapped_object_instances[triangle_key.get_object_instance_index()])
+    {
+        m_alpha_hit = true;
+        return false;
+    }
+
+    return true;
+}
+
+inline void TriangleLeafProbeVisitor::set_occluder(
+    const TriangleType&                     triangle,
+    const size_t                            triangle_index)
+{
+    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+    m_occluder->m_object_instance_index = triangle_key.get_object_instance_index();
+    m_occluder->m_region_index = triangle_key.get_region_index();
+    m_occluder->m_triangle_index = triangle_key.get_triangle_index();
+    m_occluder->m_triangle = triangle;
+    m_has_occluder = true;
+}
+
 inline bool TriangleLeafProbeVisitor::visit(
     const TriangleTree::NodeType&           node,
     const ShadingRay&                       ray,
@@ -509,6 +656,7 @@ inline bool TriangleLeafProbeVisitor::visit(
             ? user_data + sizeof(foundation::uint32)    // triangles are stored in the leaf node
             : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
 
+    const size_t triangle_index = node.get_item_index();
     const size_t triangle_count = node.get_item_count();
 
     // Sequentially intersect triangles until a hit is found.
@@ -527,9 +675,11 @@ inline bool TriangleLeafProbeVisitor::visit(
             leaf_data += sizeof(GTriangleType);
 
             // Intersect the triangle.
-            if (reader.m_triangle.intersect(ray))
+            if (intersect(reader.m_triangle, ray, triangle_index + i))
             {
                 FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
+                if (m_occluder)
+                    set_occluder(reader.m_triangle, triangle_index + i);
                 m_hit = true;
                 return false;
             }
@@ -552,8 +702,8 @@ inline bool TriangleLeafProbeVisitor::visit(
             const GTriangleType triangle(vert0, vert1, vert2);
             const impl::TriangleReader reader(triangle);
 
-            // Intersect the triangle.
-            if (reader.m_triangle.intersect(ray))
+            // Intersect the triangle. Moving triangles are never reported as occluders.
+            if (intersect(reader.m_triangle, ray, triangle_index + i))
             {
                 FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
                 m_hit = true;
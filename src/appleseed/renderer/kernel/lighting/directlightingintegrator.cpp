@@ -231,7 +231,8 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
         m_shading_context.get_tracer().trace_between(
             m_shading_point,
             emission_position,
-            ShadingRay::ShadowRay);
+            ShadingRay::ShadowRay,
+            sample.m_light);                // key into the occluder cache of the tracer
 
     // Discard occluded samples.
     if (transmission == 0.0)
@@ -355,7 +355,7 @@ void DirectLightingIntegrator::sample_lights_low_variance(
             const foundation::Vector3d s = sampling_context.next_vector2<3>();
 
             LightSample sample;
-            m_light_sampler.sample_emitting_triangles(m_time, s, sample);
+            m_light_sampler.sample_emitting_triangles(m_time, m_point, s, sample);
 
             add_emitting_triangle_sample_contribution(
                 sample,
@@ -484,7 +484,7 @@ void DirectLightingIntegrator::take_single_bsdf_sample(
         const double bsdf_point_prob = bsdf_prob * cos_on / square_distance;
 
         // Compute the probability density wrt. surface area mesure of the light sample.
-        const double light_point_prob = m_light_sampler.evaluate_pdf(light_shading_point);
+        const double light_point_prob = m_light_sampler.evaluate_pdf(light_shading_point, m_point);
 
         // Apply the weighting function.
         weight *=
@@ -519,7 +519,7 @@ void DirectLightingIntegrator::take_single_light_sample(
     const foundation::Vector3d s = sampling_context.next_vector2<3>();
 
     LightSample sample;
-    m_light_sampler.sample(m_time, s, sample);
+    m_light_sampler.sample(m_time, m_point, s, sample);
 
     if (sample.m_triangle)
     {
@@ -571,7 +571,8 @@ void DirectLightingIntegrator::add_emitting_triangle_sample_contribution(
         m_shading_context.get_tracer().trace_between(
             m_shading_point,
             sample.m_point,
-            ShadingRay::ShadowRay);
+            ShadingRay::ShadowRay,
+            edf);                           // triangles of a light share its EDF
 
     // Discard occluded samples.
     if (transmission == 0.0)
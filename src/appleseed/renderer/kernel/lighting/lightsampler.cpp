@@ -60,7 +60,9 @@
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <map>
+#include <string>
 
 using namespace foundation;
 using namespace std;
@@ -128,16 +130,27 @@ LightSampler::LightSampler(const Scene& scene, const ParamArray& params)
     // Build the hash table of emitting triangles.
     build_emitting_triangle_hash_table();
 
-    // Prepare the CDFs for sampling.
+    // Prepare the distributions for sampling.
     if (m_non_physical_lights_cdf.valid())
         m_non_physical_lights_cdf.prepare();
     if (m_emitting_triangles_cdf.valid())
         m_emitting_triangles_cdf.prepare();
+    if (m_emitting_triangles_table.valid())
+        m_emitting_triangles_table.prepare();
 
     // Store the triangle probability densities into the emitting triangles.
     const size_t emitting_triangle_count = m_emitting_triangles.size();
     for (size_t i = 0; i < emitting_triangle_count; ++i)
-        m_emitting_triangles[i].m_triangle_prob = m_emitting_triangles_cdf[i].second;
+    {
+        m_emitting_triangles[i].m_triangle_prob =
+            m_params.m_alias_table
+                ? m_emitting_triangles_table[i].second
+                : m_emitting_triangles_cdf[i].second;
+    }
+
+    // Build the light tree.
+    if (m_params.m_algorithm == Parameters::AlgorithmLightTree)
+        build_light_tree();
 
    RENDERER_LOG_INFO(
         "found %s %s, %s emitting %s.",
@@ -367,15 +380,17 @@ void LightSampler::collect_emitting_triangles(
                     emitting_triangle.m_geometric_normal = side == 0 ? geometric_normal : -geometric_normal;
                     emitting_triangle.m_triangle_support_plane = triangle_support_plane;
                     emitting_triangle.m_rcp_area = rcp_area;
-                    emitting_triangle.m_triangle_prob = 0.0;    // will be initialized once the emitting triangle CDF is built
+                    emitting_triangle.m_triangle_prob = 0.0;    // will be initialized once the emitting triangle distribution is built
                     emitting_triangle.m_edf = edf;
 
                     // Store the light-emitting triangle.
                     const size_t emitting_triangle_index = m_emitting_triangles.size();
                     m_emitting_triangles.push_back(emitting_triangle);
 
-                    // Insert the light-emitting triangle into the CDF.
-                    m_emitting_triangles_cdf.insert(emitting_triangle_index, triangle_prob);
+                    // Insert the light-emitting triangle into the CDF or the alias table.
+                    if (m_params.m_alias_table)
+                        m_emitting_triangles_table.insert(emitting_triangle_index, triangle_prob);
+                    else m_emitting_triangles_cdf.insert(emitting_triangle_index, triangle_prob);
                 }
             }
         }
@@ -403,6 +418,53 @@ void LightSampler::build_emitting_triangle_hash_table()
     }
 }
 
+void LightSampler::build_light_tree()
+{
+    const size_t emitting_triangle_count = m_emitting_triangles.size();
+
+    vector<LightTree::Item> items(emitting_triangle_count);
+
+    for (size_t i = 0; i < emitting_triangle_count; ++i)
+    {
+        const EmittingTriangle& emitting_triangle = m_emitting_triangles[i];
+        LightTree::Item& item = items[i];
+
+        item.m_bbox.invalidate();
+        item.m_bbox.insert(emitting_triangle.m_v0);
+        item.m_bbox.insert(emitting_triangle.m_v1);
+        item.m_bbox.insert(emitting_triangle.m_v2);
+
+        // Light is emitted around the interpolated shading normal, which lies in the cone of the vertex normals.
+        const Vector3d axis =
+              emitting_triangle.m_n0
+            + emitting_triangle.m_n1
+            + emitting_triangle.m_n2;
+        const double axis_norm = norm(axis);
+        if (axis_norm > 0.0)
+        {
+            item.m_axis = axis / axis_norm;
+            item.m_cone_angle =
+                acos(
+                    clamp(
+                        min(
+                            min(dot(item.m_axis, emitting_triangle.m_n0),
+                                dot(item.m_axis, emitting_triangle.m_n1)),
+                            dot(item.m_axis, emitting_triangle.m_n2)),
+                        -1.0,
+                        1.0));
+        }
+        else
+        {
+            item.m_axis = emitting_triangle.m_geometric_normal;
+            item.m_cone_angle = Pi;
+        }
+
+        item.m_power = emitting_triangle.m_triangle_prob;
+    }
+
+    m_light_tree.build(items);
+}
+
 void LightSampler::sample_non_physical_lights(
     const double                        time,
     const Vector3d&                     s,
@@ -431,11 +493,43 @@ void LightSampler::sample_emitting_triangles(
     const Vector3d&                     s,
     LightSample&                        light_sample) const
 {
-    assert(m_emitting_triangles_cdf.valid());
+    assert(has_emitting_triangles());
 
-    const EmitterCDF::ItemWeightPair result = m_emitting_triangles_cdf.sample(s[0]);
+    // The alias table is faster, but only the CDF preserves the stratification of the samples.
+    const EmitterCDF::ItemWeightPair result =
+        m_params.m_alias_table
+            ? m_emitting_triangles_table.sample(s[0])
+            : m_emitting_triangles_cdf.sample(s[0]);
     const size_t emitter_index = result.first;
     const double emitter_prob = result.second;
+    assert(m_emitting_triangles[emitter_index].m_triangle_prob == emitter_prob);
+
+    light_sample.m_light = 0;
+    sample_emitting_triangle(
+        time,
+        Vector2d(s[1], s[2]),
+        emitter_index,
+        emitter_prob,
+        light_sample);
+
+    assert(light_sample.m_triangle);
+    assert(light_sample.m_probability > 0.0);
+}
+
+void LightSampler::sample_emitting_triangles(
+    const double                        time,
+    const Vector3d&                     point,
+    const Vector3d&                     s,
+    LightSample&                        light_sample) const
+{
+    if (m_light_tree.empty())
+    {
+        sample_emitting_triangles(time, s, light_sample);
+        return;
+    }
+
+    double emitter_prob;
+    const size_t emitter_index = m_light_tree.sample(point, s[0], emitter_prob);
 
     light_sample.m_light = 0;
     sample_emitting_triangle(
@@ -454,11 +548,11 @@ void LightSampler::sample(
     const Vector3d&                     s,
     LightSample&                        light_sample) const
 {
-    assert(m_non_physical_lights_cdf.valid() || m_emitting_triangles_cdf.valid());
+    assert(m_non_physical_lights_cdf.valid() || has_emitting_triangles());
 
     if (m_non_physical_lights_cdf.valid())
     {
-        if (m_emitting_triangles_cdf.valid())
+        if (has_emitting_triangles())
         {
             if (s[0] < 0.5)
             {
@@ -482,7 +576,49 @@ void LightSampler::sample(
     else sample_emitting_triangles(time, s, light_sample);
 }
 
+void LightSampler::sample(
+    const double                        time,
+    const Vector3d&                     point,
+    const Vector3d&                     s,
+    LightSample&                        light_sample) const
+{
+    assert(m_non_physical_lights_cdf.valid() || has_emitting_triangles());
+
+    if (m_non_physical_lights_cdf.valid())
+    {
+        if (has_emitting_triangles())
+        {
+            if (s[0] < 0.5)
+            {
+                sample_non_physical_lights(
+                    time,
+                    Vector3d(s[0] * 2.0, s[1], s[2]),
+                    light_sample);
+            }
+            else
+            {
+                sample_emitting_triangles(
+                    time,
+                    point,
+                    Vector3d((s[0] - 0.5) * 2.0, s[1], s[2]),
+                    light_sample);
+            }
+
+            light_sample.m_probability *= 0.5;
+        }
+        else sample_non_physical_lights(time, s, light_sample);
+    }
+    else sample_emitting_triangles(time, point, s, light_sample);
+}
+
 double LightSampler::evaluate_pdf(const ShadingPoint& shading_point) const
+{
+    return evaluate_pdf(shading_point, shading_point.get_ray().m_org);
+}
+
+double LightSampler::evaluate_pdf(
+    const ShadingPoint&                 shading_point,
+    const Vector3d&                     point) const
 {
     const EmittingTriangleKey triangle_key(
         shading_point.get_assembly_instance().get_uid(),
@@ -491,7 +627,12 @@ double LightSampler::evaluate_pdf(const ShadingPoint& shading_point) const
         shading_point.get_triangle_index());
 
     const EmittingTriangle* triangle = m_emitting_triangle_hash_table.get(triangle_key);
-    return triangle->m_triangle_prob * triangle->m_rcp_area;
+
+    if (m_light_tree.empty())
+        return triangle->m_triangle_prob * triangle->m_rcp_area;
+
+    const size_t triangle_index = triangle - &m_emitting_triangles[0];
+    return m_light_tree.evaluate_pdf(point, triangle_index) * triangle->m_rcp_area;
 }
 
 void LightSampler::sample_non_physical_light(
@@ -521,7 +662,6 @@ void LightSampler::sample_emitting_triangle(
 {
     // Fetch the emitting triangle.
     const EmittingTriangle& emitting_triangle = m_emitting_triangles[triangle_index];
-    assert(emitting_triangle.m_triangle_prob == triangle_prob);
 
     // Store a pointer to the emitting triangle.
     light_sample.m_triangle = &emitting_triangle;
@@ -560,7 +700,28 @@ void LightSampler::sample_emitting_triangle(
 
 LightSampler::Parameters::Parameters(const ParamArray& params)
   : m_importance_sampling(params.get_optional<bool>("enable_importance_sampling", false))
+  , m_algorithm(get_algorithm(params))
+  , m_alias_table(params.get_optional<bool>("enable_alias_table", false))
+{
+}
+
+LightSampler::Parameters::Algorithm LightSampler::Parameters::get_algorithm(const ParamArray& params)
 {
+    const string value = params.get_optional<string>("algorithm", "cdf");
+
+    if (value == "cdf")
+        return AlgorithmCDF;
+    else if (value == "lighttree")
+        return AlgorithmLightTree;
+    else
+    {
+        RENDERER_LOG_ERROR(
+            "invalid value \"%s\" for parameter \"%s\", using default value \"%s\".",
+            value.c_str(),
+            "algorithm",
+            "cdf");
+        return AlgorithmCDF;
+    }
 }
 
 }   // namespace renderer
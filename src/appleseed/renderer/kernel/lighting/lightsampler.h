@@ -32,12 +32,14 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/lighting/lighttree.h"
 #include "renderer/modeling/scene/containers.h"
 #include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/platform/types.h"
+#include "foundation/math/aliastable.h"
 #include "foundation/math/cdf.h"
 #include "foundation/math/hash.h"
 #include "foundation/math/transform.h"
@@ -167,6 +169,10 @@ class LightSample
 // The light sampler collects all the light-emitting entities (non-physical lights, mesh lights)
 // and allows to sample them.
 //
+// Emitting triangles are chosen in proportion to their importance alone, unless the light
+// tree algorithm is selected: in that case, when the receiving point is known, they are
+// chosen by traversing a light tree according to their estimated contribution to that point.
+//
 
 class LightSampler
   : public foundation::NonCopyable
@@ -205,6 +211,13 @@ class LightSampler
         const foundation::Vector3d&         s,
         LightSample&                        light_sample) const;
 
+    // Sample the set of emitting triangles as seen from a given receiving point.
+    void sample_emitting_triangles(
+        const double                        time,
+        const foundation::Vector3d&         point,
+        const foundation::Vector3d&         s,
+        LightSample&                        light_sample) const;
+
     // Sample the sets of non-physical lights and emitting triangles.
     void sample(
         const double                        time,
@@ -214,20 +227,45 @@ class LightSampler
         const foundation::Vector4d&         s,
         LightSample&                        light_sample) const;
 
+    // Sample the sets of non-physical lights and emitting triangles as seen from a given receiving point.
+    void sample(
+        const double                        time,
+        const foundation::Vector3d&         point,
+        const foundation::Vector3d&         s,
+        LightSample&                        light_sample) const;
+
     // Compute the probability density in area measure of a given light sample.
+    // The receiving point is the origin of the ray that hit the light.
     double evaluate_pdf(const ShadingPoint& shading_point) const;
 
+    // Compute the probability density in area measure of a given light sample
+    // as seen from a given receiving point.
+    double evaluate_pdf(
+        const ShadingPoint&                 shading_point,
+        const foundation::Vector3d&         point) const;
+
   private:
     struct Parameters
     {
-        const bool m_importance_sampling;
+        enum Algorithm
+        {
+            AlgorithmCDF,                   // choose emitting triangles according to their importance
+            AlgorithmLightTree              // choose emitting triangles using a light tree
+        };
+
+        const bool      m_importance_sampling;
+        const Algorithm m_algorithm;
+        const bool      m_alias_table;      // choose emitting triangles with an alias table instead of a CDF
 
         explicit Parameters(const ParamArray& params);
+
+        static Algorithm get_algorithm(const ParamArray& params);
     };
 
     typedef std::vector<NonPhysicalLightInfo> NonPhysicalLightVector;
     typedef std::vector<EmittingTriangle> EmittingTriangleVector;
     typedef foundation::CDF<size_t, double> EmitterCDF;
+    typedef foundation::AliasTable<size_t, double> EmitterAliasTable;
 
     const Parameters            m_params;
 
@@ -238,10 +276,13 @@ class LightSampler
 
     EmitterCDF                  m_non_physical_lights_cdf;
     EmitterCDF                  m_emitting_triangles_cdf;
+    EmitterAliasTable           m_emitting_triangles_table;
 
     EmittingTriangleKeyHasher   m_triangle_key_hasher;
     EmittingTriangleHashTable   m_emitting_triangle_hash_table;
 
+    LightTree                   m_light_tree;
+
     // Recursively collect non-physical lights from a given set of assembly instances.
     void collect_non_physical_lights(
         const AssemblyInstanceContainer&    assembly_instances,
@@ -266,6 +307,12 @@ class LightSampler
     // Build a hash table that allows to find the emitting triangle at a given shading point.
     void build_emitting_triangle_hash_table();
 
+    // Build a light tree over the emitting triangles.
+    void build_light_tree();
+
+    // Return true if the distribution of emitting triangles is ready for sampling.
+    bool has_emitting_triangles() const;
+
     // Sample a given non-physical light.
     void sample_non_physical_light(
         const double                        time,
@@ -345,7 +392,15 @@ inline size_t LightSampler::get_emitting_triangle_count() const
 
 inline bool LightSampler::has_lights_or_emitting_triangles() const
 {
-    return m_non_physical_lights_cdf.valid() || m_emitting_triangles_cdf.valid();
+    return m_non_physical_lights_cdf.valid() || has_emitting_triangles();
+}
+
+inline bool LightSampler::has_emitting_triangles() const
+{
+    return
+        m_params.m_alias_table
+            ? m_emitting_triangles_table.valid()
+            : m_emitting_triangles_cdf.valid();
 }
 
 inline void LightSampler::sample_non_physical_light(
@@ -0,0 +1,307 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "lighttree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Compute a cone that contains two given cones.
+    void merge_cones(
+        const Vector3d&     axis_a,
+        const double        angle_a,
+        const Vector3d&     axis_b,
+        const double        angle_b,
+        Vector3d&           axis,
+        double&             angle)
+    {
+        if (angle_b > angle_a)
+        {
+            merge_cones(axis_b, angle_b, axis_a, angle_a, axis, angle);
+            return;
+        }
+
+        const double cos_d = clamp(dot(axis_a, axis_b), -1.0, 1.0);
+        const double angle_d = acos(cos_d);
+
+        // The first cone already contains the second one.
+        if (min(angle_d + angle_b, Pi) <= angle_a)
+        {
+            axis = axis_a;
+            angle = angle_a;
+            return;
+        }
+
+        const double merged_angle = 0.5 * (angle_a + angle_d + angle_b);
+
+        // The merged cone covers all directions.
+        const Vector3d ortho = axis_b - cos_d * axis_a;
+        const double ortho_norm = norm(ortho);
+        if (merged_angle >= Pi || ortho_norm == 0.0)
+        {
+            axis = axis_a;
+            angle = Pi;
+            return;
+        }
+
+        // Rotate the axis of the first cone toward the axis of the second one.
+        const double rotation = merged_angle - angle_a;
+        axis = normalize(cos(rotation) * axis_a + (sin(rotation) / ortho_norm) * ortho);
+        angle = merged_angle;
+    }
+
+    struct ItemCenterPredicate
+    {
+        const vector<LightTree::Item>&  m_items;
+        const size_t                    m_dim;
+
+        ItemCenterPredicate(
+            const vector<LightTree::Item>&  items,
+            const size_t                    dim)
+          : m_items(items)
+          , m_dim(dim)
+        {
+        }
+
+        bool operator()(const size_t lhs, const size_t rhs) const
+        {
+            return m_items[lhs].m_bbox.center(m_dim) < m_items[rhs].m_bbox.center(m_dim);
+        }
+    };
+}
+
+
+//
+// LightTree class implementation.
+//
+
+void LightTree::build(const vector<Item>& items)
+{
+    m_nodes.clear();
+    m_item_leaves.assign(items.size(), ~0);
+
+    if (items.empty())
+        return;
+
+    m_nodes.reserve(2 * items.size() - 1);
+
+    vector<size_t> indices(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+        indices[i] = i;
+
+    build_node(items, indices, 0, items.size(), ~0);
+}
+
+size_t LightTree::sample(
+    const Vector3d&         point,
+    const double            s,
+    double&                 prob) const
+{
+    assert(!m_nodes.empty());
+    assert(s >= 0.0 && s < 1.0);
+
+    double u = s;
+    size_t node_index = 0;
+    prob = 1.0;
+
+    while (m_nodes[node_index].m_second_child != ~0)
+    {
+        const double first_child_prob = compute_first_child_prob(node_index, point);
+
+        if (u < first_child_prob)
+        {
+            u /= first_child_prob;
+            prob *= first_child_prob;
+            node_index = node_index + 1;
+        }
+        else
+        {
+            u = (u - first_child_prob) / (1.0 - first_child_prob);
+            prob *= 1.0 - first_child_prob;
+            node_index = m_nodes[node_index].m_second_child;
+        }
+
+        // Guard against rounding errors pushing the sample out of [0,1).
+        u = min(u, 1.0 - 1.0e-12);
+    }
+
+    return m_nodes[node_index].m_item_index;
+}
+
+double LightTree::evaluate_pdf(
+    const Vector3d&         point,
+    const size_t            item_index) const
+{
+    assert(item_index < m_item_leaves.size());
+
+    double prob = 1.0;
+    size_t node_index = m_item_leaves[item_index];
+
+    while (m_nodes[node_index].m_parent != ~0)
+    {
+        const size_t parent_index = m_nodes[node_index].m_parent;
+        const double first_child_prob = compute_first_child_prob(parent_index, point);
+
+        prob *= node_index == parent_index + 1 ? first_child_prob : 1.0 - first_child_prob;
+
+        node_index = parent_index;
+    }
+
+    return prob;
+}
+
+size_t LightTree::build_node(
+    const vector<Item>&     items,
+    vector<size_t>&         indices,
+    const size_t            begin,
+    const size_t            end,
+    const size_t            parent)
+{
+    assert(begin < end);
+
+    const size_t node_index = m_nodes.size();
+    m_nodes.push_back(Node());
+    m_nodes[node_index].m_parent = parent;
+
+    if (end - begin == 1)
+    {
+        // Create a leaf node.
+        const size_t item_index = indices[begin];
+        const Item& item = items[item_index];
+        Node& node = m_nodes[node_index];
+        node.m_bbox = item.m_bbox;
+        node.m_axis = item.m_axis;
+        node.m_cone_angle = item.m_cone_angle;
+        node.m_power = item.m_power;
+        node.m_second_child = ~0;
+        node.m_item_index = item_index;
+        m_item_leaves[item_index] = node_index;
+        return node_index;
+    }
+
+    // Split the emitters in two halves along the longest dimension of the bounding box of their centers.
+    AABB3d center_bbox;
+    center_bbox.invalidate();
+    for (size_t i = begin; i < end; ++i)
+        center_bbox.insert(items[indices[i]].m_bbox.center());
+
+    const size_t middle = (begin + end) / 2;
+    nth_element(
+        indices.begin() + begin,
+        indices.begin() + middle,
+        indices.begin() + end,
+        ItemCenterPredicate(items, max_index(center_bbox.extent())));
+
+    // Build the child nodes.
+    const size_t first_child = build_node(items, indices, begin, middle, node_index);
+    const size_t second_child = build_node(items, indices, middle, end, node_index);
+    assert(first_child == node_index + 1);
+
+    // Bound the child nodes.
+    const Node& first = m_nodes[first_child];
+    const Node& second = m_nodes[second_child];
+    Node& node = m_nodes[node_index];
+    node.m_bbox = AABB3d::invalid();
+    node.m_bbox.insert(first.m_bbox);
+    node.m_bbox.insert(second.m_bbox);
+    merge_cones(
+        first.m_axis, first.m_cone_angle,
+        second.m_axis, second.m_cone_angle,
+        node.m_axis, node.m_cone_angle);
+    node.m_power = first.m_power + second.m_power;
+    node.m_second_child = second_child;
+    node.m_item_index = ~0;
+
+    return node_index;
+}
+
+double LightTree::compute_importance(
+    const Node&             node,
+    const Vector3d&         point) const
+{
+    const Vector3d d = point - node.m_bbox.center();
+    const double square_distance = square_norm(d);
+    const double square_radius = 0.25 * square_norm(node.m_bbox.extent());
+
+    // Neither the distance nor the orientation can be bounded from inside the bounding sphere of the node.
+    if (square_distance <= square_radius)
+        return square_radius > 0.0 ? node.m_power / square_radius : node.m_power;
+
+    // Angle between the axis of the cone and the direction to the point.
+    const double cos_theta = dot(node.m_axis, d) / sqrt(square_distance);
+    const double theta = acos(clamp(cos_theta, -1.0, 1.0));
+
+    // Angle subtended by the bounding sphere of the node.
+    const double theta_u = asin(sqrt(square_radius / square_distance));
+
+    // Lower bound on the angle between any emission normal and the direction to the point.
+    const double theta_prime = max(theta - node.m_cone_angle - theta_u, 0.0);
+
+    // No emitter of this node faces the point.
+    if (theta_prime >= HalfPi)
+        return 0.0;
+
+    return node.m_power * cos(theta_prime) / square_distance;
+}
+
+double LightTree::compute_first_child_prob(
+    const size_t            node_index,
+    const Vector3d&         point) const
+{
+    const Node& first = m_nodes[node_index + 1];
+    const Node& second = m_nodes[m_nodes[node_index].m_second_child];
+
+    const double first_importance = compute_importance(first, point);
+    const double second_importance = compute_importance(second, point);
+    const double importance = first_importance + second_importance;
+
+    if (importance > 0.0)
+        return first_importance / importance;
+
+    // Neither child can contribute: fall back to their power.
+    const double power = first.m_power + second.m_power;
+
+    return power > 0.0 ? first.m_power / power : 0.5;
+}
+
+}   // namespace renderer
@@ -0,0 +1,136 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTTREE_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTTREE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A light tree is a bounding volume hierarchy over light emitters. Each node stores the
+// bounding box, the total power and a cone bounding the emission directions of its emitters.
+// The tree is traversed stochastically to choose emitters in proportion to an estimate of
+// their contribution to a given point.
+//
+// Reference:
+//
+//   Importance Sampling of Many Lights with Adaptive Tree Splitting
+//   Alejandro Conty Estevez, Christopher Kulla
+//   http://library.imageworks.com/pdfs/imageworks-library-importance-sampling-of-many-lights.pdf
+//
+
+class LightTree
+  : public foundation::NonCopyable
+{
+  public:
+    // An emitter as seen by the light tree. Emitters only emit light in the directions
+    // that make an angle of less than 90 degrees with at least one direction of their cone.
+    struct Item
+    {
+        foundation::AABB3d      m_bbox;             // world space bounding box
+        foundation::Vector3d    m_axis;             // axis of the cone of emission normals, unit-length
+        double                  m_cone_angle;       // half-angle of the cone of emission normals, in radians
+        double                  m_power;            // importance of the emitter regardless of the receiving point
+    };
+
+    // Build the tree. Previous contents are discarded.
+    void build(const std::vector<Item>& items);
+
+    // Return true if the tree contains no emitter.
+    bool empty() const;
+
+    // Choose an emitter given a receiving point and a uniform sample in [0,1).
+    // Return the index of the emitter and set prob to the probability of choosing it.
+    size_t sample(
+        const foundation::Vector3d& point,
+        const double                s,
+        double&                     prob) const;
+
+    // Return the probability of choosing a given emitter from a given receiving point.
+    double evaluate_pdf(
+        const foundation::Vector3d& point,
+        const size_t                item_index) const;
+
+  private:
+    struct Node
+    {
+        foundation::AABB3d      m_bbox;
+        foundation::Vector3d    m_axis;
+        double                  m_cone_angle;
+        double                  m_power;
+        size_t                  m_parent;           // index of the parent node, ~0 for the root node
+        size_t                  m_second_child;     // index of the second child (the first child follows the node), ~0 for leaves
+        size_t                  m_item_index;       // index of the emitter, leaves only
+    };
+
+    std::vector<Node>           m_nodes;
+    std::vector<size_t>         m_item_leaves;      // index of the leaf node of each emitter
+
+    // Recursively build the subtree for a given range of emitters and return the index of its root node.
+    size_t build_node(
+        const std::vector<Item>&    items,
+        std::vector<size_t>&        indices,
+        const size_t                begin,
+        const size_t                end,
+        const size_t                parent);
+
+    // Estimate the contribution of the emitters of a node to a given point.
+    double compute_importance(
+        const Node&                 node,
+        const foundation::Vector3d& point) const;
+
+    // Return the probability of descending into the first child of a given interior node.
+    double compute_first_child_prob(
+        const size_t                node_index,
+        const foundation::Vector3d& point) const;
+};
+
+
+//
+// LightTree class implementation.
+//
+
+inline bool LightTree::empty() const
+{
+    return m_nodes.empty();
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTTREE_H
@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/modeling/edf/edf.h"
 #include "renderer/modeling/input/inputevaluator.h"
+#include "renderer/modeling/input/sourceinputs.h"
 
 namespace renderer
 {
@@ -48,7 +49,7 @@ void PathVertex::compute_emitted_radiance(
     const void* edf_data =
         input_evaluator.evaluate(
             m_edf->get_inputs(),
-            m_shading_point->get_uv(0));
+            SourceInputs(*m_shading_point));
 
     // Compute the emitted radiance.
     m_edf->evaluate(
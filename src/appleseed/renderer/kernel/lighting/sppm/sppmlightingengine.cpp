@@ -37,6 +37,7 @@
 #include "renderer/kernel/lighting/imagebasedlighting.h"
 #include "renderer/kernel/lighting/lightsampler.h"
 #include "renderer/kernel/lighting/pathtracer.h"
+#include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/bsdf/bsdf.h"
@@ -54,6 +55,8 @@
 #include "foundation/math/mis.h"
 #include "foundation/math/population.h"
 #include "foundation/math/scalar.h"
+#include "foundation/platform/types.h"
+#include "foundation/platform/x86timer.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/statistics.h"
 
@@ -95,6 +98,104 @@ namespace
     }
 
 
+    //
+    // Accumulate the flux reflected toward the camera by the photons around a path vertex.
+    //
+
+    class FluxAccumulator
+    {
+      public:
+        FluxAccumulator(
+            const SPPMPassCallback&     pass_callback,
+            const PathVertex&           vertex,
+            const float                 max_square_dist)
+          : m_pass_callback(pass_callback)
+          , m_vertex(vertex)
+          , m_normal(vertex.get_geometric_normal())
+          , m_rcp_max_square_dist(1.0f / max_square_dist)
+          , m_included_photon_count(0)
+          , m_flux(0.0f)
+        {
+        }
+
+        void visit(
+            const size_t                photon_index,
+            const Vector3f&             photon_position,
+            const float                 square_dist)
+        {
+            const SPPMPhotonData& data = m_pass_callback.get_photon_data(photon_index);
+
+            // Reject photons from the opposite hemisphere as they won't contribute.
+            if (dot(m_normal, data.m_incoming) <= 0.0f)
+                return;
+
+#if 1
+            // Reject photons on a surface with too different an orientation.
+            const float NormalThreshold = 1.0e-3f;
+            if (dot(m_normal, data.m_geometric_normal) < NormalThreshold)
+                return;
+#endif
+
+#if 0
+            // Reject photons on the wrong side of the surface.
+            if (dot(m_vertex.m_outgoing, Vector3d(data.m_geometric_normal)) <= 0.0)
+                return;
+#endif
+
+            // Evaluate the BSDF for this photon.
+            Spectrum bsdf_value;
+            const double bsdf_prob =
+                m_vertex.m_bsdf->evaluate(
+                    m_vertex.m_bsdf_data,
+                    false,                                  // not adjoint
+                    true,                                   // multiply by |cos(incoming, normal)|
+                    m_vertex.get_geometric_normal(),
+                    m_vertex.get_shading_basis(),
+                    m_vertex.m_outgoing,                    // toward the camera
+                    normalize(Vector3d(data.m_incoming)),   // toward the light
+                    BSDF::Diffuse,
+                    bsdf_value);
+            if (bsdf_prob == 0.0)
+                return;
+
+            // The photons store flux but we are computing reflected radiance.
+            // The first step of the flux -> radiance conversion is done here.
+            // The conversion will be completed when doing density estimation.
+            bsdf_value /= abs(dot(data.m_incoming, data.m_geometric_normal));
+            bsdf_value *= data.m_flux;
+
+            // Apply kernel weight.
+#if 0
+            bsdf_value *= box2d(square_dist * m_rcp_max_square_dist);
+#else
+            bsdf_value *= epanechnikov2d(square_dist * m_rcp_max_square_dist);
+#endif
+
+            // Accumulate reflected flux.
+            ++m_included_photon_count;
+            m_flux += bsdf_value;
+        }
+
+        size_t get_included_photon_count() const
+        {
+            return m_included_photon_count;
+        }
+
+        const Spectrum& get_flux() const
+        {
+            return m_flux;
+        }
+
+      private:
+        const SPPMPassCallback&         m_pass_callback;
+        const PathVertex&               m_vertex;
+        const Vector3f                  m_normal;
+        const float                     m_rcp_max_square_dist;
+        size_t                          m_included_photon_count;
+        Spectrum                        m_flux;
+    };
+
+
     //
     // Stochastic Progressive Photon Mapping (SPPM) lighting engine.
     //
@@ -122,7 +223,7 @@ namespace
     {
       public:
         SPPMLightingEngine(
-            const SPPMPassCallback& pass_callback,
+            SPPMPassCallback&       pass_callback,
             const LightSampler&     light_sampler,
             const SPPMParameters&   params)
           : m_params(params)
@@ -130,6 +231,8 @@ namespace
           , m_light_sampler(light_sampler)
           , m_path_count(0)
           , m_answer(m_params.m_max_photons_per_estimate)
+          , m_lookup_timer(pass_callback.get_lookup_timer())
+          , m_lookup_stats(pass_callback.create_lookup_statistics())
         {
         }
 
@@ -160,6 +263,8 @@ namespace
                 shading_context,
                 shading_point.get_scene(),
                 m_answer,
+                m_lookup_timer,
+                m_lookup_stats,
                 radiance,
                 aovs);
 
@@ -196,6 +301,9 @@ namespace
         uint64                          m_path_count;
         Population<uint64>              m_path_length;
         knn::Answer<float>              m_answer;
+        X86Timer&                       m_lookup_timer;
+        SPPMPassCallback::LookupStatistics&
+                                        m_lookup_stats;
 
         struct PathVisitor
         {
@@ -207,6 +315,9 @@ namespace
             TextureCache&               m_texture_cache;
             const EnvironmentEDF*       m_env_edf;
             knn::Answer<float>&         m_answer;
+            X86Timer&                   m_lookup_timer;
+            SPPMPassCallback::LookupStatistics&
+                                        m_lookup_stats;
             Spectrum&                   m_path_radiance;
             SpectrumStack&              m_path_aovs;
 
@@ -218,6 +329,9 @@ namespace
                 const ShadingContext&   shading_context,
                 const Scene&            scene,
                 knn::Answer<float>&     answer,
+                X86Timer&               lookup_timer,
+                SPPMPassCallback::LookupStatistics&
+                                        lookup_stats,
                 Spectrum&               path_radiance,
                 SpectrumStack&          path_aovs)
               : m_params(params)
@@ -228,6 +342,8 @@ namespace
               , m_texture_cache(shading_context.get_texture_cache())
               , m_env_edf(scene.get_environment()->get_environment_edf())
               , m_answer(answer)
+              , m_lookup_timer(lookup_timer)
+              , m_lookup_stats(lookup_stats)
               , m_path_radiance(path_radiance)
               , m_path_aovs(path_aovs)
             {
@@ -337,124 +453,99 @@ namespace
                 const PathVertex&       vertex,
                 Spectrum&               vertex_radiance,
                 SpectrumStack&          vertex_aovs)
+            {
+                const uint64 lookup_begin = m_lookup_timer.read();
+
+                // Gather the photons around the path vertex.
+                float max_square_dist;
+                Spectrum indirect_radiance;
+                const size_t included_photon_count =
+                    m_params.m_photon_lookup == SPPMParameters::HashGrid
+                        ? gather_photons_from_grid(vertex, max_square_dist, indirect_radiance)
+                        : gather_photons_from_kdtree(vertex, max_square_dist, indirect_radiance);
+
+                ++m_lookup_stats.m_lookup_count;
+                m_lookup_stats.m_lookup_ticks += m_lookup_timer.read() - lookup_begin;
+
+#if 0
+                // Unreliable density estimation if too few photons were actually included.
+                const size_t MinPhotonCount = 8;
+                if (included_photon_count < MinPhotonCount)
+                    return;
+#else
+                // Can't do density estimation without any photon.
+                if (included_photon_count == 0)
+                    return;
+#endif
+
+                // Density estimation.
+                indirect_radiance /= max_square_dist * m_pass_callback.get_emitted_photon_count();
+
+                // Add the indirect lighting contribution.
+                vertex_radiance += indirect_radiance;
+            }
+
+            size_t gather_photons_from_kdtree(
+                const PathVertex&       vertex,
+                float&                  max_square_dist,
+                Spectrum&               flux)
             {
                 const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
 
                 // No indirect lighting if the photon map is empty.
                 if (photon_map.empty())
-                    return;
+                    return 0;
 
                 const float radius = m_pass_callback.get_lookup_radius();
-                const Vector3f point(vertex.get_point());
-                const Vector3f normal(vertex.get_geometric_normal());
 
                 // Find the nearby photons around the path vertex.
                 const knn::Query3f query(photon_map, m_answer);
-                query.run(point, radius * radius);
+                query.run(Vector3f(vertex.get_point()), radius * radius);
                 const size_t photon_count = m_answer.size();
 
                 // Compute the square radius of the lookup disk.
-                float max_square_dist;
                 if (photon_count == m_params.m_max_photons_per_estimate)
                 {
                     m_answer.sort();
                     max_square_dist = m_answer.get(photon_count - 1).m_square_dist;
                 }
                 else max_square_dist = radius * radius;
-                const float rcp_max_square_dist = 1.0f / max_square_dist;
-
-#if 0
-                // Cannot do proper density estimation if too few photons are found.
-                const size_t MinPhotonCount = 8;
-                if (photon_count < MinPhotonCount)
-                    return;
-#endif
-
-                size_t included_photon_count = 0;
-                Spectrum indirect_radiance(0.0f);
 
                 // Loop over the nearby photons.
+                FluxAccumulator accumulator(m_pass_callback, vertex, max_square_dist);
                 for (size_t i = 0; i < photon_count; ++i)
                 {
-                    // Retrieve the i'th photon.
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
-                    const SPPMPhotonData& data = m_pass_callback.get_photon_data(photon_map.remap(photon.m_index));
-
-                    // Reject photons from the opposite hemisphere as they won't contribute.
-                    if (dot(normal, data.m_incoming) <= 0.0f)
-                        continue;
-
-#if 1
-                    // Reject photons on a surface with too different an orientation.
-                    const float NormalThreshold = 1.0e-3f;
-                    if (dot(normal, data.m_geometric_normal) < NormalThreshold)
-                        continue;
-#endif
-
-#if 0
-                    // Reject photons on the wrong side of the surface.
-                    if (dot(vertex.m_outgoing, Vector3d(data.m_geometric_normal)) <= 0.0)
-                        continue;
-#endif
+                    accumulator.visit(
+                        photon_map.remap(photon.m_index),
+                        photon_map.get_point(photon.m_index),
+                        photon.m_square_dist);
+                }
 
-#if 0
-                    // Reject photons too far away along the surface's normal.
-                    const Vector3f& photon_position = photon_map.get_point(photon.m_index);
-                    const Vector3f point_to_photon = photon_position - point;
-                    const float vdist = abs(dot(normal, point_to_photon));
-                    if (vdist > 0.1f * radius)
-                        continue;
-#endif
+                flux = accumulator.get_flux();
+                return accumulator.get_included_photon_count();
+            }
 
-                    // Evaluate the BSDF for this photon.
-                    Spectrum bsdf_value;
-                    const double bsdf_prob =
-                        vertex.m_bsdf->evaluate(
-                            vertex.m_bsdf_data,
-                            false,                                  // not adjoint
-                            true,                                   // multiply by |cos(incoming, normal)|
-                            vertex.get_geometric_normal(),
-                            vertex.get_shading_basis(),
-                            vertex.m_outgoing,                      // toward the camera
-                            normalize(Vector3d(data.m_incoming)),   // toward the light
-                            BSDF::Diffuse,
-                            bsdf_value);
-                    if (bsdf_prob == 0.0)
-                        continue;
-
-                    // The photons store flux but we are computing reflected radiance.
-                    // The first step of the flux -> radiance conversion is done here.
-                    // The conversion will be completed when doing density estimation.
-                    bsdf_value /= abs(dot(data.m_incoming, data.m_geometric_normal));
-                    bsdf_value *= data.m_flux;
-
-                    // Apply kernel weight.
-#if 0
-                    bsdf_value *= box2d(photon.m_square_dist * rcp_max_square_dist);
-#else
-                    bsdf_value *= epanechnikov2d(photon.m_square_dist * rcp_max_square_dist);
-#endif
+            size_t gather_photons_from_grid(
+                const PathVertex&       vertex,
+                float&                  max_square_dist,
+                Spectrum&               flux)
+            {
+                const SPPMPhotonGrid& photon_grid = m_pass_callback.get_photon_grid();
 
-                    // Accumulate reflected flux.
-                    ++included_photon_count;
-                    indirect_radiance += bsdf_value;
-                }
+                // No indirect lighting if the photon grid is empty.
+                if (photon_grid.empty())
+                    return 0;
 
-#if 0
-                // Unreliable density estimation if too few photons were actually included.
-                if (included_photon_count < MinPhotonCount)
-                    return;
-#else
-                // Can't do density estimation without any photon.
-                if (included_photon_count == 0)
-                    return;
-#endif
+                // All the photons within the lookup radius are used, no sorting is required.
+                const float radius = m_pass_callback.get_lookup_radius();
+                max_square_dist = radius * radius;
 
-                // Density estimation.
-                indirect_radiance /= max_square_dist * m_pass_callback.get_emitted_photon_count();
+                FluxAccumulator accumulator(m_pass_callback, vertex, max_square_dist);
+                photon_grid.query(Vector3f(vertex.get_point()), accumulator);
 
-                // Add the indirect lighting contribution.
-                vertex_radiance += indirect_radiance;
+                flux = accumulator.get_flux();
+                return accumulator.get_included_photon_count();
             }
 
             void add_emitted_light_contribution(
@@ -538,7 +629,7 @@ namespace
 //
 
 SPPMLightingEngineFactory::SPPMLightingEngineFactory(
-    const SPPMPassCallback&     pass_callback,
+    SPPMPassCallback&           pass_callback,
     const LightSampler&         light_sampler,
     const SPPMParameters&       params)
   : m_pass_callback(pass_callback)
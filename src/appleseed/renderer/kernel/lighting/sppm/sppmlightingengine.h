@@ -54,7 +54,7 @@ class SPPMLightingEngineFactory
   public:
     // Constructor.
     SPPMLightingEngineFactory(
-        const SPPMPassCallback&     pass_callback,
+        SPPMPassCallback&           pass_callback,
         const LightSampler&         light_sampler,
         const SPPMParameters&       params);
 
@@ -66,7 +66,7 @@ class SPPMLightingEngineFactory
 
   private:
     const SPPMParameters            m_params;
-    const SPPMPassCallback&         m_pass_callback;
+    SPPMPassCallback&               m_pass_callback;
     const LightSampler&             m_light_sampler;
 };
 
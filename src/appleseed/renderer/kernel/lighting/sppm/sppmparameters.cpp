@@ -80,6 +80,26 @@ namespace
             return default_mode;
         }
     }
+
+    SPPMParameters::Lookup get_photon_lookup(
+        const ParamArray&           params,
+        const char*                 name)
+    {
+        const string value = params.get_optional<string>(name, "kdtree");
+
+        if (value == "kdtree")
+            return SPPMParameters::KdTree;
+        else if (value == "hashgrid")
+            return SPPMParameters::HashGrid;
+        else
+        {
+            RENDERER_LOG_ERROR(
+                "invalid value \"%s\" for parameter \"%s\", using default value \"kdtree\"",
+                value.c_str(),
+                name);
+            return SPPMParameters::KdTree;
+        }
+    }
 }
 
 SPPMParameters::SPPMParameters(const ParamArray& params)
@@ -97,6 +117,7 @@ SPPMParameters::SPPMParameters(const ParamArray& params)
   , m_initial_radius_percents(params.get_required<float>("initial_radius", 0.1f))
   , m_alpha(params.get_optional<float>("alpha", 0.7f))
   , m_max_photons_per_estimate(params.get_optional<size_t>("max_photons_per_estimate", 100))
+  , m_photon_lookup(get_photon_lookup(params, "photon_lookup"))
   , m_dl_light_sample_count(params.get_optional<double>("dl_light_samples", 1.0))
   , m_view_photons(params.get_optional<bool>("view_photons", false))
   , m_view_photons_radius(params.get_optional<float>("view_photons_radius", 1.0e-3f))
@@ -135,12 +156,14 @@ void SPPMParameters::print() const
         "  initial radius   %s%%\n"
         "  alpha            %s\n"
         "  max photons/est. %s\n"
+        "  photon lookup    %s\n"
         "  dl light samples %s",
         m_path_tracing_max_path_length == ~0 ? "infinite" : pretty_uint(m_path_tracing_max_path_length).c_str(),
         m_path_tracing_rr_min_path_length == ~0 ? "infinite" : pretty_uint(m_path_tracing_rr_min_path_length).c_str(),
         pretty_scalar(m_initial_radius_percents, 3).c_str(),
         pretty_scalar(m_alpha, 1).c_str(),
         pretty_uint(m_max_photons_per_estimate).c_str(),
+        m_photon_lookup == KdTree ? "kd-tree" : "hash grid",
         pretty_scalar(m_dl_light_sample_count).c_str());
 }
 
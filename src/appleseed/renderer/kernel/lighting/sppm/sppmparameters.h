@@ -42,6 +42,7 @@ namespace renderer
 struct SPPMParameters
 {
     enum Mode { SPPM, RayTraced, Off };
+    enum Lookup { KdTree, HashGrid };
 
     const Mode      m_dl_mode;                              // direct lighting mode
     const bool      m_enable_ibl;                           // is image-based lighting enabled?
@@ -61,7 +62,8 @@ struct SPPMParameters
 
     const float     m_initial_radius_percents;              // initial lookup radius as a percentage of the scene diameter
     const float     m_alpha;                                // radius shrinking control
-    const size_t    m_max_photons_per_estimate;             // maximum number of photons per density estimation
+    const size_t    m_max_photons_per_estimate;             // maximum number of photons per density estimation, kd-tree lookup only
+    const Lookup    m_photon_lookup;                        // acceleration structure used to find the photons around a point
     const double    m_dl_light_sample_count;                // number of light samples used to estimate direct illumination in ray traced mode
     float           m_rcp_dl_light_sample_count;
 
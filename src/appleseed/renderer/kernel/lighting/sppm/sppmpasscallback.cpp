@@ -40,6 +40,7 @@
 #include "foundation/utility/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <string>
@@ -74,7 +75,10 @@ SPPMPassCallback::SPPMPassCallback(
 #endif
         params)
   , m_pass_number(0)
-  , m_emitted_photon_count(0)
+  , m_current(&m_buffers[0])
+  , m_next(&m_buffers[1])
+  , m_tracing_next(false)
+  , m_next_ready(false)
 {
     // Compute the initial lookup radius.
     const float scene_diameter = static_cast<float>(2.0 * scene.compute_radius());
@@ -99,11 +103,18 @@ void SPPMPassCallback::pre_render(
 
     m_stopwatch.start();
 
+    // If the photon map of this pass was built during the previous pass, just make it current.
+    if (m_next_ready)
+    {
+        std::swap(m_current, m_next);
+        m_next_ready = false;
+        return;
+    }
+
     // Create a new set of photons.
-    m_photons.clear_keep_memory();
-    m_emitted_photon_count =
+    m_current->m_emitted_photon_count =
         m_photon_tracer.trace_photons(
-            m_photons,
+            m_current->m_photons,
             hash_uint32(m_pass_number),
             job_queue,
             abort_switch);
@@ -113,7 +124,26 @@ void SPPMPassCallback::pre_render(
         return;
 
     // Build a new photon map.
-    m_photon_map.reset(new SPPMPhotonMap(m_photons));
+    build_photon_map(*m_current, job_queue);
+}
+
+void SPPMPassCallback::prepare_next_pass(
+    const Frame&            frame,
+    JobQueue&               job_queue,
+    AbortSwitch&            abort_switch)
+{
+    assert(!m_tracing_next);
+    assert(!m_next_ready);
+
+    // Schedule the tracing of the photons of the next pass.
+    m_next->m_emitted_photon_count =
+        m_photon_tracer.begin_photon_tracing(
+            m_next->m_photons,
+            hash_uint32(m_pass_number + 1),
+            job_queue,
+            abort_switch);
+
+    m_tracing_next = true;
 }
 
 void SPPMPassCallback::post_render(
@@ -126,8 +156,24 @@ void SPPMPassCallback::post_render(
     assert(k <= 1.0);
     m_lookup_radius *= sqrt(k);
 
+    // Photon tracing jobs of the next pass have completed along with tile jobs:
+    // build the photon map of the next pass, unless rendering was aborted.
+    if (m_tracing_next)
+    {
+        m_photon_tracer.end_photon_tracing(m_next->m_photons);
+        m_tracing_next = false;
+
+        if (!abort_switch.is_aborted())
+        {
+            build_photon_map(*m_next, job_queue);
+            m_next_ready = true;
+        }
+    }
+
     m_stopwatch.measure();
 
+    print_lookup_statistics();
+
     RENDERER_LOG_INFO(
         "sppm pass %s completed in %s.",
         pretty_uint(m_pass_number + 1).c_str(),
@@ -136,4 +182,76 @@ void SPPMPassCallback::post_render(
     ++m_pass_number;
 }
 
+SPPMPassCallback::LookupStatistics& SPPMPassCallback::create_lookup_statistics()
+{
+    boost::mutex::scoped_lock lock(m_lookup_stats_mutex);
+
+    LookupStatistics stats;
+    stats.m_lookup_count = 0;
+    stats.m_lookup_ticks = 0;
+    m_lookup_stats.push_back(stats);
+
+    return m_lookup_stats.back();
+}
+
+void SPPMPassCallback::build_photon_map(
+    PhotonBuffer&           buffer,
+    JobQueue&               job_queue)
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // The hash grid copies the photon positions, so it must be built before the kd-tree.
+    if (m_params.m_photon_lookup == SPPMParameters::HashGrid)
+        buffer.m_photon_grid.reset(new SPPMPhotonGrid(buffer.m_photons.m_positions, m_lookup_radius, job_queue));
+
+    // The kd-tree is also used to visualize the photons.
+    if (m_params.m_photon_lookup == SPPMParameters::KdTree || m_params.m_view_photons)
+        buffer.m_photon_map.reset(new SPPMPhotonMap(buffer.m_photons, job_queue));
+
+    stopwatch.measure();
+
+    RENDERER_LOG_INFO(
+        "sppm photon %s built in %s.",
+        m_params.m_photon_lookup == SPPMParameters::KdTree ? "kd-tree" : "hash grid",
+        pretty_time(stopwatch.get_seconds()).c_str());
+}
+
+void SPPMPassCallback::print_lookup_statistics()
+{
+    uint64 lookup_count = 0;
+    uint64 lookup_ticks = 0;
+
+    // Lighting engines are idle between passes.
+    for (size_t i = 0; i < m_lookup_stats.size(); ++i)
+    {
+        lookup_count += m_lookup_stats[i].m_lookup_count;
+        lookup_ticks += m_lookup_stats[i].m_lookup_ticks;
+        m_lookup_stats[i].m_lookup_count = 0;
+        m_lookup_stats[i].m_lookup_ticks = 0;
+    }
+
+    if (lookup_count == 0)
+        return;
+
+    const double lookup_time =
+        static_cast<double>(lookup_ticks) / m_lookup_timer.frequency();
+
+    RENDERER_LOG_INFO(
+        "sppm photon lookups: %s in %s of thread time, %s us per lookup.",
+        pretty_uint(lookup_count).c_str(),
+        pretty_time(lookup_time).c_str(),
+        pretty_scalar(1.0e6 * lookup_time / lookup_count, 3).c_str());
+}
+
+
+//
+// SPPMPassCallback::PhotonBuffer class implementation.
+//
+
+SPPMPassCallback::PhotonBuffer::PhotonBuffer()
+  : m_emitted_photon_count(0)
+{
+}
+
 }   // namespace renderer
@@ -33,14 +33,17 @@
 // appleseed.renderer headers.
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
+#include "renderer/kernel/lighting/sppm/sppmphotongrid.h"
 #include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
 #include "renderer/kernel/lighting/sppm/sppmphotontracer.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
 
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
 #include "foundation/platform/timer.h"
 #include "foundation/platform/types.h"
+#include "foundation/platform/x86timer.h"
 #include "foundation/utility/stopwatch.h"
 
 // OSL headers.
@@ -50,6 +53,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <deque>
 #include <memory>
 
 // Forward declarations.
@@ -68,6 +72,11 @@ namespace renderer
 //
 // This class is responsible for building a new photon map before a pass begins.
 //
+// Photon maps are double-buffered: while a pass renders using the current photon map,
+// the photons of the next pass are traced by worker threads that ran out of tiles to
+// render. The photon map of the next pass is built at the end of the pass, and becomes
+// the current one when the next pass begins.
+//
 
 class SPPMPassCallback
   : public IPassCallback
@@ -93,6 +102,12 @@ class SPPMPassCallback
         foundation::JobQueue&       job_queue,
         foundation::AbortSwitch&    abort_switch) OVERRIDE;
 
+    // This method is called once the jobs of a pass have been scheduled.
+    virtual void prepare_next_pass(
+        const Frame&                frame,
+        foundation::JobQueue&       job_queue,
+        foundation::AbortSwitch&    abort_switch) OVERRIDE;
+
     // This method is called at the end of a pass.
     virtual void post_render(
         const Frame&                frame,
@@ -105,23 +120,60 @@ class SPPMPassCallback
     // Return the i'th photon.
     const SPPMPhotonData& get_photon_data(const size_t i) const;
 
-    // Return the current photon map.
+    // Return the current photon map (kd-tree lookup).
     const SPPMPhotonMap& get_photon_map() const;
 
+    // Return the current photon grid (hash grid lookup).
+    const SPPMPhotonGrid& get_photon_grid() const;
+
     // Return the current lookup radius.
     float get_lookup_radius() const;
 
+    // Photon lookup statistics of one lighting engine, reported and reset at the end of each pass.
+    struct LookupStatistics
+    {
+        foundation::uint64          m_lookup_count;
+        foundation::uint64          m_lookup_ticks;     // measured with the lookup timer
+    };
+
+    // Allocate photon lookup statistics for a lighting engine. Thread-safe.
+    LookupStatistics& create_lookup_statistics();
+
+    // Return the timer used to measure photon lookups.
+    foundation::X86Timer& get_lookup_timer();
+
   private:
+    // The photons of a pass and the structures used to look them up.
+    struct PhotonBuffer
+    {
+        size_t                          m_emitted_photon_count;
+        SPPMPhotonVector                m_photons;
+        std::auto_ptr<SPPMPhotonMap>    m_photon_map;
+        std::auto_ptr<SPPMPhotonGrid>   m_photon_grid;
+
+        PhotonBuffer();
+    };
+
     const SPPMParameters            m_params;
     SPPMPhotonTracer                m_photon_tracer;
     foundation::uint32              m_pass_number;
-    size_t                          m_emitted_photon_count;
-    SPPMPhotonVector                m_photons;
-    std::auto_ptr<SPPMPhotonMap>    m_photon_map;
+    PhotonBuffer                    m_buffers[2];
+    PhotonBuffer*                   m_current;          // photons of the current pass
+    PhotonBuffer*                   m_next;             // photons of the next pass
+    bool                            m_tracing_next;     // are photons of the next pass being traced?
+    bool                            m_next_ready;       // is the photon map of the next pass built?
     float                           m_initial_lookup_radius;
     float                           m_lookup_radius;
     foundation::Stopwatch<foundation::DefaultWallclockTimer>
                                     m_stopwatch;
+    foundation::X86Timer            m_lookup_timer;
+    boost::mutex                    m_lookup_stats_mutex;
+    std::deque<LookupStatistics>    m_lookup_stats;
+
+    void build_photon_map(
+        PhotonBuffer&               buffer,
+        foundation::JobQueue&       job_queue);
+    void print_lookup_statistics();
 };
 
 
@@ -131,17 +183,22 @@ class SPPMPassCallback
 
 inline size_t SPPMPassCallback::get_emitted_photon_count() const
 {
-    return m_emitted_photon_count;
+    return m_current->m_emitted_photon_count;
 }
 
 inline const SPPMPhotonData& SPPMPassCallback::get_photon_data(const size_t i) const
 {
-    return m_photons.m_data[i];
+    return m_current->m_photons.m_data[i];
 }
 
 inline const SPPMPhotonMap& SPPMPassCallback::get_photon_map() const
 {
-    return *m_photon_map.get();
+    return *m_current->m_photon_map.get();
+}
+
+inline const SPPMPhotonGrid& SPPMPassCallback::get_photon_grid() const
+{
+    return *m_current->m_photon_grid.get();
 }
 
 inline float SPPMPassCallback::get_lookup_radius() const
@@ -149,6 +206,11 @@ inline float SPPMPassCallback::get_lookup_radius() const
     return m_lookup_radius;
 }
 
+inline foundation::X86Timer& SPPMPassCallback::get_lookup_timer()
+{
+    return m_lookup_timer;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMPASSCALLBACK_H
@@ -33,7 +33,12 @@
 // appleseed.foundation headers.
 #include "foundation/utility/memory.h"
 
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
@@ -42,6 +47,27 @@ namespace renderer
 // SPPMPhotonVector class implementation.
 //
 
+namespace
+{
+    // Atomically add a value to a 32-bit integer and return the previous value.
+    boost::uint32_t atomic_add32(volatile boost::uint32_t* mem, const boost::uint32_t val)
+    {
+        while (true)
+        {
+            const boost::uint32_t old_value = boost_atomic::atomic_read32(mem);
+
+            if (boost_atomic::atomic_cas32(mem, old_value + val, old_value) == old_value)
+                return old_value;
+        }
+    }
+}
+
+SPPMPhotonVector::SPPMPhotonVector()
+  : m_claimed_slots(0)
+  , m_capacity(0)
+{
+}
+
 bool SPPMPhotonVector::empty() const
 {
     assert(m_positions.empty() == m_data.empty());
@@ -57,8 +83,8 @@ size_t SPPMPhotonVector::size() const
 size_t SPPMPhotonVector::get_memory_size() const
 {
     return
-        m_positions.capacity() * sizeof(Vector3f) +
-        m_data.capacity() * sizeof(SPPMPhotonData);
+        (m_positions.capacity() + m_overflow_positions.capacity()) * sizeof(Vector3f) +
+        (m_data.capacity() + m_overflow_data.capacity()) * sizeof(SPPMPhotonData);
 }
 
 void SPPMPhotonVector::swap(SPPMPhotonVector& rhs)
@@ -85,12 +111,62 @@ void SPPMPhotonVector::push_back(const SPPMPhoton& photon)
     m_data.push_back(photon.m_data);
 }
 
+void SPPMPhotonVector::begin_collection(const size_t capacity)
+{
+    // Growing the arrays only initializes the new slots.
+    if (m_positions.size() < capacity)
+    {
+        m_positions.resize(capacity);
+        m_data.resize(capacity);
+    }
+
+    m_capacity = m_positions.size();
+    m_claimed_slots = 0;
+
+    foundation::clear_keep_memory(m_overflow_positions);
+    foundation::clear_keep_memory(m_overflow_data);
+}
+
 void SPPMPhotonVector::append(const SPPMPhotonVector& rhs)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    const size_t count = rhs.size();
+
+    if (count == 0)
+        return;
+
+    // Claim a range of slots.
+    const size_t begin = atomic_add32(&m_claimed_slots, static_cast<boost::uint32_t>(count));
+    const size_t end = begin + count;
+
+    // Copy the photons that fit into the claimed slots.
+    const size_t fitting_count = begin < m_capacity ? min(end, m_capacity) - begin : 0;
+    copy(rhs.m_positions.begin(), rhs.m_positions.begin() + fitting_count, m_positions.begin() + begin);
+    copy(rhs.m_data.begin(), rhs.m_data.begin() + fitting_count, m_data.begin() + begin);
+
+    // Keep the other photons aside.
+    if (fitting_count < count)
+    {
+        boost::mutex::scoped_lock lock(m_overflow_mutex);
+
+        m_overflow_positions.insert(m_overflow_positions.end(), rhs.m_positions.begin() + fitting_count, rhs.m_positions.end());
+        m_overflow_data.insert(m_overflow_data.end(), rhs.m_data.begin() + fitting_count, rhs.m_data.end());
+    }
+}
+
+void SPPMPhotonVector::end_collection()
+{
+    // Shrinking the arrays keeps their memory.
+    const size_t count = min(static_cast<size_t>(m_claimed_slots), m_capacity);
+    m_positions.resize(count);
+    m_data.resize(count);
+
+    m_positions.insert(m_positions.end(), m_overflow_positions.begin(), m_overflow_positions.end());
+    m_data.insert(m_data.end(), m_overflow_data.begin(), m_overflow_data.end());
+
+    assert(m_positions.size() == m_claimed_slots);
 
-    m_positions.insert(m_positions.end(), rhs.m_positions.begin(), rhs.m_positions.end());
-    m_data.insert(m_data.end(), rhs.m_data.begin(), rhs.m_data.end());
+    m_capacity = 0;
+    m_claimed_slots = 0;
 }
 
 }   // namespace renderer
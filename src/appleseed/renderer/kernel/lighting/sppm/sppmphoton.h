@@ -35,9 +35,10 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
 
 // boost headers.
-#include "foundation/platform/thread.h"
+#include "boost/cstdint.hpp"
 
 // Standard headers.
 #include <cstddef>
@@ -69,13 +70,21 @@ class SPPMPhoton
 //
 // A vector of photons.
 //
+// Photons traced by multiple threads are collected with append(): the final
+// arrays are sized in advance by begin_collection() and each call to append()
+// claims a range of slots with an atomic counter, then copies its photons
+// without taking any lock. Photons that don't fit are kept aside under a lock
+// and moved to the end of the arrays by end_collection().
+//
 
 class SPPMPhotonVector
 {
   public:
     std::vector<foundation::Vector3f>   m_positions;
     std::vector<SPPMPhotonData>         m_data;
-    boost::mutex                        m_mutex;
+
+    // Constructor.
+    SPPMPhotonVector();
 
     bool empty() const;
     size_t size() const;
@@ -88,8 +97,22 @@ class SPPMPhotonVector
     void reserve(const size_t capacity);
     void push_back(const SPPMPhoton& photon);
 
-    // Thread-safe.
+    // Remove all photons and make room for at least a given number of
+    // photons to be collected with append().
+    void begin_collection(const size_t capacity);
+
+    // Thread-safe, may only be called between begin_collection() and end_collection().
     void append(const SPPMPhotonVector& rhs);
+
+    // Finish collecting photons.
+    void end_collection();
+
+  private:
+    boost::uint32_t                     m_claimed_slots;
+    size_t                              m_capacity;
+    boost::mutex                        m_overflow_mutex;
+    std::vector<foundation::Vector3f>   m_overflow_positions;
+    std::vector<SPPMPhotonData>         m_overflow_data;
 };
 
 }       // namespace renderer
@@ -0,0 +1,230 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sppmphotongrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/job.h"
+
+// boost headers.
+#include "boost/cstdint.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// SPPMPhotonGrid class implementation.
+//
+
+namespace
+{
+    const size_t PhotonsPerJob = 64 * 1024;
+
+    typedef vector<boost::uint32_t> CounterVector;
+
+    //
+    // A job to compute the bucket of a range of photons and count the photons of each bucket.
+    //
+
+    class CountingJob
+      : public IJob
+    {
+      public:
+        CountingJob(
+            const SPPMPhotonGrid&       grid,
+            const vector<Vector3f>&     positions,
+            const size_t                photon_begin,
+            const size_t                photon_end,
+            vector<uint32>&             photon_buckets,
+            CounterVector&              bucket_counts)
+          : m_grid(grid)
+          , m_positions(positions)
+          , m_photon_begin(photon_begin)
+          , m_photon_end(photon_end)
+          , m_photon_buckets(photon_buckets)
+          , m_bucket_counts(bucket_counts)
+        {
+        }
+
+        virtual void execute(const size_t thread_index) OVERRIDE
+        {
+            for (size_t i = m_photon_begin; i < m_photon_end; ++i)
+            {
+                const uint32 bucket = m_grid.get_bucket(m_positions[i]);
+                m_photon_buckets[i] = bucket;
+                boost_atomic::atomic_inc32(&m_bucket_counts[bucket]);
+            }
+        }
+
+      private:
+        const SPPMPhotonGrid&           m_grid;
+        const vector<Vector3f>&         m_positions;
+        const size_t                    m_photon_begin;
+        const size_t                    m_photon_end;
+        vector<uint32>&                 m_photon_buckets;
+        CounterVector&                  m_bucket_counts;
+    };
+
+    //
+    // A job to move a range of photons to their final location in the grid.
+    //
+
+    class ScatteringJob
+      : public IJob
+    {
+      public:
+        ScatteringJob(
+            const vector<Vector3f>&     positions,
+            const size_t                photon_begin,
+            const size_t                photon_end,
+            const vector<uint32>&       photon_buckets,
+            CounterVector&              bucket_cursors,
+            vector<Vector3f>&           sorted_positions,
+            vector<uint32>&             sorted_indices)
+          : m_positions(positions)
+          , m_photon_begin(photon_begin)
+          , m_photon_end(photon_end)
+          , m_photon_buckets(photon_buckets)
+          , m_bucket_cursors(bucket_cursors)
+          , m_sorted_positions(sorted_positions)
+          , m_sorted_indices(sorted_indices)
+        {
+        }
+
+        virtual void execute(const size_t thread_index) OVERRIDE
+        {
+            for (size_t i = m_photon_begin; i < m_photon_end; ++i)
+            {
+                // atomic_inc32() returns the value of the cursor before the increment.
+                const size_t slot =
+                    boost_atomic::atomic_inc32(&m_bucket_cursors[m_photon_buckets[i]]);
+
+                m_sorted_positions[slot] = m_positions[i];
+                m_sorted_indices[slot] = static_cast<uint32>(i);
+            }
+        }
+
+      private:
+        const vector<Vector3f>&         m_positions;
+        const size_t                    m_photon_begin;
+        const size_t                    m_photon_end;
+        const vector<uint32>&           m_photon_buckets;
+        CounterVector&                  m_bucket_cursors;
+        vector<Vector3f>&               m_sorted_positions;
+        vector<uint32>&                 m_sorted_indices;
+    };
+}
+
+SPPMPhotonGrid::SPPMPhotonGrid(
+    const vector<Vector3f>&             positions,
+    const float                         lookup_radius,
+    JobQueue&                           job_queue)
+  : m_rcp_cell_size(1.0f / lookup_radius)
+  , m_square_lookup_radius(lookup_radius * lookup_radius)
+  , m_bucket_mask(0)
+{
+    assert(lookup_radius > 0.0f);
+
+    const size_t photon_count = positions.size();
+
+    if (photon_count == 0)
+        return;
+
+    // Use about as many buckets as there are photons.
+    const size_t bucket_count = next_pow2<uint32>(static_cast<uint32>(photon_count));
+    m_bucket_mask = static_cast<uint32>(bucket_count - 1);
+
+    // Compute the bucket of each photon and count the photons of each bucket.
+    vector<uint32> photon_buckets(photon_count);
+    CounterVector bucket_cursors(bucket_count, 0);
+    for (size_t i = 0; i < photon_count; i += PhotonsPerJob)
+    {
+        job_queue.schedule(
+            new CountingJob(
+                *this,
+                positions,
+                i,
+                min(i + PhotonsPerJob, photon_count),
+                photon_buckets,
+                bucket_cursors));
+    }
+    job_queue.wait_until_completion();
+
+    // Compute the offset of the first photon of each bucket.
+    // From now on, the counters hold the next free slot of each bucket.
+    m_bucket_offsets.resize(bucket_count + 1);
+    uint32 offset = 0;
+    for (size_t i = 0; i < bucket_count; ++i)
+    {
+        const uint32 count = bucket_cursors[i];
+        m_bucket_offsets[i] = bucket_cursors[i] = offset;
+        offset += count;
+    }
+    m_bucket_offsets[bucket_count] = offset;
+    assert(offset == photon_count);
+
+    // Move the photons to their bucket.
+    m_positions.resize(photon_count);
+    m_indices.resize(photon_count);
+    for (size_t i = 0; i < photon_count; i += PhotonsPerJob)
+    {
+        job_queue.schedule(
+            new ScatteringJob(
+                positions,
+                i,
+                min(i + PhotonsPerJob, photon_count),
+                photon_buckets,
+                bucket_cursors,
+                m_positions,
+                m_indices));
+    }
+    job_queue.wait_until_completion();
+}
+
+size_t SPPMPhotonGrid::get_memory_size() const
+{
+    return
+        sizeof(*this) +
+        m_bucket_offsets.capacity() * sizeof(uint32) +
+        m_positions.capacity() * sizeof(Vector3f) +
+        m_indices.capacity() * sizeof(uint32);
+}
+
+}   // namespace renderer
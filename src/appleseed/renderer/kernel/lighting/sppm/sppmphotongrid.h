@@ -0,0 +1,205 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMPHOTONGRID_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMPHOTONGRID_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class JobQueue; }
+
+namespace renderer
+{
+
+//
+// A photon map based on a hashed uniform grid whose cells are as large as the
+// lookup radius. Since the lookup radius is fixed during a pass, all photons
+// within the lookup radius of a point lie in the 27 cells around this point.
+//
+// The grid is built in parallel with a counting sort of the photons by cell.
+//
+
+class SPPMPhotonGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor, copies the photon positions into the grid.
+    SPPMPhotonGrid(
+        const std::vector<foundation::Vector3f>&    positions,
+        const float                                 lookup_radius,
+        foundation::JobQueue&                       job_queue);
+
+    // Return true if the grid does not contain any photon.
+    bool empty() const;
+
+    // Return the number of photons in the grid.
+    size_t size() const;
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+    // Return the bucket of the grid cell containing a given point.
+    foundation::uint32 get_bucket(const foundation::Vector3f& point) const;
+
+    // Call visitor.visit(photon_index, photon_position, square_distance) for
+    // every photon within the lookup radius of a given point. photon_index is
+    // the index of the photon in the vector passed to the constructor. Photons
+    // are visited in no particular order.
+    template <typename Visitor>
+    void query(
+        const foundation::Vector3f&                 point,
+        Visitor&                                    visitor) const;
+
+  private:
+    typedef std::vector<foundation::uint32> IndexVector;
+
+    float                                   m_rcp_cell_size;
+    float                                   m_square_lookup_radius;
+    foundation::uint32                      m_bucket_mask;
+    IndexVector                             m_bucket_offsets;   // bucket count + 1 entries
+    std::vector<foundation::Vector3f>       m_positions;        // photon positions, sorted by bucket
+    IndexVector                             m_indices;          // original photon indices, sorted by bucket
+
+    int get_cell_coordinate(const float x) const;
+
+    foundation::uint32 hash(
+        const int                                   x,
+        const int                                   y,
+        const int                                   z) const;
+};
+
+
+//
+// SPPMPhotonGrid class implementation.
+//
+
+inline bool SPPMPhotonGrid::empty() const
+{
+    return m_positions.empty();
+}
+
+inline size_t SPPMPhotonGrid::size() const
+{
+    return m_positions.size();
+}
+
+inline foundation::uint32 SPPMPhotonGrid::get_bucket(const foundation::Vector3f& point) const
+{
+    return
+        hash(
+            get_cell_coordinate(point.x),
+            get_cell_coordinate(point.y),
+            get_cell_coordinate(point.z));
+}
+
+inline int SPPMPhotonGrid::get_cell_coordinate(const float x) const
+{
+    return static_cast<int>(std::floor(x * m_rcp_cell_size));
+}
+
+inline foundation::uint32 SPPMPhotonGrid::hash(
+    const int                                       x,
+    const int                                       y,
+    const int                                       z) const
+{
+    const foundation::uint32 h =
+        (static_cast<foundation::uint32>(x) * 73856093u) ^
+        (static_cast<foundation::uint32>(y) * 19349663u) ^
+        (static_cast<foundation::uint32>(z) * 83492791u);
+
+    return h & m_bucket_mask;
+}
+
+template <typename Visitor>
+void SPPMPhotonGrid::query(
+    const foundation::Vector3f&                     point,
+    Visitor&                                        visitor) const
+{
+    if (m_positions.empty())
+        return;
+
+    const int cx = get_cell_coordinate(point.x);
+    const int cy = get_cell_coordinate(point.y);
+    const int cz = get_cell_coordinate(point.z);
+
+    // Distinct cells may share a bucket; visit each bucket only once.
+    foundation::uint32 visited[27];
+    size_t visited_count = 0;
+
+    for (int z = cz - 1; z <= cz + 1; ++z)
+    {
+        for (int y = cy - 1; y <= cy + 1; ++y)
+        {
+            for (int x = cx - 1; x <= cx + 1; ++x)
+            {
+                const foundation::uint32 bucket = hash(x, y, z);
+
+                bool already_visited = false;
+                for (size_t i = 0; i < visited_count; ++i)
+                {
+                    if (visited[i] == bucket)
+                    {
+                        already_visited = true;
+                        break;
+                    }
+                }
+
+                if (already_visited)
+                    continue;
+
+                visited[visited_count++] = bucket;
+
+                const size_t begin = m_bucket_offsets[bucket];
+                const size_t end = m_bucket_offsets[bucket + 1];
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const foundation::Vector3f& position = m_positions[i];
+                    const float square_dist = foundation::square_norm(position - point);
+
+                    if (square_dist < m_square_lookup_radius)
+                        visitor.visit(m_indices[i], position, square_dist);
+                }
+            }
+        }
+    }
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMPHOTONGRID_H
@@ -47,7 +47,9 @@ using namespace foundation;
 namespace renderer
 {
 
-SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
+SPPMPhotonMap::SPPMPhotonMap(
+    SPPMPhotonVector&   photons,
+    JobQueue&           job_queue)
 {
     const size_t photon_count = photons.size();
 
@@ -59,7 +61,7 @@ SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
             photon_count > 1 ? "photons" : "photon");
 
         knn::Builder3f builder(*this);
-        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions);
+        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions, job_queue);
 
         Statistics statistics;
         statistics.insert_time("build time", builder.get_build_time());
@@ -37,7 +37,8 @@
 #include <cstddef>
 
 // Forward declarations.
-namespace renderer  { class SPPMPhotonVector; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class SPPMPhotonVector; }
 
 namespace renderer
 {
@@ -47,7 +48,10 @@ class SPPMPhotonMap
 {
   public:
     // Constructor, *moves* the photon positions into the map.
-    explicit SPPMPhotonMap(SPPMPhotonVector& photons);
+    // The map is built in parallel using a given job queue.
+    SPPMPhotonMap(
+        SPPMPhotonVector&       photons,
+        foundation::JobQueue&   job_queue);
 
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
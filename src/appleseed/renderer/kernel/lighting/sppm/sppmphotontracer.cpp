@@ -584,6 +584,8 @@ SPPMPhotonTracer::SPPMPhotonTracer(
   , m_texture_store(texture_store)
   , m_total_emitted_photon_count(0)
   , m_total_stored_photon_count(0)
+  , m_job_count(0)
+  , m_emitted_photon_count(0)
 #ifdef WITH_OSL
   , m_shading_system(shading_system)
 #endif
@@ -596,14 +598,44 @@ size_t SPPMPhotonTracer::trace_photons(
     JobQueue&               job_queue,
     AbortSwitch&            abort_switch)
 {
-    size_t job_count = 0;
-    size_t emitted_photon_count = 0;
+    const size_t emitted_photon_count =
+        begin_photon_tracing(photons, pass_hash, job_queue, abort_switch);
 
-    // Start stopwatch.
-    Stopwatch<DefaultWallclockTimer> stopwatch;
-    stopwatch.start();
+    // Wait until the photon tracing jobs have completed.
+    job_queue.wait_until_completion();
 
-    if (m_light_sampler.has_lights_or_emitting_triangles())
+    end_photon_tracing(photons);
+
+    return emitted_photon_count;
+}
+
+size_t SPPMPhotonTracer::begin_photon_tracing(
+    SPPMPhotonVector&       photons,
+    const size_t            pass_hash,
+    JobQueue&               job_queue,
+    AbortSwitch&            abort_switch)
+{
+    m_job_count = 0;
+    m_emitted_photon_count = 0;
+
+    // Start stopwatch.
+    m_stopwatch.start();
+
+    // Make room for the photons, based on the ratio of stored to emitted photons in previous passes.
+    const bool trace_light_photons = m_light_sampler.has_lights_or_emitting_triangles();
+    const bool trace_env_photons =
+        m_params.m_enable_ibl &&
+        m_scene.get_environment()->get_environment_edf() != 0;
+    const size_t planned_photon_count =
+        (trace_light_photons ? m_params.m_light_photon_count : 0) +
+        (trace_env_photons ? m_params.m_env_photon_count : 0);
+    const double stored_photon_ratio =
+        m_total_emitted_photon_count > 0
+            ? 1.1 * m_total_stored_photon_count / m_total_emitted_photon_count
+            : 1.0;
+    photons.begin_collection(static_cast<size_t>(planned_photon_count * stored_photon_ratio));
+
+    if (trace_light_photons)
     {
         RENDERER_LOG_INFO(
             "tracing %s sppm light %s...",
@@ -631,14 +663,12 @@ size_t SPPMPhotonTracer::trace_photons(
 #endif
                     abort_switch));
 
-            ++job_count;
-            emitted_photon_count += photon_end - photon_begin;
+            ++m_job_count;
+            m_emitted_photon_count += photon_end - photon_begin;
         }
     }
 
-    if (m_params.m_enable_ibl &&
-        m_scene.get_environment()->get_environment_edf() &&
-        !abort_switch.is_aborted())
+    if (trace_env_photons && !abort_switch.is_aborted())
     {
         RENDERER_LOG_INFO(
             "tracing %s sppm environment %s...",
@@ -666,22 +696,26 @@ size_t SPPMPhotonTracer::trace_photons(
 #endif
                     abort_switch));
 
-            ++job_count;
-            emitted_photon_count += photon_end - photon_begin;
+            ++m_job_count;
+            m_emitted_photon_count += photon_end - photon_begin;
         }
     }
 
-    // Wait until the photon tracing jobs have completed.
-    job_queue.wait_until_completion();
+    return m_emitted_photon_count;
+}
+
+void SPPMPhotonTracer::end_photon_tracing(SPPMPhotonVector& photons)
+{
+    photons.end_collection();
 
     // Update photon tracing statistics.
-    m_total_emitted_photon_count += emitted_photon_count;
+    m_total_emitted_photon_count += m_emitted_photon_count;
     m_total_stored_photon_count += photons.size();
 
     // Print photon tracing statistics.
     Statistics statistics;
-    statistics.insert("tracing jobs", job_count);
-    statistics.insert_time("tracing time", stopwatch.measure().get_seconds());
+    statistics.insert("tracing jobs", m_job_count);
+    statistics.insert_time("tracing time", m_stopwatch.measure().get_seconds());
     statistics.insert("total emitted", m_total_emitted_photon_count);
     statistics.insert(
         "total stored",
@@ -692,8 +726,6 @@ size_t SPPMPhotonTracer::trace_photons(
         StatisticsVector::make(
             "sppm photon tracing statistics",
             statistics).to_string().c_str());
-
-    return emitted_photon_count;
 }
 
 }   // namespace renderer
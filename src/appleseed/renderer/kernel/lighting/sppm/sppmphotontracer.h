@@ -35,6 +35,8 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/timer.h"
+#include "foundation/utility/stopwatch.h"
 
 // OSL headers.
 #ifdef WITH_OSL
@@ -77,6 +79,17 @@ class SPPMPhotonTracer
         foundation::JobQueue&       job_queue,
         foundation::AbortSwitch&    abort_switch);
 
+    // Schedule photon tracing jobs without waiting for their completion, such that they
+    // can run concurrently with other jobs. Returns the total number of emitted photons.
+    size_t begin_photon_tracing(
+        SPPMPhotonVector&           photons,
+        const size_t                pass_hash,
+        foundation::JobQueue&       job_queue,
+        foundation::AbortSwitch&    abort_switch);
+
+    // Finish photon tracing once the jobs scheduled by begin_photon_tracing() have completed.
+    void end_photon_tracing(SPPMPhotonVector& photons);
+
   private:
     const SPPMParameters            m_params;
     const Scene&                    m_scene;
@@ -85,6 +98,10 @@ class SPPMPhotonTracer
     TextureStore&                   m_texture_store;
     size_t                          m_total_emitted_photon_count;
     size_t                          m_total_stored_photon_count;
+    size_t                          m_job_count;                // number of jobs of the ongoing photon tracing
+    size_t                          m_emitted_photon_count;     // number of photons of the ongoing photon tracing
+    foundation::Stopwatch<foundation::DefaultWallclockTimer>
+                                    m_stopwatch;
 #ifdef WITH_OSL
     OSL::ShadingSystem&             m_shading_system;
 #endif
@@ -34,7 +34,6 @@
 #include "renderer/global/globallogger.h"
 #ifdef WITH_OSL
 #include "renderer/kernel/shading/oslshadergroupexec.h"
-#include "renderer/modeling/shadergroup/shadergroup.h"
 #endif
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/material/material.h"
@@ -45,6 +44,8 @@
 #include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/hash.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/string.h"
 #include "foundation/utility/uid.h"
@@ -66,18 +67,8 @@ namespace
     {
         for (size_t i = 0; i < materials.size(); ++i)
         {
-            if (materials[i])
-            {
-                if (materials[i]->has_alpha_map())
-                    return true;
-#ifdef WITH_OSL
-                if (const ShaderGroup* sg = materials[i]->get_osl_surface())
-                {
-                    if (sg->has_transparency())
-                        return true;
-                }
-#endif
-            }
+            if (materials[i] && materials[i]->uses_alpha_mapping())
+                return true;
         }
 
         return false;
@@ -145,14 +136,85 @@ Tracer::Tracer(
   , m_transmission_threshold(static_cast<double>(transparency_threshold))
   , m_max_iterations(max_iterations)
 {
+    for (size_t i = 0; i < OccluderCacheSize; ++i)
+        m_occluder_cache[i].m_key = 0;
+
     if (print_details)
     {
         if (m_assume_no_alpha_mapping)
             RENDERER_LOG_DEBUG("the scene does not rely on alpha mapping; using probe tracing.");
-        else RENDERER_LOG_DEBUG("the scene uses alpha mapping; using standard tracing.");
+        else RENDERER_LOG_DEBUG("the scene uses alpha mapping; using alpha-aware probe tracing and standard tracing.");
     }
 }
 
+Tracer::CachedOccluder& Tracer::get_cached_occluder(const void* key)
+{
+    const uint64 hash = hash_uint64(static_cast<uint64>(reinterpret_cast<uintptr_t>(key)));
+    return m_occluder_cache[hash % OccluderCacheSize];
+}
+
+bool Tracer::hit_cached_occluder(
+    const ShadingRay&           ray,
+    const ShadingPoint*         parent_shading_point,
+    const void*                 occluder_key)
+{
+    if (occluder_key == 0)
+        return false;
+
+    const CachedOccluder& cached = get_cached_occluder(occluder_key);
+    if (cached.m_key != occluder_key)
+        return false;
+
+    const ProbeOccluder& occluder = cached.m_occluder;
+
+    // Never let a surface occlude itself.
+    if (parent_shading_point &&
+        &parent_shading_point->get_assembly_instance() == occluder.m_assembly_instance &&
+        parent_shading_point->get_object_instance_index() == occluder.m_object_instance_index &&
+        parent_shading_point->get_region_index() == occluder.m_region_index &&
+        parent_shading_point->get_triangle_index() == occluder.m_triangle_index)
+        return false;
+
+    return occluder.m_triangle.intersect(ray);
+}
+
+void Tracer::cache_occluder(
+    const void*                 occluder_key,
+    const ProbeOccluder&        occluder)
+{
+    // Only static occluders are reported, and only those can be reused.
+    if (occluder_key == 0 || occluder.m_assembly_instance == 0)
+        return;
+
+    CachedOccluder& cached = get_cached_occluder(occluder_key);
+    cached.m_key = occluder_key;
+    cached.m_occluder = occluder;
+}
+
+Intersector::ProbeResult Tracer::trace_probe(
+    const ShadingRay&           ray,
+    const ShadingPoint*         parent_shading_point,
+    const void*                 occluder_key)
+{
+    // Test the occluder that blocked the last ray with the same key.
+    if (hit_cached_occluder(ray, parent_shading_point, occluder_key))
+        return Intersector::ProbeOpaqueHit;
+
+    // Trace a single probe ray, letting it pass through alpha-mapped surfaces.
+    ProbeOccluder occluder;
+    const Intersector::ProbeResult result =
+        m_intersector.trace_probe(
+            ray,
+            !m_assume_no_alpha_mapping,
+            occluder_key ? &occluder : 0,
+            parent_shading_point);
+
+    if (result == Intersector::ProbeOpaqueHit)
+        cache_occluder(occluder_key, occluder);
+
+    return result;
+}
+
 const ShadingPoint& Tracer::do_trace(
     const Vector3d&             origin,
     const Vector3d&             direction,
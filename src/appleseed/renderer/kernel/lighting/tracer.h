@@ -59,6 +59,13 @@ namespace renderer
 // point-to-point visibility. It automatically takes into account alpha
 // transparency.
 //
+// Transmission-only queries first trace a single alpha-aware probe ray and only
+// fall back to the (more expensive) closest-hit loop when the ray crosses
+// alpha-mapped surfaces. Point-to-point queries may be given a key (typically
+// identifying a light): the last opaque occluder found for this key is tested
+// before tracing, since consecutive shadow rays toward the same light from
+// nearby points are often blocked by the same triangle.
+//
 
 class Tracer
   : public foundation::NonCopyable
@@ -126,7 +133,8 @@ class Tracer
 
     // Compute the transmission between two points. This variant may take
     // advantage of the fact that the intersection with the closest occluder
-    // is not required to deliver higher performances.
+    // is not required to deliver higher performances. 'occluder_key' is an
+    // optional key into the occluder cache.
     double trace_between(
         const foundation::Vector3d&     origin,
         const foundation::Vector3d&     target,
@@ -136,7 +144,8 @@ class Tracer
     double trace_between(
         const ShadingPoint&             origin,
         const foundation::Vector3d&     target,
-        const ShadingRay::Type          ray_type);
+        const ShadingRay::Type          ray_type,
+        const void*                     occluder_key = 0);
 
   private:
     const Intersector&                  m_intersector;
@@ -152,6 +161,35 @@ class Tracer
     const size_t                        m_max_iterations;
     ShadingPoint                        m_shading_points[2];
 
+    // Direct-mapped cache of the last opaque occluder found for a given key.
+    struct CachedOccluder
+    {
+        const void*                     m_key;
+        ProbeOccluder                   m_occluder;
+    };
+
+    enum { OccluderCacheSize = 8 };
+    CachedOccluder                      m_occluder_cache[OccluderCacheSize];
+
+    CachedOccluder& get_cached_occluder(const void* key);
+
+    // Return true if the ray is blocked by the occluder cached for a given key.
+    bool hit_cached_occluder(
+        const ShadingRay&               ray,
+        const ShadingPoint*             parent_shading_point,
+        const void*                     occluder_key);
+
+    // Cache the occluder found for a given key, if any.
+    void cache_occluder(
+        const void*                     occluder_key,
+        const ProbeOccluder&            occluder);
+
+    // Trace an alpha-aware probe ray, testing the cached occluder first.
+    Intersector::ProbeResult trace_probe(
+        const ShadingRay&               ray,
+        const ShadingPoint*             parent_shading_point,
+        const void*                     occluder_key = 0);
+
     const ShadingPoint& do_trace(
         const foundation::Vector3d&     origin,
         const foundation::Vector3d&     direction,
@@ -219,31 +257,29 @@ inline double Tracer::trace(
     const ShadingRay::Type              ray_type,
     const ShadingRay::DepthType         ray_depth)
 {
-    if (m_assume_no_alpha_mapping)
-    {
-        const ShadingRay ray(
+    const ShadingRay ray(
+        origin,
+        direction,
+        time,
+        ray_type,
+        ray_depth);
+
+    const Intersector::ProbeResult result = trace_probe(ray, 0);
+    if (result != Intersector::ProbeAlphaHit)
+        return result == Intersector::ProbeMiss ? 1.0 : 0.0;
+
+    // The ray crosses alpha-mapped surfaces: compute the actual transmission.
+    double transmission;
+    const ShadingPoint& shading_point =
+        trace(
             origin,
             direction,
             time,
             ray_type,
-            ray_depth);
+            ray_depth,
+            transmission);
 
-        return m_intersector.trace_probe(ray) ? 0.0 : 1.0;
-    }
-    else
-    {
-        double transmission;
-        const ShadingPoint& shading_point =
-            trace(
-                origin,
-                direction,
-                time,
-                ray_type,
-                ray_depth,
-                transmission);
-
-        return shading_point.hit() ? 0.0 : transmission;
-    }
+    return shading_point.hit() ? 0.0 : transmission;
 }
 
 inline double Tracer::trace(
@@ -251,29 +287,27 @@ inline double Tracer::trace(
     const foundation::Vector3d&         direction,
     const ShadingRay::Type              type)
 {
-    if (m_assume_no_alpha_mapping)
-    {
-        const ShadingRay ray(
-            origin.get_biased_point(direction),
+    const ShadingRay ray(
+        origin.get_biased_point(direction),
+        direction,
+        origin.get_time(),
+        type,
+        origin.get_ray().m_depth + 1);
+
+    const Intersector::ProbeResult result = trace_probe(ray, &origin);
+    if (result != Intersector::ProbeAlphaHit)
+        return result == Intersector::ProbeMiss ? 1.0 : 0.0;
+
+    // The ray crosses alpha-mapped surfaces: compute the actual transmission.
+    double transmission;
+    const ShadingPoint& shading_point =
+        trace(
+            origin,
             direction,
-            origin.get_time(),
             type,
-            origin.get_ray().m_depth + 1);
+            transmission);
 
-        return m_intersector.trace_probe(ray, &origin) ? 0.0 : 1.0;
-    }
-    else
-    {
-        double transmission;
-        const ShadingPoint& shading_point =
-            trace(
-                origin,
-                direction,
-                type,
-                transmission);
-
-        return shading_point.hit() ? 0.0 : transmission;
-    }
+    return shading_point.hit() ? 0.0 : transmission;
 }
 
 inline const ShadingPoint& Tracer::trace_between(
@@ -319,67 +353,64 @@ inline double Tracer::trace_between(
     const ShadingRay::Type              ray_type,
     const ShadingRay::DepthType         ray_depth)
 {
-    if (m_assume_no_alpha_mapping)
-    {
-        const ShadingRay ray(
+    const ShadingRay ray(
+        origin,
+        target - origin,
+        0.0,                            // ray tmin
+        1.0 - 1.0e-6,                   // ray tmax
+        time,
+        ray_type,
+        ray_depth);
+
+    const Intersector::ProbeResult result = trace_probe(ray, 0);
+    if (result != Intersector::ProbeAlphaHit)
+        return result == Intersector::ProbeMiss ? 1.0 : 0.0;
+
+    // The ray crosses alpha-mapped surfaces: compute the actual transmission.
+    double transmission;
+    const ShadingPoint& shading_point =
+        trace_between(
             origin,
-            target - origin,
-            0.0,                        // ray tmin
-            1.0 - 1.0e-6,               // ray tmax
+            target,
             time,
             ray_type,
-            ray_depth);
+            ray_depth,
+            transmission);
 
-        return m_intersector.trace_probe(ray) ? 0.0 : 1.0;
-    }
-    else
-    {
-        double transmission;
-        const ShadingPoint& shading_point =
-            trace_between(
-                origin,
-                target,
-                time,
-                ray_type,
-                ray_depth,
-                transmission);
-
-        return shading_point.hit() ? 0.0 : transmission;
-    }
+    return shading_point.hit() ? 0.0 : transmission;
 }
 
 inline double Tracer::trace_between(
     const ShadingPoint&                 origin,
     const foundation::Vector3d&         target,
-    const ShadingRay::Type              type)
+    const ShadingRay::Type              type,
+    const void*                         occluder_key)
 {
-    if (m_assume_no_alpha_mapping)
-    {
-        const foundation::Vector3d direction = target - origin.get_point();
-
-        const ShadingRay ray(
-            origin.get_biased_point(direction),
-            direction,
-            0.0,                        // ray tmin
-            1.0 - 1.0e-6,               // ray tmax
-            origin.get_time(),
+    const foundation::Vector3d direction = target - origin.get_point();
+
+    const ShadingRay ray(
+        origin.get_biased_point(direction),
+        direction,
+        0.0,                            // ray tmin
+        1.0 - 1.0e-6,                   // ray tmax
+        origin.get_time(),
+        type,
+        origin.get_ray().m_depth + 1);
+
+    const Intersector::ProbeResult result = trace_probe(ray, &origin, occluder_key);
+    if (result != Intersector::ProbeAlphaHit)
+        return result == Intersector::ProbeMiss ? 1.0 : 0.0;
+
+    // The ray crosses alpha-mapped surfaces: compute the actual transmission.
+    double transmission;
+    const ShadingPoint& shading_point =
+        trace_between(
+            origin,
+            target,
             type,
-            origin.get_ray().m_depth + 1);
+            transmission);
 
-        return m_intersector.trace_probe(ray, &origin) ? 0.0 : 1.0;
-    }
-    else
-    {
-        double transmission;
-        const ShadingPoint& shading_point =
-            trace_between(
-                origin,
-                target,
-                type,
-                transmission);
-
-        return shading_point.hit() ? 0.0 : transmission;
-    }
+    return shading_point.hit() ? 0.0 : transmission;
 }
 
 }       // namespace renderer
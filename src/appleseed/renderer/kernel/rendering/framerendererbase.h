@@ -49,10 +49,11 @@ namespace renderer
 class FrameRendererBase
   : public IFrameRenderer
 {
-  protected:
+  public:
     // Extract the number of rendering threads from the "rendering_threads" parameter.
     static size_t get_rendering_thread_count(const ParamArray& params);
 
+  protected:
     // Output the number of rendering threads to the log.
     static void print_rendering_thread_count(const size_t thread_count);
 };
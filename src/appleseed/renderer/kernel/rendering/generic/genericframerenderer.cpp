@@ -298,7 +298,12 @@ namespace
                     for (const_each<TileJobFactory::TileJobVector> i = tile_jobs; i; ++i)
                         m_job_queue.schedule(*i);
 
-                    // Wait until tile jobs have effectively stopped.
+                    // Let the pass callback prepare the next pass. Its jobs are scheduled after
+                    // tile jobs and keep worker threads busy once they run out of tiles to render.
+                    if (m_pass_callback && pass + 1 < m_pass_count)
+                        m_pass_callback->prepare_next_pass(m_frame, m_job_queue, m_abort_switch);
+
+                    // Wait until tile jobs (and jobs preparing the next pass) have effectively stopped.
                     m_job_queue.wait_until_completion();
 
                     // Invoke the post-pass callback if there is one.
@@ -103,6 +103,7 @@ namespace
             const bool              primary)
           : m_params(params)
           , m_scene(scene)
+          , m_frame(frame)
           , m_lighting_conditions(frame.get_lighting_conditions())
           , m_opacity_threshold(1.0f - m_params.m_transparency_threshold)
           , m_texture_cache(texture_store)
@@ -160,8 +161,9 @@ namespace
 
             // Construct a primary ray.
             ShadingRay primary_ray;
-            m_scene.get_camera()->generate_ray(
+            m_scene.get_camera()->generate_ray_differential(
                 sampling_context,
+                m_frame,
                 image_point,
                 primary_ray);
 
@@ -294,6 +296,7 @@ namespace
 
         const Parameters            m_params;
         const Scene&                m_scene;
+        const Frame&                m_frame;
         const LightingConditions&   m_lighting_conditions;
         const float                 m_opacity_threshold;
 
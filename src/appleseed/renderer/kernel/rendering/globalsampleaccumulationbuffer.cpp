@@ -42,6 +42,10 @@
 #include "foundation/image/tile.h"
 #include "foundation/platform/thread.h"
 
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
 using namespace foundation;
 using namespace std;
 
@@ -52,7 +56,8 @@ GlobalSampleAccumulationBuffer::GlobalSampleAccumulationBuffer(
     const size_t    width,
     const size_t    height,
     const Filter2d& filter)
-  : m_fb(width, height, 3, filter)
+  : SampleAccumulationBuffer(width, height, filter)
+  , m_fb(width, height, 3, filter)
   , m_filter_rcp_norm_factor(static_cast<float>(1.0 / compute_normalization_factor(filter)))
 {
 }
@@ -63,15 +68,17 @@ void GlobalSampleAccumulationBuffer::clear()
 
     SampleAccumulationBuffer::clear_no_lock();
 
+    lock_all_stripes();
     m_fb.clear();
+    unlock_all_stripes();
 }
 
 void GlobalSampleAccumulationBuffer::store_samples(
     const size_t    sample_count,
     const Sample    samples[])
 {
-    boost::mutex::scoped_lock lock(m_mutex);
-
+    // Only lock the stripes touched by each sample, so that concurrent
+    // producers and develop_to_frame() rarely contend for the same rows.
     const double fw = static_cast<double>(m_fb.get_width());
     const double fh = static_cast<double>(m_fb.get_height());
     const Sample* sample_end = samples + sample_count;
@@ -84,14 +91,13 @@ void GlobalSampleAccumulationBuffer::store_samples(
         Color3f value = sample_ptr->m_color.rgb();
         value *= m_filter_rcp_norm_factor;
 
+        StripeLock lock(*this, fy);
         m_fb.add(fx, fy, &value[0]);
     }
 }
 
 void GlobalSampleAccumulationBuffer::develop_to_frame(Frame& frame)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
-
     Image& image = frame.image();
     const CanvasProperties& frame_props = image.properties();
 
@@ -99,18 +105,47 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(Frame& frame)
     assert(frame_props.m_canvas_height == m_fb.get_height());
     assert(frame_props.m_channel_count == 4);
 
-    const float scale = 1.0f / m_sample_count;
+    uint64 sample_count;
 
-    for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
     {
-        for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
-        {
-            Tile& tile = image.tile(tx, ty);
+        boost::mutex::scoped_lock lock(m_mutex);
+        sample_count = m_sample_count;
+    }
+
+    const float scale = 1.0f / sample_count;
 
-            const size_t x = tx * frame_props.m_tile_width;
+    // Develop the buffer one stripe at a time, such that producers
+    // are only blocked while the stripe they write to is being read.
+    const size_t stripe_height = get_stripe_height();
+    const size_t stripe_count = get_stripe_count();
+
+    for (size_t stripe = 0; stripe < stripe_count; ++stripe)
+    {
+        const size_t stripe_begin = stripe * stripe_height;
+        const size_t stripe_end = min(stripe_begin + stripe_height, frame_props.m_canvas_height);
+
+        SingleStripeLock lock(*this, stripe);
+
+        const size_t ty_begin = stripe_begin / frame_props.m_tile_height;
+        const size_t ty_end = (stripe_end - 1) / frame_props.m_tile_height + 1;
+
+        for (size_t ty = ty_begin; ty < ty_end; ++ty)
+        {
             const size_t y = ty * frame_props.m_tile_height;
 
-            develop_to_tile(tile, x, y, tx, ty, scale);
+            for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
+            {
+                Tile& tile = image.tile(tx, ty);
+
+                const size_t x = tx * frame_props.m_tile_width;
+
+                develop_to_tile(
+                    tile,
+                    x, y,
+                    max(stripe_begin, y) - y,
+                    min(stripe_end, y + tile.get_height()) - y,
+                    scale);
+            }
         }
     }
 }
@@ -126,14 +161,13 @@ void GlobalSampleAccumulationBuffer::develop_to_tile(
     Tile&           tile,
     const size_t    origin_x,
     const size_t    origin_y,
-    const size_t    tile_x,
-    const size_t    tile_y,
+    const size_t    row_begin,
+    const size_t    row_end,
     const float     scale) const
 {
     const size_t tile_width = tile.get_width();
-    const size_t tile_height = tile.get_height();
 
-    for (size_t y = 0; y < tile_height; ++y)
+    for (size_t y = row_begin; y < row_end; ++y)
     {
         for (size_t x = 0; x < tile_width; ++x)
         {
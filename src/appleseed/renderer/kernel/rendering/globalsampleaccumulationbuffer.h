@@ -82,8 +82,8 @@ class GlobalSampleAccumulationBuffer
         foundation::Tile&           tile,
         const size_t                origin_x,
         const size_t                origin_y,
-        const size_t                tile_x,
-        const size_t                tile_y,
+        const size_t                row_begin,
+        const size_t                row_end,
         const float                 scale) const;
 };
 
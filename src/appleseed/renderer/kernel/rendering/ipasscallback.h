@@ -60,6 +60,14 @@ class DLLSYMBOL IPassCallback
         foundation::JobQueue&       job_queue,
         foundation::AbortSwitch&    abort_switch) = 0;
 
+    // This method is called once the jobs of a pass have been scheduled, except for the
+    // last pass. Jobs scheduled by this method run concurrently with the jobs of the pass,
+    // e.g. to prepare the next pass, and are completed before post_render() is called.
+    virtual void prepare_next_pass(
+        const Frame&                frame,
+        foundation::JobQueue&       job_queue,
+        foundation::AbortSwitch&    abort_switch) = 0;
+
     // This method is called at the end of a pass.
     virtual void post_render(
         const Frame&                frame,
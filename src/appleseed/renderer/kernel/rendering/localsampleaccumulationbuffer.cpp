@@ -72,11 +72,18 @@ namespace renderer
 //   pushing samples to and the level that is displayed.  As soon as a level contains enough
 //   samples, it becomes the new active level.
 //
+//   Once the highest resolution level is active, samples are only stored into that level,
+//   under the stripe locks of the base class rather than under the buffer-wide mutex, and
+//   the frame is developed one stripe at a time so as not to stall the sample producers.
+//   Only the tiles overlapping cells that received samples since the last development
+//   are developed again.
+//
 
 LocalSampleAccumulationBuffer::LocalSampleAccumulationBuffer(
     const size_t    width,
     const size_t    height,
     const Filter2d& filter)
+  : SampleAccumulationBuffer(width, height, filter)
 {
     const size_t MinSize = 32;
 
@@ -103,6 +110,9 @@ LocalSampleAccumulationBuffer::LocalSampleAccumulationBuffer(
         if (level_height > MinSize)
             level_height = max(level_height / 2, MinSize);
     }
+
+    m_active_level = m_levels.size() - 1;
+    m_full_resolution = m_active_level == 0 ? 1 : 0;
 }
 
 LocalSampleAccumulationBuffer::~LocalSampleAccumulationBuffer()
@@ -117,6 +127,8 @@ void LocalSampleAccumulationBuffer::clear()
 
     SampleAccumulationBuffer::clear_no_lock();
 
+    lock_all_stripes();
+
     for (size_t level_index = 0; level_index < m_levels.size(); ++level_index)
     {
         m_levels[level_index]->clear();
@@ -124,57 +136,68 @@ void LocalSampleAccumulationBuffer::clear()
     }
 
     m_active_level = m_levels.size() - 1;
+    boost_atomic::atomic_write32(&m_full_resolution, m_active_level == 0 ? 1 : 0);
+
+    set_all_dirty();
+    unlock_all_stripes();
 }
 
 void LocalSampleAccumulationBuffer::store_samples(
     const size_t    sample_count,
     const Sample    samples[])
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    if (boost_atomic::atomic_read32(&m_full_resolution))
+    {
+        store_samples_full_resolution(sample_count, samples);
+        return;
+    }
 
-    const Sample* sample_end = samples + sample_count;
+    boost::mutex::scoped_lock lock(m_mutex);
 
     if (m_active_level == 0)
     {
-        FilteredTile* level = m_levels[0];
-
-        const double level_width = static_cast<double>(level->get_width());
-        const double level_height = static_cast<double>(level->get_height());
+        // Another thread completed the highest resolution level while we were waiting.
+        lock.unlock();
+        store_samples_full_resolution(sample_count, samples);
+        return;
+    }
 
-        for (const Sample* sample_ptr = samples; sample_ptr < sample_end; ++sample_ptr)
-        {
-            const double fx = sample_ptr->m_position.x * level_width;
-            const double fy = sample_ptr->m_position.y * level_height;
+    const Sample* sample_end = samples + sample_count;
 
-            level->add(fx, fy, &sample_ptr->m_color[0]);
-        }
-    }
-    else
+    for (const Sample* sample_ptr = samples; sample_ptr < sample_end; ++sample_ptr)
     {
-        for (const Sample* sample_ptr = samples; sample_ptr < sample_end; ++sample_ptr)
+        for (size_t level_index = 0; level_index <= m_active_level; ++level_index)
         {
-            for (size_t level_index = 0; level_index <= m_active_level; ++level_index)
-            {
-                FilteredTile* level = m_levels[level_index];
+            FilteredTile* level = m_levels[level_index];
 
-                const double fx = sample_ptr->m_position.x * level->get_width();
-                const double fy = sample_ptr->m_position.y * level->get_height();
+            const double fx = sample_ptr->m_position.x * level->get_width();
+            const double fy = sample_ptr->m_position.y * level->get_height();
 
+            if (level_index == 0)
+            {
+                // The highest resolution level may be concurrently written to
+                // by threads that observed it as the active level.
+                StripeLock stripe_lock(*this, fy);
                 level->add(fx, fy, &sample_ptr->m_color[0]);
+                stripe_lock.set_dirty(fx);
+            }
+            else level->add(fx, fy, &sample_ptr->m_color[0]);
 
-                size_t& remaining_pixels = m_remaining_pixels[level_index];
+            size_t& remaining_pixels = m_remaining_pixels[level_index];
 
-                if (remaining_pixels > 0)
-                    --remaining_pixels;
+            if (remaining_pixels > 0)
+                --remaining_pixels;
 
-                if (remaining_pixels == 0)
-                {
-                    // We just completed this level: make it the new active level.
-                    m_active_level = level_index;
+            if (remaining_pixels == 0)
+            {
+                // We just completed this level: make it the new active level.
+                m_active_level = level_index;
 
-                    // No need to fill the coarser levels anymore.
-                    break;
-                }
+                if (level_index == 0)
+                    boost_atomic::atomic_write32(&m_full_resolution, 1);
+
+                // No need to fill the coarser levels anymore.
+                break;
             }
         }
     }
@@ -182,6 +205,30 @@ void LocalSampleAccumulationBuffer::store_samples(
     m_sample_count += sample_count;
 }
 
+void LocalSampleAccumulationBuffer::store_samples_full_resolution(
+    const size_t    sample_count,
+    const Sample    samples[])
+{
+    FilteredTile* level = m_levels[0];
+
+    const double level_width = static_cast<double>(level->get_width());
+    const double level_height = static_cast<double>(level->get_height());
+    const Sample* sample_end = samples + sample_count;
+
+    for (const Sample* sample_ptr = samples; sample_ptr < sample_end; ++sample_ptr)
+    {
+        const double fx = sample_ptr->m_position.x * level_width;
+        const double fy = sample_ptr->m_position.y * level_height;
+
+        StripeLock lock(*this, fy);
+        level->add(fx, fy, &sample_ptr->m_color[0]);
+        lock.set_dirty(fx);
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_sample_count += sample_count;
+}
+
 namespace
 {
     void develop_to_tile(
@@ -191,15 +238,16 @@ namespace
         const FilteredTile&     level,
         const size_t            origin_x,
         const size_t            origin_y,
+        const size_t            row_begin,
+        const size_t            row_end,
         const AABB2u&           crop_window,
         const bool              undo_premultiplied_alpha)
     {
         const size_t tile_width = tile.get_width();
-        const size_t tile_height = tile.get_height();
         const size_t level_width = level.get_width();
         const size_t level_height = level.get_height();
 
-        for (size_t y = 0; y < tile_height; ++y)
+        for (size_t y = row_begin; y < row_end; ++y)
         {
             for (size_t x = 0; x < tile_width; ++x)
             {
@@ -250,24 +298,83 @@ void LocalSampleAccumulationBuffer::develop_to_frame(Frame& frame)
 
     const FilteredTile& level = find_display_level();
 
-    for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
+    if (&level != m_levels[0])
     {
-        for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
+        // Coarser levels are only written to while holding the buffer-wide mutex.
+        for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
         {
-            Tile& tile = image.tile(tx, ty);
+            for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
+            {
+                Tile& tile = image.tile(tx, ty);
+
+                const size_t origin_x = tx * frame_props.m_tile_width;
+                const size_t origin_y = ty * frame_props.m_tile_height;
+
+                develop_to_tile(
+                    tile,
+                    frame_props.m_canvas_width,
+                    frame_props.m_canvas_height,
+                    level,
+                    origin_x, origin_y,
+                    0, tile.get_height(),
+                    crop_window,
+                    undo_premultiplied_alpha);
+            }
+        }
 
-            const size_t origin_x = tx * frame_props.m_tile_width;
+        // The whole frame will have to be developed again once the highest resolution level is displayed.
+        lock_all_stripes();
+        set_all_dirty();
+        unlock_all_stripes();
+
+        return;
+    }
+
+    // The highest resolution level is displayed: release the buffer-wide mutex
+    // and develop the dirty tiles of the frame one stripe at a time.
+    lock.unlock();
+
+    const size_t stripe_height = get_stripe_height();
+    const size_t stripe_count = get_stripe_count();
+
+    for (size_t stripe = 0; stripe < stripe_count; ++stripe)
+    {
+        const size_t stripe_begin = stripe * stripe_height;
+        const size_t stripe_end = min(stripe_begin + stripe_height, frame_props.m_canvas_height);
+
+        SingleStripeLock stripe_lock(*this, stripe);
+
+        const size_t ty_begin = stripe_begin / frame_props.m_tile_height;
+        const size_t ty_end = (stripe_end - 1) / frame_props.m_tile_height + 1;
+
+        for (size_t ty = ty_begin; ty < ty_end; ++ty)
+        {
             const size_t origin_y = ty * frame_props.m_tile_height;
 
-            develop_to_tile(
-                tile,
-                frame_props.m_canvas_width,
-                frame_props.m_canvas_height,
-                level,
-                origin_x, origin_y,
-                crop_window,
-                undo_premultiplied_alpha);
+            for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
+            {
+                Tile& tile = image.tile(tx, ty);
+
+                const size_t origin_x = tx * frame_props.m_tile_width;
+
+                // Skip tiles that did not receive samples since they were last developed.
+                if (!is_dirty(stripe, origin_x, origin_x + tile.get_width()))
+                    continue;
+
+                develop_to_tile(
+                    tile,
+                    frame_props.m_canvas_width,
+                    frame_props.m_canvas_height,
+                    level,
+                    origin_x, origin_y,
+                    max(stripe_begin, origin_y) - origin_y,
+                    min(stripe_end, origin_y + tile.get_height()) - origin_y,
+                    crop_window,
+                    undo_premultiplied_alpha);
+            }
         }
+
+        clear_dirty(stripe);
     }
 }
 
@@ -36,6 +36,7 @@
 // appleseed.foundation headers.
 #include "foundation/math/filter.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
 
 // Standard headers.
 #include <cstddef>
@@ -77,9 +78,15 @@ class LocalSampleAccumulationBuffer
     std::vector<foundation::FilteredTile*>  m_levels;
     std::vector<size_t>                     m_remaining_pixels;
     size_t                                  m_active_level;
+    volatile boost::uint32_t                m_full_resolution;  // 1 once the highest resolution level is active
 
     // Find the first (the highest resolution) level that has all its pixels set.
     const foundation::FilteredTile& find_display_level() const;
+
+    // Store samples into the highest resolution level only, under stripe locks.
+    void store_samples_full_resolution(
+        const size_t                        sample_count,
+        const Sample                        samples[]);
 };
 
 }       // namespace renderer
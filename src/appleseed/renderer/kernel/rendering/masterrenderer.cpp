@@ -30,6 +30,7 @@
 #include "masterrenderer.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/lighting/drt/drtlightingengine.h"
 #include "renderer/kernel/lighting/lighttracing/lighttracingsamplegenerator.h"
 #include "renderer/kernel/lighting/pt/ptlightingengine.h"
@@ -50,6 +51,7 @@
 #include "renderer/kernel/rendering/generic/generictilerenderer.h"
 #include "renderer/kernel/rendering/progressive/progressiveframerenderer.h"
 #include "renderer/kernel/rendering/ephemeralshadingresultframebufferfactory.h"
+#include "renderer/kernel/rendering/framerendererbase.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
 #include "renderer/kernel/rendering/ipixelrenderer.h"
@@ -64,10 +66,19 @@
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingengine.h"
 #include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/edf/edf.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/input/inputbinder.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/object/object.h"
 #include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/texture/texture.h"
 #ifdef WITH_OSL
 #include "renderer/kernel/rendering/oiioerrorhandler.h"
 #include "renderer/kernel/rendering/rendererservices.h"
@@ -77,6 +88,7 @@
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/thread.h"
+#include "foundation/utility/foreach.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/searchpaths.h"
 
@@ -88,6 +100,8 @@
 // Standard headers.
 #include <deque>
 #include <exception>
+#include <utility>
+#include <vector>
 
 using namespace boost;
 using namespace foundation;
@@ -130,6 +144,9 @@ MasterRenderer::MasterRenderer(
   , m_abort_switch(abort_switch)
   , m_serial_renderer_controller(new SerialRendererController(renderer_controller, tile_callback))
   , m_serial_tile_callback_factory(new SerialTileCallbackFactory(m_serial_renderer_controller))
+#ifdef WITH_OSL
+  , m_texture_cache_size(0)
+#endif
 {
     m_renderer_controller = m_serial_renderer_controller;
     m_tile_callback_factory = m_serial_tile_callback_factory;
@@ -217,149 +234,115 @@ namespace
             dest.strings().insert(param_name, source.strings().get(param_name));
     }
 
-#ifdef WITH_OSL
+    typedef vector<pair<UniqueID, VersionID> > VersionStamp;
+    typedef vector<TransformSequence> TransformStamp;
 
-    void destroy_osl_shading_system(
-        OSL::ShadingSystem*     s,
-        OIIO::TextureSystem*    tx)
+    template <typename EntityContainer>
+    void collect_versions(
+        const EntityContainer&  entities,
+        VersionStamp&           stamp)
     {
-        RENDERER_LOG_INFO("%s", tx->getstats().c_str());
-        tx->reset_stats();
-        OSL::ShadingSystem::destroy(s);
+        for (const_each<EntityContainer> i = entities; i; ++i)
+            stamp.push_back(make_pair(i->get_uid(), i->get_version_id()));
     }
 
-#endif
-}
-
-IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence()
-{
-    assert(m_project.get_scene());
-    assert(m_project.get_frame());
-
-    // Reset the abort switch.
-    if (m_abort_switch)
-        m_abort_switch->clear();
-
-#ifdef WITH_OSL
-
-    // Create the error handler.
-    OIIOErrorHandler error_handler;
-
-    // While debugging, we want all possible outputs.
-#ifndef NDEBUG
-    error_handler.verbosity(OIIO::ErrorHandler::VERBOSE);
-#endif
-
-    const size_t texture_cache_size =
-        m_params.get_optional<size_t>("texture_cache_size",  256 * 1024 * 1024);
-
-    // If the texture cache size changes, we have to recreate the texture system.
-    if (texture_cache_size != m_texture_cache_size)
+    void collect_texture_store_versions(
+        const AssemblyContainer&    assemblies,
+        VersionStamp&               stamp)
     {
-        m_texture_cache_size = texture_cache_size;
-        m_texture_system.reset();
-    }
+        for (const_each<AssemblyContainer> i = assemblies; i; ++i)
+        {
+            // The texture store only keeps track of the identity of assemblies.
+            stamp.push_back(make_pair(i->get_uid(), InvalidVersionID));
 
-    // Create the OIIO texture system, if needed.
-    if (!m_texture_system)
-    {
-        m_texture_system.reset(
-            OIIO::TextureSystem::create(false),
-            bind(&OIIO::TextureSystem::destroy, _1));
+            collect_versions(i->textures(), stamp);
+            collect_texture_store_versions(i->assemblies(), stamp);
+        }
     }
 
-    // Set the texture system mem limit.
-    m_texture_system->attribute("max_memory_MB", static_cast<float>(m_texture_cache_size / 1024));
-
-    std::string search_paths;
-
-    // Skip search paths for builtin projects.
-    if (m_project.search_paths().has_root_path())
+    void collect_light_sampler_versions(
+        const AssemblyInstanceContainer&    assembly_instances,
+        VersionStamp&                       stamp)
     {
-        // Setup texture / shader search paths.
-        // In OIIO / OSL, the path priorities are the opposite of appleseed,
-        // so we copy the paths in reverse order.
-
-        const filesystem::path root_path = m_project.search_paths().get_root_path();
-
-        if (!m_project.search_paths().empty())
+        for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
         {
-            for (size_t i = 0, e = m_project.search_paths().size(); i != e; ++i)
-            {
-                filesystem::path p(m_project.search_paths()[e - 1 - i]);
+            const Assembly& assembly = i->get_assembly();
 
-                if (p.is_relative())
-                   p = root_path / p;
+            stamp.push_back(make_pair(i->get_uid(), i->get_version_id()));
+            stamp.push_back(make_pair(assembly.get_uid(), assembly.get_version_id()));
 
-                search_paths.append(p.string());
-                search_paths.append(";");
-            }
+            collect_versions(assembly.lights(), stamp);
+            collect_versions(assembly.objects(), stamp);
+            collect_versions(assembly.object_instances(), stamp);
+            collect_versions(assembly.materials(), stamp);
+            collect_versions(assembly.edfs(), stamp);
+            collect_light_sampler_versions(assembly.assembly_instances(), stamp);
         }
-
-        search_paths.append(root_path.string());
     }
 
-    if (!search_paths.empty())
-        m_texture_system->attribute("searchpath", search_paths);
-
-    // TODO: set other texture system options here.
-
-    // Create our renderer services.
-    RendererServices services(m_project, *m_texture_system);
-
-    // Create our OSL shading system.
-    boost::shared_ptr<OSL::ShadingSystem> shading_system(
-        OSL::ShadingSystem::create(
-            &services,
-            m_texture_system.get(),
-            &error_handler),
-            bind(&destroy_osl_shading_system, _1, m_texture_system.get()));
+    void collect_transforms(
+        const AssemblyInstanceContainer&    assembly_instances,
+        TransformStamp&                     stamp)
+    {
+        for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+        {
+            stamp.push_back(i->transform_sequence());
+            collect_transforms(i->get_assembly().assembly_instances(), stamp);
+        }
+    }
 
-    if (!search_paths.empty())
-        shading_system->attribute("searchpath:shader", search_paths);
+    // Compute the version stamp of the entities the texture store depends on.
+    VersionStamp compute_texture_store_stamp(const Scene& scene)
+    {
+        VersionStamp stamp;
+        stamp.push_back(make_pair(scene.get_uid(), scene.get_version_id()));
+        collect_versions(scene.textures(), stamp);
+        collect_texture_store_versions(scene.assemblies(), stamp);
+        return stamp;
+    }
 
-    shading_system->attribute("lockgeom", 1);
-    shading_system->attribute("colorspace", "Linear");
-    shading_system->attribute("commonspace", "world");
+    // Compute the version stamp of the entities the light sampler depends on.
+    VersionStamp compute_light_sampler_stamp(const Scene& scene)
+    {
+        VersionStamp stamp;
+        stamp.push_back(make_pair(scene.get_uid(), scene.get_version_id()));
+        collect_light_sampler_versions(scene.assembly_instances(), stamp);
+        return stamp;
+    }
 
-    // This array needs to be kept in sync with the ShadingRay::Type enumeration.
-    static const char* ray_type_labels[] =
+    // Compute the transforms of the assembly instances the light sampler depends on.
+    TransformStamp compute_light_sampler_transforms(const Scene& scene)
     {
-        "camera",
-        "light",
-        "shadow",
-        "probe",
-        "diffuse",
-        "glossy",
-        "specular"
-    };
-
-    shading_system->attribute(
-        "raytypes",
-        OSL::TypeDesc(
-            OSL::TypeDesc::STRING,
-            sizeof(ray_type_labels) / sizeof(ray_type_labels[0])),
-        ray_type_labels);
+        TransformStamp stamp;
+        collect_transforms(scene.assembly_instances(), stamp);
+        return stamp;
+    }
+}
 
-#ifndef NDEBUG
-    // While debugging, we want all possible outputs.
-    shading_system->attribute("debug", 1);
-    shading_system->attribute("statistics:level", 1);
-    shading_system->attribute("compile_report", 1);
-    shading_system->attribute("countlayerexecs", 1);
-    shading_system->attribute("clearmemory", 1);
-#endif
+IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence()
+{
+    assert(m_project.get_scene());
+    assert(m_project.get_frame());
 
-    register_closures(*shading_system);
+    // Reset the abort switch.
+    if (m_abort_switch)
+        m_abort_switch->clear();
 
-#endif  // WITH_OSL
+#ifdef WITH_OSL
+    // Create the OIIO texture system and the OSL shading system, or update them.
+    update_osl_shading_system();
+    OSL::ShadingSystem& shading_system = *m_shading_system;
+#endif
 
     // We start by binding entities inputs. This must be done before creating/updating the trace context.
     if (!bind_scene_entities_inputs())
         return IRendererController::AbortRendering;
 
+    // Child acceleration structures are built with as many threads as are used for rendering.
+    const size_t rendering_thread_count = FrameRendererBase::get_rendering_thread_count(m_params);
+
     m_project.create_aov_images();
-    m_project.update_trace_context();
+    m_project.update_trace_context(rendering_thread_count);
 
     const Scene& scene = *m_project.get_scene();
 
@@ -368,14 +351,15 @@ IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence
 
     const TraceContext& trace_context = m_project.get_trace_context();
 
-    // Create the texture store.
-    TextureStore texture_store(scene, m_params.child("texture_store"));
-
-    // Create the light sampler.
-    LightSampler light_sampler(scene, m_params.child("light_sampler"));
+    // Build acceleration structures before rendering starts if requested, instead of building them on demand.
+    if (m_params.get_optional<bool>("eager_tree_construction", false))
+        trace_context.build_acceleration_structures(rendering_thread_count);
 
-    // Create the shading engine.
-    ShadingEngine shading_engine(m_params.child("shading_engine"));
+    // Create the texture store, the light sampler and the shading engine, or reuse them.
+    update_persistent_components(scene);
+    TextureStore& texture_store = *m_texture_store;
+    const LightSampler& light_sampler = *m_light_sampler;
+    ShadingEngine& shading_engine = *m_shading_engine;
 
     //
     // Create a lighting engine factory.
@@ -411,7 +395,7 @@ IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence
                     trace_context,
                     texture_store,
 #ifdef WITH_OSL
-                    *shading_system,
+                    shading_system,
 #endif
                     params);
             pass_callback.reset(sppm_pass_callback);
@@ -451,7 +435,7 @@ IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence
                     lighting_engine_factory.get(),
                     shading_engine,
 #ifdef WITH_OSL
-                    *shading_system,
+                    shading_system,
 #endif
                     m_params.child("generic_sample_renderer")));
         }
@@ -498,7 +482,7 @@ IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence
                     texture_store,
                     light_sampler,
 #ifdef WITH_OSL
-                    *shading_system,
+                    shading_system,
 #endif
                     m_params.child("lighttracing_sample_generator")));
         }
@@ -657,16 +641,189 @@ IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence
         render_frame_sequence(
             frame_renderer.get()
 #ifdef WITH_OSL
-            , *shading_system
+            , shading_system
 #endif
             );
 
     // Print texture store performance statistics.
     RENDERER_LOG_DEBUG("%s", texture_store.get_statistics().to_string().c_str());
 
+#ifdef WITH_OSL
+    // Print OIIO texture system performance statistics.
+    RENDERER_LOG_INFO("%s", m_texture_system->getstats().c_str());
+    m_texture_system->reset_stats();
+#endif
+
     return status;
 }
 
+#ifdef WITH_OSL
+
+void MasterRenderer::update_osl_shading_system()
+{
+    const size_t texture_cache_size =
+        m_params.get_optional<size_t>("texture_cache_size",  256 * 1024 * 1024);
+
+    // If the texture cache size changes, we have to recreate the texture system,
+    // as well as the shading system that refers to it.
+    if (texture_cache_size != m_texture_cache_size)
+    {
+        m_texture_cache_size = texture_cache_size;
+        m_shading_system.reset();
+        m_texture_system.reset();
+    }
+
+    // Create the OIIO texture system, if needed.
+    if (!m_texture_system)
+    {
+        m_texture_system.reset(
+            OIIO::TextureSystem::create(false),
+            bind(&OIIO::TextureSystem::destroy, _1));
+    }
+
+    // Set the texture system mem limit.
+    m_texture_system->attribute("max_memory_MB", static_cast<float>(m_texture_cache_size / 1024));
+
+    std::string search_paths;
+
+    // Skip search paths for builtin projects.
+    if (m_project.search_paths().has_root_path())
+    {
+        // Setup texture / shader search paths.
+        // In OIIO / OSL, the path priorities are the opposite of appleseed,
+        // so we copy the paths in reverse order.
+
+        const filesystem::path root_path = m_project.search_paths().get_root_path();
+
+        if (!m_project.search_paths().empty())
+        {
+            for (size_t i = 0, e = m_project.search_paths().size(); i != e; ++i)
+            {
+                filesystem::path p(m_project.search_paths()[e - 1 - i]);
+
+                if (p.is_relative())
+                   p = root_path / p;
+
+                search_paths.append(p.string());
+                search_paths.append(";");
+            }
+        }
+
+        search_paths.append(root_path.string());
+    }
+
+    if (!search_paths.empty())
+        m_texture_system->attribute("searchpath", search_paths);
+
+    // TODO: set other texture system options here.
+
+    // Create the OSL shading system, if needed. It is kept across reinitializations
+    // so that shaders already loaded and compiled by OSL can be reused.
+    if (!m_shading_system)
+    {
+        // Create the error handler.
+        m_error_handler.reset(new OIIOErrorHandler());
+
+        // While debugging, we want all possible outputs.
+#ifndef NDEBUG
+        m_error_handler->verbosity(OIIO::ErrorHandler::VERBOSE);
+#endif
+
+        // Create our renderer services.
+        m_renderer_services.reset(new RendererServices(m_project, *m_texture_system));
+
+        m_shading_system.reset(
+            OSL::ShadingSystem::create(
+                m_renderer_services.get(),
+                m_texture_system.get(),
+                m_error_handler.get()),
+            bind(&OSL::ShadingSystem::destroy, _1));
+
+        m_shading_system->attribute("lockgeom", 1);
+        m_shading_system->attribute("colorspace", "Linear");
+        m_shading_system->attribute("commonspace", "world");
+
+        // This array needs to be kept in sync with the ShadingRay::Type enumeration.
+        static const char* ray_type_labels[] =
+        {
+            "camera",
+            "light",
+            "shadow",
+            "probe",
+            "diffuse",
+            "glossy",
+            "specular"
+        };
+
+        m_shading_system->attribute(
+            "raytypes",
+            OSL::TypeDesc(
+                OSL::TypeDesc::STRING,
+                sizeof(ray_type_labels) / sizeof(ray_type_labels[0])),
+            ray_type_labels);
+
+#ifndef NDEBUG
+        // While debugging, we want all possible outputs.
+        m_shading_system->attribute("debug", 1);
+        m_shading_system->attribute("statistics:level", 1);
+        m_shading_system->attribute("compile_report", 1);
+        m_shading_system->attribute("countlayerexecs", 1);
+        m_shading_system->attribute("clearmemory", 1);
+#endif
+
+        register_closures(*m_shading_system);
+    }
+
+    if (!search_paths.empty())
+        m_shading_system->attribute("searchpath:shader", search_paths);
+}
+
+#endif  // WITH_OSL
+
+void MasterRenderer::update_persistent_components(const Scene& scene)
+{
+    const ParamArray& texture_store_params = m_params.child("texture_store");
+    const VersionStamp texture_store_stamp = compute_texture_store_stamp(scene);
+
+    if (m_texture_store.get() == 0 ||
+        m_texture_store_params != texture_store_params ||
+        m_texture_store_stamp != texture_store_stamp)
+    {
+        // Release the tiles of the previous texture store before creating the new one.
+        m_texture_store.reset();
+        m_texture_store.reset(new TextureStore(scene, texture_store_params));
+        m_texture_store_params = texture_store_params;
+        m_texture_store_stamp = texture_store_stamp;
+    }
+    else RENDERER_LOG_DEBUG("reusing texture store.");
+
+    const ParamArray& light_sampler_params = m_params.child("light_sampler");
+    const VersionStamp light_sampler_stamp = compute_light_sampler_stamp(scene);
+    const TransformStamp light_sampler_transforms = compute_light_sampler_transforms(scene);
+
+    if (m_light_sampler.get() == 0 ||
+        m_light_sampler_params != light_sampler_params ||
+        m_light_sampler_stamp != light_sampler_stamp ||
+        m_light_sampler_transforms != light_sampler_transforms)
+    {
+        m_light_sampler.reset();
+        m_light_sampler.reset(new LightSampler(scene, light_sampler_params));
+        m_light_sampler_params = light_sampler_params;
+        m_light_sampler_stamp = light_sampler_stamp;
+        m_light_sampler_transforms = light_sampler_transforms;
+    }
+    else RENDERER_LOG_DEBUG("reusing light sampler.");
+
+    const ParamArray& shading_engine_params = m_params.child("shading_engine");
+
+    if (m_shading_engine.get() == 0 ||
+        m_shading_engine_params != shading_engine_params)
+    {
+        m_shading_engine.reset(new ShadingEngine(shading_engine_params));
+        m_shading_engine_params = shading_engine_params;
+    }
+}
+
 IRendererController::Status MasterRenderer::render_frame_sequence(
     IFrameRenderer*         frame_renderer
 #ifdef WITH_OSL
@@ -701,6 +858,11 @@ IRendererController::Status MasterRenderer::render_frame_sequence(
             return m_renderer_controller->on_progress();
         }
 
+#ifdef WITH_OSL
+        // Child trees built so far assumed that all OSL shader groups have transparency.
+        m_project.get_trace_context().update_alpha_mapped_object_instances();
+#endif
+
         frame_renderer->start_rendering();
 
         const IRendererController::Status status = wait_for_event(frame_renderer);
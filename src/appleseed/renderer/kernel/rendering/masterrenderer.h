@@ -33,6 +33,11 @@
 // appleseed.renderer headers.
 #include "renderer/global/global.h"
 #include "renderer/kernel/rendering/irenderercontroller.h"
+#include "renderer/utility/transformsequence.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/uid.h"
+#include "foundation/utility/version.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
@@ -47,13 +52,28 @@
 #include "boost/shared_ptr.hpp"
 #endif
 
+// Standard headers.
+#include <memory>
+#include <utility>
+#include <vector>
+
 // Forward declarations.
 namespace foundation    { class AbortSwitch; }
 namespace renderer      { class IFrameRenderer; }
 namespace renderer      { class ITileCallbackFactory; }
 namespace renderer      { class ITileCallback; }
+namespace renderer      { class LightSampler; }
+#ifdef WITH_OSL
+namespace renderer      { class OIIOErrorHandler; }
+#endif
 namespace renderer      { class Project; }
+#ifdef WITH_OSL
+namespace renderer      { class RendererServices; }
+#endif
+namespace renderer      { class Scene; }
 namespace renderer      { class SerialRendererController; }
+namespace renderer      { class ShadingEngine; }
+namespace renderer      { class TextureStore; }
 
 namespace renderer
 {
@@ -106,14 +126,45 @@ class DLLSYMBOL MasterRenderer
 #ifdef WITH_OSL
     boost::shared_ptr<OIIO::TextureSystem>  m_texture_system;
     std::size_t                             m_texture_cache_size;
+    std::auto_ptr<OIIOErrorHandler>         m_error_handler;
+    std::auto_ptr<RendererServices>         m_renderer_services;
+    boost::shared_ptr<OSL::ShadingSystem>   m_shading_system;
 #endif
 
+    // The (uid, version ID) pairs of the entities a rendering component depends on.
+    typedef std::vector<
+        std::pair<foundation::UniqueID, foundation::VersionID>
+    > VersionStamp;
+
+    // The transforms of the assembly instances, which can be modified without changing their version ID.
+    typedef std::vector<TransformSequence> TransformStamp;
+
+    // Rendering components that persist across reinitializations of the rendering.
+    // Each of them is only recreated when its parameters or the entities it depends on changed.
+    std::auto_ptr<TextureStore>     m_texture_store;
+    ParamArray                      m_texture_store_params;
+    VersionStamp                    m_texture_store_stamp;
+    std::auto_ptr<LightSampler>     m_light_sampler;
+    ParamArray                      m_light_sampler_params;
+    VersionStamp                    m_light_sampler_stamp;
+    TransformStamp                  m_light_sampler_transforms;
+    std::auto_ptr<ShadingEngine>    m_shading_engine;
+    ParamArray                      m_shading_engine_params;
+
     // Render frame sequences, each time reinitializing the rendering components.
     void do_render();
 
     // Initialize the rendering components and render a frame sequence.
     IRendererController::Status initialize_and_render_frame_sequence();
 
+#ifdef WITH_OSL
+    // Create the OIIO texture system and the OSL shading system, or update them if they already exist.
+    void update_osl_shading_system();
+#endif
+
+    // Create the texture store, the light sampler and the shading engine, or reuse them if they are up-to-date.
+    void update_persistent_components(const Scene& scene);
+
     // Render a frame sequence until the sequence is completed or rendering is aborted.
     IRendererController::Status render_frame_sequence(
         IFrameRenderer*             frame_renderer
@@ -87,6 +87,7 @@ namespace
           : m_frame(*project.get_frame())
           , m_params(params)
           , m_sample_counter(m_params.m_max_sample_count)
+          , m_display_tile_callback(0)
           , m_ref_image_avg_lum(0.0)
         {
             // We must have a generator factory, but it's OK not to have a callback factory.
@@ -113,11 +114,13 @@ namespace
                         i == 0));
             }
 
-            // Instantiate tile callbacks, one per rendering thread.
+            // Instantiate tile callbacks, one per rendering thread, plus one for the display thread.
             if (callback_factory)
             {
                 for (size_t i = 0; i < m_params.m_thread_count; ++i)
                     m_tile_callbacks.push_back(callback_factory->create());
+
+                m_display_tile_callback = callback_factory->create();
             }
 
             // Load the reference image if one is specified.
@@ -154,17 +157,24 @@ namespace
 
         virtual ~ProgressiveFrameRenderer()
         {
-            // Tell the statistics printing thread to stop.
+            // Tell the statistics printing and display threads to stop.
             m_abort_switch.abort();
 
             // Wait until the statistics printing thread is terminated.
             if (m_statistics_thread.get() && m_statistics_thread->joinable())
                 m_statistics_thread->join();
 
+            // Wait until the display thread is terminated.
+            if (m_display_thread.get() && m_display_thread->joinable())
+                m_display_thread->join();
+
             // Delete tile callbacks.
             for (const_each<TileCallbackVector> i = m_tile_callbacks; i; ++i)
                 (*i)->release();
 
+            if (m_display_tile_callback)
+                m_display_tile_callback->release();
+
             // Delete sample generators.
             for (const_each<SampleGeneratorVector> i = m_sample_generators; i; ++i)
                 (*i)->release();
@@ -180,6 +190,9 @@ namespace
             start_rendering();
 
             m_job_queue.wait_until_completion();
+
+            // Stop the auxiliary threads and display the final state of the frame.
+            stop_rendering();
         }
 
         virtual void start_rendering()
@@ -226,6 +239,17 @@ namespace
                     m_abort_switch));
             ThreadFunctionWrapper<StatisticsFunc> wrapper(m_statistics_func.get());
             m_statistics_thread.reset(new thread(wrapper));
+
+            // Create and start the display thread.
+            m_display_func.reset(
+                new DisplayFunc(
+                    m_frame,
+                    *m_buffer.get(),
+                    m_display_tile_callback,
+                    m_params.m_max_fps,
+                    m_abort_switch));
+            ThreadFunctionWrapper<DisplayFunc> display_wrapper(m_display_func.get());
+            m_display_thread.reset(new thread(display_wrapper));
         }
 
         virtual void stop_rendering()
@@ -233,14 +257,22 @@ namespace
             // First, delete scheduled jobs to prevent worker threads from picking them up.
             m_job_queue.clear_scheduled_jobs();
 
-            // Tell rendering jobs and the statistics printing thread to stop.
+            // Tell rendering jobs, the statistics printing thread and the display thread to stop.
             m_abort_switch.abort();
 
             // Wait until the statistics printing thread has stopped.
-            m_statistics_thread->join();
+            if (m_statistics_thread->joinable())
+                m_statistics_thread->join();
+
+            // Wait until the display thread has stopped.
+            if (m_display_thread->joinable())
+                m_display_thread->join();
 
             // Wait until rendering jobs have effectively stopped.
             m_job_queue.wait_until_completion();
+
+            // Display the samples stored since the last update of the display.
+            m_display_func->develop();
         }
 
         virtual void terminate_rendering()
@@ -266,16 +298,86 @@ namespace
             const uint64    m_max_sample_count;         // maximum total number of samples to compute
             const bool      m_print_luminance_stats;    // compute and print luminance statistics?
             const string    m_ref_image_path;           // path to the reference image
+            const double    m_max_fps;                  // maximum number of display updates per second
 
             explicit Parameters(const ParamArray& params)
               : m_thread_count(FrameRendererBase::get_rendering_thread_count(params))
               , m_max_sample_count(params.get_optional<uint64>("max_samples", numeric_limits<uint64>::max()))
               , m_print_luminance_stats(params.get_optional<bool>("print_luminance_statistics", false))
               , m_ref_image_path(params.get_optional<string>("reference_image", ""))
+              , m_max_fps(params.get_optional<double>("max_fps", 30.0))
             {
             }
         };
 
+        class DisplayFunc
+          : public NonCopyable
+        {
+          public:
+            DisplayFunc(
+                Frame&                      frame,
+                SampleAccumulationBuffer&   buffer,
+                ITileCallback*              tile_callback,
+                const double                max_fps,
+                AbortSwitch&                abort_switch)
+              : m_frame(frame)
+              , m_buffer(buffer)
+              , m_tile_callback(tile_callback)
+              , m_min_display_period(max_fps > 0.0 ? 1.0 / max_fps : 0.0)
+              , m_abort_switch(abort_switch)
+              , m_timer_frequency(m_timer.frequency())
+              , m_last_time(m_timer.read())
+              , m_last_sample_count(0)
+            {
+            }
+
+            void operator()()
+            {
+                while (!m_abort_switch.is_aborted())
+                {
+                    const uint64 time = m_timer.read();
+                    const uint64 elapsed_ticks = time - m_last_time;
+                    const double elapsed_seconds = static_cast<double>(elapsed_ticks) / m_timer_frequency;
+
+                    if (elapsed_seconds >= m_min_display_period)
+                    {
+                        develop();
+                        m_last_time = time;
+                    }
+
+                    foundation::sleep(5);
+                }
+            }
+
+            // Develop the accumulation buffer to the frame if it received samples since the last call.
+            void develop()
+            {
+                const uint64 sample_count = m_buffer.get_sample_count();
+
+                if (sample_count == m_last_sample_count)
+                    return;
+
+                m_buffer.develop_to_frame(m_frame);
+
+                if (m_tile_callback)
+                    m_tile_callback->post_render(&m_frame);
+
+                m_last_sample_count = sample_count;
+            }
+
+          private:
+            Frame&                          m_frame;
+            SampleAccumulationBuffer&       m_buffer;
+            ITileCallback*                  m_tile_callback;
+            const double                    m_min_display_period;   // in seconds
+            AbortSwitch&                    m_abort_switch;
+
+            DefaultWallclockTimer           m_timer;
+            uint64                          m_timer_frequency;
+            uint64                          m_last_time;
+            uint64                          m_last_sample_count;
+        };
+
         class StatisticsFunc
           : public NonCopyable
         {
@@ -428,6 +530,7 @@ namespace
 
         SampleGeneratorVector               m_sample_generators;
         TileCallbackVector                  m_tile_callbacks;
+        ITileCallback*                      m_display_tile_callback;
 
         auto_ptr<Image>                     m_ref_image;
         double                              m_ref_image_avg_lum;
@@ -435,6 +538,9 @@ namespace
         auto_ptr<StatisticsFunc>            m_statistics_func;
         auto_ptr<thread>                    m_statistics_thread;
 
+        auto_ptr<DisplayFunc>               m_display_func;
+        auto_ptr<thread>                    m_display_thread;
+
         void print_sample_generators_stats() const
         {
             assert(!m_sample_generators.empty());
@@ -127,13 +127,8 @@ void SampleGeneratorJob::execute(const size_t thread_index)
         m_sample_generator->generate_samples(sample_count, m_buffer, m_abort_switch);
     }
 
-    if (m_job_index == 0)
-    {
-        m_buffer.develop_to_frame(m_frame);
-
-        if (m_tile_callback)
-            m_tile_callback->post_render(&m_frame);
-    }
+    // The accumulation buffer is developed to the frame by the display thread
+    // of the progressive frame renderer, not by sample generation jobs.
 
     // This job reschedules itself automatically.
     if (!m_abort_switch.is_aborted())
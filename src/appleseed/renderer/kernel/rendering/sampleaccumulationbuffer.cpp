@@ -0,0 +1,156 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sampleaccumulationbuffer.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// SampleAccumulationBuffer class implementation.
+//
+
+SampleAccumulationBuffer::SampleAccumulationBuffer(
+    const size_t    width,
+    const size_t    height,
+    const Filter2d& filter)
+  : m_sample_count(0)
+  , m_width(width)
+  , m_height(height)
+  , m_filter_xradius(filter.get_xradius())
+  , m_filter_yradius(filter.get_yradius())
+{
+    // Make stripes at least as tall as the filter footprint so that
+    // a single sample never touches more than two consecutive stripes.
+    const size_t MinStripeHeight = 16;
+    const size_t footprint_height = truncate<size_t>(std::ceil(2.0 * m_filter_yradius)) + 1;
+
+    m_stripe_height = max(footprint_height, MinStripeHeight);
+    m_stripe_count = max<size_t>((height + m_stripe_height - 1) / m_stripe_height, 1);
+    m_stripe_mutexes = new boost::mutex[m_stripe_count];
+
+    // Initially, all cells are dirty.
+    m_cell_count_x = max<size_t>((width + m_stripe_height - 1) / m_stripe_height, 1);
+    m_dirty_cells = new uint8[m_stripe_count * m_cell_count_x];
+    fill(m_dirty_cells, m_dirty_cells + m_stripe_count * m_cell_count_x, 1);
+}
+
+SampleAccumulationBuffer::~SampleAccumulationBuffer()
+{
+    delete [] m_dirty_cells;
+    delete [] m_stripe_mutexes;
+}
+
+void SampleAccumulationBuffer::lock_all_stripes()
+{
+    for (size_t i = 0; i < m_stripe_count; ++i)
+        m_stripe_mutexes[i].lock();
+}
+
+void SampleAccumulationBuffer::unlock_all_stripes()
+{
+    for (size_t i = m_stripe_count; i > 0; --i)
+        m_stripe_mutexes[i - 1].unlock();
+}
+
+void SampleAccumulationBuffer::clear_dirty(const size_t stripe)
+{
+    uint8* cells = m_dirty_cells + stripe * m_cell_count_x;
+    fill(cells, cells + m_cell_count_x, 0);
+}
+
+void SampleAccumulationBuffer::set_all_dirty()
+{
+    fill(m_dirty_cells, m_dirty_cells + m_stripe_count * m_cell_count_x, 1);
+}
+
+SampleAccumulationBuffer::StripeLock::StripeLock(
+    SampleAccumulationBuffer&   buffer,
+    const double                y)
+  : m_buffer(buffer)
+{
+    // Range of rows affected by the sample, see FilteredTile::add().
+    const double min_y = std::ceil(y - 0.5 - buffer.m_filter_yradius);
+    const double max_y = std::floor(y - 0.5 + buffer.m_filter_yradius);
+    const double last_row = static_cast<double>(buffer.m_height - 1);
+
+    if (max_y < 0.0 || min_y > last_row || min_y > max_y)
+    {
+        m_begin = m_end = 0;
+        return;
+    }
+
+    const size_t first_row = truncate<size_t>(max(min_y, 0.0));
+    const size_t end_row = truncate<size_t>(min(max_y, last_row)) + 1;
+
+    m_begin = first_row / buffer.m_stripe_height;
+    m_end = (end_row - 1) / buffer.m_stripe_height + 1;
+
+    for (size_t i = m_begin; i < m_end; ++i)
+        buffer.m_stripe_mutexes[i].lock();
+}
+
+SampleAccumulationBuffer::StripeLock::~StripeLock()
+{
+    for (size_t i = m_end; i > m_begin; --i)
+        m_buffer.m_stripe_mutexes[i - 1].unlock();
+}
+
+void SampleAccumulationBuffer::StripeLock::set_dirty(const double x)
+{
+    // Range of columns affected by the sample, see FilteredTile::add().
+    const double min_x = std::ceil(x - 0.5 - m_buffer.m_filter_xradius);
+    const double max_x = std::floor(x - 0.5 + m_buffer.m_filter_xradius);
+    const double last_column = static_cast<double>(m_buffer.m_width - 1);
+
+    if (max_x < 0.0 || min_x > last_column || min_x > max_x)
+        return;
+
+    const size_t cell_begin = truncate<size_t>(max(min_x, 0.0)) / m_buffer.m_stripe_height;
+    const size_t cell_end = truncate<size_t>(min(max_x, last_column)) / m_buffer.m_stripe_height + 1;
+
+    for (size_t i = m_begin; i < m_end; ++i)
+    {
+        uint8* cells = m_buffer.m_dirty_cells + i * m_buffer.m_cell_count_x;
+        fill(cells + cell_begin, cells + cell_end, 1);
+    }
+}
+
+}   // namespace renderer
@@ -32,10 +32,12 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/filter.h"
 #include "foundation/platform/thread.h"
 #include "foundation/platform/types.h"
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
 
 // Forward declarations.
@@ -45,12 +47,25 @@ namespace renderer  { class Sample; }
 namespace renderer
 {
 
+//
+// Base class for sample accumulation buffers.
+//
+// The rows of the buffer are grouped into horizontal stripes, each protected by its
+// own lock, so that samples landing in different parts of the image can be stored
+// concurrently. Lock ordering: m_mutex first, then stripes in increasing order.
+//
+// Stripes are further divided into cells (as wide as stripes are tall) that can be
+// flagged as dirty when they receive samples, so that derived classes can restrict
+// development to the parts of the image that changed. Dirty flags of a stripe are
+// only accessed while holding the lock of that stripe.
+//
+
 class SampleAccumulationBuffer
   : public foundation::NonCopyable
 {
   public:
     // Destructor.
-    virtual ~SampleAccumulationBuffer() {}
+    virtual ~SampleAccumulationBuffer();
 
     // Get the number of samples stored in the buffer.
     foundation::uint64 get_sample_count() const;
@@ -70,12 +85,85 @@ class SampleAccumulationBuffer
     mutable boost::mutex    m_mutex;
     foundation::uint64      m_sample_count;
 
+    // Constructor.
+    SampleAccumulationBuffer(
+        const size_t                width,
+        const size_t                height,
+        const foundation::Filter2d& filter);
+
     void clear_no_lock();
+
+    // Stripe properties.
+    size_t get_stripe_height() const;
+    size_t get_stripe_count() const;
+
+    // Lock or unlock all the stripes.
+    void lock_all_stripes();
+    void unlock_all_stripes();
+
+    // Return true if any cell of a given stripe overlapping columns [x_begin, x_end) is dirty.
+    // The lock of the stripe must be held.
+    bool is_dirty(
+        const size_t                stripe,
+        const size_t                x_begin,
+        const size_t                x_end) const;
+
+    // Clear the dirty flags of a given stripe. The lock of the stripe must be held.
+    void clear_dirty(const size_t stripe);
+
+    // Flag all cells as dirty. The locks of all stripes must be held.
+    void set_all_dirty();
+
+    // Lock the stripes affected by a sample for the lifetime of this object.
+    class StripeLock
+      : public foundation::NonCopyable
+    {
+      public:
+        // @y is the vertical coordinate of the sample in continuous image space.
+        StripeLock(
+            SampleAccumulationBuffer&   buffer,
+            const double                y);
+
+        ~StripeLock();
+
+        // Flag the cells affected by a sample as dirty.
+        // @x is the horizontal coordinate of the sample in continuous image space.
+        void set_dirty(const double x);
+
+      private:
+        SampleAccumulationBuffer&       m_buffer;
+        size_t                          m_begin;
+        size_t                          m_end;
+    };
+
+    // Lock a single stripe for the lifetime of this object.
+    class SingleStripeLock
+      : public foundation::NonCopyable
+    {
+      public:
+        SingleStripeLock(
+            SampleAccumulationBuffer&   buffer,
+            const size_t                stripe);
+
+      private:
+        boost::mutex::scoped_lock       m_lock;
+    };
+
+  private:
+    const size_t            m_width;
+    const size_t            m_height;
+    const double            m_filter_xradius;
+    const double            m_filter_yradius;
+    size_t                  m_stripe_height;
+    size_t                  m_stripe_count;
+    boost::mutex*           m_stripe_mutexes;
+    size_t                  m_cell_count_x;         // number of cells per stripe
+    foundation::uint8*      m_dirty_cells;          // m_stripe_count x m_cell_count_x dirty flags
 };
 
 
 //
-// SampleAccumulationBufferclass implementation.
+// SampleAccumulationBuffer class implementation.
 //
 
 inline foundation::uint64 SampleAccumulationBuffer::get_sample_count() const
@@ -90,6 +178,42 @@ inline void SampleAccumulationBuffer::clear_no_lock()
     m_sample_count = 0;
 }
 
+inline size_t SampleAccumulationBuffer::get_stripe_height() const
+{
+    return m_stripe_height;
+}
+
+inline size_t SampleAccumulationBuffer::get_stripe_count() const
+{
+    return m_stripe_count;
+}
+
+inline bool SampleAccumulationBuffer::is_dirty(
+    const size_t                stripe,
+    const size_t                x_begin,
+    const size_t                x_end) const
+{
+    assert(x_begin < x_end);
+
+    const foundation::uint8* cells = m_dirty_cells + stripe * m_cell_count_x;
+    const size_t cell_end = (x_end - 1) / m_stripe_height + 1;
+
+    for (size_t i = x_begin / m_stripe_height; i < cell_end; ++i)
+    {
+        if (cells[i])
+            return true;
+    }
+
+    return false;
+}
+
+inline SampleAccumulationBuffer::SingleStripeLock::SingleStripeLock(
+    SampleAccumulationBuffer&   buffer,
+    const size_t                stripe)
+  : m_lock(buffer.m_stripe_mutexes[stripe])
+{
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_SAMPLEACCUMULATIONBUFFER_H
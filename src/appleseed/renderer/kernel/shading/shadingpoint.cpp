@@ -199,6 +199,72 @@ void ShadingPoint::refine_and_offset() const
     m_members |= ShadingPoint::HasRefinedPoints;
 }
 
+namespace
+{
+    // Intersect a ray with a plane, return false if they are parallel.
+    bool intersect_plane(
+        const Ray3d&        ray,
+        const Vector3d&     plane_point,
+        const Vector3d&     plane_normal,
+        Vector3d&           hit)
+    {
+        const double d = dot(plane_normal, ray.m_dir);
+
+        if (d == 0.0)
+            return false;
+
+        const double t = dot(plane_normal, plane_point - ray.m_org) / d;
+        hit = ray.point_at(t);
+
+        return true;
+    }
+}
+
+void ShadingPoint::compute_uv_derivatives() const
+{
+    m_duvdx = Vector2d(0.0);
+    m_duvdy = Vector2d(0.0);
+
+    if (!m_ray.m_has_differentials)
+        return;
+
+    cache_source_geometry();
+
+    const Vector3d& v0 = get_vertex(0);
+    const Vector3d e1 = get_vertex(1) - v0;
+    const Vector3d e2 = get_vertex(2) - v0;
+    const Vector3d n = cross(e1, e2);
+    const double square_n = square_norm(n);
+
+    if (square_n == 0.0)
+        return;
+
+    // Intersect the auxiliary rays with the plane of the hit triangle.
+    Vector3d px, py;
+    if (!intersect_plane(m_ray.m_rx, v0, n, px) ||
+        !intersect_plane(m_ray.m_ry, v0, n, py))
+        return;
+
+    const Vector3d& p = get_point();
+    const Vector3d dpdx = px - p;
+    const Vector3d dpdy = py - p;
+
+    // Compute the variations of the barycentric coordinates of the triangle.
+    const double rcp_square_n = 1.0 / square_n;
+    const double dw1dx = dot(cross(dpdx, e2), n) * rcp_square_n;
+    const double dw2dx = dot(cross(e1, dpdx), n) * rcp_square_n;
+    const double dw1dy = dot(cross(dpdy, e2), n) * rcp_square_n;
+    const double dw2dy = dot(cross(e1, dpdy), n) * rcp_square_n;
+
+    // Deduce the variations of the texture coordinates.
+    const Vector2d uv0(m_v0_uv);
+    const Vector2d duv1 = Vector2d(m_v1_uv) - uv0;
+    const Vector2d duv2 = Vector2d(m_v2_uv) - uv0;
+
+    m_duvdx = dw1dx * duv1 + dw2dx * duv2;
+    m_duvdy = dw1dy * duv1 + dw2dy * duv2;
+}
+
 Vector3d ShadingPoint::get_biased_point(const Vector3d& direction) const
 {
     assert(hit());
@@ -267,12 +333,12 @@ OSL::ShaderGlobals& ShadingPoint::get_osl_shader_globals() const
         m_shader_globals.Ng = Vector3f(get_geometric_normal());
 
         m_shader_globals.u = get_uv(0).x;
-        m_shader_globals.dudx = 0;
-        m_shader_globals.dudy = 0;
+        m_shader_globals.dudx = get_duvdx(0).x;
+        m_shader_globals.dudy = get_duvdy(0).x;
 
         m_shader_globals.v = get_uv(0).y;
-        m_shader_globals.dvdx = 0;
-        m_shader_globals.dvdy = 0;
+        m_shader_globals.dvdx = get_duvdx(0).y;
+        m_shader_globals.dvdy = get_duvdy(0).y;
 
         m_shader_globals.dPdu = Vector3f(get_dpdu(0));
         m_shader_globals.dPdv = Vector3f(get_dpdv(0));
@@ -121,6 +121,11 @@ class ShadingPoint
     const foundation::Vector3d& get_dpdu(const size_t uvset) const;
     const foundation::Vector3d& get_dpdv(const size_t uvset) const;
 
+    // Return the screen space partial derivatives of the texture coordinates from a given UV set.
+    // The derivatives are null if the ray that was cast through the scene has no differentials.
+    const foundation::Vector2d& get_duvdx(const size_t uvset) const;
+    const foundation::Vector2d& get_duvdy(const size_t uvset) const;
+
     // Return the world space geometric normal at the intersection point. The geometric normal
     // always faces the incoming ray, i.e. dot(ray_dir, geometric_normal) is always positive or null.
     const foundation::Vector3d& get_geometric_normal() const;
@@ -216,10 +221,11 @@ class ShadingPoint
         HasShadingBasis                 = 1 << 9,
         HasWorldSpaceVertices           = 1 << 10,
         HasWorldSpaceVertexNormals      = 1 << 11,
-        HasMaterial                     = 1 << 12
+        HasMaterial                     = 1 << 12,
+        HasUVDerivatives                = 1 << 13
 
 #ifdef WITH_OSL
-        , HasOSLShaderGlobals           = 1 << 13
+        , HasOSLShaderGlobals           = 1 << 14
 #endif
     };
     mutable foundation::uint32          m_members;                      // which members have already been computed
@@ -235,6 +241,8 @@ class ShadingPoint
     mutable foundation::Vector3d        m_biased_point;                 // world space intersection point with per-object-instance bias applied
     mutable foundation::Vector3d        m_dpdu;                         // world space partial derivative of the intersection point wrt. U
     mutable foundation::Vector3d        m_dpdv;                         // world space partial derivative of the intersection point wrt. V
+    mutable foundation::Vector2d        m_duvdx;                        // screen space partial derivative of the texture coordinates wrt. X
+    mutable foundation::Vector2d        m_duvdy;                        // screen space partial derivative of the texture coordinates wrt. Y
     mutable foundation::Vector3d        m_geometric_normal;             // world space geometric normal, unit-length
     mutable foundation::Vector3d        m_shading_normal;               // world space (possibly modified) shading normal, unit-length
     mutable foundation::Vector3d        m_original_shading_normal;      // original world space shading normal, unit-length
@@ -264,6 +272,9 @@ class ShadingPoint
 
     // Compute the partial derivatives dp/du and dp/dv.
     void compute_partial_derivatives() const;
+
+    // Compute the screen space partial derivatives of the texture coordinates.
+    void compute_uv_derivatives() const;
 };
 
 
@@ -417,6 +428,34 @@ inline const foundation::Vector3d& ShadingPoint::get_dpdv(const size_t uvset) co
     return m_dpdv;
 }
 
+inline const foundation::Vector2d& ShadingPoint::get_duvdx(const size_t uvset) const
+{
+    assert(hit());
+    assert(uvset == 0);     // todo: support multiple UV sets
+
+    if (!(m_members & HasUVDerivatives))
+    {
+        compute_uv_derivatives();
+        m_members |= HasUVDerivatives;
+    }
+
+    return m_duvdx;
+}
+
+inline const foundation::Vector2d& ShadingPoint::get_duvdy(const size_t uvset) const
+{
+    assert(hit());
+    assert(uvset == 0);     // todo: support multiple UV sets
+
+    if (!(m_members & HasUVDerivatives))
+    {
+        compute_uv_derivatives();
+        m_members |= HasUVDerivatives;
+    }
+
+    return m_duvdy;
+}
+
 inline const foundation::Vector3d& ShadingPoint::get_geometric_normal() const
 {
     assert(hit());
@@ -43,7 +43,6 @@ namespace renderer
 // A ray as it is used throughout the renderer.
 //
 // todo: add importance/contribution?
-// todo: replace ray by ray differential.
 //
 
 class ShadingRay
@@ -75,8 +74,13 @@ class ShadingRay
     TypeType                        m_type;
     DepthType                       m_depth;
 
+    // Ray differentials: auxiliary rays offset by one pixel in x and y on the film plane.
+    bool                            m_has_differentials;
+    RayType                         m_rx;
+    RayType                         m_ry;
+
     // Constructors.
-    ShadingRay();                               // leave all fields uninitialized
+    ShadingRay();                               // leave all fields uninitialized, except m_has_differentials
     ShadingRay(
         const RayType&              ray,
         const double                time,
@@ -114,6 +118,7 @@ ShadingRay transform_to_parent(
 //
 
 inline ShadingRay::ShadingRay()
+  : m_has_differentials(false)
 {
 }
 
@@ -126,6 +131,7 @@ inline ShadingRay::ShadingRay(
   , m_time(time)
   , m_type(type)
   , m_depth(depth)
+  , m_has_differentials(false)
 {
 }
 
@@ -139,6 +145,7 @@ inline ShadingRay::ShadingRay(
   , m_time(time)
   , m_type(type)
   , m_depth(depth)
+  , m_has_differentials(false)
 {
 }
 
@@ -154,6 +161,7 @@ inline ShadingRay::ShadingRay(
   , m_time(time)
   , m_type(type)
   , m_depth(depth)
+  , m_has_differentials(false)
 {
 }
 
@@ -82,6 +82,10 @@ class StaticTessellation
     // Append a UV vertex to this tessellation.
     size_t push_uv_vertex(const GVector2& uv);
 
+    // Insert UV vertices into the tessellation.
+    // Return the index of the first vertex.
+    size_t push_uv_vertices(const GVector2* uvs, const size_t count);
+
     // Retrieve the number of UV vertices stored in this tessellation.
     size_t get_uv_vertex_count() const;
 
@@ -165,6 +169,15 @@ inline size_t StaticTessellation<Primitive>::push_uv_vertex(const GVector2& uv)
     return m_vertex_attributes.push_attribute(m_uv_0_cid, uv);
 }
 
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::push_uv_vertices(const GVector2* uvs, const size_t count)
+{
+    if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
+        create_uv_0_attribute();
+
+    return m_vertex_attributes.push_attributes(m_uv_0_cid, uvs, count);
+}
+
 template <typename Primitive>
 inline size_t StaticTessellation<Primitive>::get_uv_vertex_count() const
 {
@@ -66,7 +66,8 @@ class TextureCache
         const foundation::UniqueID  assembly_uid,
         const foundation::UniqueID  texture_uid,
         const size_t                tile_x,
-        const size_t                tile_y);
+        const size_t                tile_y,
+        const size_t                level = 0);
 
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
@@ -131,9 +132,10 @@ inline foundation::Tile& TextureCache::get(
     const foundation::UniqueID      assembly_uid,
     const foundation::UniqueID      texture_uid,
     const size_t                    tile_x,
-    const size_t                    tile_y)
+    const size_t                    tile_y,
+    const size_t                    level)
 {
-    const TileKey key(assembly_uid, texture_uid, tile_x, tile_y);
+    const TileKey key(assembly_uid, texture_uid, tile_x, tile_y, level);
     return *m_tile_cache.get(key)->m_tile;
 }
 
@@ -166,7 +168,8 @@ inline size_t TextureCache::TileKeyHasher::operator()(const TileKey& key) const
         foundation::mix_uint32(
             static_cast<foundation::uint32>(key.m_assembly_uid),
             static_cast<foundation::uint32>(key.m_texture_uid),
-            static_cast<foundation::uint32>(key.m_tile_xy));
+            static_cast<foundation::uint32>(key.m_tile_xy),
+            static_cast<foundation::uint32>(key.m_level));
 }
 
 
@@ -38,9 +38,11 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/tile.h"
+#include "foundation/math/hash.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/memory.h"
@@ -65,18 +67,222 @@ TextureStore::TextureStore(
     const Scene&        scene,
     const ParamArray&   params)
   : m_tile_swapper(scene, params)
-  , m_tile_cache(m_tile_swapper)
 {
+    for (size_t i = 0; i < ShardCount; ++i)
+        m_shards[i] = new Shard(m_tile_swapper);
+}
+
+TextureStore::~TextureStore()
+{
+    for (size_t i = 0; i < ShardCount; ++i)
+        delete m_shards[i];
+}
+
+TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
+{
+    Shard& shard = get_shard(key);
+
+    boost::mutex::scoped_lock lock(shard.m_mutex, boost::try_to_lock);
+
+    if (!lock.owns_lock())
+    {
+        lock.lock();
+        ++shard.m_contention_count;
+    }
+
+    TileRecord& record = shard.m_tile_cache.get(key);
+
+    // Prevent the record from being evicted while we're using it.
+    boost_atomic::atomic_inc32(&record.m_owners);
+
+    if (record.m_state == TileRecord::Unloaded)
+    {
+        // We're the first thread to request this tile: load it without holding the lock.
+        record.m_state = TileRecord::Loading;
+        lock.unlock();
+
+        Tile* tile =
+            key.m_level == 0
+                ? m_tile_swapper.load_tile(key)
+                : generate_mip_tile(key);
+
+        m_tile_swapper.track_loaded_tile(*tile);
+
+        lock.lock();
+        record.m_tile = tile;
+        record.m_state = TileRecord::Loaded;
+        shard.m_tile_loaded.notify_all();
+    }
+    else if (record.m_state == TileRecord::Loading)
+    {
+        // Another thread is loading this tile: wait until it's ready.
+        ++shard.m_wait_count;
+
+        while (record.m_state != TileRecord::Loaded)
+            shard.m_tile_loaded.wait(lock);
+    }
+
+    return record;
 }
 
 StatisticsVector TextureStore::get_statistics() const
 {
-    Statistics stats = make_single_stage_cache_stats(m_tile_cache);
+    uint64 hit_count = 0;
+    uint64 miss_count = 0;
+    uint64 contention_count = 0;
+    uint64 wait_count = 0;
+
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        Shard& shard = *m_shards[i];
+        boost::mutex::scoped_lock lock(shard.m_mutex);
+
+        hit_count += shard.m_tile_cache.get_hit_count();
+        miss_count += shard.m_tile_cache.get_miss_count();
+        contention_count += shard.m_contention_count;
+        wait_count += shard.m_wait_count;
+    }
+
+    const uint64 request_count = hit_count + miss_count;
+
+    Statistics stats;
+    stats.insert("shards", static_cast<size_t>(ShardCount));
+    stats.insert("hits", hit_count);
+    stats.insert("misses", miss_count);
+    stats.insert_percent("hit rate", hit_count, request_count);
+    stats.insert_percent("lock contention", contention_count, request_count);
+    stats.insert_percent("waits on loading", wait_count, request_count);
     stats.insert_size("peak size", m_tile_swapper.get_peak_memory_size());
 
     return StatisticsVector::make("texture store statistics", stats);
 }
 
+TextureStore::Shard& TextureStore::get_shard(const TileKey& key)
+{
+    const uint32 h =
+        mix_uint32(
+            hash_uint64_to_uint32(key.m_assembly_uid),
+            hash_uint64_to_uint32(key.m_texture_uid),
+            key.m_tile_xy,
+            key.m_level);
+
+    return *m_shards[h % ShardCount];
+}
+
+Tile* TextureStore::generate_mip_tile(const TileKey& key)
+{
+    assert(key.m_level > 0);
+
+    const CanvasProperties& texture_props = m_tile_swapper.get_texture(key)->properties();
+    const CanvasProperties parent_props = texture_props.get_mip_level_properties(key.m_level - 1);
+    const CanvasProperties props = texture_props.get_mip_level_properties(key.m_level);
+
+    const size_t tile_x = key.get_tile_x();
+    const size_t tile_y = key.get_tile_y();
+    const size_t tile_width = props.get_tile_width(tile_x);
+    const size_t tile_height = props.get_tile_height(tile_y);
+    const size_t origin_x = tile_x * props.m_tile_width;
+    const size_t origin_y = tile_y * props.m_tile_height;
+
+    // Range of tiles of the previous level covered by this tile (at most 2x2 tiles).
+    const size_t max_parent_x = parent_props.m_canvas_width - 1;
+    const size_t max_parent_y = parent_props.m_canvas_height - 1;
+    const size_t parent_tile_x0 = min(2 * origin_x, max_parent_x) / parent_props.m_tile_width;
+    const size_t parent_tile_y0 = min(2 * origin_y, max_parent_y) / parent_props.m_tile_height;
+    const size_t parent_tile_x1 = min(2 * (origin_x + tile_width) - 1, max_parent_x) / parent_props.m_tile_width;
+    const size_t parent_tile_y1 = min(2 * (origin_y + tile_height) - 1, max_parent_y) / parent_props.m_tile_height;
+    assert(parent_tile_x1 - parent_tile_x0 < 2);
+    assert(parent_tile_y1 - parent_tile_y0 < 2);
+
+    // Acquire the tiles of the previous level.
+    TileRecord* parents[2][2] = { { 0, 0 }, { 0, 0 } };
+    for (size_t py = parent_tile_y0; py <= parent_tile_y1; ++py)
+    {
+        for (size_t px = parent_tile_x0; px <= parent_tile_x1; ++px)
+        {
+            parents[py - parent_tile_y0][px - parent_tile_x0] =
+                &acquire(
+                    TileKey(
+                        key.m_assembly_uid,
+                        key.m_texture_uid,
+                        px, py,
+                        key.m_level - 1));
+        }
+    }
+
+    Tile* tile =
+        new Tile(
+            tile_width,
+            tile_height,
+            props.m_channel_count,
+            props.m_pixel_format);
+
+    // Downsample the previous level with a box filter.
+    for (size_t y = 0; y < tile_height; ++y)
+    {
+        for (size_t x = 0; x < tile_width; ++x)
+        {
+            Color4f sum(0.0f);
+
+            for (size_t j = 0; j < 2; ++j)
+            {
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    const size_t ix = min(2 * (origin_x + x) + i, max_parent_x);
+                    const size_t iy = min(2 * (origin_y + y) + j, max_parent_y);
+                    const size_t ptx = ix / parent_props.m_tile_width;
+                    const size_t pty = iy / parent_props.m_tile_height;
+
+                    const Tile& parent = *parents[pty - parent_tile_y0][ptx - parent_tile_x0]->m_tile;
+                    const size_t pixel_x = ix - ptx * parent_props.m_tile_width;
+                    const size_t pixel_y = iy - pty * parent_props.m_tile_height;
+
+                    Color4f color;
+                    if (props.m_channel_count == 3)
+                    {
+                        Color3f rgb;
+                        parent.get_pixel(pixel_x, pixel_y, rgb);
+                        color = Color4f(rgb[0], rgb[1], rgb[2], 1.0f);
+                    }
+                    else parent.get_pixel(pixel_x, pixel_y, color);
+
+                    sum += color;
+                }
+            }
+
+            sum *= 0.25f;
+
+            if (props.m_channel_count == 3)
+                tile->set_pixel(x, y, sum.rgb());
+            else tile->set_pixel(x, y, sum);
+        }
+    }
+
+    // Release the tiles of the previous level.
+    for (size_t py = 0; py < 2; ++py)
+    {
+        for (size_t px = 0; px < 2; ++px)
+        {
+            if (parents[py][px])
+                release(*parents[py][px]);
+        }
+    }
+
+    return tile;
+}
+
+
+//
+// TextureStore::Shard class implementation.
+//
+
+TextureStore::Shard::Shard(TileSwapper& tile_swapper)
+  : m_tile_cache(tile_swapper)
+  , m_contention_count(0)
+  , m_wait_count(0)
+{
+}
+
 
 //
 // TextureStore::TileSwapper class implementation.
@@ -156,14 +362,17 @@ TextureStore::TileSwapper::TileSwapper(
 
 void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
 {
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == ~0
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    record.m_tile = 0;
+    record.m_owners = 0;
+    record.m_state = TileRecord::Unloaded;
+}
+
+Tile* TextureStore::TileSwapper::load_tile(const TileKey& key)
+{
+    assert(key.m_level == 0);
 
     // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    Texture* texture = get_texture(key);
 
     if (m_params.m_track_tile_loading)
     {
@@ -176,8 +385,7 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
     }
 
     // Load the tile.
-    record.m_tile = texture->load_tile(key.get_tile_x(), key.get_tile_y());
-    record.m_owners = 0;
+    Tile* tile = texture->load_tile(key.get_tile_x(), key.get_tile_y());
 
     // Convert the tile to the linear RGB color space.
     switch (texture->get_color_space())
@@ -186,18 +394,25 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
         break;
 
       case ColorSpaceSRGB:
-        convert_tile_srgb_to_linear_rgb(*record.m_tile);
+        convert_tile_srgb_to_linear_rgb(*tile);
         break;
 
       case ColorSpaceCIEXYZ:
-        convert_tile_ciexyz_to_linear_rgb(*record.m_tile);
+        convert_tile_ciexyz_to_linear_rgb(*tile);
         break;
 
       assert_otherwise;
     }
 
+    return tile;
+}
+
+void TextureStore::TileSwapper::track_loaded_tile(const Tile& tile)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
     // Track the amount of memory used by the tile cache.
-    m_memory_size += record.m_tile->get_memory_size();
+    m_memory_size += tile.get_memory_size();
     m_peak_memory_size = max(m_peak_memory_size, m_memory_size);
 
     if (m_params.m_track_store_size)
@@ -223,36 +438,39 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
 
 bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
 {
-    // Cannot unload tiles that are still in use.
+    // Cannot unload tiles that are still in use or not yet loaded.
     if (boost_atomic::atomic_read32(&record.m_owners) > 0)
         return false;
 
-    // Track the amount of memory used by the tile cache.
-    const size_t tile_memory_size = record.m_tile->get_memory_size();
-    assert(m_memory_size >= tile_memory_size);
-    m_memory_size -= tile_memory_size;
+    if (record.m_state != TileRecord::Loaded)
+        return false;
 
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == ~0
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    // Track the amount of memory used by the tile cache.
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        const size_t tile_memory_size = record.m_tile->get_memory_size();
+        assert(m_memory_size >= tile_memory_size);
+        m_memory_size -= tile_memory_size;
+    }
 
     // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    Texture* texture = get_texture(key);
 
     if (m_params.m_track_tile_unloading)
     {
         RENDERER_LOG_DEBUG(
             "unloading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") "
-            "from texture \"%s\"...",
+            "of level %u from texture \"%s\"...",
             key.get_tile_x(),
             key.get_tile_y(),
+            key.m_level,
             texture->get_name());
     }
 
-    // Unload the tile.
-    texture->unload_tile(key.get_tile_x(), key.get_tile_y(), record.m_tile);
+    // Unload the tile. Tiles of the other levels were generated by the store.
+    if (key.m_level == 0)
+        texture->unload_tile(key.get_tile_x(), key.get_tile_y(), record.m_tile);
+    else delete record.m_tile;
 
     // Successfully unloaded the tile.
     return true;
@@ -267,6 +485,19 @@ void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assem
     }
 }
 
+Texture* TextureStore::TileSwapper::get_texture(const TileKey& key) const
+{
+    // Fetch the texture container. The assembly map is not modified after
+    // construction, so it may be safely searched from multiple threads.
+    const TextureContainer& textures =
+        key.m_assembly_uid == ~0
+            ? m_scene.textures()
+            : m_assemblies.find(key.m_assembly_uid)->second->textures();
+
+    // Fetch the texture.
+    return textures.get_by_uid(key.m_texture_uid);
+}
+
 
 //
 // TextureStore::TileSwapper::Parameters class implementation.
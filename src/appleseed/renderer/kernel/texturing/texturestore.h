@@ -42,6 +42,8 @@
 
 // boost headers.
 #include "boost/cstdint.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
 
 // Standard headers.
 #include <cassert>
@@ -54,6 +56,7 @@ namespace foundation    { class Tile; }
 namespace renderer      { class Assemblies; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class Scene; }
+namespace renderer      { class Texture; }
 
 namespace renderer
 {
@@ -61,6 +64,14 @@ namespace renderer
 //
 // A shared store for texture tiles (the backend of the thread-local texture cache).
 //
+// Tiles of the levels of the MIP pyramid of a texture (other than the base level) are
+// generated on demand by downsampling tiles of the previous level, which are themselves
+// retrieved from the store.
+//
+// Tiles are distributed over a number of shards, each with its own lock and LRU cache.
+// Tiles are decoded outside of any lock: threads requesting a tile that is being loaded
+// by another thread wait for that tile only, while other requests proceed concurrently.
+//
 
 class TextureStore
   : public foundation::NonCopyable
@@ -72,6 +83,7 @@ class TextureStore
         foundation::UniqueID    m_assembly_uid;
         foundation::UniqueID    m_texture_uid;
         foundation::uint32      m_tile_xy;
+        foundation::uint32      m_level;            // level in the MIP pyramid of the texture
 
         TileKey();
 
@@ -79,7 +91,8 @@ class TextureStore
             const foundation::UniqueID  assembly_uid,
             const foundation::UniqueID  texture_uid,
             const size_t                tile_x,
-            const size_t                tile_y);
+            const size_t                tile_y,
+            const size_t                level = 0);
 
         TileKey(
             const foundation::UniqueID  assembly_uid,
@@ -102,8 +115,16 @@ class TextureStore
 
     struct TileRecord
     {
+        enum State
+        {
+            Unloaded,                           // the tile has not been loaded yet
+            Loading,                            // the tile is being loaded by some thread
+            Loaded                              // the tile is ready to be used
+        };
+
         foundation::Tile*           m_tile;
         volatile boost::uint32_t    m_owners;
+        State                       m_state;    // only accessed while holding the lock of the shard
     };
 
     // Constructor.
@@ -111,6 +132,9 @@ class TextureStore
         const Scene&        scene,
         const ParamArray&   params = ParamArray());
 
+    // Destructor.
+    ~TextureStore();
+
     // Acquire an element from the cache. Thread-safe.
     TileRecord& acquire(const TileKey& key);
 
@@ -130,15 +154,24 @@ class TextureStore
             const Scene&        scene,
             const ParamArray&   params);
 
-        // Load a cache line.
+        // Load a cache line. The tile itself is loaded later by load_tile().
         void load(const TileKey& key, TileRecord& record);
 
-        // Unload a cache line.
+        // Unload a cache line. Thread-safe.
         bool unload(const TileKey& key, TileRecord& record);
 
-        // Return true if the cache is full, false otherwise.
+        // Return true if the cache is full, false otherwise. Thread-safe.
         bool is_full(const size_t element_count) const;
 
+        // Load a tile of the base level of a texture. Thread-safe.
+        foundation::Tile* load_tile(const TileKey& key);
+
+        // Account for a tile that was just loaded or generated. Thread-safe.
+        void track_loaded_tile(const foundation::Tile& tile);
+
+        // Retrieve the texture a tile belongs to. Thread-safe.
+        Texture* get_texture(const TileKey& key) const;
+
         // Return the peak memory size in bytes of the tile cache.
         size_t get_peak_memory_size() const;
 
@@ -155,11 +188,12 @@ class TextureStore
 
         typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
 
-        const Scene&        m_scene;
-        const Parameters    m_params;
-        size_t              m_memory_size;
-        size_t              m_peak_memory_size;
-        AssemblyMap         m_assemblies;
+        const Scene&            m_scene;
+        const Parameters        m_params;
+        mutable boost::mutex    m_mutex;
+        size_t                  m_memory_size;
+        size_t                  m_peak_memory_size;
+        AssemblyMap             m_assemblies;
 
         void gather_assemblies(const AssemblyContainer& assemblies);
     };
@@ -170,9 +204,27 @@ class TextureStore
         TileSwapper
     > TileCache;
 
-    boost::mutex    m_mutex;
+    struct Shard
+      : public foundation::NonCopyable
+    {
+        boost::mutex                m_mutex;
+        boost::condition_variable   m_tile_loaded;
+        TileCache                   m_tile_cache;
+        foundation::uint64          m_contention_count;     // number of times the lock of this shard was contended
+        foundation::uint64          m_wait_count;           // number of times a thread waited for a tile being loaded
+
+        explicit Shard(TileSwapper& tile_swapper);
+    };
+
+    enum { ShardCount = 16 };
+
     TileSwapper     m_tile_swapper;
-    TileCache       m_tile_cache;
+    Shard*          m_shards[ShardCount];
+
+    Shard& get_shard(const TileKey& key);
+
+    // Generate a tile of a level of the MIP pyramid of a texture from the previous level.
+    foundation::Tile* generate_mip_tile(const TileKey& key);
 };
 
 
@@ -180,17 +232,6 @@ class TextureStore
 // TextureStore class implementation.
 //
 
-inline TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
-{
-    boost::mutex::scoped_lock lock(m_mutex);
-
-    TileRecord& record = m_tile_cache.get(key);
-
-    boost_atomic::atomic_inc32(&record.m_owners);
-
-    return record;
-}
-
 inline void TextureStore::release(TileRecord& record) const
 {
     assert(boost_atomic::atomic_read32(&record.m_owners) > 0);
@@ -211,10 +252,12 @@ inline TextureStore::TileKey::TileKey(
     const foundation::UniqueID  assembly_uid,
     const foundation::UniqueID  texture_uid,
     const size_t                tile_x,
-    const size_t                tile_y)
+    const size_t                tile_y,
+    const size_t                level)
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(static_cast<foundation::uint32>((tile_y << 16) | tile_x))
+  , m_level(static_cast<foundation::uint32>(level))
 {
     assert(tile_x < (1UL << 16));
     assert(tile_y < (1UL << 16));
@@ -227,6 +270,7 @@ inline TextureStore::TileKey::TileKey(
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(tile_xy)
+  , m_level(0)
 {
 }
 
@@ -234,6 +278,7 @@ inline TextureStore::TileKey::TileKey(const TileKey& rhs)
   : m_assembly_uid(rhs.m_assembly_uid)
   , m_texture_uid(rhs.m_texture_uid)
   , m_tile_xy(rhs.m_tile_xy)
+  , m_level(rhs.m_level)
 {
 }
 
@@ -249,13 +294,16 @@ inline size_t TextureStore::TileKey::get_tile_y() const
 
 inline TextureStore::TileKey TextureStore::TileKey::invalid()
 {
-    return TileKey(~0, ~0, ~0);
+    TileKey key(~0, ~0, ~0U);
+    key.m_level = ~0U;
+    return key;
 }
 
 inline bool TextureStore::TileKey::operator==(const TileKey& rhs) const
 {
     return
         m_tile_xy == rhs.m_tile_xy &&
+        m_level == rhs.m_level &&
         m_texture_uid == rhs.m_texture_uid &&
         m_assembly_uid == rhs.m_assembly_uid;
 }
@@ -270,7 +318,9 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
     return
         m_assembly_uid == rhs.m_assembly_uid ?
             m_texture_uid == rhs.m_texture_uid ?
-                m_tile_xy < rhs.m_tile_xy :
+                m_level == rhs.m_level ?
+                    m_tile_xy < rhs.m_tile_xy :
+                m_level < rhs.m_level :
             m_texture_uid < rhs.m_texture_uid :
         m_assembly_uid < rhs.m_assembly_uid;
 }
@@ -282,11 +332,15 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
 
 inline bool TextureStore::TileSwapper::is_full(const size_t element_count) const
 {
+    boost::mutex::scoped_lock lock(m_mutex);
+
     return m_memory_size >= m_params.m_memory_limit;
 }
 
 inline size_t TextureStore::TileSwapper::get_peak_memory_size() const
 {
+    boost::mutex::scoped_lock lock(m_mutex);
+
     return m_peak_memory_size;
 }
 
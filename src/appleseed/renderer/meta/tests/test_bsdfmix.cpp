@@ -48,6 +48,7 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/memory.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
@@ -147,14 +148,18 @@ TEST_SUITE(Renderer_Modeling_BSDF_BSDFMix)
         EXPECT_EQ(0.2, get_value<double>(input_evaluator, 16));
         EXPECT_EQ(0.8, get_value<double>(input_evaluator, 24));
 
+        // Size of the inputs of a Lambertian BRDF (reflectance and reflectance multiplier).
+        const size_t LambertianInputSize =
+            align(sizeof(Spectrum) + sizeof(Alpha), sizeof(double)) + sizeof(double);
+
         // child0_child0_bsdf reflectance.
         EXPECT_EQ(Spectrum(0.5f), get_value<Spectrum>(input_evaluator, 32));
 
         // child0_child1_bsdf reflectance.
-        EXPECT_EQ(Spectrum(0.1f), get_value<Spectrum>(input_evaluator, 176));
+        EXPECT_EQ(Spectrum(0.1f), get_value<Spectrum>(input_evaluator, 32 + LambertianInputSize));
 
         // child1_bsdf reflectance.
-        EXPECT_EQ(Spectrum(1.0f), get_value<Spectrum>(input_evaluator, 320));
+        EXPECT_EQ(Spectrum(1.0f), get_value<Spectrum>(input_evaluator, 32 + 2 * LambertianInputSize));
 
         scene.on_frame_end(project.ref());
     }
@@ -0,0 +1,286 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionfilter.h"
+#include "renderer/kernel/intersection/trianglekey.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/textureinstance.h"
+#include "renderer/modeling/surfaceshader/constantsurfaceshader.h"
+#include "renderer/modeling/surfaceshader/surfaceshader.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Intersection_IntersectionFilter)
+{
+    enum AlphaPattern
+    {
+        AlphaPatternOpaque,
+        AlphaPatternTransparent,
+        AlphaPatternLeftHalfOpaque
+    };
+
+    // A 32x32 texture whose luminance is used as an alpha map.
+    class AlphaTexture
+      : public Texture
+    {
+      public:
+        AlphaTexture(const char* name, const AlphaPattern pattern)
+          : Texture(name, ParamArray())
+          , m_props(
+                32, 32,
+                32, 32,
+                3,
+                PixelFormatFloat)
+        {
+            m_tile.reset(
+                new Tile(
+                    m_props.m_canvas_width,
+                    m_props.m_canvas_height,
+                    m_props.m_channel_count,
+                    m_props.m_pixel_format));
+
+            for (size_t y = 0; y < m_props.m_canvas_height; ++y)
+            {
+                for (size_t x = 0; x < m_props.m_canvas_width; ++x)
+                {
+                    const bool opaque =
+                        pattern == AlphaPatternOpaque ||
+                        (pattern == AlphaPatternLeftHalfOpaque && x < m_props.m_canvas_width / 2);
+
+                    m_tile->set_pixel(x, y, Color3f(opaque ? 1.0f : 0.0f));
+                }
+            }
+        }
+
+        virtual void release() OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual const char* get_model() const OVERRIDE
+        {
+            return "alpha_texture";
+        }
+
+        virtual ColorSpace get_color_space() const OVERRIDE
+        {
+            return ColorSpaceLinearRGB;
+        }
+
+        virtual const CanvasProperties& properties() OVERRIDE
+        {
+            return m_props;
+        }
+
+        virtual Tile* load_tile(
+            const size_t    tile_x,
+            const size_t    tile_y) OVERRIDE
+        {
+            return m_tile.get();
+        }
+
+        virtual void unload_tile(
+            const size_t    tile_x,
+            const size_t    tile_y,
+            const Tile*     tile) OVERRIDE
+        {
+        }
+
+      private:
+        const CanvasProperties  m_props;
+        auto_ptr<Tile>          m_tile;
+    };
+
+    struct Fixture
+      : public TestFixtureBase
+    {
+        // Indices of the triangles of the test object.
+        enum
+        {
+            LeftTriangle,           // only covers the left half of the UV space
+            RightTriangle,          // only covers the right half of the UV space
+            CenterTriangle          // straddles both halves of the UV space
+        };
+
+        auto_ptr<TextureStore>          m_texture_store;
+        auto_ptr<TextureCache>          m_texture_cache;
+        auto_ptr<IntersectionFilter>    m_filter;
+
+        void create_filter(const AlphaPattern pattern)
+        {
+            m_scene.textures().insert(
+                auto_release_ptr<Texture>(
+                    new AlphaTexture("texture", pattern)));
+
+            ParamArray texture_instance_params;
+            texture_instance_params.insert("addressing_mode", "clamp");
+            texture_instance_params.insert("filtering_mode", "nearest");
+            texture_instance_params.insert("alpha_mode", "luminance");
+            m_scene.texture_instances().insert(
+                TextureInstanceFactory::create("texture_instance", texture_instance_params, "texture"));
+
+            create_color_entity("white", Color3f(1.0f));
+
+            ParamArray surface_shader_params;
+            surface_shader_params.insert("color", "white");
+            m_assembly.surface_shaders().insert(
+                ConstantSurfaceShaderFactory().create("surface_shader", surface_shader_params));
+
+            ParamArray material_params;
+            material_params.insert("surface_shader", "surface_shader");
+            material_params.insert("alpha_map", "texture_instance");
+            m_assembly.materials().insert(
+                GenericMaterialFactory().create("material", material_params));
+
+            create_object();
+
+            bind_inputs();
+
+            MaterialArray materials;
+            materials.push_back(m_assembly.materials().get_by_name("material"));
+
+            m_texture_store.reset(new TextureStore(m_scene));
+            m_texture_cache.reset(new TextureCache(*m_texture_store));
+            m_filter.reset(
+                new IntersectionFilter(
+                    *m_assembly.objects().get_by_name("object"),
+                    materials,
+                    *m_texture_cache));
+        }
+
+        void create_object()
+        {
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory::create("object", ParamArray()));
+
+            push_triangle(mesh_object.ref(), 0.05f, 0.4f);
+            push_triangle(mesh_object.ref(), 0.6f, 0.95f);
+            push_triangle(mesh_object.ref(), 0.25f, 0.75f);
+
+            m_assembly.objects().insert(auto_release_ptr<Object>(mesh_object));
+        }
+
+        // Push a triangle spanning [u0, u1] in U and [0.1, 0.9] in V.
+        static void push_triangle(MeshObject& mesh_object, const float u0, const float u1)
+        {
+            const size_t base = mesh_object.get_vertex_count();
+
+            mesh_object.push_vertex(GVector3(u0, 0.1f, 0.0f));
+            mesh_object.push_vertex(GVector3(u1, 0.1f, 0.0f));
+            mesh_object.push_vertex(GVector3(u0, 0.9f, 0.0f));
+
+            mesh_object.push_tex_coords(GVector2(u0, 0.1f));
+            mesh_object.push_tex_coords(GVector2(u1, 0.1f));
+            mesh_object.push_tex_coords(GVector2(u0, 0.9f));
+
+            mesh_object.push_triangle(
+                Triangle(
+                    base + 0, base + 1, base + 2,
+                    Triangle::None, Triangle::None, Triangle::None,
+                    base + 0, base + 1, base + 2,
+                    0));
+        }
+
+        static TriangleKey make_key(const size_t triangle_index)
+        {
+            return TriangleKey(0, 0, triangle_index, 0);
+        }
+    };
+
+    TEST_CASE_F(Constructor_GivenOpaqueAlphaMap_DiscardsAlphaMask, Fixture)
+    {
+        create_filter(AlphaPatternOpaque);
+
+        EXPECT_FALSE(m_filter->has_alpha_masks());
+    }
+
+    TEST_CASE_F(Constructor_GivenTransparentAlphaMap_ClassifiesAllTrianglesAsTransparent, Fixture)
+    {
+        create_filter(AlphaPatternTransparent);
+
+        ASSERT_TRUE(m_filter->has_alpha_masks());
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            EXPECT_TRUE(m_filter->is_transparent(make_key(i)));
+            EXPECT_FALSE(m_filter->accept(make_key(i), 0.25, 0.25));
+        }
+    }
+
+    TEST_CASE_F(Constructor_GivenHalfOpaqueAlphaMap_ClassifiesTrianglesByCoverage, Fixture)
+    {
+        create_filter(AlphaPatternLeftHalfOpaque);
+
+        ASSERT_TRUE(m_filter->has_alpha_masks());
+
+        // Opaque triangle: accepted everywhere.
+        EXPECT_FALSE(m_filter->is_transparent(make_key(LeftTriangle)));
+        EXPECT_TRUE(m_filter->accept(make_key(LeftTriangle), 0.1, 0.1));
+        EXPECT_TRUE(m_filter->accept(make_key(LeftTriangle), 0.9, 0.05));
+
+        // Transparent triangle: skipped.
+        EXPECT_TRUE(m_filter->is_transparent(make_key(RightTriangle)));
+        EXPECT_FALSE(m_filter->accept(make_key(RightTriangle), 0.1, 0.1));
+
+        // Mixed triangle: accepted only on the opaque half of the alpha map.
+        EXPECT_FALSE(m_filter->is_transparent(make_key(CenterTriangle)));
+        EXPECT_TRUE(m_filter->accept(make_key(CenterTriangle), 0.1, 0.1));     // u = 0.3
+        EXPECT_FALSE(m_filter->accept(make_key(CenterTriangle), 0.9, 0.05));   // u = 0.7
+    }
+}
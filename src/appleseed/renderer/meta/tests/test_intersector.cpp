@@ -35,7 +35,9 @@
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/kernel/texturing/texturecache.h"
 #include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
 #include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/containers.h"
@@ -139,4 +141,164 @@ TEST_SUITE(Renderer_Kernel_Intersection_Intersector)
 
         EXPECT_FALSE(hit);
     }
+
+    struct SceneWithPlane
+    {
+        auto_release_ptr<Scene> m_scene;
+        AssemblyInstance*       m_assembly_instance;
+
+        SceneWithPlane()
+          : m_scene(SceneFactory::create())
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory::create("assembly", ParamArray()));
+
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory::create("plane", ParamArray()));
+            mesh_object->push_vertex(GVector3(-1.0f, -1.0f, 0.0f));
+            mesh_object->push_vertex(GVector3(+1.0f, -1.0f, 0.0f));
+            mesh_object->push_vertex(GVector3(+1.0f, +1.0f, 0.0f));
+            mesh_object->push_vertex(GVector3(-1.0f, +1.0f, 0.0f));
+            mesh_object->push_vertex_normal(GVector3(0.0f, 0.0f, 1.0f));
+            mesh_object->push_tex_coords(GVector2(0.0f, 0.0f));
+            mesh_object->push_tex_coords(GVector2(1.0f, 0.0f));
+            mesh_object->push_tex_coords(GVector2(1.0f, 1.0f));
+            mesh_object->push_tex_coords(GVector2(0.0f, 1.0f));
+            mesh_object->push_triangle(Triangle(0, 1, 2, 0, 0, 0, 0, 1, 2, Triangle::None));
+            mesh_object->push_triangle(Triangle(2, 3, 0, 0, 0, 0, 2, 3, 0, Triangle::None));
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "plane_instance",
+                    ParamArray(),
+                    "plane",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            m_scene->assembly_instances().insert(
+                auto_release_ptr<AssemblyInstance>(
+                    AssemblyInstanceFactory::create(
+                        "assembly_instance",
+                        ParamArray(),
+                        "assembly")));
+            m_assembly_instance = m_scene->assembly_instances().get_by_name("assembly_instance");
+
+            m_scene->assemblies().insert(assembly);
+        }
+    };
+
+    struct SceneWithPlaneFixture
+      : public BindInputs<SceneWithPlane>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+
+        SceneWithPlaneFixture()
+          : m_trace_context(m_scene.ref())
+          , m_texture_store(m_scene.ref())
+          , m_texture_cache(m_texture_store)
+        {
+        }
+    };
+
+    TEST_CASE_F(Trace_GivenAssemblyInstanceMovedAndTraceContextUpdated_HitsMovedGeometry, SceneWithPlaneFixture)
+    {
+        m_assembly_instance->transform_sequence().set_transform(
+            0.0, Transformd::from_local_to_parent(Matrix4d::translation(Vector3d(0.0, 0.0, -1.0))));
+        m_assembly_instance->bump_version_id();
+        m_trace_context.update();
+
+        const ShadingRay ray(
+            Vector3d(0.0, 0.0, 2.0),
+            Vector3d(0.0, 0.0, -1.0),
+            0.0,
+            10.0,
+            0.0,
+            ShadingRay::CameraRay);
+
+        Intersector intersector(m_trace_context, m_texture_cache);
+        ShadingPoint shading_point;
+        const bool hit = intersector.trace(ray, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(3.0, shading_point.get_distance());
+    }
+
+    TEST_CASE_F(Trace_GivenAssemblyInstanceMovedWithoutVersionBumpAndTraceContextUpdated_HitsMovedGeometry, SceneWithPlaneFixture)
+    {
+        m_assembly_instance->transform_sequence().set_transform(
+            0.0, Transformd::from_local_to_parent(Matrix4d::translation(Vector3d(0.0, 0.0, -1.0))));
+        m_trace_context.update();
+
+        const ShadingRay ray(
+            Vector3d(0.0, 0.0, 2.0),
+            Vector3d(0.0, 0.0, -1.0),
+            0.0,
+            10.0,
+            0.0,
+            ShadingRay::CameraRay);
+
+        Intersector intersector(m_trace_context, m_texture_cache);
+        ShadingPoint shading_point;
+        const bool hit = intersector.trace(ray, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(3.0, shading_point.get_distance());
+    }
+
+    TEST_CASE_F(Trace_GivenAssemblyInstanceAddedAndTraceContextUpdated_HitsNewInstance, SceneWithPlaneFixture)
+    {
+        // Adding an assembly instance changes the set of items: the assembly tree is rebuilt instead of being refit.
+        m_scene->assembly_instances().insert(
+            AssemblyInstanceFactory::create(
+                "assembly_instance2",
+                ParamArray(),
+                "assembly"));
+        AssemblyInstance* assembly_instance2 = m_scene->assembly_instances().get_by_name("assembly_instance2");
+        assembly_instance2->transform_sequence().set_transform(
+            0.0, Transformd::from_local_to_parent(Matrix4d::translation(Vector3d(5.0, 0.0, -1.0))));
+        assembly_instance2->bind_assembly(m_scene->assemblies());
+        m_trace_context.update();
+
+        const ShadingRay ray(
+            Vector3d(5.0, 0.0, 2.0),
+            Vector3d(0.0, 0.0, -1.0),
+            0.0,
+            10.0,
+            0.0,
+            ShadingRay::CameraRay);
+
+        Intersector intersector(m_trace_context, m_texture_cache);
+        ShadingPoint shading_point;
+        const bool hit = intersector.trace(ray, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(3.0, shading_point.get_distance());
+        EXPECT_EQ(assembly_instance2, &shading_point.get_assembly_instance());
+    }
+
+    TEST_CASE_F(GetUVDerivatives_GivenRayDifferentialsHittingPlane_ReturnsVariationsOfTextureCoordinates, SceneWithPlaneFixture)
+    {
+        ShadingRay ray(
+            Vector3d(0.0, 0.0, 2.0),
+            Vector3d(0.0, 0.0, -1.0),
+            0.0,
+            10.0,
+            0.0,
+            ShadingRay::CameraRay);
+        ray.m_has_differentials = true;
+        ray.m_rx = ShadingRay::RayType(Vector3d(0.1, 0.0, 2.0), Vector3d(0.0, 0.0, -1.0));
+        ray.m_ry = ShadingRay::RayType(Vector3d(0.0, 0.1, 2.0), Vector3d(0.0, 0.0, -1.0));
+
+        Intersector intersector(m_trace_context, m_texture_cache);
+        ShadingPoint shading_point;
+        const bool hit = intersector.trace(ray, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(Vector2d(0.5, 0.5), shading_point.get_uv(0));
+        EXPECT_FEQ(Vector2d(0.05, 0.0), shading_point.get_duvdx(0));
+        EXPECT_FEQ(Vector2d(0.0, 0.05), shading_point.get_duvdy(0));
+    }
 }
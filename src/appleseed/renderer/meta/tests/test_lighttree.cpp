@@ -0,0 +1,130 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lighttree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightTree)
+{
+    LightTree::Item make_item(
+        const Vector3d&     center,
+        const Vector3d&     normal,
+        const double        power)
+    {
+        LightTree::Item item;
+        item.m_bbox = AABB3d(center - Vector3d(0.1), center + Vector3d(0.1));
+        item.m_axis = normal;
+        item.m_cone_angle = 0.0;
+        item.m_power = power;
+        return item;
+    }
+
+    TEST_CASE(Sample_GivenSingleEmitter_ReturnsEmitterWithProbabilityOne)
+    {
+        vector<LightTree::Item> items;
+        items.push_back(make_item(Vector3d(0.0, 1.0, 0.0), Vector3d(0.0, -1.0, 0.0), 1.0));
+
+        LightTree tree;
+        tree.build(items);
+
+        double prob;
+        const size_t item_index = tree.sample(Vector3d(0.0), 0.5, prob);
+
+        EXPECT_EQ(0, item_index);
+        EXPECT_EQ(1.0, prob);
+    }
+
+    TEST_CASE(Sample_GivenEmitterFacingAwayFromPoint_NeverReturnsIt)
+    {
+        vector<LightTree::Item> items;
+        items.push_back(make_item(Vector3d(0.0, 1.0, 0.0), Vector3d(0.0, -1.0, 0.0), 1.0));
+        items.push_back(make_item(Vector3d(0.0, 2.0, 0.0), Vector3d(0.0, 1.0, 0.0), 1.0));
+
+        LightTree tree;
+        tree.build(items);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            double prob;
+            const size_t item_index = tree.sample(Vector3d(0.0), i / 16.0, prob);
+
+            EXPECT_EQ(0, item_index);
+            EXPECT_EQ(1.0, prob);
+        }
+
+        EXPECT_EQ(0.0, tree.evaluate_pdf(Vector3d(0.0), 1));
+    }
+
+    TEST_CASE(EvaluatePDF_MatchesProbabilityReturnedBySample)
+    {
+        vector<LightTree::Item> items;
+        for (size_t i = 0; i < 10; ++i)
+        {
+            const double x = static_cast<double>(i);
+            items.push_back(
+                make_item(
+                    Vector3d(x, 3.0 + 0.5 * x, -x),
+                    normalize(Vector3d(0.2 * x - 1.0, -1.0, 0.1 * x)),
+                    1.0 + x));
+        }
+
+        LightTree tree;
+        tree.build(items);
+
+        const Vector3d point(2.0, 0.0, -1.0);
+
+        double pdf_sum = 0.0;
+        for (size_t i = 0; i < items.size(); ++i)
+            pdf_sum += tree.evaluate_pdf(point, i);
+
+        EXPECT_FEQ(1.0, pdf_sum);
+
+        for (size_t i = 0; i < 64; ++i)
+        {
+            double prob;
+            const size_t item_index = tree.sample(point, i / 64.0, prob);
+
+            EXPECT_FEQ(tree.evaluate_pdf(point, item_index), prob);
+        }
+    }
+}
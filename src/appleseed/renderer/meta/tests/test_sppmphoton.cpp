@@ -0,0 +1,144 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SPPM_SPPMPhotonVector)
+{
+    void make_photons(
+        SPPMPhotonVector&   photons,
+        const size_t        begin,
+        const size_t        end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            SPPMPhoton photon;
+            photon.m_position = Vector3f(static_cast<float>(i), 0.0f, 0.0f);
+            photon.m_data.m_flux.set(static_cast<float>(i));
+            photons.push_back(photon);
+        }
+    }
+
+    bool contains_photons(
+        const SPPMPhotonVector& photons,
+        const size_t            count)
+    {
+        if (photons.size() != count)
+            return false;
+
+        vector<float> values;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (photons.m_positions[i].x != photons.m_data[i].m_flux[0])
+                return false;
+
+            values.push_back(photons.m_positions[i].x);
+        }
+
+        sort(values.begin(), values.end());
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (values[i] != static_cast<float>(i))
+                return false;
+        }
+
+        return true;
+    }
+
+    TEST_CASE(Append_GivenEnoughCapacity_CollectsAllPhotons)
+    {
+        SPPMPhotonVector photons;
+        photons.begin_collection(10);
+
+        SPPMPhotonVector local_photons1;
+        make_photons(local_photons1, 0, 3);
+        photons.append(local_photons1);
+
+        SPPMPhotonVector local_photons2;
+        make_photons(local_photons2, 3, 7);
+        photons.append(local_photons2);
+
+        photons.end_collection();
+
+        EXPECT_TRUE(contains_photons(photons, 7));
+    }
+
+    TEST_CASE(Append_GivenInsufficientCapacity_CollectsAllPhotons)
+    {
+        SPPMPhotonVector photons;
+        photons.begin_collection(4);
+
+        SPPMPhotonVector local_photons1;
+        make_photons(local_photons1, 0, 3);
+        photons.append(local_photons1);
+
+        SPPMPhotonVector local_photons2;
+        make_photons(local_photons2, 3, 7);
+        photons.append(local_photons2);
+
+        SPPMPhotonVector local_photons3;
+        make_photons(local_photons3, 7, 9);
+        photons.append(local_photons3);
+
+        photons.end_collection();
+
+        EXPECT_TRUE(contains_photons(photons, 9));
+    }
+
+    TEST_CASE(BeginCollection_AfterPreviousCollection_RemovesPreviousPhotons)
+    {
+        SPPMPhotonVector photons;
+        photons.begin_collection(10);
+
+        SPPMPhotonVector local_photons;
+        make_photons(local_photons, 0, 5);
+        photons.append(local_photons);
+        photons.end_collection();
+
+        photons.begin_collection(2);
+        photons.end_collection();
+
+        EXPECT_TRUE(photons.empty());
+    }
+}
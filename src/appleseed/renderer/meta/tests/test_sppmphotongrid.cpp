@@ -0,0 +1,133 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sppm/sppmphotongrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SPPM_SPPMPhotonGrid)
+{
+    struct PhotonCollector
+    {
+        vector<size_t> m_indices;
+
+        void visit(
+            const size_t        photon_index,
+            const Vector3f&     photon_position,
+            const float         square_dist)
+        {
+            m_indices.push_back(photon_index);
+        }
+    };
+
+    struct Fixture
+    {
+        Logger      m_logger;
+        JobQueue    m_job_queue;
+        JobManager  m_job_manager;
+
+        Fixture()
+          : m_job_manager(m_logger, m_job_queue, 2)
+        {
+            m_job_manager.start();
+        }
+    };
+
+    TEST_CASE_F(Empty_GivenNoPhoton_ReturnsTrue, Fixture)
+    {
+        const vector<Vector3f> positions;
+        const SPPMPhotonGrid grid(positions, 0.1f, m_job_queue);
+
+        EXPECT_TRUE(grid.empty());
+    }
+
+    TEST_CASE_F(Query_GivenRandomPhotons_FindsSamePhotonsAsBruteForceSearch, Fixture)
+    {
+        const size_t PhotonCount = 200000;
+        const size_t QueryCount = 100;
+        const float Radius = 0.05f;
+
+        MersenneTwister rng;
+
+        vector<Vector3f> positions(PhotonCount);
+        for (size_t i = 0; i < PhotonCount; ++i)
+        {
+            positions[i] =
+                Vector3f(
+                    rand_float1(rng, -1.0f, 1.0f),
+                    rand_float1(rng, -1.0f, 1.0f),
+                    rand_float1(rng, -1.0f, 1.0f));
+        }
+
+        const SPPMPhotonGrid grid(positions, Radius, m_job_queue);
+
+        EXPECT_EQ(PhotonCount, grid.size());
+
+        bool all_equal = true;
+
+        for (size_t q = 0; q < QueryCount; ++q)
+        {
+            const Vector3f point(
+                rand_float1(rng, -1.0f, 1.0f),
+                rand_float1(rng, -1.0f, 1.0f),
+                rand_float1(rng, -1.0f, 1.0f));
+
+            PhotonCollector collector;
+            grid.query(point, collector);
+            sort(collector.m_indices.begin(), collector.m_indices.end());
+
+            vector<size_t> expected;
+            for (size_t i = 0; i < PhotonCount; ++i)
+            {
+                if (square_norm(positions[i] - point) < Radius * Radius)
+                    expected.push_back(i);
+            }
+
+            if (collector.m_indices != expected)
+                all_equal = false;
+        }
+
+        EXPECT_TRUE(all_equal);
+    }
+}
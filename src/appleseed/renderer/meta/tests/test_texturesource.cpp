@@ -0,0 +1,223 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/input/inputformat.h"
+#include "renderer/modeling/input/sourceinputs.h"
+#include "renderer/modeling/input/texturesource.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/textureinstance.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Modeling_Input_TextureSource)
+{
+    // An 8x8 texture, either of constant color or made of alternating black and white columns.
+    class TestTexture
+      : public Texture
+    {
+      public:
+        TestTexture(const char* name, const bool stripes)
+          : Texture(name, ParamArray())
+          , m_props(
+                8, 8,
+                8, 8,
+                3,
+                PixelFormatFloat)
+        {
+            m_tile.reset(
+                new Tile(
+                    m_props.m_canvas_width,
+                    m_props.m_canvas_height,
+                    m_props.m_channel_count,
+                    m_props.m_pixel_format));
+
+            for (size_t y = 0; y < m_props.m_canvas_height; ++y)
+            {
+                for (size_t x = 0; x < m_props.m_canvas_width; ++x)
+                {
+                    m_tile->set_pixel(
+                        x, y,
+                        stripes ? Color3f(static_cast<float>(x % 2)) : Color3f(0.2f, 0.4f, 0.6f));
+                }
+            }
+        }
+
+        virtual void release() OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual const char* get_model() const OVERRIDE
+        {
+            return "test_texture";
+        }
+
+        virtual ColorSpace get_color_space() const OVERRIDE
+        {
+            return ColorSpaceLinearRGB;
+        }
+
+        virtual const CanvasProperties& properties() OVERRIDE
+        {
+            return m_props;
+        }
+
+        virtual Tile* load_tile(
+            const size_t    tile_x,
+            const size_t    tile_y) OVERRIDE
+        {
+            return m_tile.get();
+        }
+
+        virtual void unload_tile(
+            const size_t    tile_x,
+            const size_t    tile_y,
+            const Tile*     tile) OVERRIDE
+        {
+        }
+
+      private:
+        const CanvasProperties  m_props;
+        auto_ptr<Tile>          m_tile;
+    };
+
+    struct Fixture
+      : public TestFixtureBase
+    {
+        Color3f evaluate(
+            const bool          stripes,
+            const char*         filtering_mode,
+            const Vector2d&     uv,
+            const Vector2d&     duvdx,
+            const Vector2d&     duvdy)
+        {
+            m_scene.textures().insert(
+                auto_release_ptr<Texture>(
+                    new TestTexture("texture", stripes)));
+
+            ParamArray params;
+            params.insert("addressing_mode", "clamp");
+            params.insert("filtering_mode", filtering_mode);
+
+            m_scene.texture_instances().insert(
+                TextureInstanceFactory::create("texture_instance", params, "texture"));
+
+            bind_inputs();
+
+            const TextureSource source(
+                ~0,
+                *m_scene.texture_instances().get_by_name("texture_instance"),
+                InputFormatSpectralReflectance);
+
+            TextureStore texture_store(m_scene);
+            TextureCache texture_cache(texture_store);
+
+            Color3f result;
+            source.evaluate(texture_cache, SourceInputs(uv, duvdx, duvdy), result);
+
+            return result;
+        }
+    };
+
+    TEST_CASE_F(Evaluate_Trilinear_GivenConstantTexture_ReturnsConstantColor, Fixture)
+    {
+        const Color3f result =
+            evaluate(false, "trilinear", Vector2d(0.3, 0.6), Vector2d(0.3, 0.0), Vector2d(0.0, 0.1));
+
+        EXPECT_FEQ(Color3f(0.2f, 0.4f, 0.6f), result);
+    }
+
+    TEST_CASE_F(Evaluate_Trilinear_GivenFootprintOfTwoTexels_ReturnsAverageOfColumns, Fixture)
+    {
+        const Color3f result =
+            evaluate(true, "trilinear", Vector2d(1.0 / 7, 0.5), Vector2d(0.25, 0.0), Vector2d(0.0, 0.25));
+
+        EXPECT_FEQ(Color3f(0.5f), result);
+    }
+
+    TEST_CASE_F(Evaluate_Trilinear_GivenFootprintCoveringTexture_ReturnsAverageOfTexture, Fixture)
+    {
+        const Color3f result =
+            evaluate(true, "trilinear", Vector2d(1.0 / 7, 0.5), Vector2d(2.0, 0.0), Vector2d(0.0, 2.0));
+
+        EXPECT_FEQ(Color3f(0.5f), result);
+    }
+
+    TEST_CASE_F(Evaluate_Trilinear_GivenFootprintBetweenLevels_BlendsLevels, Fixture)
+    {
+        // Texel (1, 4) of the base level is white, the first level is uniformly gray.
+        const Color3f result =
+            evaluate(true, "trilinear", Vector2d(1.0 / 7, 4.0 / 7), Vector2d(1.5 / 8, 0.0), Vector2d(0.0, 0.0));
+
+        const float t = static_cast<float>(log(1.5) / log(2.0));
+
+        EXPECT_FEQ(Color3f(1.0f - 0.5f * t), result);
+    }
+
+    TEST_CASE_F(Evaluate_Anisotropic_GivenConstantTexture_ReturnsConstantColor, Fixture)
+    {
+        const Color3f result =
+            evaluate(false, "anisotropic", Vector2d(0.3, 0.6), Vector2d(0.5, 0.0), Vector2d(0.0, 0.05));
+
+        EXPECT_FEQ(Color3f(0.2f, 0.4f, 0.6f), result);
+    }
+
+    TEST_CASE_F(Evaluate_Anisotropic_GivenFootprintElongatedAcrossColumns_ReturnsAverageOfColumns, Fixture)
+    {
+        const Color3f result =
+            evaluate(true, "anisotropic", Vector2d(1.0 / 7, 0.5), Vector2d(1.0, 0.0), Vector2d(0.0, 0.25));
+
+        EXPECT_FEQ(Color3f(0.5f), result);
+    }
+}
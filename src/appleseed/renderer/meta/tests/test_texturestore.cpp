@@ -29,11 +29,28 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
 using namespace renderer;
+using namespace std;
 
 TEST_SUITE(Renderer_Kernel_Texturing_TextureStore_TileKey)
 {
@@ -46,4 +63,147 @@ TEST_SUITE(Renderer_Kernel_Texturing_TextureStore_TileKey)
         EXPECT_EQ(32323, key.get_tile_x());
         EXPECT_EQ(56565, key.get_tile_y());
     }
+
+    TEST_CASE(StoreAndRetrieveMipLevel)
+    {
+        const TextureStore::TileKey key(123, 12345, 32323, 56565, 7);
+
+        EXPECT_EQ(7, key.m_level);
+        EXPECT_EQ(32323, key.get_tile_x());
+        EXPECT_EQ(56565, key.get_tile_y());
+    }
+
+    TEST_CASE(KeysOfDifferentMipLevelsAreDistinct)
+    {
+        const TextureStore::TileKey key0(123, 12345, 1, 2, 0);
+        const TextureStore::TileKey key1(123, 12345, 1, 2, 1);
+
+        EXPECT_FALSE(key0 == key1);
+        EXPECT_TRUE(key0 < key1 || key1 < key0);
+    }
+}
+
+TEST_SUITE(Renderer_Kernel_Texturing_TextureStore)
+{
+    // An 8x8 texture made of 4x4 tiles, either of constant color or made of alternating black and white columns.
+    class TestTexture
+      : public Texture
+    {
+      public:
+        TestTexture(const char* name, const bool stripes)
+          : Texture(name, ParamArray())
+          , m_props(
+                8, 8,
+                4, 4,
+                3,
+                PixelFormatFloat)
+        {
+            for (size_t ty = 0; ty < 2; ++ty)
+            {
+                for (size_t tx = 0; tx < 2; ++tx)
+                {
+                    m_tiles[ty][tx].reset(new Tile(4, 4, 3, PixelFormatFloat));
+
+                    for (size_t y = 0; y < 4; ++y)
+                    {
+                        for (size_t x = 0; x < 4; ++x)
+                        {
+                            m_tiles[ty][tx]->set_pixel(
+                                x, y,
+                                stripes ? Color3f(static_cast<float>(x % 2)) : Color3f(0.2f, 0.4f, 0.6f));
+                        }
+                    }
+                }
+            }
+        }
+
+        virtual void release() OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual const char* get_model() const OVERRIDE
+        {
+            return "test_texture";
+        }
+
+        virtual ColorSpace get_color_space() const OVERRIDE
+        {
+            return ColorSpaceLinearRGB;
+        }
+
+        virtual const CanvasProperties& properties() OVERRIDE
+        {
+            return m_props;
+        }
+
+        virtual Tile* load_tile(
+            const size_t    tile_x,
+            const size_t    tile_y) OVERRIDE
+        {
+            return m_tiles[tile_y][tile_x].get();
+        }
+
+        virtual void unload_tile(
+            const size_t    tile_x,
+            const size_t    tile_y,
+            const Tile*     tile) OVERRIDE
+        {
+        }
+
+      private:
+        const CanvasProperties  m_props;
+        auto_ptr<Tile>          m_tiles[2][2];
+    };
+
+    struct Fixture
+      : public TestFixtureBase
+    {
+        const Texture& create_texture(const bool stripes)
+        {
+            m_scene.textures().insert(
+                auto_release_ptr<Texture>(
+                    new TestTexture("texture", stripes)));
+
+            return *m_scene.textures().get_by_name("texture");
+        }
+
+        Color3f get_pixel(
+            TextureStore&   texture_store,
+            const Texture&  texture,
+            const size_t    level,
+            const size_t    x,
+            const size_t    y)
+        {
+            TextureStore::TileRecord& record =
+                texture_store.acquire(
+                    TextureStore::TileKey(~0, texture.get_uid(), 0, 0, level));
+
+            Color3f color;
+            record.m_tile->get_pixel(x, y, color);
+
+            texture_store.release(record);
+
+            return color;
+        }
+    };
+
+    TEST_CASE_F(Acquire_GivenConstantTexture_GeneratesMipLevelsOfSameColor, Fixture)
+    {
+        const Texture& texture = create_texture(false);
+        TextureStore texture_store(m_scene);
+
+        EXPECT_FEQ(Color3f(0.2f, 0.4f, 0.6f), get_pixel(texture_store, texture, 1, 3, 3));
+        EXPECT_FEQ(Color3f(0.2f, 0.4f, 0.6f), get_pixel(texture_store, texture, 3, 0, 0));
+    }
+
+    TEST_CASE_F(Acquire_GivenAlternatingColumns_GeneratesMipLevelOfAverageColor, Fixture)
+    {
+        const Texture& texture = create_texture(true);
+        TextureStore texture_store(m_scene);
+
+        EXPECT_FEQ(Color3f(0.5f), get_pixel(texture_store, texture, 1, 0, 0));
+        EXPECT_FEQ(Color3f(0.5f), get_pixel(texture_store, texture, 1, 3, 2));
+        EXPECT_FEQ(Color3f(0.5f), get_pixel(texture_store, texture, 3, 0, 0));
+    }
 }
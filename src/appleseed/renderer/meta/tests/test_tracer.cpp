@@ -32,12 +32,19 @@
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/lighting/tracer.h"
+#ifdef WITH_OSL
+#include "renderer/kernel/rendering/oiioerrorhandler.h"
+#include "renderer/kernel/rendering/rendererservices.h"
+#endif
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/kernel/texturing/texturecache.h"
 #include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/color/colorentity.h"
 #include "renderer/modeling/material/genericmaterial.h"
+#ifdef WITH_OSL
+#include "renderer/modeling/material/oslmaterial.h"
+#endif
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/triangle.h"
 #include "renderer/modeling/project/project.h"
@@ -45,6 +52,9 @@
 #include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
+#ifdef WITH_OSL
+#include "renderer/modeling/shadergroup/shadergroup.h"
+#endif
 #include "renderer/modeling/surfaceshader/constantsurfaceshader.h"
 #include "renderer/modeling/surfaceshader/surfaceshader.h"
 #include "renderer/utility/paramarray.h"
@@ -60,6 +70,22 @@
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/test.h"
 
+// OSL headers.
+#ifdef WITH_OSL
+#include "OSL/oslexec.h"
+#endif
+
+// OpenImageIO headers.
+#ifdef WITH_OSL
+#include "OpenImageIO/texture.h"
+#endif
+
+// boost headers.
+#ifdef WITH_OSL
+#include "boost/bind.hpp"
+#include "boost/shared_ptr.hpp"
+#endif
+
 // Standard headers.
 #include <cstddef>
 #include <string>
@@ -712,6 +738,116 @@ TEST_SUITE(Renderer_Kernel_Lighting_Tracer)
         EXPECT_EQ(1.0, transmission);
     }
 
+    TEST_CASE_F(TraceBetween_GivenOccluderKey_ComputeVisibilityBeforeAndPastSecondOpaqueOccluder, Fixture<SceneWithTwoOpaqueOccluders>)
+    {
+        Tracer parent_tracer(
+            *m_scene, 
+            m_intersector, 
+            m_texture_cache
+#ifdef WITH_OSL
+            , 0
+#endif
+            );
+
+        double parent_transmission;
+        const ShadingPoint& parent_shading_point =
+            parent_tracer.trace(
+                Vector3d(0.0, 0.0, 0.0),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                ShadingRay::ShadowRay,
+                0,
+                parent_transmission);
+
+        ASSERT_TRUE(parent_shading_point.hit());
+        ASSERT_FEQ(2.0, parent_shading_point.get_distance());
+
+        Tracer tracer(
+            *m_scene, 
+            m_intersector, 
+            m_texture_cache
+#ifdef WITH_OSL
+            , 0
+#endif
+            );
+        const int key = 0;
+        const double transmission_past =
+            tracer.trace_between(
+                parent_shading_point,
+                Vector3d(6.0, 0.0, 0.0),
+                ShadingRay::ShadowRay,
+                &key);
+        const double transmission_before =
+            tracer.trace_between(
+                parent_shading_point,
+                Vector3d(3.0, 0.0, 0.0),
+                ShadingRay::ShadowRay,
+                &key);
+
+        EXPECT_EQ(0.0, transmission_past);
+        EXPECT_EQ(1.0, transmission_before);
+    }
+
+    struct SceneWithOpaqueThenTransparentOccluders
+      : public SceneBase
+    {
+        SceneWithOpaqueThenTransparentOccluders()
+        {
+            create_plane_object_instance("plane_inst1", Vector3d(2.0, 0.0, 0.0), "opaque_material");
+            create_plane_object_instance("plane_inst2", Vector3d(4.0, 0.0, 0.0), "transparent_material");
+        }
+    };
+
+    TEST_CASE_F(TraceBetween_GivenOccluderKey_DoesNotCacheAlphaMappedOccluder, Fixture<SceneWithOpaqueThenTransparentOccluders>)
+    {
+        Tracer parent_tracer(
+            *m_scene, 
+            m_intersector, 
+            m_texture_cache
+#ifdef WITH_OSL
+            , 0
+#endif
+            );
+
+        double parent_transmission;
+        const ShadingPoint& parent_shading_point =
+            parent_tracer.trace(
+                Vector3d(0.0, 0.0, 0.0),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                ShadingRay::ShadowRay,
+                0,
+                parent_transmission);
+
+        ASSERT_TRUE(parent_shading_point.hit());
+        ASSERT_FEQ(2.0, parent_shading_point.get_distance());
+
+        Tracer tracer(
+            *m_scene, 
+            m_intersector, 
+            m_texture_cache
+#ifdef WITH_OSL
+            , 0
+#endif
+            );
+        const int key = 0;
+        const double first_transmission =
+            tracer.trace_between(
+                parent_shading_point,
+                Vector3d(6.0, 0.0, 0.0),
+                ShadingRay::ShadowRay,
+                &key);
+        const double second_transmission =
+            tracer.trace_between(
+                parent_shading_point,
+                Vector3d(6.0, 0.0, 0.0),
+                ShadingRay::ShadowRay,
+                &key);
+
+        EXPECT_FEQ(0.5, first_transmission);
+        EXPECT_FEQ(0.5, second_transmission);
+    }
+
     struct SceneWithTwoOpaqueOccludersAndScaledAssemblyInstance
       : public SceneWithTwoOpaqueOccluders
     {
@@ -762,4 +898,68 @@ TEST_SUITE(Renderer_Kernel_Lighting_Tracer)
 
         EXPECT_EQ(1.0, transmission);
     }
+
+#ifdef WITH_OSL
+
+    struct SceneWithSingleOSLShadedOpaqueOccluder
+      : public SceneBase
+    {
+        SceneWithSingleOSLShadedOpaqueOccluder()
+        {
+            // A shader group without any shader has no transparency closure.
+            m_assembly->shader_groups().insert(ShaderGroupFactory::create("shader_group"));
+
+            ParamArray params;
+            params.insert("surface_shader", "constant_white_surface_shader");
+            params.insert("osl_surface", "shader_group");
+
+            m_assembly->materials().insert(
+                OSLMaterialFactory().create("osl_material", params));
+
+            create_plane_object_instance("plane_inst", Vector3d(2.0, 0.0, 0.0), "osl_material");
+        }
+    };
+
+    TEST_CASE_F(TraceProbe_GivenOSLShadedOpaqueOccluder_ReturnsOpaqueHitOnceShaderGroupsAreSetUp, BindInputs<SceneWithSingleOSLShadedOpaqueOccluder>)
+    {
+        // Build the triangle tree before the shader group is set up.
+        TraceContext trace_context(*m_scene);
+        trace_context.build_acceleration_structures(1);
+
+        TextureStore texture_store(*m_scene);
+        TextureCache texture_cache(texture_store);
+        Intersector intersector(trace_context, texture_cache);
+
+        const ShadingRay ray(
+            Vector3d(0.0, 0.0, 0.0),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,
+            5.0,
+            0.0,
+            ShadingRay::ShadowRay);
+
+        // Until it is set up, the shader group is assumed to have transparency.
+        EXPECT_EQ(Intersector::ProbeAlphaHit, intersector.trace_probe(ray, true, 0));
+
+        boost::shared_ptr<OIIO::TextureSystem> texture_system(
+            OIIO::TextureSystem::create(false),
+            boost::bind(&OIIO::TextureSystem::destroy, _1));
+        OIIOErrorHandler error_handler;
+        RendererServices renderer_services(m_project.ref(), *texture_system);
+        boost::shared_ptr<OSL::ShadingSystem> shading_system(
+            OSL::ShadingSystem::create(
+                &renderer_services,
+                texture_system.get(),
+                &error_handler),
+            boost::bind(&OSL::ShadingSystem::destroy, _1));
+
+        ASSERT_TRUE(m_scene->on_frame_begin(m_project.ref(), shading_system.get()));
+        trace_context.update_alpha_mapped_object_instances();
+
+        EXPECT_EQ(Intersector::ProbeOpaqueHit, intersector.trace_probe(ray, true, 0));
+
+        m_scene->on_frame_end(m_project.ref());
+    }
+
+#endif
 }
@@ -93,6 +93,30 @@ TEST_SUITE(Renderer_Utility_TransformSequence)
         EXPECT_EQ(NewTransform, transform);
     }
 
+    TEST_CASE(OperatorEqual_GivenCopiedSequence_ReturnsTrue)
+    {
+        TransformSequence sequence;
+        sequence.set_transform(1.0, Transformd::from_local_to_parent(Matrix4d::translation(Vector3d(1.0, 2.0, 3.0))));
+        sequence.set_transform(2.0, Transformd::identity());
+
+        const TransformSequence copy(sequence);
+
+        EXPECT_TRUE(copy == sequence);
+        EXPECT_FALSE(copy != sequence);
+    }
+
+    TEST_CASE(OperatorEqual_GivenSequenceWithReplacedTransform_ReturnsFalse)
+    {
+        TransformSequence sequence;
+        sequence.set_transform(1.0, Transformd::identity());
+
+        TransformSequence modified(sequence);
+        modified.set_transform(1.0, Transformd::from_local_to_parent(Matrix4d::translation(Vector3d(1.0, 2.0, 3.0))));
+
+        EXPECT_FALSE(modified == sequence);
+        EXPECT_TRUE(modified != sequence);
+    }
+
     TEST_CASE(GetEarliestTransform_EmptySequence_ReturnsIdentity)
     {
         const TransformSequence sequence;
@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/input/inputevaluator.h"
+#include "renderer/modeling/input/sourceinputs.h"
 
 using namespace foundation;
 
@@ -92,7 +93,10 @@ void BSDF::evaluate_inputs(
     const ShadingPoint& shading_point,
     const size_t        offset) const
 {
-    input_evaluator.evaluate(get_inputs(), shading_point.get_uv(0), offset);
+    input_evaluator.evaluate(
+        get_inputs(),
+        SourceInputs(shading_point),
+        offset);
 }
 
 }   // namespace renderer
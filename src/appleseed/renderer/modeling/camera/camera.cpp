@@ -92,6 +92,17 @@ void Camera::on_frame_end(const Project& project)
 {
 }
 
+void Camera::generate_ray_differential(
+    SamplingContext&    sampling_context,
+    const Frame&        frame,
+    const Vector2d&     point,
+    ShadingRay&         ray) const
+{
+    generate_ray(sampling_context, point, ray);
+
+    ray.m_has_differentials = false;
+}
+
 Vector2d Camera::extract_film_dimensions() const
 {
     const Vector2d DefaultFilmDimensions(0.025, 0.025);     // in meters
@@ -103,6 +103,15 @@ class DLLSYMBOL Camera
         const foundation::Vector2d&     point,
         ShadingRay&                     ray) const = 0;
 
+    // Like generate_ray(), but also compute the ray differentials wrt. a one pixel offset
+    // on the film plane of a given frame. The default implementation generates a ray
+    // without differentials.
+    virtual void generate_ray_differential(
+        SamplingContext&                sampling_context,
+        const Frame&                    frame,
+        const foundation::Vector2d&     point,
+        ShadingRay&                     ray) const;
+
     // Project a 3D point back to the film plane. The input point is expressed in
     // world space. The returned point is expressed in normalized device coordinates.
     // Returns true if the projection was successful, false otherwise.
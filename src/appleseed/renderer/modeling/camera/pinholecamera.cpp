@@ -132,14 +132,36 @@ namespace
             Transformd tmp;
             const Transformd& transform = m_transform_sequence.evaluate(ray.m_time, tmp);
 
-            // Compute the origin of the ray.
-            ray.m_org =
-                m_transform_sequence.size() <= 1
-                    ? m_ray_org
-                    : transform.get_local_to_parent().extract_translation();
+            // Compute the origin and direction of the ray.
+            compute_ray(transform, point, ray);
+        }
 
-            // Compute the direction of the ray.
-            ray.m_dir = transform.vector_to_parent(ndc_to_camera(point));
+        virtual void generate_ray_differential(
+            SamplingContext&        sampling_context,
+            const Frame&            frame,
+            const Vector2d&         point,
+            ShadingRay&             ray) const OVERRIDE
+        {
+            // Initialize the ray.
+            initialize_ray(sampling_context, ray);
+
+            // Retrieve the camera transform.
+            Transformd tmp;
+            const Transformd& transform = m_transform_sequence.evaluate(ray.m_time, tmp);
+
+            // Compute the origin and direction of the ray.
+            compute_ray(transform, point, ray);
+
+            // The auxiliary rays share the origin of the main ray.
+            const CanvasProperties& props = frame.image().properties();
+            const double dx = m_film_dimensions[0] / props.m_canvas_width;
+            const double dy = m_film_dimensions[1] / props.m_canvas_height;
+
+            ray.m_rx.m_org = ray.m_org;
+            ray.m_rx.m_dir = ray.m_dir + transform.vector_to_parent(Vector3d(dx, 0.0, 0.0));
+            ray.m_ry.m_org = ray.m_org;
+            ray.m_ry.m_dir = ray.m_dir + transform.vector_to_parent(Vector3d(0.0, -dy, 0.0));
+            ray.m_has_differentials = true;
         }
 
         virtual bool project_point(
@@ -241,6 +263,21 @@ namespace
                     (0.5 - point.y) * m_film_dimensions[1],
                     -m_focal_length);
         }
+
+        void compute_ray(
+            const Transformd&       transform,
+            const Vector2d&         point,
+            ShadingRay&             ray) const
+        {
+            // Compute the origin of the ray.
+            ray.m_org =
+                m_transform_sequence.size() <= 1
+                    ? m_ray_org
+                    : transform.get_local_to_parent().extract_translation();
+
+            // Compute the direction of the ray.
+            ray.m_dir = transform.vector_to_parent(ndc_to_camera(point));
+        }
     };
 }
 
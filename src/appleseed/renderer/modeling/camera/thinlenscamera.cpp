@@ -182,53 +182,40 @@ namespace
             // Initialize the ray.
             initialize_ray(sampling_context, ray);
 
-            // Sample the surface of the lens.
-            Vector2d lens_point;
-            if (m_diaphragm_blade_count == 0)
-            {
-                sampling_context.split_in_place(2, 1);
-                const Vector2d s = sampling_context.next_vector2<2>();
-                lens_point = m_lens_radius * sample_disk_uniform(s);
-            }
-            else
-            {
-                sampling_context.split_in_place(3, 1);
-                const Vector3d s = sampling_context.next_vector2<3>();
-                lens_point =
-                    m_lens_radius *
-                    sample_regular_polygon_uniform(
-                        s,
-                        m_diaphragm_vertices.size(),
-                        &m_diaphragm_vertices.front());
-            }
+            // Retrieve the camera transform.
+            Transformd tmp;
+            const Transformd& transform = m_transform_sequence.evaluate(ray.m_time, tmp);
+
+            // Compute the origin and direction of the ray.
+            compute_ray(sampling_context, transform, point, ray);
+        }
+
+        virtual void generate_ray_differential(
+            SamplingContext&        sampling_context,
+            const Frame&            frame,
+            const Vector2d&         point,
+            ShadingRay&             ray) const OVERRIDE
+        {
+            // Initialize the ray.
+            initialize_ray(sampling_context, ray);
 
             // Retrieve the camera transform.
             Transformd tmp;
             const Transformd& transform = m_transform_sequence.evaluate(ray.m_time, tmp);
 
-            // Compute the origin of the ray.
-            const Transformd::MatrixType& mat = transform.get_local_to_parent();
-            ray.m_org.x =    mat[ 0] * lens_point.x +
-                             mat[ 1] * lens_point.y +
-                             mat[ 3];
-            ray.m_org.y =    mat[ 4] * lens_point.x +
-                             mat[ 5] * lens_point.y +
-                             mat[ 7];
-            ray.m_org.z =    mat[ 8] * lens_point.x +
-                             mat[ 9] * lens_point.y +
-                             mat[11];
-            const double w = mat[12] * lens_point.x +
-                             mat[13] * lens_point.y +
-                             mat[15];
-            assert(w != 0.0);
-            if (w != 1.0)
-                ray.m_org /= w;
+            // Compute the origin and direction of the ray.
+            compute_ray(sampling_context, transform, point, ray);
 
-            // Compute the direction of the ray.
-            ray.m_dir.x = (point.x - 0.5) * m_kx - lens_point.x;
-            ray.m_dir.y = (0.5 - point.y) * m_ky - lens_point.y;
-            ray.m_dir.z = -m_focal_distance;
-            ray.m_dir = transform.vector_to_parent(ray.m_dir);
+            // The auxiliary rays go through the same point of the lens as the main ray.
+            const CanvasProperties& props = frame.image().properties();
+            const double dx = m_kx / props.m_canvas_width;
+            const double dy = m_ky / props.m_canvas_height;
+
+            ray.m_rx.m_org = ray.m_org;
+            ray.m_rx.m_dir = ray.m_dir + transform.vector_to_parent(Vector3d(dx, 0.0, 0.0));
+            ray.m_ry.m_org = ray.m_org;
+            ray.m_ry.m_dir = ray.m_dir + transform.vector_to_parent(Vector3d(0.0, -dy, 0.0));
+            ray.m_has_differentials = true;
         }
 
         virtual bool project_point(
@@ -422,6 +409,57 @@ namespace
                     (0.5 - point.y) * m_film_dimensions[1],
                     -m_focal_length);
         }
+
+        void compute_ray(
+            SamplingContext&        sampling_context,
+            const Transformd&       transform,
+            const Vector2d&         point,
+            ShadingRay&             ray) const
+        {
+            // Sample the surface of the lens.
+            Vector2d lens_point;
+            if (m_diaphragm_blade_count == 0)
+            {
+                sampling_context.split_in_place(2, 1);
+                const Vector2d s = sampling_context.next_vector2<2>();
+                lens_point = m_lens_radius * sample_disk_uniform(s);
+            }
+            else
+            {
+                sampling_context.split_in_place(3, 1);
+                const Vector3d s = sampling_context.next_vector2<3>();
+                lens_point =
+                    m_lens_radius *
+                    sample_regular_polygon_uniform(
+                        s,
+                        m_diaphragm_vertices.size(),
+                        &m_diaphragm_vertices.front());
+            }
+
+            // Compute the origin of the ray.
+            const Transformd::MatrixType& mat = transform.get_local_to_parent();
+            ray.m_org.x =    mat[ 0] * lens_point.x +
+                             mat[ 1] * lens_point.y +
+                             mat[ 3];
+            ray.m_org.y =    mat[ 4] * lens_point.x +
+                             mat[ 5] * lens_point.y +
+                             mat[ 7];
+            ray.m_org.z =    mat[ 8] * lens_point.x +
+                             mat[ 9] * lens_point.y +
+                             mat[11];
+            const double w = mat[12] * lens_point.x +
+                             mat[13] * lens_point.y +
+                             mat[15];
+            assert(w != 0.0);
+            if (w != 1.0)
+                ray.m_org /= w;
+
+            // Compute the direction of the ray.
+            ray.m_dir.x = (point.x - 0.5) * m_kx - lens_point.x;
+            ray.m_dir.y = (0.5 - point.y) * m_ky - lens_point.y;
+            ray.m_dir.z = -m_focal_distance;
+            ray.m_dir = transform.vector_to_parent(ray.m_dir);
+        }
     };
 }
 
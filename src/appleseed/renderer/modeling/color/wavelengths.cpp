@@ -48,7 +48,7 @@ namespace renderer
 // Range of wavelengths used throughout the light simulation.
 //
 
-Spectrum g_light_wavelengths;
+Spectrum31f g_light_wavelengths;
 
 namespace
 {
@@ -59,7 +59,7 @@ namespace
             generate_wavelengths(
                 LowWavelength,
                 HighWavelength,
-                Spectrum::Samples,
+                Spectrum31f::Samples,
                 &g_light_wavelengths[0]);
         }
     };
@@ -113,14 +113,36 @@ void spectral_values_to_spectrum(
         &wavelengths[0]);
 
     // Resample the spectrum to the internal wavelength range.
-    Spectrum spectrum;
+    Spectrum31f sampled_spectrum;
     spectrum_to_spectrum(
         input_spectrum_count,
         &wavelengths[0],
         input_spectrum,
-        Spectrum::Samples,
+        Spectrum31f::Samples,
         &g_light_wavelengths[0],
-        output_spectrum);
+        &sampled_spectrum[0]);
+
+    // Convert the result to the internal spectrum format.
+    Spectrum spectrum;
+    sampled_spectrum_to_spectrum(sampled_spectrum, spectrum);
+
+    for (size_t i = 0; i < Spectrum::Samples; ++i)
+        output_spectrum[i] = spectrum[i];
+}
+
+void sampled_spectrum_to_spectrum(
+    const Spectrum31f&      input,
+    Spectrum&               output)
+{
+#ifdef USE_RGB_SPECTRUM
+    static const LightingConditions lighting_conditions(IlluminantCIED65, XYZCMFCIE196410Deg);
+
+    linear_rgb_illuminance_to_spectrum(
+        ciexyz_to_linear_rgb(spectrum_to_ciexyz<float>(lighting_conditions, input)),
+        output);
+#else
+    output = input;
+#endif
 }
 
 }   // namespace renderer
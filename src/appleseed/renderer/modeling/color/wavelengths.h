@@ -33,6 +33,9 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 
+// appleseed.foundation headers.
+#include "foundation/image/spectrum.h"
+
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
@@ -46,9 +49,9 @@ namespace renderer
 // Wavelengths used throughout the spectral light simulation.
 //
 
-const float LowWavelength = 400.0f;         // low wavelength, in nm
-const float HighWavelength = 700.0f;        // high wavelength, in nm
-extern Spectrum g_light_wavelengths;        // wavelengths, in nm
+const float LowWavelength = 400.0f;                 // low wavelength, in nm
+const float HighWavelength = 700.0f;                // high wavelength, in nm
+extern foundation::Spectrum31f g_light_wavelengths; // wavelengths, in nm
 
 
 //
@@ -70,6 +73,12 @@ DLLSYMBOL void spectral_values_to_spectrum(
     const float             input_spectrum[],
     float                   output_spectrum[]);
 
+// Convert a spectrum sampled at the light wavelengths to the internal spectrum format.
+// This is a simple copy unless the renderer is built with RGB light transport.
+DLLSYMBOL void sampled_spectrum_to_spectrum(
+    const foundation::Spectrum31f&  input,
+    Spectrum&                       output);
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_MODELING_SPECTRUM_WAVELENGTHS_H
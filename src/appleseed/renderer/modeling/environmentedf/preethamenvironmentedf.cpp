@@ -410,7 +410,7 @@ namespace
             // Compute the final sky radiance.
             value *=
                   luminance                                 // start with computed luminance
-                / sum_value(value * XYZCMFCIE19312Deg[1])   // normalize to unit luminance
+                / spectrum_luminance(value)                 // normalize to unit luminance
                 * (1.0f / 683.0f)                           // convert lumens to Watts
                 * static_cast<float>(RcpPi);                // convert irradiance to radiance
         }
@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 #include "renderer/modeling/input/source.h"
+#include "renderer/modeling/input/sourceinputs.h"
 
 // appleseed.foundation headers.
 #include "foundation/platform/types.h"
@@ -109,7 +110,7 @@ namespace
 
         uint8* evaluate(
             TextureCache&       texture_cache,
-            const Vector2d&     uv,
+            const SourceInputs& source_inputs,
             uint8*              ptr) const
         {
             switch (m_format)
@@ -120,7 +121,7 @@ namespace
                     double* out_scalar = reinterpret_cast<double*>(ptr);
 
                     if (m_source)
-                        m_source->evaluate(texture_cache, uv, *out_scalar);
+                        m_source->evaluate(texture_cache, source_inputs, *out_scalar);
                     else *out_scalar = 0.0;
 
                     ptr += sizeof(double);
@@ -135,7 +136,7 @@ namespace
                     Alpha* out_alpha = reinterpret_cast<Alpha*>(ptr + sizeof(Spectrum));
 
                     if (m_source)
-                        m_source->evaluate(texture_cache, uv, *out_spectrum, *out_alpha);
+                        m_source->evaluate(texture_cache, source_inputs, *out_spectrum, *out_alpha);
                     else
                     {
                         out_spectrum->set(0.0f);
@@ -325,7 +326,7 @@ size_t InputArray::compute_data_size() const
 
 void InputArray::evaluate(
     TextureCache&       texture_cache,
-    const Vector2d&     uv,
+    const SourceInputs& source_inputs,
     void*               values,
     const size_t        offset) const
 {
@@ -338,7 +339,7 @@ void InputArray::evaluate(
 #endif
 
     for (const_each<InputVector> i = impl->m_inputs; i; ++i)
-        ptr = i->evaluate(texture_cache, uv, ptr);
+        ptr = i->evaluate(texture_cache, source_inputs, ptr);
 }
 
 void InputArray::evaluate_uniforms(
@@ -47,6 +47,7 @@
 // Forward declarations.
 namespace renderer      { class Entity; }
 namespace renderer      { class Source; }
+namespace renderer      { class SourceInputs; }
 namespace renderer      { class TextureCache; }
 
 namespace renderer
@@ -188,7 +189,7 @@ class DLLSYMBOL InputArray
     // The address 'values + offset' must be 16-byte aligned.
     void evaluate(
         TextureCache&               texture_cache,
-        const foundation::Vector2d& uv,
+        const SourceInputs&         source_inputs,
         void*                       values,
         const size_t                offset = 0) const;
 
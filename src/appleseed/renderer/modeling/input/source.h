@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/modeling/input/sourceinputs.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
@@ -62,28 +63,28 @@ class Source
     // Evaluate the source at a given shading point.
     virtual void evaluate(
         TextureCache&               texture_cache,
-        const foundation::Vector2d& uv,
+        const SourceInputs&         source_inputs,
         double&                     scalar) const;
     virtual void evaluate(
         TextureCache&               texture_cache,
-        const foundation::Vector2d& uv,
+        const SourceInputs&         source_inputs,
         foundation::Color3f&        linear_rgb) const;
     virtual void evaluate(
         TextureCache&               texture_cache,
-        const foundation::Vector2d& uv,
+        const SourceInputs&         source_inputs,
         Spectrum&                   spectrum) const;
     virtual void evaluate(
         TextureCache&               texture_cache,
-        const foundation::Vector2d& uv,
+        const SourceInputs&         source_inputs,
         Alpha&                      alpha) const;
     virtual void evaluate(
         TextureCache&               texture_cache,
-        const foundation::Vector2d& uv,
+        const SourceInputs&         source_inputs,
         foundation::Color3f&        linear_rgb,
         Alpha&                      alpha) const;
     virtual void evaluate(
         TextureCache&               texture_cache,
-        const foundation::Vector2d& uv,
+        const SourceInputs&         source_inputs,
         Spectrum&                   spectrum,
         Alpha&                      alpha) const;
 
@@ -128,7 +129,7 @@ inline bool Source::is_uniform() const
 
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
-    const foundation::Vector2d&     uv,
+    const SourceInputs&             source_inputs,
     double&                         scalar) const
 {
     evaluate_uniform(scalar);
@@ -136,7 +137,7 @@ inline void Source::evaluate(
 
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
-    const foundation::Vector2d&     uv,
+    const SourceInputs&             source_inputs,
     foundation::Color3f&            linear_rgb) const
 {
     evaluate_uniform(linear_rgb);
@@ -144,7 +145,7 @@ inline void Source::evaluate(
 
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
-    const foundation::Vector2d&     uv,
+    const SourceInputs&             source_inputs,
     Spectrum&                       spectrum) const
 {
     evaluate_uniform(spectrum);
@@ -152,7 +153,7 @@ inline void Source::evaluate(
 
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
-    const foundation::Vector2d&     uv,
+    const SourceInputs&             source_inputs,
     Alpha&                          alpha) const
 {
     evaluate_uniform(alpha);
@@ -160,22 +161,22 @@ inline void Source::evaluate(
 
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
-    const foundation::Vector2d&     uv,
+    const SourceInputs&             source_inputs,
     foundation::Color3f&            linear_rgb,
     Alpha&                          alpha) const
 {
-    evaluate(texture_cache, uv, linear_rgb);
-    evaluate(texture_cache, uv, alpha);
+    evaluate(texture_cache, source_inputs, linear_rgb);
+    evaluate(texture_cache, source_inputs, alpha);
 }
 
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
-    const foundation::Vector2d&     uv,
+    const SourceInputs&             source_inputs,
     Spectrum&                       spectrum,
     Alpha&                          alpha) const
 {
-    evaluate(texture_cache, uv, spectrum);
-    evaluate(texture_cache, uv, alpha);
+    evaluate(texture_cache, source_inputs, spectrum);
+    evaluate(texture_cache, source_inputs, alpha);
 }
 
 inline void Source::evaluate_uniform(
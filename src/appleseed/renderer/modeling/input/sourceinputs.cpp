@@ -0,0 +1,61 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sourceinputs.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/shading/shadingpoint.h"
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// SourceInputs class implementation.
+//
+
+SourceInputs::SourceInputs(const ShadingPoint& shading_point)
+  : m_uv(shading_point.get_uv(0))
+  , m_shading_point(&shading_point)
+{
+}
+
+const Vector2d& SourceInputs::get_duvdx() const
+{
+    return m_shading_point ? m_shading_point->get_duvdx(0) : m_duvdx;
+}
+
+const Vector2d& SourceInputs::get_duvdy() const
+{
+    return m_shading_point ? m_shading_point->get_duvdy(0) : m_duvdy;
+}
+
+}   // namespace renderer
@@ -0,0 +1,112 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_RENDERER_MODELING_INPUT_SOURCEINPUTS_H
+#define APPLESEED_RENDERER_MODELING_INPUT_SOURCEINPUTS_H
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+
+// Forward declarations.
+namespace renderer      { class ShadingPoint; }
+
+namespace renderer
+{
+
+//
+// The values a source is evaluated at: texture coordinates and, optionally,
+// their screen space partial derivatives (used to filter texture lookups).
+//
+
+class SourceInputs
+{
+  public:
+    foundation::Vector2d    m_uv;
+
+    // Constructors. The first one is intentionally non-explicit, and results in null derivatives.
+    SourceInputs(const foundation::Vector2d& uv);
+    SourceInputs(
+        const foundation::Vector2d& uv,
+        const foundation::Vector2d& duvdx,
+        const foundation::Vector2d& duvdy);
+
+    // Constructor for the first UV set of a shading point. The partial derivatives
+    // are only computed by the shading point if they are actually retrieved.
+    explicit SourceInputs(const ShadingPoint& shading_point);
+
+    // Return the partial derivatives of the texture coordinates wrt. screen space X and Y.
+    const foundation::Vector2d& get_duvdx() const;
+    const foundation::Vector2d& get_duvdy() const;
+
+    // Return true if the texture coordinates have non-null partial derivatives.
+    bool has_derivatives() const;
+
+  private:
+    const ShadingPoint*     m_shading_point;
+    foundation::Vector2d    m_duvdx;
+    foundation::Vector2d    m_duvdy;
+};
+
+
+//
+// SourceInputs class implementation.
+//
+
+inline SourceInputs::SourceInputs(const foundation::Vector2d& uv)
+  : m_uv(uv)
+  , m_shading_point(0)
+  , m_duvdx(0.0)
+  , m_duvdy(0.0)
+{
+}
+
+inline SourceInputs::SourceInputs(
+    const foundation::Vector2d&     uv,
+    const foundation::Vector2d&     duvdx,
+    const foundation::Vector2d&     duvdy)
+  : m_uv(uv)
+  , m_shading_point(0)
+  , m_duvdx(duvdx)
+  , m_duvdy(duvdy)
+{
+}
+
+inline bool SourceInputs::has_derivatives() const
+{
+    const foundation::Vector2d& duvdx = get_duvdx();
+    const foundation::Vector2d& duvdy = get_duvdy();
+
+    return
+        duvdx.x != 0.0 || duvdx.y != 0.0 ||
+        duvdy.x != 0.0 || duvdy.y != 0.0;
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_MODELING_INPUT_SOURCEINPUTS_H
@@ -41,7 +41,9 @@
 #include "foundation/platform/types.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 using namespace foundation;
 using namespace std;
@@ -142,6 +144,7 @@ namespace
         const UniqueID              texture_uid,
         const size_t                tile_x,
         const size_t                tile_y,
+        const size_t                level,
         const size_t                pixel_x,
         const size_t                pixel_y,
         Color4f&                    sample)
@@ -152,7 +155,8 @@ namespace
                 assembly_uid,
                 texture_uid,
                 tile_x,
-                tile_y);
+                tile_y,
+                level);
 
         // Sample the tile.
         if (tile.get_channel_count() == 3)
@@ -184,6 +188,12 @@ TextureSource::TextureSource(
   , m_max_x(static_cast<double>(m_texture_props.m_canvas_width - 1))
   , m_max_y(static_cast<double>(m_texture_props.m_canvas_height - 1))
 {
+    const size_t level_count = m_texture_props.get_mip_level_count();
+
+    m_level_props.reserve(level_count);
+
+    for (size_t i = 0; i < level_count; ++i)
+        m_level_props.push_back(m_texture_props.get_mip_level_properties(i));
 }
 
 Vector2d TextureSource::apply_transform(const Vector2d& uv) const
@@ -198,6 +208,14 @@ Vector2d TextureSource::apply_transform(const Vector2d& uv) const
     return Vector2d(p.x, p.y);
 }
 
+Vector2d TextureSource::transform_derivative(const Vector2d& duv) const
+{
+    const Vector3d d = m_texture_transform.vector_to_local(Vector3d(duv.x, duv.y, 0.0));
+
+    // The V axis is flipped when going from UV space to texture space.
+    return Vector2d(d.x * m_scalar_canvas_width, -d.y * m_scalar_canvas_height);
+}
+
 Color4f TextureSource::get_texel(
     TextureCache&               texture_cache,
     const size_t                ix,
@@ -240,6 +258,7 @@ Color4f TextureSource::get_texel(
         m_texture_uid,
         tile_x,
         tile_y,
+        0,
         pixel_x,
         pixel_y,
         sample);
@@ -249,6 +268,7 @@ Color4f TextureSource::get_texel(
 
 void TextureSource::get_texels_2x2(
     TextureCache&               texture_cache,
+    const size_t                level,
     const int                   ix,
     const int                   iy,
     Color4f&                    t00,
@@ -256,19 +276,21 @@ void TextureSource::get_texels_2x2(
     Color4f&                    t01,
     Color4f&                    t11) const
 {
+    const CanvasProperties& props = m_level_props[level];
+
     const Vector<size_t, 2> p00 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            props.m_canvas_width,
+            props.m_canvas_height,
             ix + 0,
             iy + 0);
 
     const Vector<size_t, 2> p11 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            props.m_canvas_width,
+            props.m_canvas_height,
             ix + 1,
             iy + 1);
 
@@ -276,10 +298,10 @@ void TextureSource::get_texels_2x2(
     const Vector<size_t, 2> p01(p00.x, p11.y);
 
     // Compute the coordinates of the tile containing each texel.
-    const size_t tile_x_00 = truncate<size_t>(p00.x * m_texture_props.m_rcp_tile_width);
-    const size_t tile_y_00 = truncate<size_t>(p00.y * m_texture_props.m_rcp_tile_height);
-    const size_t tile_x_11 = truncate<size_t>(p11.x * m_texture_props.m_rcp_tile_width);
-    const size_t tile_y_11 = truncate<size_t>(p11.y * m_texture_props.m_rcp_tile_height);
+    const size_t tile_x_00 = truncate<size_t>(p00.x * props.m_rcp_tile_width);
+    const size_t tile_y_00 = truncate<size_t>(p00.y * props.m_rcp_tile_height);
+    const size_t tile_x_11 = truncate<size_t>(p11.x * props.m_rcp_tile_width);
+    const size_t tile_y_11 = truncate<size_t>(p11.y * props.m_rcp_tile_height);
 
     // Check whether all four texels are part of the same tile.
     const size_t tile_x_mask = tile_x_00 ^ tile_x_11;
@@ -288,10 +310,10 @@ void TextureSource::get_texels_2x2(
     if (tile_x_mask | tile_y_mask)
     {
         // Compute the tile space coordinates of each texel.
-        const size_t pixel_x_00 = p00.x - tile_x_00 * m_texture_props.m_tile_width;
-        const size_t pixel_y_00 = p00.y - tile_y_00 * m_texture_props.m_tile_height;
-        const size_t pixel_x_11 = p11.x - tile_x_11 * m_texture_props.m_tile_width;
-        const size_t pixel_y_11 = p11.y - tile_y_11 * m_texture_props.m_tile_height;
+        const size_t pixel_x_00 = p00.x - tile_x_00 * props.m_tile_width;
+        const size_t pixel_y_00 = p00.y - tile_y_00 * props.m_tile_height;
+        const size_t pixel_x_11 = p11.x - tile_x_11 * props.m_tile_width;
+        const size_t pixel_y_11 = p11.y - tile_y_11 * props.m_tile_height;
 
         // Sample the tile.
         sample_tile(
@@ -300,6 +322,7 @@ void TextureSource::get_texels_2x2(
             m_texture_uid,
             tile_x_00,
             tile_y_00,
+            level,
             pixel_x_00,
             pixel_y_00,
             t00);
@@ -309,6 +332,7 @@ void TextureSource::get_texels_2x2(
             m_texture_uid,
             tile_x_11,
             tile_y_00,
+            level,
             pixel_x_11,
             pixel_y_00,
             t10);
@@ -318,6 +342,7 @@ void TextureSource::get_texels_2x2(
             m_texture_uid,
             tile_x_00,
             tile_y_11,
+            level,
             pixel_x_00,
             pixel_y_11,
             t01);
@@ -327,6 +352,7 @@ void TextureSource::get_texels_2x2(
             m_texture_uid,
             tile_x_11,
             tile_y_11,
+            level,
             pixel_x_11,
             pixel_y_11,
             t11);
@@ -334,8 +360,8 @@ void TextureSource::get_texels_2x2(
     else
     {
         // Compute the tile space coordinates of each texel.
-        const size_t org_x = tile_x_00 * m_texture_props.m_tile_width;
-        const size_t org_y = tile_y_00 * m_texture_props.m_tile_height;
+        const size_t org_x = tile_x_00 * props.m_tile_width;
+        const size_t org_y = tile_y_00 * props.m_tile_height;
         const size_t pixel_x_00 = p00.x - org_x;
         const size_t pixel_y_00 = p00.y - org_y;
         const size_t pixel_x_11 = p11.x - org_x;
@@ -347,7 +373,8 @@ void TextureSource::get_texels_2x2(
                 m_assembly_uid,
                 m_texture_uid,
                 tile_x_00,
-                tile_y_00);
+                tile_y_00,
+                level);
 
         // Sample the tile.
         if (tile.get_channel_count() == 3)
@@ -390,10 +417,10 @@ void TextureSource::get_texels_2x2(
 
 Color4f TextureSource::sample_texture(
     TextureCache&               texture_cache,
-    const Vector2d&             uv) const
+    const SourceInputs&         source_inputs) const
 {
     // Start with the transformed input texture coordinates.
-    Vector2d p = apply_transform(uv);
+    Vector2d p = apply_transform(source_inputs.m_uv);
     p.y = 1.0 - p.y;
 
     // Apply the texture addressing mode.
@@ -413,38 +440,25 @@ Color4f TextureSource::sample_texture(
         }
 
       case TextureFilteringBilinear:
+        return sample_bilinear(texture_cache, 0, p);
+
+      case TextureFilteringTrilinear:
+      case TextureFilteringAnisotropic:
         {
-            p.x *= m_max_x;
-            p.y *= m_max_y;
-
-            const int ix = truncate<int>(p.x);
-            const int iy = truncate<int>(p.y);
-
-            // Retrieve the four surrounding texels.
-            Color4f t00, t10, t01, t11;
-            get_texels_2x2(
-                texture_cache,
-                ix, iy,
-                t00, t10, t01, t11);
-
-            // Compute weights.
-            const float wx1 = static_cast<float>(p.x - ix);
-            const float wy1 = static_cast<float>(p.y - iy);
-            const float wx0 = 1.0f - wx1;
-            const float wy0 = 1.0f - wy1;
-
-            // Apply weights.
-            t00 *= wx0 * wy0;
-            t10 *= wx1 * wy0;
-            t01 *= wx0 * wy1;
-            t11 *= wx1 * wy1;
-
-            // Accumulate.
-            t00 += t10;
-            t00 += t01;
-            t00 += t11;
-
-            return t00;
+            // Without ray differentials, fall back to bilinear filtering of the base level.
+            if (!source_inputs.has_derivatives())
+                return sample_bilinear(texture_cache, 0, p);
+
+            // Compute the footprint of the lookup in texel space.
+            const Vector2d dpdx = transform_derivative(source_inputs.get_duvdx());
+            const Vector2d dpdy = transform_derivative(source_inputs.get_duvdy());
+
+            if (m_texture_instance.get_filtering_mode() == TextureFilteringTrilinear)
+            {
+                const double width = max(norm(dpdx), norm(dpdy));
+                return sample_trilinear(texture_cache, p, width);
+            }
+            else return sample_anisotropic(texture_cache, p, dpdx, dpdy);
         }
 
       default:
@@ -453,4 +467,118 @@ Color4f TextureSource::sample_texture(
     }
 }
 
+Color4f TextureSource::sample_bilinear(
+    TextureCache&               texture_cache,
+    const size_t                level,
+    const Vector2d&             p) const
+{
+    const CanvasProperties& props = m_level_props[level];
+
+    const double x = p.x * static_cast<double>(props.m_canvas_width - 1);
+    const double y = p.y * static_cast<double>(props.m_canvas_height - 1);
+
+    const int ix = truncate<int>(x);
+    const int iy = truncate<int>(y);
+
+    // Retrieve the four surrounding texels.
+    Color4f t00, t10, t01, t11;
+    get_texels_2x2(
+        texture_cache,
+        level,
+        ix, iy,
+        t00, t10, t01, t11);
+
+    // Compute weights.
+    const float wx1 = static_cast<float>(x - ix);
+    const float wy1 = static_cast<float>(y - iy);
+    const float wx0 = 1.0f - wx1;
+    const float wy0 = 1.0f - wy1;
+
+    // Apply weights.
+    t00 *= wx0 * wy0;
+    t10 *= wx1 * wy0;
+    t01 *= wx0 * wy1;
+    t11 *= wx1 * wy1;
+
+    // Accumulate.
+    t00 += t10;
+    t00 += t01;
+    t00 += t11;
+
+    return t00;
+}
+
+Color4f TextureSource::sample_trilinear(
+    TextureCache&               texture_cache,
+    const Vector2d&             p,
+    const double                width) const
+{
+    // Select the two levels whose resolution best matches the width of the filter.
+    const double lod = width > 1.0 ? std::log(width) * (1.0 / std::log(2.0)) : 0.0;
+    const size_t max_level = m_level_props.size() - 1;
+
+    if (lod >= max_level)
+        return sample_bilinear(texture_cache, max_level, p);
+
+    const size_t level = truncate<size_t>(lod);
+    const float t = static_cast<float>(lod - level);
+
+    Color4f c0 = sample_bilinear(texture_cache, level, p);
+
+    if (t == 0.0f)
+        return c0;
+
+    Color4f c1 = sample_bilinear(texture_cache, level + 1, p);
+
+    // Blend the lookups.
+    c0 *= 1.0f - t;
+    c1 *= t;
+    c0 += c1;
+
+    return c0;
+}
+
+Color4f TextureSource::sample_anisotropic(
+    TextureCache&               texture_cache,
+    const Vector2d&             p,
+    const Vector2d&             dpdx,
+    const Vector2d&             dpdy) const
+{
+    const double MaxAnisotropy = 8.0;
+
+    // Find the major and minor axes of the footprint.
+    const bool x_is_major = square_norm(dpdx) >= square_norm(dpdy);
+    const Vector2d& major_axis = x_is_major ? dpdx : dpdy;
+    const double major_length = norm(major_axis);
+    double minor_length = norm(x_is_major ? dpdy : dpdx);
+
+    if (major_length == 0.0)
+        return sample_bilinear(texture_cache, 0, p);
+
+    // Clamp the eccentricity of the footprint to bound the number of lookups.
+    if (minor_length * MaxAnisotropy < major_length)
+        minor_length = major_length / MaxAnisotropy;
+
+    // Take trilinear lookups along the major axis, sized after the minor axis.
+    const size_t lookup_count = max<size_t>(truncate<size_t>(std::ceil(major_length / minor_length)), 1);
+    const float rcp_lookup_count = 1.0f / lookup_count;
+    const Vector2d step(
+        major_axis.x / m_scalar_canvas_width,
+        major_axis.y / m_scalar_canvas_height);
+
+    Color4f result(0.0f);
+
+    for (size_t i = 0; i < lookup_count; ++i)
+    {
+        Vector2d q = p + ((i + 0.5) * rcp_lookup_count - 0.5) * step;
+        apply_addressing_mode(m_texture_instance.get_addressing_mode(), q);
+
+        result += sample_trilinear(texture_cache, q, minor_length);
+    }
+
+    result *= rcp_lookup_count;
+
+    return result;
+}
+
 }   // namespace renderer
@@ -34,6 +34,7 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/modeling/input/inputformat.h"
 #include "renderer/modeling/input/source.h"
+#include "renderer/modeling/input/sourceinputs.h"
 #include "renderer/modeling/scene/textureinstance.h"
 
 // appleseed.foundation headers.
@@ -47,6 +48,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 // Forward declarations.
 namespace renderer      { class TextureCache; }
@@ -74,28 +76,28 @@ class TextureSource
     // Evaluate the source at a given shading point.
     virtual void evaluate(
         TextureCache&                       texture_cache,
-        const foundation::Vector2d&         uv,
+        const SourceInputs&                 source_inputs,
         double&                             scalar) const OVERRIDE;
     virtual void evaluate(
         TextureCache&                       texture_cache,
-        const foundation::Vector2d&         uv,
+        const SourceInputs&                 source_inputs,
         foundation::Color3f&                linear_rgb) const OVERRIDE;
     virtual void evaluate(
         TextureCache&                       texture_cache,
-        const foundation::Vector2d&         uv,
+        const SourceInputs&                 source_inputs,
         Spectrum&                           spectrum) const OVERRIDE;
     virtual void evaluate(
         TextureCache&                       texture_cache,
-        const foundation::Vector2d&         uv,
+        const SourceInputs&                 source_inputs,
         Alpha&                              alpha) const OVERRIDE;
     virtual void evaluate(
         TextureCache&                       texture_cache,
-        const foundation::Vector2d&         uv,
+        const SourceInputs&                 source_inputs,
         foundation::Color3f&                linear_rgb,
         Alpha&                              alpha) const OVERRIDE;
     virtual void evaluate(
         TextureCache&                       texture_cache,
-        const foundation::Vector2d&         uv,
+        const SourceInputs&                 source_inputs,
         Spectrum&                           spectrum,
         Alpha&                              alpha) const OVERRIDE;
 
@@ -110,20 +112,28 @@ class TextureSource
     const double                            m_scalar_canvas_height;
     const double                            m_max_x;
     const double                            m_max_y;
+    std::vector<foundation::CanvasProperties> m_level_props;  // properties of the levels of the MIP pyramid
 
     // Apply the texture instance transform to UV coordinates.
     foundation::Vector2d apply_transform(
         const foundation::Vector2d&         uv) const;
 
+    // Apply the texture instance transform to partial derivatives of UV coordinates,
+    // and express them in texel units of the base level of the texture.
+    foundation::Vector2d transform_derivative(
+        const foundation::Vector2d&         duv) const;
+
     // Retrieve a given texel. Return a color in the linear RGB color space.
     foundation::Color4f get_texel(
         TextureCache&                       texture_cache,
         const size_t                        ix,
         const size_t                        iy) const;
 
-    // Retrieve a 2x2 block of texels. Texels are expressed in the linear RGB color space.
+    // Retrieve a 2x2 block of texels from a given level of the MIP pyramid.
+    // Texels are expressed in the linear RGB color space.
     void get_texels_2x2(
         TextureCache&                       texture_cache,
+        const size_t                        level,
         const int                           ix,
         const int                           iy,
         foundation::Color4f&                t00,
@@ -134,7 +144,29 @@ class TextureSource
     // Sample the texture. Return a color in the linear RGB color space.
     foundation::Color4f sample_texture(
         TextureCache&                       texture_cache,
-        const foundation::Vector2d&         uv) const;
+        const SourceInputs&                 source_inputs) const;
+
+    // Sample a given level of the MIP pyramid with bilinear filtering.
+    // @p is expressed in normalized texture space.
+    foundation::Color4f sample_bilinear(
+        TextureCache&                       texture_cache,
+        const size_t                        level,
+        const foundation::Vector2d&         p) const;
+
+    // Sample the MIP pyramid with trilinear filtering, for a filter of a given width
+    // expressed in texel units of the base level.
+    foundation::Color4f sample_trilinear(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2d&         p,
+        const double                        width) const;
+
+    // Sample the MIP pyramid with anisotropic filtering, given the axes of the footprint
+    // of the lookup expressed in texel units of the base level.
+    foundation::Color4f sample_anisotropic(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2d&         p,
+        const foundation::Vector2d&         dpdx,
+        const foundation::Vector2d&         dpdy) const;
 
     // Compute an alpha value given a linear RGBA color and the alpha mode of the texture instance.
     void evaluate_alpha(
@@ -154,30 +186,30 @@ inline const TextureInstance& TextureSource::get_texture_instance() const
 
 inline void TextureSource::evaluate(
     TextureCache&                           texture_cache,
-    const foundation::Vector2d&             uv,
+    const SourceInputs&                     source_inputs,
     double&                                 scalar) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, uv);
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
 
     scalar = static_cast<double>(color[0]);
 }
 
 inline void TextureSource::evaluate(
     TextureCache&                           texture_cache,
-    const foundation::Vector2d&             uv,
+    const SourceInputs&                     source_inputs,
     foundation::Color3f&                    linear_rgb) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, uv);
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
 
     linear_rgb = color.rgb();
 }
 
 inline void TextureSource::evaluate(
     TextureCache&                           texture_cache,
-    const foundation::Vector2d&             uv,
+    const SourceInputs&                     source_inputs,
     Spectrum&                               spectrum) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, uv);
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
 
     if (m_input_format == InputFormatSpectralReflectance)
         foundation::linear_rgb_reflectance_to_spectrum(color.rgb(), spectrum);
@@ -186,21 +218,21 @@ inline void TextureSource::evaluate(
 
 inline void TextureSource::evaluate(
     TextureCache&                           texture_cache,
-    const foundation::Vector2d&             uv,
+    const SourceInputs&                     source_inputs,
     Alpha&                                  alpha) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, uv);
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
 
     evaluate_alpha(color, alpha);
 }
 
 inline void TextureSource::evaluate(
     TextureCache&                           texture_cache,
-    const foundation::Vector2d&             uv,
+    const SourceInputs&                     source_inputs,
     foundation::Color3f&                    linear_rgb,
     Alpha&                                  alpha) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, uv);
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
 
     linear_rgb = color.rgb();
 
@@ -209,11 +241,11 @@ inline void TextureSource::evaluate(
 
 inline void TextureSource::evaluate(
     TextureCache&                           texture_cache,
-    const foundation::Vector2d&             uv,
+    const SourceInputs&                     source_inputs,
     Spectrum&                               spectrum,
     Alpha&                                  alpha) const
 {
-    const foundation::Color4f color = sample_texture(texture_cache, uv);
+    const foundation::Color4f color = sample_texture(texture_cache, source_inputs);
 
     if (m_input_format == InputFormatSpectralReflectance)
         foundation::linear_rgb_reflectance_to_spectrum(color.rgb(), spectrum);
@@ -41,6 +41,7 @@
 #include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/spectrum.h"
 #include "foundation/math/basis.h"
 #include "foundation/math/sampling.h"
 #include "foundation/math/scalar.h"
@@ -222,17 +223,17 @@ namespace
             const float m = 1.0f / (cos_theta + 0.15f * pow(93.885f - rad_to_deg(theta), -1.253f));
 
             // Compute wavelengths in micrometers.
-            const Spectrum wavelengths = g_light_wavelengths / 1000.0f;
+            const Spectrum31f wavelengths = g_light_wavelengths / 1000.0f;
 
             // Compute transmittance due to Rayleigh scattering.
-            Spectrum tau_r;
+            Spectrum31f tau_r;
             for (size_t i = 0; i < 31; ++i)
                 tau_r[i] = exp(-0.008735f * m * pow(wavelengths[i], -4.08f));
 
             // Compute transmittance due to aerosols.
             const float Alpha = 1.3f;               // ratio of small to large particle sizes (0 to 4, typically 1.3)
             const float beta = 0.04608f * static_cast<float>(turbidity) - 0.04586f;
-            Spectrum tau_a;
+            Spectrum31f tau_a;
             for (size_t i = 0; i < 31; ++i)
                 tau_a[i] = exp(-beta * m * pow(wavelengths[i], -Alpha));
 
@@ -249,7 +250,7 @@ namespace
                 0.079f, 0.067f, 0.057f, 0.048f,
                 0.036f, 0.028f, 0.023f
             };
-            Spectrum tau_o;
+            Spectrum31f tau_o;
             for (size_t i = 0; i < 31; ++i)
                 tau_o[i] = exp(-Ko[i] * L * m);
 
@@ -265,7 +266,7 @@ namespace
                 0.000f, 0.000f, 0.000f, 0.000f,
                 0.000f, 0.000f, 0.000f
             };
-            Spectrum tau_g;
+            Spectrum31f tau_g;
             for (size_t i = 0; i < 31; ++i)
                 tau_g[i] = exp(-1.41f * Kg[i] * m / pow(1.0f + 118.93f * Kg[i] * m, 0.45f));
 
@@ -282,7 +283,7 @@ namespace
                 0.000f, 0.000f, 0.000f, 0.000f,
                 0.000f, 0.016f, 0.024f
             };
-            Spectrum tau_wa;
+            Spectrum31f tau_wa;
             for (size_t i = 0; i < 31; ++i)
                 tau_wa[i] = exp(-0.2385f * Kwa[i] * W * m / pow(1.0f + 20.07f * Kwa[i] * W * m, 0.45f));
 
@@ -300,13 +301,16 @@ namespace
             };
 
             // Compute the attenuated radiance of the sun.
-            radiance = Spectrum(SunRadianceValues);
-            radiance *= tau_r;
-            radiance *= tau_a;
-            radiance *= tau_o;
-            radiance *= tau_g;
-            radiance *= tau_wa;
-            radiance *= static_cast<float>(radiance_multiplier);
+            Spectrum31f sampled_radiance(SunRadianceValues);
+            sampled_radiance *= tau_r;
+            sampled_radiance *= tau_a;
+            sampled_radiance *= tau_o;
+            sampled_radiance *= tau_g;
+            sampled_radiance *= tau_wa;
+            sampled_radiance *= static_cast<float>(radiance_multiplier);
+
+            // Convert the result to the internal spectrum format.
+            sampled_spectrum_to_spectrum(sampled_radiance, radiance);
         }
     };
 }
@@ -275,6 +275,21 @@ const ShaderGroup* Material::get_uncached_osl_surface() const
 
 #endif
 
+bool Material::uses_alpha_mapping() const
+{
+    if (get_uncached_alpha_map())
+        return true;
+
+#ifdef WITH_OSL
+    // Whether a shader group has transparency is only known once it has been set up.
+    const ShaderGroup* shader_group = get_uncached_osl_surface();
+    if (shader_group && (!shader_group->valid() || shader_group->has_transparency()))
+        return true;
+#endif
+
+    return false;
+}
+
 bool Material::create_normal_modifier(const MessageContext& context)
 {
     assert(m_normal_modifier == 0);
@@ -104,6 +104,11 @@ class DLLSYMBOL Material
     // Return whether surface shaders should be invoked for fully transparent shading points.
     bool shade_alpha_cutouts() const;
 
+    // Return true if this material may be partially transparent, i.e. if it has an alpha map
+    // or an OSL shader group with transparency. Can be called before on_frame_begin(), in
+    // which case OSL shader groups are conservatively assumed to have transparency.
+    bool uses_alpha_mapping() const;
+
     //
     // The get_*() methods below retrieve entities that were cached by on_frame_begin().
     // To retrieve the entities before on_frame_begin() or after on_frame_end() is called,
@@ -143,6 +143,13 @@ size_t MeshObject::push_vertex(const GVector3& vertex)
     return index;
 }
 
+size_t MeshObject::push_vertices(const GVector3* vertices, const size_t count)
+{
+    const size_t index = impl->m_tess.m_vertices.size();
+    impl->m_tess.m_vertices.insert(impl->m_tess.m_vertices.end(), vertices, vertices + count);
+    return index;
+}
+
 size_t MeshObject::get_vertex_count() const
 {
     return impl->m_tess.m_vertices.size();
@@ -167,6 +174,13 @@ size_t MeshObject::push_vertex_normal(const GVector3& normal)
     return index;
 }
 
+size_t MeshObject::push_vertex_normals(const GVector3* normals, const size_t count)
+{
+    const size_t index = impl->m_tess.m_vertex_normals.size();
+    impl->m_tess.m_vertex_normals.insert(impl->m_tess.m_vertex_normals.end(), normals, normals + count);
+    return index;
+}
+
 size_t MeshObject::get_vertex_normal_count() const
 {
     return impl->m_tess.m_vertex_normals.size();
@@ -182,6 +196,11 @@ size_t MeshObject::push_tex_coords(const GVector2& tex_coords)
     return impl->m_tess.push_uv_vertex(tex_coords);
 }
 
+size_t MeshObject::push_tex_coords(const GVector2* tex_coords, const size_t count)
+{
+    return impl->m_tess.push_uv_vertices(tex_coords, count);
+}
+
 size_t MeshObject::get_tex_coords_count() const
 {
     return impl->m_tess.get_uv_vertex_count();
@@ -204,6 +223,13 @@ size_t MeshObject::push_triangle(const Triangle& triangle)
     return index;
 }
 
+size_t MeshObject::push_triangles(const Triangle* triangles, const size_t count)
+{
+    const size_t index = impl->m_tess.m_primitives.size();
+    impl->m_tess.m_primitives.insert(impl->m_tess.m_primitives.end(), triangles, triangles + count);
+    return index;
+}
+
 size_t MeshObject::get_triangle_count() const
 {
     return impl->m_tess.m_primitives.size();
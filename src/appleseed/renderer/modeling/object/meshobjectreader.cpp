@@ -56,6 +56,10 @@
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
+// boost headers.
+#include "boost/static_assert.hpp"
+#include "boost/type_traits/is_same.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
@@ -84,6 +88,11 @@ DEFINE_ARRAY(MeshObjectArray);
 
 namespace
 {
+    // The bulk insertion methods reinterpret arrays of floats as arrays of vectors.
+    BOOST_STATIC_ASSERT((boost::is_same<GScalar, float>::value));
+    BOOST_STATIC_ASSERT(sizeof(GVector3) == 3 * sizeof(float));
+    BOOST_STATIC_ASSERT(sizeof(GVector2) == 2 * sizeof(float));
+
     class MeshObjectBuilder
       : public IMeshBuilder
     {
@@ -172,21 +181,7 @@ namespace
 
         virtual size_t push_vertex_normal(const Vector3d& v) OVERRIDE
         {
-            GVector3 n(v);
-
-            const GScalar norm_n = norm(n);
-
-            if (norm_n > GScalar(0.0))
-                n /= norm_n;
-            else
-            {
-                ++m_null_normal_vector_count;
-                n = GVector3(GScalar(1.0), GScalar(0.0), GScalar(0.0));
-            }
-
-            ++m_normal_count;
-
-            return m_objects.back()->push_vertex_normal(n);
+            return m_objects.back()->push_vertex_normal(make_unit_normal(GVector3(v)));
         }
 
         virtual size_t push_tex_coords(const Vector2d& v) OVERRIDE
@@ -292,6 +287,72 @@ namespace
             m_face_material = static_cast<uint32>(material);
         }
 
+        virtual size_t push_vertex_array(const float* vertices, const size_t count) OVERRIDE
+        {
+            return m_objects.back()->push_vertices(reinterpret_cast<const GVector3*>(vertices), count);
+        }
+
+        virtual size_t push_vertex_normal_array(const float* vertex_normals, const size_t count) OVERRIDE
+        {
+            m_normal_buffer.resize(count);
+
+            const GVector3* input = reinterpret_cast<const GVector3*>(vertex_normals);
+            for (size_t i = 0; i < count; ++i)
+                m_normal_buffer[i] = make_unit_normal(input[i]);
+
+            return m_objects.back()->push_vertex_normals(count > 0 ? &m_normal_buffer[0] : 0, count);
+        }
+
+        virtual size_t push_tex_coords_array(const float* tex_coords, const size_t count) OVERRIDE
+        {
+            return m_objects.back()->push_tex_coords(reinterpret_cast<const GVector2*>(tex_coords), count);
+        }
+
+        virtual void push_triangle_array(const IndexedTriangle* triangles, const size_t count) OVERRIDE
+        {
+            m_triangle_buffer.resize(count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const IndexedTriangle& input = triangles[i];
+                Triangle& triangle = m_triangle_buffer[i];
+
+                // Set triangle vertices.
+                triangle.m_v0 = input.m_v0;
+                triangle.m_v1 = input.m_v1;
+                triangle.m_v2 = input.m_v2;
+
+                // Set triangle vertex normals.
+                if (!m_ignore_vertex_normals && input.m_n0 != None)
+                {
+                    triangle.m_n0 = input.m_n0;
+                    triangle.m_n1 = input.m_n1;
+                    triangle.m_n2 = input.m_n2;
+                }
+                else
+                {
+                    const uint32 geometric_normal_index =
+                        push_geometric_normal(triangle.m_v0, triangle.m_v1, triangle.m_v2);
+
+                    triangle.m_n0 = geometric_normal_index;
+                    triangle.m_n1 = geometric_normal_index;
+                    triangle.m_n2 = geometric_normal_index;
+                }
+
+                // Set triangle vertex texture coordinates (if any).
+                triangle.m_a0 = input.m_a0 != None ? input.m_a0 : Triangle::None;
+                triangle.m_a1 = input.m_a0 != None ? input.m_a1 : Triangle::None;
+                triangle.m_a2 = input.m_a0 != None ? input.m_a2 : Triangle::None;
+
+                // Set triangle material.
+                triangle.m_pa = input.m_pa != None ? input.m_pa : Triangle::None;
+            }
+
+            m_objects.back()->push_triangles(count > 0 ? &m_triangle_buffer[0] : 0, count);
+
+            m_face_count += count;
+        }
+
       private:
         const ParamArray        m_params;
         const bool              m_ignore_vertex_normals;
@@ -315,6 +376,10 @@ namespace
         vector<Vector3d>        m_polygon;
         vector<size_t>          m_triangles;
 
+        // Support data for bulk insertions.
+        vector<GVector3>        m_normal_buffer;
+        vector<Triangle>        m_triangle_buffer;
+
         // Mesh statistics.
         size_t                  m_normal_count;
         size_t                  m_face_count;
@@ -333,6 +398,40 @@ namespace
             m_null_normal_vector_count = 0;
         }
 
+        GVector3 make_unit_normal(GVector3 n)
+        {
+            const GScalar norm_n = norm(n);
+
+            if (norm_n > GScalar(0.0))
+                n /= norm_n;
+            else
+            {
+                ++m_null_normal_vector_count;
+                n = GVector3(GScalar(1.0), GScalar(0.0), GScalar(0.0));
+            }
+
+            ++m_normal_count;
+
+            return n;
+        }
+
+        uint32 push_geometric_normal(
+            const uint32        v0_index,
+            const uint32        v1_index,
+            const uint32        v2_index)
+        {
+            // Fetch the triangle vertices.
+            const Vector3d v0 = Vector3d(m_objects.back()->get_vertex(v0_index));
+            const Vector3d v1 = Vector3d(m_objects.back()->get_vertex(v1_index));
+            const Vector3d v2 = Vector3d(m_objects.back()->get_vertex(v2_index));
+
+            // Compute the geometric normal to the triangle.
+            const Vector3d geometric_normal = normalize(cross(v1 - v0, v2 - v0));
+
+            // Insert the geometric normal into the mesh.
+            return static_cast<uint32>(m_objects.back()->push_vertex_normal(GVector3(geometric_normal)));
+        }
+
         string make_unique_mesh_name(string mesh_name)
         {
             if (mesh_name.empty())
@@ -368,17 +467,9 @@ namespace
             }
             else
             {
-                // Fetch the triangle vertices.
-                const Vector3d v0 = Vector3d(m_objects.back()->get_vertex(triangle.m_v0));
-                const Vector3d v1 = Vector3d(m_objects.back()->get_vertex(triangle.m_v1));
-                const Vector3d v2 = Vector3d(m_objects.back()->get_vertex(triangle.m_v2));
-
-                // Compute the geometric normal to the triangle.
-                const Vector3d geometric_normal = normalize(cross(v1 - v0, v2 - v0));
-
                 // Insert the geometric normal into the mesh.
                 const uint32 geometric_normal_index =
-                    static_cast<uint32>(m_objects.back()->push_vertex_normal(GVector3(geometric_normal)));
+                    push_geometric_normal(triangle.m_v0, triangle.m_v1, triangle.m_v2);
 
                 // Assign the geometric normal to all vertices of the triangle.
                 triangle.m_n0 = geometric_normal_index;
@@ -427,10 +427,14 @@ const TraceContext& Project::get_trace_context() const
     return *impl->m_trace_context;
 }
 
-void Project::update_trace_context()
+void Project::update_trace_context(const size_t build_thread_count)
 {
-    if (impl->m_trace_context.get())
-        impl->m_trace_context->update();
+    if (impl->m_trace_context.get() == 0)
+    {
+        assert(impl->m_scene.get());
+        impl->m_trace_context.reset(new TraceContext(*impl->m_scene, build_thread_count));
+    }
+    else impl->m_trace_context->update(build_thread_count);
 }
 
 void Project::add_base_configurations()
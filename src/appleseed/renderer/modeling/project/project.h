@@ -118,8 +118,10 @@ class DLLSYMBOL Project
     // Get the trace context.
     const TraceContext& get_trace_context() const;
 
-    // Synchronize the trace context with the scene.
-    void update_trace_context();
+    // Create the trace context if it doesn't exist yet, or synchronize it with the
+    // scene. Acceleration structures are built using up to 'build_thread_count'
+    // threads each.
+    void update_trace_context(const size_t build_thread_count = 1);
 
   private:
     friend class ProjectFactory;
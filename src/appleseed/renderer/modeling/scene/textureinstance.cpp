@@ -110,6 +110,10 @@ TextureInstance::TextureInstance(
         m_filtering_mode = TextureFilteringNearest;
     else if (filtering_mode == "bilinear")
         m_filtering_mode = TextureFilteringBilinear;
+    else if (filtering_mode == "trilinear")
+        m_filtering_mode = TextureFilteringTrilinear;
+    else if (filtering_mode == "anisotropic")
+        m_filtering_mode = TextureFilteringAnisotropic;
     else
     {
         RENDERER_LOG_ERROR(
@@ -299,7 +303,9 @@ DictionaryArray TextureInstanceFactory::get_input_metadata()
             .insert("items",
                 Dictionary()
                     .insert("Nearest", "nearest")
-                    .insert("Bilinear", "bilinear"))
+                    .insert("Bilinear", "bilinear")
+                    .insert("Trilinear", "trilinear")
+                    .insert("Anisotropic", "anisotropic"))
             .insert("use", "required")
             .insert("default", "bilinear"));
 
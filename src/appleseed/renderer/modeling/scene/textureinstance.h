@@ -71,6 +71,8 @@ enum TextureFilteringMode
 {
     TextureFilteringNearest,
     TextureFilteringBilinear,
+    TextureFilteringTrilinear,          // bilinear lookups in the two nearest MIP levels
+    TextureFilteringAnisotropic,        // several trilinear lookups along the major axis of the footprint
     TextureFilteringBicubic,
     TextureFilteringFeline,             // Reference: http://www.hpl.hp.com/techreports/Compaq-DEC/WRL-99-1.pdf
     TextureFilteringEWA
@@ -248,6 +248,26 @@ TransformSequence TransformSequence::operator*(const TransformSequence& rhs) con
     return result;
 }
 
+bool TransformSequence::operator==(const TransformSequence& rhs) const
+{
+    if (m_size != rhs.m_size)
+        return false;
+
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        if (m_keys[i].m_time != rhs.m_keys[i].m_time ||
+            m_keys[i].m_transform != rhs.m_keys[i].m_transform)
+            return false;
+    }
+
+    return true;
+}
+
+bool TransformSequence::operator!=(const TransformSequence& rhs) const
+{
+    return !(*this == rhs);
+}
+
 void TransformSequence::copy_from(const TransformSequence& rhs)
 {
     m_capacity = rhs.m_size;    // shrink to size on copy
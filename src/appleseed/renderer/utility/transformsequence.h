@@ -108,6 +108,11 @@ class DLLSYMBOL TransformSequence
     // Compose two transform sequences.
     TransformSequence operator*(const TransformSequence& rhs) const;
 
+    // Exact comparison operators. Two sequences are equal if they contain
+    // the same (time, transform) pairs in the same order.
+    bool operator==(const TransformSequence& rhs) const;
+    bool operator!=(const TransformSequence& rhs) const;
+
     // Transform a 3D axis-aligned bounding box.
     // If the bounding box is invalid, it is returned unmodified.
     template <typename T>
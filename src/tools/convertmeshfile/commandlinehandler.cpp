@@ -56,6 +56,16 @@ CommandLineHandler::CommandLineHandler()
     m_print_bboxes.add_name("-b");
     m_print_bboxes.set_description("print mesh bounding boxes");
     parser().add_option_handler(&m_print_bboxes);
+
+    m_mappable.add_name("--mappable");
+    m_mappable.add_name("-m");
+    m_mappable.set_description("write BinaryMesh files in the memory-mappable format (version 4)");
+    parser().add_option_handler(&m_mappable);
+
+    m_compress_arrays.add_name("--compress-arrays");
+    m_compress_arrays.add_name("-c");
+    m_compress_arrays.set_description("compress the arrays of memory-mappable BinaryMesh files");
+    parser().add_option_handler(&m_compress_arrays);
 }
 
 void CommandLineHandler::print_program_usage(
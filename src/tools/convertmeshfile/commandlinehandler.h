@@ -55,6 +55,8 @@ class CommandLineHandler
   public:
     foundation::ValueOptionHandler<std::string> m_filename;
     foundation::FlagOptionHandler               m_print_bboxes;
+    foundation::FlagOptionHandler               m_mappable;
+    foundation::FlagOptionHandler               m_compress_arrays;
 
     // Constructor.
     CommandLineHandler();
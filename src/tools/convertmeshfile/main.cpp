@@ -37,6 +37,7 @@
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
 #include "foundation/math/vector.h"
+#include "foundation/mesh/binarymeshfilewriter.h"
 #include "foundation/mesh/genericmeshfilereader.h"
 #include "foundation/mesh/genericmeshfilewriter.h"
 #include "foundation/mesh/imeshbuilder.h"
@@ -318,8 +319,17 @@ int main(int argc, const char* argv[])
             print_bbox(logger, *i);
     }
 
+    // Select the format of BinaryMesh output files.
+    int binarymesh_options = BinaryMeshFileWriter::Default;
+    if (cl.m_mappable.is_set())
+    {
+        binarymesh_options |= BinaryMeshFileWriter::MemoryMappable;
+        if (cl.m_compress_arrays.is_set())
+            binarymesh_options |= BinaryMeshFileWriter::CompressArrays;
+    }
+
     // Write the output mesh file.
-    GenericMeshFileWriter writer(output_filepath.c_str());
+    GenericMeshFileWriter writer(output_filepath.c_str(), binarymesh_options);
     try
     {
         for (const_each<list<Mesh> > i = builder.get_meshes(); i; ++i)